@@ -0,0 +1,30 @@
+#ifndef _AST_ALLOC_STATS_H_
+#define _AST_ALLOC_STATS_H_
+
+#include <stddef.h>
+
+typedef enum ASTAllocKind {
+    AST_ALLOC_NODE,     // Nodes and their statement arrays
+    AST_ALLOC_SYMBOL,
+    AST_ALLOC_SCOPE,    // Scopes and their variable arrays
+    AST_ALLOC_KINDS_COUNT
+} ASTAllocKind;
+
+typedef struct ASTAllocCounter {
+    unsigned long count;
+    size_t bytes;
+} ASTAllocCounter;
+
+typedef struct ASTAllocStats {
+    ASTAllocCounter counters[AST_ALLOC_KINDS_COUNT];
+} ASTAllocStats;
+
+const char* ASTAllocKindToStr(ASTAllocKind kind);
+
+// Allocations made by the calling thread since it started or since the last reset. The bytes of the nodes
+// allocated from an arena are counted as well.
+ASTAllocStats getASTAllocStats();
+
+void resetASTAllocStats();
+
+#endif
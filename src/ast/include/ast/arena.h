@@ -0,0 +1,32 @@
+#ifndef _AST_ARENA_H_
+#define _AST_ARENA_H_
+
+#include <stddef.h>
+
+// Bump allocator for the nodes of one AST. Nodes are laid out in allocation order and are only released
+// all at once, when the arena is deleted.
+typedef struct ASTArena ASTArena;
+
+#define AST_ARENA_DEFAULT_CHUNK_SIZE (16 * 1024)
+#define AST_ARENA_MAX_CHUNK_SIZE (4 * 1024 * 1024)
+
+ASTArena* newASTArena(size_t chunk_size);
+
+#define newASTArenaDefault() newASTArena(AST_ARENA_DEFAULT_CHUNK_SIZE)
+
+void deleteASTArena(ASTArena** arena);
+
+void* ASTArenaAlloc(ASTArena* arena, size_t size);
+
+unsigned int getASTArenaChunkCount(const ASTArena* arena);
+
+size_t getASTArenaUsedBytes(const ASTArena* arena);
+
+// While an arena is set as current, every node created by the calling thread is allocated from it.
+// deleteASTNode does not release these nodes, so a tree must only be attached to nodes of the same arena
+// if it is to be released with the arena. Returns the previous arena.
+ASTArena* setCurrentASTArena(ASTArena* arena);
+
+ASTArena* getCurrentASTArena();
+
+#endif
@@ -60,6 +60,9 @@ typedef enum ASTNodeType {
     AST_FOR,
     AST_BREAK,
     AST_CONTINUE,
+    AST_WRAP_ADD,         // Arithmetic created by the optimizer, which wraps around on every backend
+    AST_WRAP_SUB,
+    AST_WRAP_MUL,
     AST_NODE_TYPES_COUNT  // Count of AST node types
 } ASTNodeType;
 
@@ -68,6 +71,7 @@ typedef enum ASTOpType {
     UNARY_OP,
     BINARY_OP,
     TERNARY_OP,
+    N_ARY_OP,
     UNKNOWN_OP
 } ASTOpType;
 
@@ -76,13 +80,19 @@ typedef struct ASTNode {
     ASTType value_type;
 
     unsigned int size;
+    unsigned int line;   // Position in the source, 0 when the node was not parsed
+    unsigned int column;
     bool allowed_lval;
+    bool in_arena; // Released with its arena instead of by deleteASTNode
 
     union {
         int n;      // AST_INT
         bool z;     // AST_BOOL
         ASTType t;  // AST_TYPE
-        Symbol* id; // AST_ID
+        struct {    // AST_ID
+            Symbol* id;
+            unsigned int slot; // Frame slot of the var, resolved once for the evaluators
+        };
         struct {    // BINARY_OP
             const struct ASTNode* left;
             const struct ASTNode* right;
@@ -96,6 +106,11 @@ typedef struct ASTNode {
             struct ASTNode* second;
             struct ASTNode* third;
         };
+        struct {    // N_ARY_OP (AST_STATEMENT_SEQ)
+            const struct ASTNode** stmts;
+            unsigned int stmt_count;
+            unsigned int stmt_capacity;
+        };
     };
 } ASTNode;
 
@@ -115,6 +130,8 @@ ASTResult newASTTernaryOP(ASTNodeType node_type, ASTNode* first, ASTNode* second
 
 ASTNode* newASTNoOp();
 
+void setASTLocation(ASTNode* node, unsigned int line, unsigned int column);
+
 bool equalAST(const ASTNode* ast1, const ASTNode* ast2);
 
 bool isStmt(const ASTNode* ast);
@@ -123,6 +140,8 @@ bool isExp(const ASTNode* ast);
 
 bool isCmpExp(const ASTNode* ast);
 
+bool hasSideEffects(const ASTNode* ast);
+
 ASTOpType getNodeOpType(const ASTNodeType node_type);
 
 const char* nodeTypeToStr(ASTNodeType node_type);
@@ -136,6 +155,12 @@ int printAST(const ASTNode* ast, const IOStream* stream, int level);
 #define newASTMul(l, r) newASTBinaryOP(AST_MUL, l, r)
 #define newASTDiv(l, r) newASTBinaryOP(AST_DIV, l, r)
 #define newASTMod(l, r) newASTBinaryOP(AST_MOD, l, r)
+#define newASTWrapAdd(l, r) newASTBinaryOP(AST_WRAP_ADD, l, r)
+#define newASTWrapSub(l, r) newASTBinaryOP(AST_WRAP_SUB, l, r)
+#define newASTWrapMul(l, r) newASTBinaryOP(AST_WRAP_MUL, l, r)
+
+// Result of the operator of an AST_WRAP_* node, which is +, - or *, modulo 2^32
+#define WRAP_INT_OP(l, op, r) ((int) ((unsigned int) (l) op (unsigned int) (r)))
 
 #define newASTUSub(e) newASTUnaryOP(AST_USUB, e)
 #define newASTUAdd(e) newASTUnaryOP(AST_UADD, e)
@@ -155,7 +180,11 @@ int printAST(const ASTNode* ast, const IOStream* stream, int level);
 #define newASTLogicalAnd(l, r) newASTBinaryOP(AST_LOGICAL_AND, l, r)
 #define newASTLogicalOr(l, r) newASTBinaryOP(AST_LOGICAL_OR, l, r)
 
-#define newASTStatementList(stmt, list) (list == NULL ? stmt : newASTBinaryOP(AST_STATEMENT_SEQ, stmt, list).result_value)
+// Appends stmt to the sequence seq, which is updated in place and returned. If seq is not a sequence, a new one
+// is created with seq as its first statement. The statements of a sequence given as stmt are moved into seq.
+ASTNode* appendASTStatement(ASTNode* seq, const ASTNode* stmt);
+
+#define newASTStatementList(stmt, list) ((list) == NULL ? (stmt) : appendASTStatement(stmt, list))
 
 ASTNode* newASTID(Symbol* id);
 ASTResult newASTIDDeclaration(ASTType type, const char* id, const ASTNode* value, bool redef, SymbolTable* st);
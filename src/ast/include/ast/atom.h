@@ -0,0 +1,18 @@
+#ifndef _AST_ATOM_H_
+#define _AST_ATOM_H_
+
+#include <stddef.h>
+
+// Interned strings: equal strings are interned to the same pointer, so atoms are compared with ==.
+// Atoms live until the end of the program.
+typedef const char* Atom;
+
+// Interns the first len characters of str (or less, if it ends before). Only locks if str is not interned yet.
+Atom internAtom(const char* str, size_t len);
+
+// Returns NULL if str was never interned. Never locks, so concurrent parses do not wait on each other.
+Atom findAtom(const char* str, size_t len);
+
+unsigned int getAtomCount();
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef _OPTIMIZE_H_
+#define _OPTIMIZE_H_
+
+#include "ast.h"
+#include "symbol.h"
+
+typedef enum ASTOptimization {
+    AST_OPT_NONE               = 0,
+    AST_OPT_CONSTANT_FOLDING   = 1 << 0,
+    AST_OPT_LOOP_INVARIANTS    = 1 << 1,  // Computes the invariant expressions of a loop once, before it
+    AST_OPT_STRENGTH_REDUCTION = 1 << 2,  // Updates the products of the induction variables by additions
+    AST_OPT_SCALAR_EVOLUTION   = 1 << 3,  // Computes the values after the loops that only accumulate directly
+    AST_OPT_ALL                = AST_OPT_CONSTANT_FOLDING | AST_OPT_LOOP_INVARIANTS | AST_OPT_STRENGTH_REDUCTION
+                               | AST_OPT_SCALAR_EVOLUTION,
+    // Not part of AST_OPT_ALL, as the dumps of the state show the last variable of each slot
+    AST_OPT_FRAME_SLOTS        = 1 << 4,  // Shares the slots of the variables whose live ranges do not overlap
+} ASTOptimization;
+
+// Rewrites the AST in place (the root may be replaced). Must run before the AST is executed or compiled.
+void optimizeAST(ASTNode** ast, SymbolTable* st, unsigned int optimizations);
+
+#define optimizeASTDefault(ast, st) optimizeAST(ast, st, AST_OPT_ALL)
+
+ASTNode* foldConstants(ASTNode* ast);
+
+// Applies the loop optimizations among the given ones, defining their temporaries in the symbol table. The loops
+// that are rewritten are wrapped in a scope with the declarations of their temporaries, and the loops that are
+// computed in closed form are kept for the values that the closed form does not cover.
+ASTNode* optimizeLoops(ASTNode* ast, SymbolTable* st, unsigned int optimizations);
+
+// Gives the variables the fewest slots of the frame, by liveness: a variable is live from its declaration to its last
+// access, over the whole of the loops that access it from outside, and to the end of the program if it is in the
+// outermost scope. Variables of the same type whose live ranges do not overlap share a slot. Only applies if the AST
+// declares each variable of the symbol table once, with a value. Returns whether the slots were changed.
+bool assignFrameSlots(const ASTNode* ast, SymbolTable* st);
+
+#endif
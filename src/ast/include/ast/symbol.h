@@ -50,10 +50,29 @@ Symbol* lookupVar(const SymbolTable *st, const char *id);
 
 Symbol* lookupVarInScope(const Scope* scope, const char *id);
 
+// Most recently defined symbol on the frame slot, in O(1)
 Symbol* lookupLastVarWithOffset(const SymbolTable *st, unsigned int var_offset);
 
 ASTResult defineVar(SymbolTable* st, const ASTType type, const char* id, bool redef);
 
+// Prefix of the ids of the temporaries, which the lexer never produces
+#define TEMP_VAR_PREFIX "_t"
+
+// Variable introduced by the optimizer, on a slot after the ones of the program. It can not be looked up by id and
+// it is left out of the dumps of the state.
+Symbol* defineTempVar(SymbolTable* st, ASTType type);
+
+bool isTempVar(const Symbol* var);
+
+// Variable of the outermost scope, whose value is part of the state that the program leaves
+bool isGlobalVar(const Symbol* var);
+
+// Moves the variables to the given slots of the frame, where several variables may share a slot as long as their
+// values are never needed at the same time. All the variables must be given, in the order in which the program
+// declares them, so that lookupLastVarWithOffset returns the last one to run on each slot. Afterwards only
+// temporaries can be defined.
+void assignVarSlots(SymbolTable* st, Symbol* const* vars, const unsigned int* offsets, unsigned int count);
+
 ASTResult getVarReference(const SymbolTable* st, const char* id);
 
 const char* getVarId(const Symbol* var);
@@ -62,6 +81,9 @@ ASTType getVarType(const Symbol* var);
 
 unsigned int getVarOffset(const Symbol* var);
 
+// Whether assignVarSlots gave the slot of the variable to other variables too
+bool isVarSlotShared(const Symbol* var);
+
 unsigned int getVarRedefLevel(const Symbol* var);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,28 @@
+#ifndef _AST_ALLOC_H_
+#define _AST_ALLOC_H_
+
+#include "ast.h"
+#include "alloc_stats.h"
+
+extern _Thread_local ASTAllocStats ast_alloc_stats;
+
+// Counts an allocation of the calling thread. The count is only incremented for new objects, the bytes also
+// for the arrays that they grow.
+static inline void countASTAlloc(ASTAllocKind kind, unsigned int count, size_t bytes) {
+    ast_alloc_stats.counters[kind].count += count;
+    ast_alloc_stats.counters[kind].bytes += bytes;
+}
+
+// Allocates a node from the current arena, or from the heap when there is none
+ASTNode* allocASTNode();
+
+// Releases only the node itself, its children are not touched
+void freeASTNode(ASTNode* node);
+
+// Resizes the statement array of a sequence. It is allocated like the node: from the current arena if the
+// node is in one, or from the heap otherwise.
+const ASTNode** resizeASTStmts(const ASTNode* seq, unsigned int capacity);
+
+void freeASTStmts(const ASTNode* seq);
+
+#endif
@@ -0,0 +1,27 @@
+#include <assert.h>
+#include <string.h>
+
+#include "alloc_stats.h"
+#include "alloc.h"
+
+_Thread_local ASTAllocStats ast_alloc_stats;
+
+static const char* ASTAllocKindStr[] = {
+    [AST_ALLOC_NODE]   = "nodes",
+    [AST_ALLOC_SYMBOL] = "symbols",
+    [AST_ALLOC_SCOPE]  = "scopes",
+};
+
+const char* ASTAllocKindToStr(ASTAllocKind kind) {
+    assert((sizeof(ASTAllocKindStr)/sizeof(ASTAllocKindStr[0])) == AST_ALLOC_KINDS_COUNT);
+    assert(kind < AST_ALLOC_KINDS_COUNT);
+    return ASTAllocKindStr[kind];
+}
+
+ASTAllocStats getASTAllocStats() {
+    return ast_alloc_stats;
+}
+
+void resetASTAllocStats() {
+    memset(&ast_alloc_stats, 0, sizeof(ast_alloc_stats));
+}
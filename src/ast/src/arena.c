@@ -0,0 +1,163 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+
+#include "arena.h"
+#include "alloc.h"
+
+// Nodes are packed back to back, without rounding them up to the malloc alignment
+#define ALIGNMENT (_Alignof(ASTNode))
+#define alignUp(n) (((n) + ALIGNMENT - 1) & ~(ALIGNMENT - 1))
+
+typedef struct Chunk {
+    struct Chunk* next;
+    size_t capacity;
+    size_t used;
+    _Alignas(ASTNode) unsigned char data[];
+} Chunk;
+
+typedef struct ASTArena {
+    Chunk* head; // Chunk being filled, the older ones follow
+    size_t chunk_size;
+    unsigned int chunk_count;
+    size_t used_bytes;
+} ASTArena;
+
+static _Thread_local ASTArena* current_arena = NULL;
+
+static Chunk* newChunk(size_t capacity, Chunk* next) {
+    Chunk* chunk = malloc(sizeof(Chunk) + capacity);
+    assert(chunk != NULL);
+    chunk->next = next;
+    chunk->capacity = capacity;
+    chunk->used = 0;
+    return chunk;
+}
+
+ASTArena* newASTArena(size_t chunk_size) {
+    assert(chunk_size > 0);
+
+    ASTArena* arena = malloc(sizeof(ASTArena));
+    assert(arena != NULL);
+    arena->head = NULL;
+    arena->chunk_size = alignUp(chunk_size);
+    arena->chunk_count = 0;
+    arena->used_bytes = 0;
+    return arena;
+}
+
+void deleteASTArena(ASTArena** arena) {
+    assert(arena != NULL && *arena != NULL);
+    assert(current_arena != *arena);
+
+    Chunk* chunk = (*arena)->head;
+    while (chunk != NULL) {
+        Chunk* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+
+    free(*arena);
+    *arena = NULL;
+}
+
+void* ASTArenaAlloc(ASTArena* arena, size_t size) {
+    assert(arena != NULL);
+
+    size = alignUp(size);
+
+    Chunk* chunk = arena->head;
+    if (chunk == NULL || chunk->capacity - chunk->used < size) {
+        // Chunks grow geometrically, so large ASTs only need a few of them
+        size_t capacity = arena->chunk_size;
+        if (chunk != NULL && chunk->capacity < AST_ARENA_MAX_CHUNK_SIZE) {
+            capacity = 2 * chunk->capacity;
+        } else if (chunk != NULL) {
+            capacity = chunk->capacity;
+        }
+        if (capacity < size) {
+            capacity = size;
+        }
+
+        chunk = newChunk(capacity, chunk);
+        arena->head = chunk;
+        arena->chunk_count++;
+    }
+
+    void* ptr = chunk->data + chunk->used;
+    chunk->used += size;
+    arena->used_bytes += size;
+    return ptr;
+}
+
+unsigned int getASTArenaChunkCount(const ASTArena* arena) {
+    assert(arena != NULL);
+    return arena->chunk_count;
+}
+
+size_t getASTArenaUsedBytes(const ASTArena* arena) {
+    assert(arena != NULL);
+    return arena->used_bytes;
+}
+
+ASTArena* setCurrentASTArena(ASTArena* arena) {
+    ASTArena* previous = current_arena;
+    current_arena = arena;
+    return previous;
+}
+
+ASTArena* getCurrentASTArena() {
+    return current_arena;
+}
+
+ASTNode* allocASTNode() {
+    ASTNode* node = NULL;
+    if (current_arena != NULL) {
+        node = ASTArenaAlloc(current_arena, sizeof(ASTNode));
+        node->in_arena = true;
+    } else {
+        node = malloc(sizeof(ASTNode));
+        assert(node != NULL);
+        node->in_arena = false;
+    }
+    countASTAlloc(AST_ALLOC_NODE, 1, sizeof(ASTNode));
+    return node;
+}
+
+void freeASTNode(ASTNode* node) {
+    assert(node != NULL);
+
+    // Arena nodes are released with their arena
+    if (!node->in_arena) {
+        free(node);
+    }
+}
+
+const ASTNode** resizeASTStmts(const ASTNode* seq, unsigned int capacity) {
+    assert(seq != NULL && capacity >= seq->stmt_count);
+
+    countASTAlloc(AST_ALLOC_NODE, 0, (capacity - seq->stmt_capacity) * sizeof(ASTNode*));
+
+    if (!seq->in_arena) {
+        const ASTNode** stmts = realloc(seq->stmts, capacity * sizeof(ASTNode*));
+        assert(stmts != NULL);
+        return stmts;
+    }
+
+    // The old array is left in the arena, which is fine since arrays grow geometrically
+    assert(current_arena != NULL);
+    const ASTNode** stmts = ASTArenaAlloc(current_arena, capacity * sizeof(ASTNode*));
+    if (seq->stmt_count > 0) {
+        memcpy(stmts, seq->stmts, seq->stmt_count * sizeof(ASTNode*));
+    }
+    return stmts;
+}
+
+void freeASTStmts(const ASTNode* seq) {
+    assert(seq != NULL);
+
+    if (!seq->in_arena) {
+        free(seq->stmts);
+    }
+}
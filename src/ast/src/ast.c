@@ -4,6 +4,7 @@
 #include <string.h>
 
 #include "ast.h"
+#include "alloc.h"
 
 #define getNodeOPType(node) (ASTNodeTable[node->node_type].op_type)
 #define isBinaryOP(node) (getNodeOPType(node) == BINARY_OP)
@@ -143,6 +144,43 @@ bool isCmpExp(const ASTNode* ast) {
     }
 }
 
+bool hasSideEffects(const ASTNode* ast) {
+    assert(ast != NULL);
+
+    switch (ast->node_type) {
+        case AST_ID_ASSIGNMENT:
+        case AST_COMPD_ASSIGN:
+        case AST_INC:
+        case AST_DEC:
+        case AST_LOGICAL_TOGGLE:
+        case AST_BITWISE_TOGGLE:
+            return true;
+        default:
+            break;
+    }
+
+    switch (getNodeOpType(ast->node_type)) {
+        case ZEROARY_OP:
+            return false;
+        case UNARY_OP:
+            return hasSideEffects(ast->child);
+        case BINARY_OP:
+            return hasSideEffects(ast->left) || hasSideEffects(ast->right);
+        case TERNARY_OP:
+            return hasSideEffects(ast->first) || hasSideEffects(ast->second) || hasSideEffects(ast->third);
+        case N_ARY_OP:
+            for (unsigned int i = 0; i < ast->stmt_count; i++) {
+                if (hasSideEffects(ast->stmts[i])) {
+                    return true;
+                }
+            }
+            return false;
+        default:
+            assert(false);
+            return true;
+    }
+}
+
 bool isEqCmpExp(const ASTNode* ast) {
     return ast->node_type == AST_CMP_EQ || ast->node_type == AST_CMP_NEQ;
 }
@@ -330,7 +368,7 @@ ASTNodeInfo ASTNodeTable[] = {
     [AST_ID_DECLARATION] = {"AST_ID_DECLARATION", UNARY_OP,   true,  &genericStatementTypeHandler, NULL},
     [AST_ID_DECL_ASSIGN] = {"AST_ID_DECL_ASSIGN", BINARY_OP,  true,  &declAssignmentTypeHandler, NULL},
     [AST_ID_ASSIGNMENT]  = {"AST_ID_ASSIGNMENT",  BINARY_OP,  false, &assignmentTypeHandler, &assignmentLvalChecker},
-    [AST_STATEMENT_SEQ]  = {"AST_STATEMENT_SEQ",  BINARY_OP,  true,  &genericStatementTypeHandler, NULL},
+    [AST_STATEMENT_SEQ]  = {"AST_STATEMENT_SEQ",  N_ARY_OP,   true,  &genericStatementTypeHandler, NULL},
     [AST_PRINT]          = {"AST_PRINT",          UNARY_OP,   true,  &genericStatementTypeHandler, NULL},
     [AST_PRINT_VAR]      = {"AST_PRINT_VAR",      UNARY_OP,   true,  &genericStatementTypeHandler, NULL},
     [AST_NO_OP]          = {"AST_NO_OP",          ZEROARY_OP, true,  NULL, NULL},
@@ -357,6 +395,9 @@ ASTNodeInfo ASTNodeTable[] = {
     [AST_FOR]            = {"AST_FOR",            UNARY_OP,   true,  &genericStatementTypeHandler, NULL},
     [AST_BREAK]          = {"AST_BREAK",          ZEROARY_OP, true,  NULL, NULL},
     [AST_CONTINUE]       = {"AST_CONTINUE",       ZEROARY_OP, true,  NULL, NULL},
+    [AST_WRAP_ADD]       = {"AST_WRAP_ADD",       BINARY_OP,  false, &binaryExpressionTypeHandler, NULL},
+    [AST_WRAP_SUB]       = {"AST_WRAP_SUB",       BINARY_OP,  false, &binaryExpressionTypeHandler, NULL},
+    [AST_WRAP_MUL]       = {"AST_WRAP_MUL",       BINARY_OP,  false, &binaryExpressionTypeHandler, NULL},
 };
 
 ASTOpType getNodeOpType(ASTNodeType node_type) {
@@ -368,10 +409,12 @@ const char* nodeTypeToStr(ASTNodeType node_type) {
 }
 
 static inline ASTNode* newASTNode(const ASTNodeType node_type, const unsigned int size) {
-    ASTNode* node = (ASTNode*) malloc(sizeof(ASTNode));
+    ASTNode* node = allocASTNode();
     node->node_type = node_type;
     node->value_type = AST_TYPE_COUNT;
     node->size = size;
+    node->line = 0;
+    node->column = 0;
     node->allowed_lval = false;
     return node;
 }
@@ -470,12 +513,56 @@ ASTResult newASTTernaryOP(ASTNodeType node_type, ASTNode* first, ASTNode* second
     return OK(node);
 }
 
+#define STMTS_INITIAL_CAPACITY 4
+
+static inline void pushStatement(ASTNode* seq, const ASTNode* stmt) {
+    if (seq->stmt_count == seq->stmt_capacity) {
+        unsigned int capacity = seq->stmt_capacity == 0 ? STMTS_INITIAL_CAPACITY : 2 * seq->stmt_capacity;
+        seq->stmts = resizeASTStmts(seq, capacity);
+        seq->stmt_capacity = capacity;
+    }
+    seq->stmts[seq->stmt_count++] = stmt;
+    seq->size += stmt->size;
+}
+
+static ASTNode* newASTStatementSeq() {
+    ASTNode* seq = newASTNode(AST_STATEMENT_SEQ, 1);
+    seq->value_type = AST_TYPE_VOID;
+    seq->stmts = NULL;
+    seq->stmt_count = 0;
+    seq->stmt_capacity = 0;
+    return seq;
+}
+
+ASTNode* appendASTStatement(ASTNode* seq, const ASTNode* stmt) {
+    assert(seq != NULL && stmt != NULL);
+
+    if (seq->node_type != AST_STATEMENT_SEQ) {
+        ASTNode* first = seq;
+        seq = newASTStatementSeq();
+        pushStatement(seq, first);
+    }
+
+    if (stmt->node_type == AST_STATEMENT_SEQ) {
+        for (unsigned int i = 0; i < stmt->stmt_count; i++) {
+            pushStatement(seq, stmt->stmts[i]);
+        }
+        freeASTStmts(stmt);
+        freeASTNode((ASTNode*) stmt);
+    } else {
+        pushStatement(seq, stmt);
+    }
+
+    return seq;
+}
+
 ASTNode* newASTID(Symbol* id) {
     assert(id != NULL);
 
     ASTNode* node = newASTNode(AST_ID, 1);
     node->value_type = getVarType(id);
     node->id = id;
+    node->slot = getVarOffset(id);
     node->allowed_lval = true;
     return node;
 }
@@ -509,6 +596,12 @@ ASTNode* newASTNoOp() {
     return node;
 }
 
+void setASTLocation(ASTNode* node, unsigned int line, unsigned int column) {
+    assert(node != NULL);
+    node->line = line;
+    node->column = column;
+}
+
 ASTResult newASTUnaryCompoundAssign(ASTNodeType node_type, const ASTNode* lval, bool is_prefix) {
     assert(lval != NULL);
 
@@ -623,7 +716,7 @@ ASTResult newASTFor(const ASTNode* init, const ASTNode* cond, const ASTNode* upd
     assert(body != NULL);
     assert(body->node_type == AST_SCOPE || body->node_type == AST_NO_OP);
 
-    const ASTNode* s = newASTScope(newASTStatementList(body, update));
+    const ASTNode* s = newASTScope(newASTStatementList((ASTNode*) body, update));
 
     if (cond->node_type == AST_NO_OP) {
         deleteASTNode((ASTNode**)&cond);
@@ -636,7 +729,7 @@ ASTResult newASTFor(const ASTNode* init, const ASTNode* cond, const ASTNode* upd
     }
     const ASTNode* loop = res.result_value;
 
-    return newASTUnaryOP(AST_FOR, newASTStatementList(init, loop));
+    return newASTUnaryOP(AST_FOR, newASTStatementList((ASTNode*) init, loop));
 }
 
 ASTNode* newASTBreak() {
@@ -668,11 +761,17 @@ void deleteASTNode(ASTNode** node) {
             deleteASTNode(&((*node)->second));
             deleteASTNode(&((*node)->third));
             break;
+        case N_ARY_OP:
+            for (unsigned int i = 0; i < (*node)->stmt_count; i++) {
+                deleteASTNode((ASTNode**)&((*node)->stmts[i]));
+            }
+            freeASTStmts(*node);
+            break;
         default:
             assert(false);
     }
 
-    free(*node);
+    freeASTNode(*node);
     *node = NULL;
 }
 
@@ -697,9 +796,11 @@ bool equalAST(const ASTNode* ast1, const ASTNode* ast2) {
                 case AST_TYPE:
                     return ast1->t == ast2->t;
                 case AST_ID:
-                    return strncmp(getVarId(ast1->id), getVarId(ast2->id), MAX_ID_SIZE) == 0;
+                    return getVarId(ast1->id) == getVarId(ast2->id); // Ids are atoms
                 case AST_NO_OP:
-                    return ast2->node_type == AST_NO_OP;
+                case AST_BREAK:
+                case AST_CONTINUE:
+                    return true;
                 default:
                     assert(false);
             }
@@ -709,6 +810,16 @@ bool equalAST(const ASTNode* ast1, const ASTNode* ast2) {
             return equalAST(ast1->left, ast2->left) && equalAST(ast1->right, ast2->right);
         case TERNARY_OP:
             return equalAST(ast1->first, ast2->first) && equalAST(ast1->second, ast2->second) && equalAST(ast1->third, ast2->third);
+        case N_ARY_OP:
+            if (ast1->stmt_count != ast2->stmt_count) {
+                return false;
+            }
+            for (unsigned int i = 0; i < ast1->stmt_count; i++) {
+                if (!equalAST(ast1->stmts[i], ast2->stmts[i])) {
+                    return false;
+                }
+            }
+            return true;
         default:
             assert(false);
     }
@@ -776,10 +887,20 @@ ASTNode* copyAST(const ASTNode* src_ast) {
             cp_ast = res.result_value;
             break;
         }
+        case N_ARY_OP: {
+            // Statement by statement, so that nested sequences are kept as they are
+            cp_ast = newASTStatementSeq();
+            for (unsigned int i = 0; i < src_ast->stmt_count; i++) {
+                pushStatement(cp_ast, copyAST(src_ast->stmts[i]));
+            }
+            break;
+        }
         default:
             assert(false);
     }
 
+    setASTLocation(cp_ast, src_ast->line, src_ast->column);
+
     assert(equalAST(src_ast, cp_ast));
     return cp_ast;
 }
@@ -831,6 +952,13 @@ int printAST(const ASTNode* ast, const IOStream* stream, int level) {
             n += printAST(ast->third, stream, level + 1);
             break;
         }
+        case N_ARY_OP: {
+            n += IOStreamWritef(stream, "[%s (%d)]\n", nodeTypeToStr(ast->node_type), ast->size);
+            for (unsigned int i = 0; i < ast->stmt_count; i++) {
+                n += printAST(ast->stmts[i], stream, level + 1);
+            }
+            break;
+        }
         default:
             assert(false);
     }
@@ -0,0 +1,118 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "atom.h"
+
+#define INITIAL_CAPACITY 256 // Must be a power of 2
+
+// Files may be parsed concurrently. Lookups do not lock: a slot is published with a release store once its atom is
+// written, and a grown table once all its slots are. Inserting and growing take the lock.
+typedef struct AtomTable {
+    _Atomic(Atom)* slots;
+    unsigned int capacity;
+    const struct AtomTable* replaced; // Kept, as a lookup may still be probing it
+} AtomTable;
+
+static _Atomic(AtomTable*) table = NULL;
+static unsigned int table_size = 0;
+static pthread_mutex_t table_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// FNV-1a
+static inline uint32_t hash(const char* str, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char) str[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static inline bool equalAtom(Atom atom, const char* str, size_t len) {
+    return strncmp(atom, str, len) == 0 && atom[len] == '\0';
+}
+
+// Returns the slot of the atom, or the empty slot where it would be inserted
+static inline _Atomic(Atom)* findSlot(const AtomTable* t, const char* str, size_t len) {
+    unsigned int mask = t->capacity - 1;
+    unsigned int i = hash(str, len) & mask;
+    Atom atom;
+    while ((atom = atomic_load_explicit(&t->slots[i], memory_order_acquire)) != NULL && !equalAtom(atom, str, len)) {
+        i = (i + 1) & mask;
+    }
+    return &t->slots[i];
+}
+
+static AtomTable* growTable(AtomTable* old) {
+    AtomTable* t = malloc(sizeof(AtomTable));
+    assert(t != NULL);
+    t->capacity = old == NULL ? INITIAL_CAPACITY : 2 * old->capacity;
+    t->slots = calloc(t->capacity, sizeof(_Atomic(Atom)));
+    assert(t->slots != NULL);
+    t->replaced = old;
+
+    for (unsigned int i = 0; old != NULL && i < old->capacity; i++) {
+        Atom atom = atomic_load_explicit(&old->slots[i], memory_order_relaxed);
+        if (atom != NULL) {
+            atomic_store_explicit(findSlot(t, atom, strlen(atom)), atom, memory_order_relaxed);
+        }
+    }
+
+    atomic_store_explicit(&table, t, memory_order_release);
+    return t;
+}
+
+Atom internAtom(const char* str, size_t len) {
+    assert(str != NULL);
+
+    len = strnlen(str, len);
+
+    // Most ids are already interned
+    Atom atom = findAtom(str, len);
+    if (atom != NULL) {
+        return atom;
+    }
+
+    pthread_mutex_lock(&table_lock);
+
+    AtomTable* t = atomic_load_explicit(&table, memory_order_relaxed);
+    // Keep the load factor under 1/2
+    if (t == NULL || 2 * (table_size + 1) > t->capacity) {
+        t = growTable(t);
+    }
+
+    _Atomic(Atom)* slot = findSlot(t, str, len);
+    atom = atomic_load_explicit(slot, memory_order_relaxed);
+    if (atom == NULL) {
+        char* new_atom = malloc(len + 1);
+        assert(new_atom != NULL);
+        memcpy(new_atom, str, len);
+        new_atom[len] = '\0';
+        atomic_store_explicit(slot, new_atom, memory_order_release);
+        table_size++;
+        atom = new_atom;
+    }
+
+    pthread_mutex_unlock(&table_lock);
+    return atom;
+}
+
+Atom findAtom(const char* str, size_t len) {
+    assert(str != NULL);
+
+    len = strnlen(str, len);
+
+    const AtomTable* t = atomic_load_explicit(&table, memory_order_acquire);
+    return t == NULL ? NULL : atomic_load_explicit(findSlot(t, str, len), memory_order_acquire);
+}
+
+unsigned int getAtomCount() {
+    pthread_mutex_lock(&table_lock);
+    unsigned int count = table_size;
+    pthread_mutex_unlock(&table_lock);
+    return count;
+}
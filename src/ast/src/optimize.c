@@ -0,0 +1,1726 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <limits.h>
+
+#include "optimize.h"
+#include "alloc.h"
+
+static ASTNode* foldExpression(ASTNode* node);
+static ASTNode* foldStatements(ASTNode* node);
+
+void optimizeAST(ASTNode** ast, SymbolTable* st, unsigned int optimizations) {
+    assert(ast != NULL && *ast != NULL);
+    assert(st != NULL);
+
+    if (optimizations & AST_OPT_CONSTANT_FOLDING) {
+        *ast = foldConstants(*ast);
+    }
+    // After the folding, so that the constant expressions are not hoisted
+    if (optimizations & (AST_OPT_LOOP_INVARIANTS | AST_OPT_STRENGTH_REDUCTION | AST_OPT_SCALAR_EVOLUTION)) {
+        *ast = optimizeLoops(*ast, st, optimizations);
+    }
+    // Last, as the other optimizations define temporaries
+    if (optimizations & AST_OPT_FRAME_SLOTS) {
+        assignFrameSlots(*ast, st);
+    }
+}
+
+ASTNode* foldConstants(ASTNode* ast) {
+    assert(ast != NULL);
+    return isStmt(ast) ? foldStatements(ast) : foldExpression(ast);
+}
+
+static inline bool isConstant(const ASTNode* node) {
+    return node->node_type == AST_INT || node->node_type == AST_BOOL || node->node_type == AST_TYPE;
+}
+
+static inline int constantValue(const ASTNode* node) {
+    switch (node->node_type) {
+        case AST_INT:  return node->n;
+        case AST_BOOL: return node->z;
+        case AST_TYPE: return node->t;
+        default:
+            assert(false);
+            return 0;
+    }
+}
+
+static inline bool isConstantValue(const ASTNode* node, int value) {
+    return isConstant(node) && constantValue(node) == value;
+}
+
+// INT_MIN has no literal in the target languages, so it is never produced
+static ASTNode* newConstant(ASTType type, int value) {
+    switch (type) {
+        case AST_TYPE_INT:  return value == INT_MIN ? NULL : newASTInt(value);
+        case AST_TYPE_BOOL: return newASTBool(value != 0);
+        case AST_TYPE_TYPE: return newASTType(value);
+        default:
+            assert(false);
+            return NULL;
+    }
+}
+
+static inline void updateSize(ASTNode* node) {
+    switch (getNodeOpType(node->node_type)) {
+        case ZEROARY_OP: node->size = 1; break;
+        case UNARY_OP:   node->size = node->child->size + 1; break;
+        case BINARY_OP:  node->size = node->left->size + node->right->size + 1; break;
+        case TERNARY_OP: node->size = node->first->size + node->second->size + node->third->size + 1; break;
+        case N_ARY_OP: {
+            node->size = 1;
+            for (unsigned int i = 0; i < node->stmt_count; i++) {
+                node->size += node->stmts[i]->size;
+            }
+            break;
+        }
+        default:
+            assert(false);
+    }
+}
+
+// Deletes the node and all its children except kept, which is returned
+static ASTNode* keepChild(ASTNode* node, const ASTNode* kept) {
+    ASTNode* children[3] = { NULL, NULL, NULL };
+    switch (getNodeOpType(node->node_type)) {
+        case UNARY_OP:
+            children[0] = (ASTNode*) node->child;
+            break;
+        case BINARY_OP:
+            children[0] = (ASTNode*) node->left;
+            children[1] = (ASTNode*) node->right;
+            break;
+        case TERNARY_OP:
+            children[0] = node->first;
+            children[1] = node->second;
+            children[2] = node->third;
+            break;
+        default:
+            assert(false);
+    }
+
+    for (int i = 0; i < 3; i++) {
+        if (children[i] != NULL && children[i] != kept) {
+            deleteASTNode(&children[i]);
+        }
+    }
+    freeASTNode(node);
+    return (ASTNode*) kept;
+}
+
+static ASTNode* replaceWithConstant(ASTNode* node, ASTNode* constant) {
+    if (constant == NULL) {
+        return node;
+    }
+    deleteASTNode(&node);
+    return constant;
+}
+
+// Integer division and remainder trap on a zero divisor and on INT_MIN / -1
+static inline bool mayTrapAlone(const ASTNode* node) {
+    if (node->node_type == AST_DIV || node->node_type == AST_MOD) {
+        return node->right->node_type != AST_INT || node->right->n == 0 || node->right->n == -1;
+    }
+    return false;
+}
+
+static bool mayTrap(const ASTNode* node) {
+    if (mayTrapAlone(node)) {
+        return true;
+    }
+
+    switch (getNodeOpType(node->node_type)) {
+        case ZEROARY_OP: return false;
+        case UNARY_OP:   return mayTrap(node->child);
+        case BINARY_OP:  return mayTrap(node->left) || mayTrap(node->right);
+        case TERNARY_OP: return mayTrap(node->first) || mayTrap(node->second) || mayTrap(node->third);
+        default:
+            assert(false);
+            return true;
+    }
+}
+
+// Whether the expression can be dropped without changing the behaviour of the program
+static inline bool isRemovable(const ASTNode* node) {
+    return !hasSideEffects(node) && !mayTrap(node);
+}
+
+static inline bool compare(const ASTNodeType node_type, const int l, const int r) {
+    switch (node_type) {
+        case AST_CMP_EQ:  return l == r;
+        case AST_CMP_NEQ: return l != r;
+        case AST_CMP_LT:  return l <  r;
+        case AST_CMP_LTE: return l <= r;
+        case AST_CMP_GT:  return l >  r;
+        case AST_CMP_GTE: return l >= r;
+        default:
+            assert(false);
+            return false;
+    }
+}
+
+// Arithmetic wraps around, like the generated code does in practice
+static bool evalBinaryConstant(const ASTNode* node, int* result) {
+    const int l = constantValue(node->left);
+    const int r = constantValue(node->right);
+
+    switch (node->node_type) {
+        case AST_ADD:
+        case AST_WRAP_ADD: *result = WRAP_INT_OP(l, +, r); return true;
+        case AST_SUB:
+        case AST_WRAP_SUB: *result = WRAP_INT_OP(l, -, r); return true;
+        case AST_MUL:
+        case AST_WRAP_MUL: *result = WRAP_INT_OP(l, *, r); return true;
+        case AST_DIV:
+        case AST_MOD: {
+            if (r == 0 || (l == INT_MIN && r == -1)) {
+                return false;
+            }
+            *result = node->node_type == AST_DIV ? l / r : l % r;
+            return true;
+        }
+        case AST_BITWISE_OR:  *result = l | r; return true;
+        case AST_BITWISE_AND: *result = l & r; return true;
+        case AST_BITWISE_XOR: *result = l ^ r; return true;
+        case AST_L_SHIFT:
+        case AST_R_SHIFT: {
+            if (r < 0 || r >= (int) (sizeof(int) * CHAR_BIT)) {
+                return false;
+            }
+            *result = node->node_type == AST_L_SHIFT ? (int) ((unsigned int) l << r) : l >> r;
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+static bool evalUnaryConstant(const ASTNode* node, int* result) {
+    const int v = constantValue(node->child);
+
+    switch (node->node_type) {
+        case AST_USUB:         *result = (int) (0U - (unsigned int) v); return true;
+        case AST_UADD:         *result = v; return true;
+        case AST_LOGICAL_NOT:  *result = !v; return true;
+        case AST_BITWISE_NOT:  *result = node->child->value_type == AST_TYPE_BOOL ? !v : ~v; return true;
+        case AST_ABS:          *result = v >= 0 ? v : (int) (0U - (unsigned int) v); return true;
+        case AST_SET_POSITIVE: *result = v < 0 ? (int) (0U - (unsigned int) v) : v; return true;
+        case AST_SET_NEGATIVE: *result = v < 0 ? v : (int) (0U - (unsigned int) v); return true;
+        default:
+            return false;
+    }
+}
+
+// Applies the identities of the operator when one of the sides is constant
+static ASTNode* simplifyBinaryOP(ASTNode* node) {
+    const ASTNode* l = node->left;
+    const ASTNode* r = node->right;
+    const bool is_bool = node->value_type == AST_TYPE_BOOL;
+
+    switch (node->node_type) {
+        case AST_ADD:
+        case AST_WRAP_ADD:
+            if (isConstantValue(r, 0)) return keepChild(node, l);
+            if (isConstantValue(l, 0)) return keepChild(node, r);
+            break;
+        case AST_SUB:
+        case AST_WRAP_SUB:
+        case AST_L_SHIFT:
+        case AST_R_SHIFT:
+            if (isConstantValue(r, 0)) return keepChild(node, l);
+            break;
+        case AST_MUL:
+        case AST_WRAP_MUL:
+            if (isConstantValue(r, 1)) return keepChild(node, l);
+            if (isConstantValue(l, 1)) return keepChild(node, r);
+            if (isConstantValue(r, 0) && isRemovable(l)) return keepChild(node, r);
+            if (isConstantValue(l, 0) && isRemovable(r)) return keepChild(node, l);
+            break;
+        case AST_DIV:
+            if (isConstantValue(r, 1)) return keepChild(node, l);
+            break;
+        case AST_MOD:
+            if (isConstantValue(r, 1) && isRemovable(l)) return replaceWithConstant(node, newASTInt(0));
+            break;
+        case AST_BITWISE_AND: {
+            const int ones = is_bool ? true : -1;
+            if (isConstantValue(r, ones)) return keepChild(node, l);
+            if (isConstantValue(l, ones)) return keepChild(node, r);
+            if (isConstantValue(r, 0) && isRemovable(l)) return keepChild(node, r);
+            if (isConstantValue(l, 0) && isRemovable(r)) return keepChild(node, l);
+            break;
+        } case AST_BITWISE_OR: {
+            const int ones = is_bool ? true : -1;
+            if (isConstantValue(r, 0)) return keepChild(node, l);
+            if (isConstantValue(l, 0)) return keepChild(node, r);
+            if (isConstantValue(r, ones) && isRemovable(l)) return keepChild(node, r);
+            if (isConstantValue(l, ones) && isRemovable(r)) return keepChild(node, l);
+            break;
+        } case AST_BITWISE_XOR:
+            if (isConstantValue(r, 0)) return keepChild(node, l);
+            if (isConstantValue(l, 0)) return keepChild(node, r);
+            break;
+        case AST_LOGICAL_AND:
+            // The right side is only evaluated when the left one is true
+            if (isConstant(l)) return keepChild(node, constantValue(l) ? r : l);
+            if (isConstantValue(r, true)) return keepChild(node, l);
+            if (isConstantValue(r, false) && isRemovable(l)) return keepChild(node, r);
+            break;
+        case AST_LOGICAL_OR:
+            if (isConstant(l)) return keepChild(node, constantValue(l) ? l : r);
+            if (isConstantValue(r, false)) return keepChild(node, l);
+            if (isConstantValue(r, true) && isRemovable(l)) return keepChild(node, r);
+            break;
+        default:
+            break;
+    }
+
+    return node;
+}
+
+// Comparison operands must not turn into bare comparisons, or they would be read as a chain
+static inline bool bindsLooserThanCmp(const ASTNode* node) {
+    switch (node->node_type) {
+        case AST_BITWISE_AND:
+        case AST_BITWISE_OR:
+        case AST_BITWISE_XOR:
+        case AST_LOGICAL_AND:
+        case AST_LOGICAL_OR:
+        case AST_TERNARY_COND:
+        case AST_ID_ASSIGNMENT:
+        case AST_COMPD_ASSIGN:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Simplifying an operand (e.g. "(x += 1) / 1") may expose an operator that binds looser than the comparison,
+// and the backends emit comparison operands as they are, so these are kept explicitly parenthesized.
+static inline ASTNode* foldCmpOperand(ASTNode* operand) {
+    operand = foldExpression(operand);
+    if (isCmpExp(operand)) {
+        return newASTParentheses(operand);
+    }
+    return bindsLooserThanCmp(operand) ? newASTUnaryOP(AST_PARENTHESES, operand).result_value : operand;
+}
+
+// Chains short-circuit on the first false comparison, so the leading comparisons that are known to hold are
+// dropped and the chain is false as soon as one of them does not. Trailing comparisons that always hold are dropped.
+static ASTNode* foldCmpChain(ASTNode* node) {
+    unsigned int n = 0;
+    for (const ASTNode* current = node; isCmpExp(current); current = current->left) {
+        n++;
+    }
+
+    ASTNodeType* ops = malloc(n * sizeof(ASTNodeType));
+    ASTNode** operands = malloc((n + 1) * sizeof(ASTNode*));
+    assert(ops != NULL && operands != NULL);
+
+    ASTNode* current = node;
+    for (int i = n - 1; i >= 0; i--) {
+        ASTNode* left = (ASTNode*) current->left;
+        ops[i] = current->node_type;
+        operands[i + 1] = (ASTNode*) current->right;
+        freeASTNode(current);
+        current = left;
+    }
+    operands[0] = current;
+
+    for (unsigned int i = 0; i <= n; i++) {
+        operands[i] = foldCmpOperand(operands[i]);
+    }
+
+    ASTNode* result = NULL;
+
+    unsigned int start = 0;
+    while (start < n && isConstant(operands[start]) && isConstant(operands[start + 1])) {
+        if (!compare(ops[start], constantValue(operands[start]), constantValue(operands[start + 1]))) {
+            // The remaining operands are never evaluated
+            result = newASTBool(false);
+            break;
+        }
+        deleteASTNode(&operands[start++]);
+    }
+
+    unsigned int end = n;
+    if (result == NULL && start == n) {
+        result = newASTBool(true);
+    }
+
+    while (result == NULL && end - start > 1 && isConstant(operands[end - 1]) && isConstant(operands[end])) {
+        if (compare(ops[end - 1], constantValue(operands[end - 1]), constantValue(operands[end]))) {
+            deleteASTNode(&operands[end--]);
+            continue;
+        }
+
+        bool removable = true;
+        for (unsigned int i = start; i < end && removable; i++) {
+            removable = isRemovable(operands[i]);
+        }
+        if (removable) {
+            result = newASTBool(false);
+        }
+        break;
+    }
+
+    if (result != NULL) {
+        for (unsigned int i = start; i <= end; i++) {
+            if (operands[i] != NULL) {
+                deleteASTNode(&operands[i]);
+            }
+        }
+    } else {
+        // Dropping a leading comparison may leave a chain that mixes the types of its operands (e.g. 2 == b
+        // from 1 < 2 == b), which is still evaluated the same way
+        result = operands[start];
+        for (unsigned int i = start; i < end; i++) {
+            ASTResult res = newASTBinaryOP(ops[i], result, operands[i + 1]);
+            result = res.result_value;
+            result->value_type = AST_TYPE_BOOL;
+        }
+    }
+
+    free(ops);
+    free(operands);
+    return result;
+}
+
+// The operation of a compound assignment is kept, since the backends read the operator from it
+static void foldCompoundAssignment(ASTNode* assignment) {
+    assert(assignment->node_type == AST_ID_ASSIGNMENT);
+
+    assignment->left = foldExpression((ASTNode*) assignment->left);
+
+    ASTNode* op = (ASTNode*) assignment->right;
+    if (getNodeOpType(op->node_type) == UNARY_OP) {
+        op->child = foldExpression((ASTNode*) op->child);
+    } else {
+        op->left = foldExpression((ASTNode*) op->left);
+        op->right = foldExpression((ASTNode*) op->right);
+    }
+
+    updateSize(op);
+    updateSize(assignment);
+}
+
+static ASTNode* foldExpression(ASTNode* node) {
+    assert(node != NULL);
+
+    switch (node->node_type) {
+        case AST_INT:
+        case AST_BOOL:
+        case AST_TYPE:
+        case AST_ID:
+            return node;
+        case AST_CMP_EQ:
+        case AST_CMP_NEQ:
+        case AST_CMP_LT:
+        case AST_CMP_LTE:
+        case AST_CMP_GT:
+        case AST_CMP_GTE:
+            return foldCmpChain(node);
+        case AST_INC:
+        case AST_DEC:
+        case AST_LOGICAL_TOGGLE:
+        case AST_BITWISE_TOGGLE:
+        case AST_COMPD_ASSIGN: {
+            foldCompoundAssignment((ASTNode*) node->child);
+            updateSize(node);
+            return node;
+        }
+        case AST_PARENTHESES: {
+            node->child = foldExpression((ASTNode*) node->child);
+            const ASTNode* child = node->child;
+            bool required = isCmpExp(child) || (child->node_type == AST_TERNARY_COND && child->allowed_lval);
+            if (!required) {
+                return keepChild(node, child);
+            }
+            updateSize(node);
+            return node;
+        }
+        case AST_TERNARY_COND: {
+            node->first = foldExpression(node->first);
+            if (isConstant(node->first)) {
+                ASTNode* branch = constantValue(node->first) ? node->second : node->third;
+                return foldExpression(keepChild(node, branch));
+            }
+            node->second = foldExpression(node->second);
+            node->third = foldExpression(node->third);
+            updateSize(node);
+            return node;
+        }
+        case AST_TYPE_OF: {
+            node->child = foldExpression((ASTNode*) node->child);
+            if (isRemovable(node->child)) {
+                return replaceWithConstant(node, newASTType(node->child->value_type));
+            }
+            updateSize(node);
+            return node;
+        }
+        default:
+            break;
+    }
+
+    int value = 0;
+    switch (getNodeOpType(node->node_type)) {
+        case UNARY_OP: {
+            node->child = foldExpression((ASTNode*) node->child);
+            updateSize(node);
+            if (isConstant(node->child) && evalUnaryConstant(node, &value)) {
+                return replaceWithConstant(node, newConstant(node->value_type, value));
+            }
+            return node;
+        }
+        case BINARY_OP: {
+            node->left = foldExpression((ASTNode*) node->left);
+            node->right = foldExpression((ASTNode*) node->right);
+            updateSize(node);
+            if (isConstant(node->left) && isConstant(node->right) && evalBinaryConstant(node, &value)) {
+                return replaceWithConstant(node, newConstant(node->value_type, value));
+            }
+            return simplifyBinaryOP(node);
+        }
+        default:
+            assert(false);
+            return node;
+    }
+}
+
+static ASTNode* foldStatements(ASTNode* node) {
+    assert(node != NULL);
+
+    switch (node->node_type) {
+        case AST_ID_DECLARATION:
+        case AST_PRINT_VAR:
+        case AST_NO_OP:
+        case AST_BREAK:
+        case AST_CONTINUE:
+            return node;
+        case AST_ID_DECL_ASSIGN: {
+            node->right = foldExpression((ASTNode*) node->right);
+            break;
+        } case AST_STATEMENT_SEQ: {
+            // The statements that become no-ops are dropped
+            unsigned int count = 0;
+            for (unsigned int i = 0; i < node->stmt_count; i++) {
+                ASTNode* stmt = foldStatements((ASTNode*) node->stmts[i]);
+                if (stmt->node_type == AST_NO_OP) {
+                    deleteASTNode(&stmt);
+                } else {
+                    node->stmts[count++] = stmt;
+                }
+            }
+            node->stmt_count = count;
+
+            if (count <= 1) {
+                ASTNode* stmt = count == 0 ? newASTNoOp() : (ASTNode*) node->stmts[0];
+                node->stmt_count = 0;
+                deleteASTNode(&node);
+                return stmt;
+            }
+            break;
+        } case AST_PRINT: {
+            node->child = foldExpression((ASTNode*) node->child);
+            break;
+        } case AST_SCOPE: {
+            node->child = foldStatements((ASTNode*) node->child);
+            break;
+        } case AST_IF: {
+            node->left = foldExpression((ASTNode*) node->left);
+            if (isConstant(node->left)) {
+                if (constantValue(node->left)) {
+                    return foldStatements(keepChild(node, node->right));
+                }
+                deleteASTNode(&node);
+                return newASTNoOp();
+            }
+            node->right = foldStatements((ASTNode*) node->right);
+            break;
+        } case AST_IF_ELSE: {
+            node->first = foldExpression(node->first);
+            if (isConstant(node->first)) {
+                ASTNode* branch = constantValue(node->first) ? node->second : node->third;
+                return foldStatements(keepChild(node, branch));
+            }
+            node->second = foldStatements(node->second);
+            node->third = foldStatements(node->third);
+            if (node->third->node_type == AST_NO_OP) {
+                ASTNode* cond = node->first;
+                ASTNode* then = node->second;
+                deleteASTNode(&node->third);
+                freeASTNode(node);
+                ASTResult res = newASTIf(cond, then);
+                assert(isOK(res));
+                return res.result_value;
+            }
+            break;
+        } case AST_WHILE: {
+            node->left = foldExpression((ASTNode*) node->left);
+            if (isConstantValue(node->left, false)) {
+                deleteASTNode(&node);
+                return newASTNoOp();
+            }
+            node->right = foldStatements((ASTNode*) node->right);
+            break;
+        } case AST_DO_WHILE: {
+            node->left = foldStatements((ASTNode*) node->left);
+            node->right = foldExpression((ASTNode*) node->right);
+            break;
+        } case AST_FOR: {
+            // The desugared structure of the loop is kept as is
+            ASTNode* seq = (ASTNode*) node->child;
+            ASTNode* loop = (ASTNode*) seq->stmts[1];
+            ASTNode* scope = (ASTNode*) loop->right;
+            ASTNode* body = (ASTNode*) scope->child;
+
+            seq->stmts[0] = foldStatements((ASTNode*) seq->stmts[0]);
+            loop->left = foldExpression((ASTNode*) loop->left);
+            body->stmts[0] = foldStatements((ASTNode*) body->stmts[0]);
+            body->stmts[1] = foldStatements((ASTNode*) body->stmts[1]);
+
+            updateSize(body);
+            updateSize(scope);
+            updateSize(loop);
+            updateSize(seq);
+            break;
+        }
+        default: {
+            assert(isExp(node));
+            return foldExpression(node);
+        }
+    }
+
+    updateSize(node);
+    return node;
+}
+
+// Writes to each slot of the frame in a loop, by assignments and declarations
+typedef struct LoopDefs {
+    unsigned int* counts;
+    unsigned int size;  // The later slots are of temporaries defined outside of the loop
+} LoopDefs;
+
+static inline bool isDefinedInLoop(const LoopDefs* defs, const Symbol* var) {
+    const unsigned int offset = getVarOffset(var);
+    return offset < defs->size && defs->counts[offset] > 0;
+}
+
+static inline void addDef(LoopDefs* defs, const Symbol* var) {
+    assert(getVarOffset(var) < defs->size);
+    defs->counts[getVarOffset(var)]++;
+}
+
+// The condition of a ternary lvalue is only read
+static void collectLValDefs(const ASTNode* lval, LoopDefs* defs) {
+    switch (lval->node_type) {
+        case AST_ID:
+            addDef(defs, lval->id);
+            break;
+        case AST_PARENTHESES:
+            collectLValDefs(lval->child, defs);
+            break;
+        case AST_TERNARY_COND:
+            collectLValDefs(lval->second, defs);
+            collectLValDefs(lval->third, defs);
+            break;
+        default:
+            assert(false);
+    }
+}
+
+static void collectDefs(const ASTNode* node, LoopDefs* defs) {
+    switch (node->node_type) {
+        case AST_ID_ASSIGNMENT:
+            collectLValDefs(node->left, defs);
+            break;
+        case AST_ID_DECL_ASSIGN:
+            addDef(defs, node->left->id);
+            break;
+        case AST_ID_DECLARATION:
+            addDef(defs, node->child->id);
+            return;
+        default:
+            break;
+    }
+
+    switch (getNodeOpType(node->node_type)) {
+        case ZEROARY_OP:
+            break;
+        case UNARY_OP:
+            collectDefs(node->child, defs);
+            break;
+        case BINARY_OP:
+            collectDefs(node->left, defs);
+            collectDefs(node->right, defs);
+            break;
+        case TERNARY_OP:
+            collectDefs(node->first, defs);
+            collectDefs(node->second, defs);
+            collectDefs(node->third, defs);
+            break;
+        case N_ARY_OP:
+            for (unsigned int i = 0; i < node->stmt_count; i++) {
+                collectDefs(node->stmts[i], defs);
+            }
+            break;
+        default:
+            assert(false);
+    }
+}
+
+static LoopDefs newLoopDefs(const ASTNode* node, const SymbolTable* st) {
+    LoopDefs defs = { .size = getMaxOffset(st) + 1 };
+    defs.counts = calloc(defs.size, sizeof(unsigned int));
+    assert(defs.counts != NULL);
+    collectDefs(node, &defs);
+    return defs;
+}
+
+// Declarations of the temporaries of a loop, which run before it
+typedef struct LoopTemps {
+    ASTNode** decls;
+    unsigned int count;
+    unsigned int capacity;
+} LoopTemps;
+
+static Symbol* declareTemp(SymbolTable* st, LoopTemps* temps, ASTNode* value) {
+    Symbol* var = defineTempVar(st, value->value_type);
+    if (temps->count == temps->capacity) {
+        temps->capacity = 2 * temps->capacity + 1;
+        temps->decls = realloc(temps->decls, temps->capacity * sizeof(ASTNode*));
+        assert(temps->decls != NULL);
+    }
+    ASTResult res = newASTBinaryOP(AST_ID_DECL_ASSIGN, newASTID(var), value);
+    assert(isOK(res));
+    temps->decls[temps->count++] = res.result_value;
+    return var;
+}
+
+static inline ASTNode* appendPrelude(ASTNode* prelude, ASTNode* stmt) {
+    return prelude == NULL ? stmt : appendASTStatement(prelude, stmt);
+}
+
+static ASTNode* appendTemps(ASTNode* prelude, LoopTemps* temps) {
+    for (unsigned int i = 0; i < temps->count; i++) {
+        prelude = appendPrelude(prelude, temps->decls[i]);
+    }
+    free(temps->decls);
+    return prelude;
+}
+
+// Same structure and the same variables, while equalAST compares the ids of the variables
+static bool sameExpression(const ASTNode* a, const ASTNode* b) {
+    if (a->node_type != b->node_type || a->value_type != b->value_type) {
+        return false;
+    }
+
+    switch (getNodeOpType(a->node_type)) {
+        case ZEROARY_OP:
+            return a->node_type == AST_ID ? a->id == b->id : constantValue(a) == constantValue(b);
+        case UNARY_OP:
+            return sameExpression(a->child, b->child);
+        case BINARY_OP:
+            return sameExpression(a->left, b->left) && sameExpression(a->right, b->right);
+        case TERNARY_OP:
+            return sameExpression(a->first, b->first) && sameExpression(a->second, b->second)
+                && sameExpression(a->third, b->third);
+        default:
+            return false;
+    }
+}
+
+static inline bool isCompoundAssignment(const ASTNode* node) {
+    switch (node->node_type) {
+        case AST_INC:
+        case AST_DEC:
+        case AST_LOGICAL_TOGGLE:
+        case AST_BITWISE_TOGGLE:
+        case AST_COMPD_ASSIGN:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Calls visit on each expression of the statements, with whether the value of the expression is used
+typedef void (*ExpressionVisitor)(ASTNode** exp, bool value_used, void* ctx);
+
+static void visitExpressions(ASTNode** stmt, ExpressionVisitor visit, void* ctx) {
+    ASTNode* node = *stmt;
+
+    switch (node->node_type) {
+        case AST_ID_DECLARATION:
+        case AST_PRINT_VAR:
+        case AST_NO_OP:
+        case AST_BREAK:
+        case AST_CONTINUE:
+            return;
+        case AST_STATEMENT_SEQ:
+            for (unsigned int i = 0; i < node->stmt_count; i++) {
+                visitExpressions((ASTNode**) &node->stmts[i], visit, ctx);
+            }
+            break;
+        case AST_SCOPE:
+        case AST_FOR:
+            visitExpressions((ASTNode**) &node->child, visit, ctx);
+            break;
+        case AST_PRINT:
+            visit((ASTNode**) &node->child, true, ctx);
+            break;
+        case AST_ID_DECL_ASSIGN:
+            visit((ASTNode**) &node->right, true, ctx);
+            break;
+        case AST_IF:
+        case AST_WHILE:
+            visit((ASTNode**) &node->left, true, ctx);
+            visitExpressions((ASTNode**) &node->right, visit, ctx);
+            break;
+        case AST_DO_WHILE:
+            visitExpressions((ASTNode**) &node->left, visit, ctx);
+            visit((ASTNode**) &node->right, true, ctx);
+            break;
+        case AST_IF_ELSE:
+            visit(&node->first, true, ctx);
+            visitExpressions(&node->second, visit, ctx);
+            visitExpressions(&node->third, visit, ctx);
+            break;
+        default:
+            assert(isExp(node));
+            visit(stmt, false, ctx);
+            return;
+    }
+
+    updateSize(node);
+}
+
+// Loop invariant code motion
+
+typedef struct Hoisting {
+    SymbolTable* st;
+    const LoopDefs* defs;
+    LoopTemps temps;
+} Hoisting;
+
+// Variables and constants are as cheap as the temporaries, which are int or bool
+static inline bool isWorthHoisting(const ASTNode* node) {
+    return getNodeOpType(node->node_type) != ZEROARY_OP
+        && (node->value_type == AST_TYPE_INT || node->value_type == AST_TYPE_BOOL);
+}
+
+// The expressions that are the same share their temporary
+static ASTNode* hoistExpression(ASTNode* exp, Hoisting* h) {
+    for (unsigned int i = 0; i < h->temps.count; i++) {
+        const ASTNode* decl = h->temps.decls[i];
+        if (sameExpression(decl->right, exp)) {
+            deleteASTNode(&exp);
+            return newASTID(decl->left->id);
+        }
+    }
+    return newASTID(declareTemp(h->st, &h->temps, exp));
+}
+
+static void hoistOperand(ASTNode** operand, Hoisting* h);
+
+// Returns whether the expression is invariant in the loop and can be evaluated before it, in which case hoisting it
+// is left to the caller. Otherwise, its maximal subexpressions that are are replaced by temporaries.
+static bool hoistInvariants(ASTNode** exp, Hoisting* h) {
+    ASTNode* node = *exp;
+
+    switch (node->node_type) {
+        case AST_INT:
+        case AST_BOOL:
+        case AST_TYPE:
+            return true;
+        case AST_ID:
+            return !isDefinedInLoop(h->defs, node->id);
+        case AST_ID_ASSIGNMENT:
+            // The lvalue is written, only the value is read
+            hoistOperand((ASTNode**) &node->right, h);
+            updateSize(node);
+            return false;
+        default:
+            break;
+    }
+
+    if (isCompoundAssignment(node)) {
+        // The operation is kept, since the backends read the operator from it, and its left side is the lvalue
+        ASTNode* assignment = (ASTNode*) node->child;
+        ASTNode* op = (ASTNode*) assignment->right;
+        if (getNodeOpType(op->node_type) == BINARY_OP) {
+            hoistOperand((ASTNode**) &op->right, h);
+            updateSize(op);
+        }
+        updateSize(assignment);
+        updateSize(node);
+        return false;
+    }
+
+    ASTNode** children[3] = { NULL, NULL, NULL };
+    switch (getNodeOpType(node->node_type)) {
+        case UNARY_OP:
+            children[0] = (ASTNode**) &node->child;
+            break;
+        case BINARY_OP:
+            children[0] = (ASTNode**) &node->left;
+            children[1] = (ASTNode**) &node->right;
+            break;
+        case TERNARY_OP:
+            children[0] = &node->first;
+            children[1] = &node->second;
+            children[2] = &node->third;
+            break;
+        default:
+            assert(false);
+            return false;
+    }
+
+    bool invariant[3] = { false, false, false };
+    bool all_invariant = true;
+    for (int i = 0; i < 3 && children[i] != NULL; i++) {
+        invariant[i] = hoistInvariants(children[i], h);
+        all_invariant = all_invariant && invariant[i];
+    }
+    if (all_invariant && !mayTrapAlone(node)) {
+        return true;
+    }
+
+    for (int i = 0; i < 3 && children[i] != NULL; i++) {
+        // The left comparison of a chain is part of it
+        bool in_chain = i == 0 && isCmpExp(node) && isCmpExp(*children[i]);
+        if (invariant[i] && !in_chain && isWorthHoisting(*children[i])) {
+            *children[i] = hoistExpression(*children[i], h);
+        }
+    }
+    updateSize(node);
+    return false;
+}
+
+static void hoistOperand(ASTNode** operand, Hoisting* h) {
+    if (hoistInvariants(operand, h) && isWorthHoisting(*operand)) {
+        *operand = hoistExpression(*operand, h);
+    }
+}
+
+// The value of an expression statement is not used, so only its subexpressions are hoisted
+static void hoistVisitor(ASTNode** exp, bool value_used, void* ctx) {
+    if (value_used) {
+        hoistOperand(exp, ctx);
+    } else {
+        hoistInvariants(exp, ctx);
+    }
+}
+
+// Strength reduction
+
+typedef struct InductionVar {
+    Symbol* var;
+    int step;
+} InductionVar;
+
+static inline bool isVar(const ASTNode* node, const Symbol* var) {
+    return node->node_type == AST_ID && node->id == var;
+}
+
+// Matches i++, i--, i += c, i -= c, i = i + c, i = c + i and i = i - c, with a step that has a literal
+static bool matchInductionUpdate(const ASTNode* update, InductionVar* iv) {
+    const ASTNode* assignment = update;
+    if (update->node_type == AST_INC || update->node_type == AST_DEC || update->node_type == AST_COMPD_ASSIGN) {
+        assignment = update->child;
+    } else if (update->node_type != AST_ID_ASSIGNMENT) {
+        return false;
+    }
+
+    const ASTNode* lval = assignment->left;
+    const ASTNode* op = assignment->right;
+    if (lval->node_type != AST_ID || lval->value_type != AST_TYPE_INT) {
+        return false;
+    }
+    Symbol* var = lval->id;
+
+    int step = 0;
+    switch (op->node_type) {
+        case AST_ADD:
+            if (isVar(op->left, var) && op->right->node_type == AST_INT) {
+                step = op->right->n;
+            } else if (op->left->node_type == AST_INT && isVar(op->right, var)) {
+                step = op->left->n;
+            }
+            break;
+        case AST_SUB:
+            if (isVar(op->left, var) && op->right->node_type == AST_INT) {
+                step = (int) (0U - (unsigned int) op->right->n);
+            }
+            break;
+        default:
+            break;
+    }
+    if (step == 0 || step == INT_MIN) {
+        return false;
+    }
+
+    iv->var = var;
+    iv->step = step;
+    return true;
+}
+
+typedef struct Reduction {
+    SymbolTable* st;
+    const LoopDefs* defs;
+    InductionVar iv;
+    LoopTemps steps;        // Increments that are not constant
+    LoopTemps temps;        // Derived variables, that follow the product of the induction variable by a factor
+    ASTNode** factors;      // Factor of each derived variable
+    ASTNode** increments;   // Constant or variable added to each derived variable on each iteration
+} Reduction;
+
+static inline bool isInvariantFactor(const ASTNode* node, const Reduction* r) {
+    return node->node_type == AST_INT || (node->node_type == AST_ID && !isDefinedInLoop(r->defs, node->id));
+}
+
+// Returns the factor of a product of the induction variable by an invariant, or NULL
+static const ASTNode* inductionFactor(const ASTNode* node, const Reduction* r) {
+    if (node->node_type != AST_MUL) {
+        return NULL;
+    }
+    if (isVar(node->left, r->iv.var) && isInvariantFactor(node->right, r)) {
+        return node->right;
+    }
+    if (isVar(node->right, r->iv.var) && isInvariantFactor(node->left, r)) {
+        return node->left;
+    }
+    return NULL;
+}
+
+// d = i * k - step * k before the loop, so that d = i * k once each iteration starts with d += step * k.
+// d also takes the values one step before the first product and past the last one, which may overflow where the
+// products of the loop do not, so it is computed with wrapping arithmetic.
+static Symbol* derivedVar(Reduction* r, const ASTNode* factor) {
+    for (unsigned int i = 0; i < r->temps.count; i++) {
+        if (sameExpression(r->factors[i], factor)) {
+            return r->temps.decls[i]->left->id;
+        }
+    }
+
+    ASTNode* increment = foldExpression(newASTWrapMul(newASTInt(r->iv.step), copyAST(factor)).result_value);
+    if (getNodeOpType(increment->node_type) != ZEROARY_OP) {
+        increment = newASTID(declareTemp(r->st, &r->steps, increment));
+    }
+    ASTNode* product = newASTWrapMul(newASTID(r->iv.var), copyAST(factor)).result_value;
+    ASTResult start = increment->node_type == AST_INT && increment->n < 0 && increment->n != INT_MIN
+        ? newASTWrapAdd(product, newASTInt(-increment->n))
+        : newASTWrapSub(product, copyAST(increment));
+    Symbol* var = declareTemp(r->st, &r->temps, foldExpression(start.result_value));
+
+    r->factors = realloc(r->factors, r->temps.count * sizeof(ASTNode*));
+    r->increments = realloc(r->increments, r->temps.count * sizeof(ASTNode*));
+    assert(r->factors != NULL && r->increments != NULL);
+    r->factors[r->temps.count - 1] = copyAST(factor);
+    r->increments[r->temps.count - 1] = increment;
+    return var;
+}
+
+static void reduceProducts(ASTNode** exp, Reduction* r) {
+    ASTNode* node = *exp;
+
+    const ASTNode* factor = inductionFactor(node, r);
+    if (factor != NULL) {
+        *exp = newASTID(derivedVar(r, factor));
+        deleteASTNode(&node);
+        return;
+    }
+
+    if (node->node_type == AST_ID_ASSIGNMENT) {
+        reduceProducts((ASTNode**) &node->right, r);
+        updateSize(node);
+        return;
+    }
+    if (isCompoundAssignment(node)) {
+        ASTNode* assignment = (ASTNode*) node->child;
+        ASTNode* op = (ASTNode*) assignment->right;
+        if (getNodeOpType(op->node_type) == BINARY_OP) {
+            reduceProducts((ASTNode**) &op->right, r);
+            updateSize(op);
+        }
+        updateSize(assignment);
+        updateSize(node);
+        return;
+    }
+
+    switch (getNodeOpType(node->node_type)) {
+        case ZEROARY_OP:
+            return;
+        case UNARY_OP:
+            reduceProducts((ASTNode**) &node->child, r);
+            break;
+        case BINARY_OP:
+            reduceProducts((ASTNode**) &node->left, r);
+            reduceProducts((ASTNode**) &node->right, r);
+            break;
+        case TERNARY_OP:
+            reduceProducts(&node->first, r);
+            reduceProducts(&node->second, r);
+            reduceProducts(&node->third, r);
+            break;
+        default:
+            assert(false);
+    }
+    updateSize(node);
+}
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+static void reduceVisitor(ASTNode** exp, bool value_used, void* ctx) {
+    reduceProducts(exp, ctx);
+}
+#pragma GCC diagnostic pop
+
+// Whether the statements continue the loop that they are in, the nested loops aside
+static bool continuesLoop(const ASTNode* node) {
+    switch (node->node_type) {
+        case AST_CONTINUE:
+            return true;
+        case AST_STATEMENT_SEQ:
+            for (unsigned int i = 0; i < node->stmt_count; i++) {
+                if (continuesLoop(node->stmts[i])) {
+                    return true;
+                }
+            }
+            return false;
+        case AST_SCOPE:
+            return continuesLoop(node->child);
+        case AST_IF:
+            return continuesLoop(node->right);
+        case AST_IF_ELSE:
+            return continuesLoop(node->second) || continuesLoop(node->third);
+        default:
+            return false;
+    }
+}
+
+// The induction variable must be updated once at the end of every iteration that goes on: by the update of a for
+// loop, or by the last statement of the body of a loop without continue. The products in the body are replaced by
+// derived variables, updated at the start of each iteration. Returns whether any was, in which case the init of a
+// for loop is moved to *init, as the derived variables start from its result.
+static bool reduceStrength(ASTNode* loop, Reduction* r, ASTNode** init) {
+    ASTNode* body = NULL;
+    const ASTNode* update = NULL;
+
+    if (loop->node_type == AST_FOR) {
+        ASTNode* seq = (ASTNode*) loop->child;
+        ASTNode* scope = (ASTNode*) seq->stmts[1]->right;
+        body = (ASTNode*) scope->child->stmts[0];
+        update = scope->child->stmts[1];
+        if (body->node_type != AST_SCOPE || !matchInductionUpdate(update, &r->iv)) {
+            return false;
+        }
+
+        LoopDefs init_defs = newLoopDefs(seq->stmts[0], r->st);
+        const unsigned int offset = getVarOffset(r->iv.var);
+        const bool single_update = r->defs->counts[offset] == init_defs.counts[offset] + 1;
+        free(init_defs.counts);
+        if (!single_update) {
+            return false;
+        }
+
+        visitExpressions((ASTNode**) &scope->child->stmts[0], reduceVisitor, r);
+    } else {
+        body = (ASTNode*) (loop->node_type == AST_WHILE ? loop->right : loop->left);
+        if (body->node_type != AST_SCOPE || continuesLoop(body->child)) {
+            return false;
+        }
+
+        ASTNode* stmts = (ASTNode*) body->child;
+        const bool is_seq = stmts->node_type == AST_STATEMENT_SEQ;
+        update = is_seq ? stmts->stmts[stmts->stmt_count - 1] : stmts;
+        if (!matchInductionUpdate(update, &r->iv) || r->defs->counts[getVarOffset(r->iv.var)] != 1) {
+            return false;
+        }
+
+        for (unsigned int i = 0; is_seq && i < stmts->stmt_count - 1; i++) {
+            visitExpressions((ASTNode**) &stmts->stmts[i], reduceVisitor, r);
+        }
+        if (is_seq) {
+            updateSize(stmts);
+        }
+    }
+
+    if (r->temps.count == 0) {
+        return false;
+    }
+
+    ASTNode* updates = NULL;
+    for (unsigned int i = 0; i < r->temps.count; i++) {
+        Symbol* var = r->temps.decls[i]->left->id;
+        ASTResult res = newASTAssignment(newASTID(var), newASTWrapAdd(newASTID(var), r->increments[i]).result_value);
+        assert(isOK(res));
+        updates = appendPrelude(updates, res.result_value);
+    }
+    body->child = appendASTStatement(updates, body->child);
+    updateSize(body);
+
+    if (loop->node_type == AST_FOR) {
+        ASTNode* seq = (ASTNode*) loop->child;
+        ASTNode* cond_loop = (ASTNode*) seq->stmts[1];
+        ASTNode* scope = (ASTNode*) cond_loop->right;
+        updateSize((ASTNode*) scope->child);
+        updateSize(scope);
+        updateSize(cond_loop);
+
+        if (seq->stmts[0]->node_type != AST_NO_OP) {
+            *init = (ASTNode*) seq->stmts[0];
+            seq->stmts[0] = newASTNoOp();
+        }
+        updateSize(seq);
+    }
+    updateSize(loop);
+    return true;
+}
+
+// Scalar evolution
+
+static bool readsDefinedVar(const ASTNode* node, const LoopDefs* defs) {
+    switch (getNodeOpType(node->node_type)) {
+        case ZEROARY_OP: return node->node_type == AST_ID && isDefinedInLoop(defs, node->id);
+        case UNARY_OP:   return readsDefinedVar(node->child, defs);
+        case BINARY_OP:  return readsDefinedVar(node->left, defs) || readsDefinedVar(node->right, defs);
+        case TERNARY_OP:
+            return readsDefinedVar(node->first, defs) || readsDefinedVar(node->second, defs)
+                || readsDefinedVar(node->third, defs);
+        default:
+            assert(false);
+            return true;
+    }
+}
+
+// Has the same value on every iteration, and can be evaluated any number of times
+static inline bool isInvariantInt(const ASTNode* node, const LoopDefs* defs) {
+    return node->value_type == AST_TYPE_INT && isRemovable(node) && !readsDefinedVar(node, defs);
+}
+
+// coef * i + base, with invariant coefficients that are NULL for 0
+typedef struct AffineExp {
+    ASTNode* coef;
+    ASTNode* base;
+} AffineExp;
+
+static inline void deleteAffineExp(AffineExp* exp) {
+    if (exp->coef != NULL) {
+        deleteASTNode(&exp->coef);
+    }
+    if (exp->base != NULL) {
+        deleteASTNode(&exp->base);
+    }
+}
+
+// Adds or subtracts terms that may be 0. The coefficients are sums that the loop never computes, which may overflow
+// where its own additions do not, so they wrap around.
+static ASTNode* combineTerms(ASTNodeType node_type, ASTNode* l, ASTNode* r) {
+    if (r == NULL) {
+        return l;
+    }
+    if (l == NULL) {
+        return node_type == AST_SUB ? newASTWrapSub(newASTInt(0), r).result_value : r;
+    }
+    return newASTBinaryOP(node_type == AST_SUB ? AST_WRAP_SUB : AST_WRAP_ADD, l, r).result_value;
+}
+
+static inline ASTNode* scaleTerm(ASTNode* term, const ASTNode* factor) {
+    return term == NULL ? NULL : newASTWrapMul(term, copyAST(factor)).result_value;
+}
+
+static bool matchAffine(const ASTNode* node, const Symbol* iv, const LoopDefs* defs, AffineExp* exp) {
+    exp->coef = NULL;
+    exp->base = NULL;
+    if (isVar(node, iv)) {
+        exp->coef = newASTInt(1);
+        return true;
+    }
+    if (isInvariantInt(node, defs)) {
+        exp->base = copyAST(node);
+        return true;
+    }
+
+    AffineExp l, r;
+    switch (node->node_type) {
+        case AST_PARENTHESES:
+            return matchAffine(node->child, iv, defs, exp);
+        case AST_USUB:
+            if (!matchAffine(node->child, iv, defs, &l)) {
+                return false;
+            }
+            exp->coef = combineTerms(AST_SUB, NULL, l.coef);
+            exp->base = combineTerms(AST_SUB, NULL, l.base);
+            return true;
+        case AST_ADD:
+        case AST_SUB:
+            if (!matchAffine(node->left, iv, defs, &l)) {
+                return false;
+            }
+            if (!matchAffine(node->right, iv, defs, &r)) {
+                deleteAffineExp(&l);
+                return false;
+            }
+            exp->coef = combineTerms(node->node_type, l.coef, r.coef);
+            exp->base = combineTerms(node->node_type, l.base, r.base);
+            return true;
+        case AST_MUL: {
+            const bool left_factor = isInvariantInt(node->left, defs);
+            const ASTNode* factor = left_factor ? node->left : node->right;
+            if (!isInvariantInt(factor, defs) || !matchAffine(left_factor ? node->right : node->left, iv, defs, &l)) {
+                return false;
+            }
+            exp->coef = scaleTerm(l.coef, factor);
+            exp->base = scaleTerm(l.base, factor);
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+typedef struct Accumulation {
+    Symbol* var;
+    ASTNodeType op;     // AST_ADD or AST_SUB
+    AffineExp exp;      // Added or subtracted on each iteration
+} Accumulation;
+
+typedef struct Evolution {
+    const LoopDefs* defs;
+    InductionVar iv;
+    ASTNodeType cmp;        // The induction variable goes on while it compares to the bound this way
+    const ASTNode* bound;
+    ASTNode* start;         // Value of the induction variable before the loop
+    Accumulation* accs;
+    unsigned int acc_count;
+} Evolution;
+
+// Matches s++, s--, s += e, s -= e, s = s + e, s = e + s and s = s - e, with e affine in the induction variable and s
+// not written elsewhere in the loop
+static bool matchAccumulation(const ASTNode* stmt, const Evolution* e, Accumulation* acc) {
+    const ASTNode* assignment = stmt;
+    if (stmt->node_type == AST_INC || stmt->node_type == AST_DEC || stmt->node_type == AST_COMPD_ASSIGN) {
+        assignment = stmt->child;
+    } else if (stmt->node_type != AST_ID_ASSIGNMENT) {
+        return false;
+    }
+
+    const ASTNode* lval = assignment->left;
+    const ASTNode* op = assignment->right;
+    if (lval->node_type != AST_ID || lval->value_type != AST_TYPE_INT || lval->id == e->iv.var
+        || e->defs->counts[getVarOffset(lval->id)] != 1 || (op->node_type != AST_ADD && op->node_type != AST_SUB)) {
+        return false;
+    }
+
+    const ASTNode* term = NULL;
+    if (isVar(op->left, lval->id)) {
+        term = op->right;
+    } else if (op->node_type == AST_ADD && isVar(op->right, lval->id)) {
+        term = op->left;
+    } else {
+        return false;
+    }
+
+    acc->var = lval->id;
+    acc->op = op->node_type;
+    return matchAffine(term, e->iv.var, e->defs, &acc->exp);
+}
+
+static bool collectAccumulations(const ASTNode* node, Evolution* e) {
+    switch (node->node_type) {
+        case AST_NO_OP:
+            return true;
+        case AST_SCOPE:
+            return collectAccumulations(node->child, e);
+        case AST_STATEMENT_SEQ:
+            for (unsigned int i = 0; i < node->stmt_count; i++) {
+                if (!collectAccumulations(node->stmts[i], e)) {
+                    return false;
+                }
+            }
+            return true;
+        default: {
+            Accumulation acc;
+            if (!matchAccumulation(node, e, &acc)) {
+                return false;
+            }
+            e->accs = realloc(e->accs, (e->acc_count + 1) * sizeof(Accumulation));
+            assert(e->accs != NULL);
+            e->accs[e->acc_count++] = acc;
+            return true;
+        }
+    }
+}
+
+static inline ASTNodeType mirrorCmp(ASTNodeType node_type) {
+    switch (node_type) {
+        case AST_CMP_LT:  return AST_CMP_GT;
+        case AST_CMP_LTE: return AST_CMP_GTE;
+        case AST_CMP_GT:  return AST_CMP_LT;
+        case AST_CMP_GTE: return AST_CMP_LTE;
+        default:
+            assert(false);
+            return node_type;
+    }
+}
+
+// Matches i < b, i <= b, b > i and b >= i for a positive step, and the reverse for a negative one, with b invariant
+static bool matchExitBound(const ASTNode* cond, Evolution* e) {
+    switch (cond->node_type) {
+        case AST_CMP_LT:
+        case AST_CMP_LTE:
+        case AST_CMP_GT:
+        case AST_CMP_GTE:
+            break;
+        default:
+            return false;
+    }
+
+    if (isVar(cond->left, e->iv.var) && isInvariantInt(cond->right, e->defs)) {
+        e->cmp = cond->node_type;
+        e->bound = cond->right;
+    } else if (isVar(cond->right, e->iv.var) && isInvariantInt(cond->left, e->defs)) {
+        e->cmp = mirrorCmp(cond->node_type);
+        e->bound = cond->left;
+    } else {
+        return false;
+    }
+    return e->iv.step > 0 ? e->cmp == AST_CMP_LT || e->cmp == AST_CMP_LTE : e->cmp == AST_CMP_GT || e->cmp == AST_CMP_GTE;
+}
+
+static inline bool isStrictCmp(ASTNodeType node_type) {
+    return node_type == AST_CMP_LT || node_type == AST_CMP_GT;
+}
+
+// Distance from the start to the bound for which the trip count is an int, with n * (n - 1) exact modulo 2^32
+// once the even factor is halved
+static inline long long maxDistance(const Evolution* e) {
+    return isStrictCmp(e->cmp) ? INT_MAX : INT_MAX - 1;
+}
+
+// exp <= limit or exp >= limit, or NULL if it always holds
+static ASTNode* newLimitCheck(ASTNode* exp, ASTNodeType cmp, long long limit) {
+    if ((cmp == AST_CMP_LTE && limit >= INT_MAX) || (cmp == AST_CMP_GTE && limit <= INT_MIN)) {
+        deleteASTNode(&exp);
+        return NULL;
+    }
+    assert(limit > INT_MIN && limit < INT_MAX);
+    return newASTBinaryOP(cmp, exp, newASTInt((int) limit)).result_value;
+}
+
+static inline ASTNode* appendCheck(ASTNode* guard, ASTNode* check) {
+    return check == NULL ? guard : newASTLogicalAnd(guard, check).result_value;
+}
+
+// The closed form holds when the loop runs, the distance to the bound fits in an int and the induction variable does
+// not wrap around past the bound. None of the checks overflows.
+static ASTNode* newEvolutionGuard(const Evolution* e) {
+    const bool up = e->iv.step > 0;
+    const long long step = up ? e->iv.step : -(long long) e->iv.step;
+    const long long max = maxDistance(e);
+    ASTNode* guard = newASTBinaryOP(e->cmp, copyAST(e->start), copyAST(e->bound)).result_value;
+
+    if (e->start->node_type == AST_INT) {
+        guard = appendCheck(guard, up
+            ? newLimitCheck(copyAST(e->bound), AST_CMP_LTE, e->start->n + max)
+            : newLimitCheck(copyAST(e->bound), AST_CMP_GTE, e->start->n - max));
+    } else if (e->bound->node_type == AST_INT) {
+        guard = appendCheck(guard, up
+            ? newLimitCheck(copyAST(e->start), AST_CMP_GTE, e->bound->n - max)
+            : newLimitCheck(copyAST(e->start), AST_CMP_LTE, e->bound->n + max));
+    } else {
+        // The limit is only computed for the bounds for which it is an int, the distance fits for the others
+        ASTNode* limit = up
+            ? newASTSub(copyAST(e->bound), newASTInt((int) max)).result_value
+            : newASTAdd(copyAST(e->bound), newASTInt((int) max)).result_value;
+        ASTNode* fits = up
+            ? newASTCmpLT(copyAST(e->bound), newASTInt((int) (max - INT_MAX))).result_value
+            : newASTCmpGT(copyAST(e->bound), newASTInt((int) (INT_MAX - max))).result_value;
+        ASTNode* check = newASTBinaryOP(up ? AST_CMP_GTE : AST_CMP_LTE, copyAST(e->start), limit).result_value;
+        guard = appendCheck(guard, newASTLogicalOr(fits, check).result_value);
+    }
+
+    // The last value is less than a step past the bound
+    const long long strict = isStrictCmp(e->cmp);
+    guard = appendCheck(guard, up
+        ? newLimitCheck(copyAST(e->bound), AST_CMP_LTE, INT_MAX - step + strict)
+        : newLimitCheck(copyAST(e->bound), AST_CMP_GTE, INT_MIN + step - strict));
+    return foldExpression(guard);
+}
+
+// (distance - 1) / step + 1 for a strict comparison, distance / step + 1 otherwise
+static ASTNode* newTripCount(const Evolution* e) {
+    const bool up = e->iv.step > 0;
+    const int step = up ? e->iv.step : -e->iv.step;
+    ASTNode* distance = up
+        ? newASTSub(copyAST(e->bound), copyAST(e->start)).result_value
+        : newASTSub(copyAST(e->start), copyAST(e->bound)).result_value;
+
+    ASTNode* count = NULL;
+    if (step == 1) {
+        count = isStrictCmp(e->cmp) ? distance : newASTAdd(distance, newASTInt(1)).result_value;
+    } else {
+        if (isStrictCmp(e->cmp)) {
+            distance = newASTSub(distance, newASTInt(1)).result_value;
+        }
+        count = newASTAdd(newASTDiv(distance, newASTInt(step)).result_value, newASTInt(1)).result_value;
+    }
+    return foldExpression(count);
+}
+
+// n * (n - 1) / 2 modulo 2^32, halving the even factor first
+static ASTNode* newPairCount(const ASTNode* n) {
+    ASTNode* is_even = newASTCmpEQ(newASTMod(copyAST(n), newASTInt(2)).result_value, newASTInt(0)).result_value;
+    ASTNode* even = newASTWrapMul(newASTDiv(copyAST(n), newASTInt(2)).result_value,
+        newASTSub(copyAST(n), newASTInt(1)).result_value).result_value;
+    ASTNode* odd = newASTWrapMul(newASTDiv(newASTSub(copyAST(n), newASTInt(1)).result_value, newASTInt(2)).result_value,
+        copyAST(n)).result_value;
+    return foldExpression(newASTTernaryCond(is_even, even, odd).result_value);
+}
+
+// The sum of coef * (start + k * step) + base for k from 0 to n - 1: n * (coef * start + base) + coef * step * pairs.
+// Its terms may overflow even when the partial sums of the loop do not, and only their sum modulo 2^32 is the one of
+// the loop, so all of its arithmetic wraps around.
+static ASTNode* newAccumulatedValue(const Accumulation* acc, const Evolution* e, const ASTNode* n, const ASTNode* pairs) {
+    const AffineExp* exp = &acc->exp;
+    ASTNode* first = exp->coef == NULL ? NULL : newASTWrapMul(copyAST(exp->coef), copyAST(e->start)).result_value;
+    first = combineTerms(AST_ADD, first, exp->base == NULL ? NULL : copyAST(exp->base));
+    ASTNode* value = first == NULL ? NULL : newASTWrapMul(copyAST(n), first).result_value;
+    if (exp->coef != NULL) {
+        ASTNode* increment = newASTWrapMul(copyAST(exp->coef), newASTInt(e->iv.step)).result_value;
+        value = combineTerms(AST_ADD, value, newASTWrapMul(increment, copyAST(pairs)).result_value);
+    }
+    assert(value != NULL);
+    return foldExpression(value);
+}
+
+// var = var + value or var = var - value, wrapping around as the value is only the one of the loop modulo 2^32
+static ASTNode* newWrappingUpdate(Symbol* var, ASTNodeType op, ASTNode* value) {
+    ASTNode* sum = newASTBinaryOP(op == AST_SUB ? AST_WRAP_SUB : AST_WRAP_ADD, newASTID(var), value).result_value;
+    ASTResult res = newASTAssignment(newASTID(var), sum);
+    assert(isOK(res));
+    return res.result_value;
+}
+
+static ASTNode* newClosedForm(const Evolution* e, SymbolTable* st) {
+    LoopTemps temps = { NULL, 0, 0 };
+    ASTNode* n = newTripCount(e);
+    if (getNodeOpType(n->node_type) != ZEROARY_OP) {
+        n = newASTID(declareTemp(st, &temps, n));
+    }
+    ASTNode* pairs = NULL;
+    for (unsigned int i = 0; i < e->acc_count && pairs == NULL; i++) {
+        if (e->accs[i].exp.coef != NULL) {
+            pairs = newPairCount(n);
+            if (getNodeOpType(pairs->node_type) != ZEROARY_OP) {
+                pairs = newASTID(declareTemp(st, &temps, pairs));
+            }
+        }
+    }
+    ASTNode* stmts = appendTemps(NULL, &temps);
+
+    // The induction variable is updated last, as the accumulated values start from it
+    for (unsigned int i = 0; i < e->acc_count; i++) {
+        ASTNode* value = newAccumulatedValue(&e->accs[i], e, n, pairs);
+        stmts = appendPrelude(stmts, newWrappingUpdate(e->accs[i].var, e->accs[i].op, value));
+    }
+    if (pairs != NULL) {
+        deleteASTNode(&pairs);
+    }
+    ASTNode* distance = foldExpression(newASTWrapMul(n, newASTInt(e->iv.step)).result_value);
+    return newASTScope(appendPrelude(stmts, newWrappingUpdate(e->iv.var, AST_ADD, distance)));
+}
+
+static ASTNode* optimizeLoop(ASTNode* loop, SymbolTable* st, unsigned int optimizations);
+
+// A while or for loop that updates its induction variable by a constant step until it passes an invariant bound, and
+// otherwise only adds affine functions of the induction variable to other variables, is replaced by the values that
+// the variables have after it. The loop is kept, with the other optimizations, for the cases that the closed form
+// does not cover. Returns NULL if the loop does not have this form.
+static ASTNode* evolveLoop(ASTNode* loop, SymbolTable* st, unsigned int optimizations) {
+    ASTNode* cond_loop = loop;
+    ASTNode* init = NULL;
+    if (loop->node_type == AST_FOR) {
+        const ASTNode* seq = loop->child;
+        init = (ASTNode*) seq->stmts[0];
+        cond_loop = (ASTNode*) seq->stmts[1];
+    } else if (loop->node_type != AST_WHILE) {
+        return NULL;
+    }
+    const ASTNode* scope = cond_loop->right;
+    if (scope->node_type != AST_SCOPE) {
+        return NULL;
+    }
+
+    // The body of a while loop ends with the update, and the one of a for loop is followed by it
+    const ASTNode* stmts = scope->child;
+    const bool is_seq = stmts->node_type == AST_STATEMENT_SEQ;
+    const ASTNode* update = is_seq ? stmts->stmts[stmts->stmt_count - 1] : stmts;
+    if (loop->node_type == AST_FOR && (!is_seq || stmts->stmt_count != 2)) {
+        return NULL;
+    }
+
+    LoopDefs defs = newLoopDefs(cond_loop, st);
+    Evolution e = { .defs = &defs, .start = NULL, .accs = NULL, .acc_count = 0 };
+    bool matches = matchInductionUpdate(update, &e.iv) && defs.counts[getVarOffset(e.iv.var)] == 1
+        && matchExitBound(cond_loop->left, &e);
+    for (unsigned int i = 0; matches && is_seq && i < stmts->stmt_count - 1; i++) {
+        matches = collectAccumulations(stmts->stmts[i], &e);
+    }
+
+    ASTNode* guard = NULL;
+    if (matches) {
+        // The start is known when the for loop initializes the induction variable with a constant
+        const bool init_start = init != NULL && (init->node_type == AST_ID_ASSIGNMENT || init->node_type == AST_ID_DECL_ASSIGN)
+            && isVar(init->left, e.iv.var) && init->right->node_type == AST_INT;
+        e.start = init_start ? copyAST(init->right) : newASTID(e.iv.var);
+        guard = newEvolutionGuard(&e);
+        matches = !isConstantValue(guard, false);
+    }
+
+    ASTNode* result = NULL;
+    if (matches) {
+        if (init != NULL && init->node_type != AST_NO_OP) {
+            ASTNode* seq = (ASTNode*) loop->child;
+            seq->stmts[0] = newASTNoOp();
+            updateSize(seq);
+            updateSize(loop);
+        } else {
+            init = NULL;
+        }
+
+        result = newClosedForm(&e, st);
+        if (isConstantValue(guard, true)) {
+            deleteASTNode(&guard);
+            deleteASTNode(&loop);
+        } else {
+            ASTNode* fallback = optimizeLoop(loop, st, optimizations);
+            if (fallback->node_type != AST_SCOPE) {
+                fallback = newASTScope(fallback);
+            }
+            result = newASTIfElse(guard, result, fallback).result_value;
+        }
+        if (init != NULL) {
+            result = newASTScope(appendASTStatement(init, result));
+        }
+    } else if (guard != NULL) {
+        deleteASTNode(&guard);
+    }
+
+    for (unsigned int i = 0; i < e.acc_count; i++) {
+        deleteAffineExp(&e.accs[i].exp);
+    }
+    free(e.accs);
+    if (e.start != NULL) {
+        deleteASTNode(&e.start);
+    }
+    free(defs.counts);
+    return result;
+}
+
+static ASTNode* optimizeLoop(ASTNode* loop, SymbolTable* st, unsigned int optimizations) {
+    if (optimizations & AST_OPT_SCALAR_EVOLUTION) {
+        ASTNode* evolved = evolveLoop(loop, st, optimizations & ~AST_OPT_SCALAR_EVOLUTION);
+        if (evolved != NULL) {
+            return evolved;
+        }
+    }
+
+    LoopDefs defs = newLoopDefs(loop, st);
+    ASTNode* prelude = NULL;
+
+    if (optimizations & AST_OPT_LOOP_INVARIANTS) {
+        Hoisting h = { .st = st, .defs = &defs, .temps = { NULL, 0, 0 } };
+        if (loop->node_type == AST_FOR) {
+            // The init runs once anyway
+            ASTNode* seq = (ASTNode*) loop->child;
+            visitExpressions((ASTNode**) &seq->stmts[1], hoistVisitor, &h);
+            updateSize(seq);
+            updateSize(loop);
+        } else {
+            visitExpressions(&loop, hoistVisitor, &h);
+        }
+        prelude = appendTemps(prelude, &h.temps);
+    }
+
+    if (optimizations & AST_OPT_STRENGTH_REDUCTION) {
+        Reduction r = {
+            .st = st, .defs = &defs, .steps = { NULL, 0, 0 }, .temps = { NULL, 0, 0 }, .factors = NULL, .increments = NULL
+        };
+        ASTNode* init = NULL;
+        if (reduceStrength(loop, &r, &init)) {
+            if (init != NULL) {
+                prelude = appendPrelude(prelude, init);
+            }
+            prelude = appendTemps(prelude, &r.steps);
+            prelude = appendTemps(prelude, &r.temps);
+        } else {
+            // Nothing was replaced
+            assert(r.temps.count == 0 && r.steps.count == 0);
+        }
+        for (unsigned int i = 0; i < r.temps.count; i++) {
+            deleteASTNode(&r.factors[i]);
+        }
+        free(r.factors);
+        free(r.increments);
+    }
+
+    free(defs.counts);
+    return prelude == NULL ? loop : newASTScope(appendASTStatement(prelude, loop));
+}
+
+// The inner loops are optimized first, so that the outer ones see the temporaries that they declare
+static ASTNode* optimizeLoopStatements(ASTNode* node, SymbolTable* st, unsigned int optimizations) {
+    switch (node->node_type) {
+        case AST_STATEMENT_SEQ:
+            for (unsigned int i = 0; i < node->stmt_count; i++) {
+                node->stmts[i] = optimizeLoopStatements((ASTNode*) node->stmts[i], st, optimizations);
+            }
+            break;
+        case AST_SCOPE:
+            node->child = optimizeLoopStatements((ASTNode*) node->child, st, optimizations);
+            break;
+        case AST_IF:
+            node->right = optimizeLoopStatements((ASTNode*) node->right, st, optimizations);
+            break;
+        case AST_IF_ELSE:
+            node->second = optimizeLoopStatements(node->second, st, optimizations);
+            node->third = optimizeLoopStatements(node->third, st, optimizations);
+            break;
+        case AST_WHILE:
+            node->right = optimizeLoopStatements((ASTNode*) node->right, st, optimizations);
+            updateSize(node);
+            return optimizeLoop(node, st, optimizations);
+        case AST_DO_WHILE:
+            node->left = optimizeLoopStatements((ASTNode*) node->left, st, optimizations);
+            updateSize(node);
+            return optimizeLoop(node, st, optimizations);
+        case AST_FOR: {
+            // The inner loops are in the body of the desugared loop
+            ASTNode* seq = (ASTNode*) node->child;
+            ASTNode* loop = (ASTNode*) seq->stmts[1];
+            ASTNode* scope = (ASTNode*) loop->right;
+            ASTNode* body = (ASTNode*) scope->child;
+            body->stmts[0] = optimizeLoopStatements((ASTNode*) body->stmts[0], st, optimizations);
+
+            updateSize(body);
+            updateSize(scope);
+            updateSize(loop);
+            updateSize(seq);
+            updateSize(node);
+            return optimizeLoop(node, st, optimizations);
+        }
+        default:
+            return node;
+    }
+
+    updateSize(node);
+    return node;
+}
+
+ASTNode* optimizeLoops(ASTNode* ast, SymbolTable* st, unsigned int optimizations) {
+    assert(ast != NULL);
+    assert(st != NULL);
+    return isStmt(ast) ? optimizeLoopStatements(ast, st, optimizations) : ast;
+}
@@ -0,0 +1,290 @@
+#include <assert.h>
+#include <limits.h>
+#include <stdlib.h>
+
+#include "optimize.h"
+
+#define NO_RANGE UINT_MAX
+
+// Positions of the AST between the declaration of a variable and its last access, in the order in which it runs
+typedef struct LiveRange {
+    Symbol* var;
+    unsigned int start;
+    unsigned int end;
+} LiveRange;
+
+typedef struct Liveness {
+    LiveRange* ranges;      // In the order of the declarations, which is also the order of their starts
+    unsigned int count;
+    unsigned int capacity;
+    unsigned int* current;  // Range of the last declaration of each slot, by the offsets of the scopes
+    unsigned int slot_count;
+    unsigned int position;
+    bool supported;
+} Liveness;
+
+static void declareVar(Liveness* lv, Symbol* var) {
+    const unsigned int offset = getVarOffset(var);
+    assert(offset < lv->slot_count);
+
+    if (lv->count == lv->capacity) {
+        lv->capacity = 2 * lv->capacity + 16;
+        lv->ranges = realloc(lv->ranges, lv->capacity * sizeof(LiveRange));
+        assert(lv->ranges != NULL);
+    }
+    lv->position++;
+    lv->ranges[lv->count] = (LiveRange){ .var = var, .start = lv->position, .end = lv->position };
+    lv->current[offset] = lv->count++;
+}
+
+static void accessVar(Liveness* lv, const Symbol* var) {
+    const unsigned int offset = getVarOffset(var);
+    const unsigned int r = offset < lv->slot_count ? lv->current[offset] : NO_RANGE;
+    // A variable that the AST does not declare is defined by the caller, who may expect it in its slot
+    if (r == NO_RANGE || lv->ranges[r].var != var) {
+        lv->supported = false;
+        return;
+    }
+    lv->ranges[r].end = ++lv->position;
+}
+
+static void collectRanges(const ASTNode* node, Liveness* lv) {
+    switch (node->node_type) {
+        case AST_ID:
+            accessVar(lv, node->id);
+            return;
+        case AST_ID_DECL_ASSIGN:
+            // The variable starts once its value is computed, so it can take the slot of a variable that the value
+            // reads for the last time
+            collectRanges(node->right, lv);
+            declareVar(lv, node->left->id);
+            return;
+        case AST_ID_DECLARATION:
+            // Without a value the variable keeps what its slot held
+            lv->supported = false;
+            return;
+        case AST_WHILE:
+        case AST_DO_WHILE: {
+            // The variables declared before the loop and accessed in it are live during all of its iterations
+            const unsigned int first = lv->count;
+            const unsigned int start = ++lv->position;
+            collectRanges(node->left, lv);
+            collectRanges(node->right, lv);
+            const unsigned int end = ++lv->position;
+            for (unsigned int r = 0; r < first; r++) {
+                if (lv->ranges[r].end >= start) {
+                    lv->ranges[r].end = end;
+                }
+            }
+            return;
+        }
+        default:
+            break;
+    }
+
+    switch (getNodeOpType(node->node_type)) {
+        case ZEROARY_OP:
+            break;
+        case UNARY_OP:
+            collectRanges(node->child, lv);
+            break;
+        case BINARY_OP:
+            collectRanges(node->left, lv);
+            collectRanges(node->right, lv);
+            break;
+        case TERNARY_OP:
+            collectRanges(node->first, lv);
+            collectRanges(node->second, lv);
+            collectRanges(node->third, lv);
+            break;
+        case N_ARY_OP:
+            for (unsigned int i = 0; i < node->stmt_count; i++) {
+                collectRanges(node->stmts[i], lv);
+            }
+            break;
+        default:
+            assert(false);
+    }
+}
+
+static int compareSymbols(const void* a, const void* b) {
+    const Symbol* l = *(Symbol* const*) a;
+    const Symbol* r = *(Symbol* const*) b;
+    return (l > r) - (l < r);
+}
+
+// Whether each variable of the symbol table is declared exactly once in the AST
+static bool declaresEachVarOnce(const Liveness* lv, const SymbolTable* st) {
+    if (lv->count != getTotalSymbolAmount(st)) {
+        return false;
+    }
+
+    Symbol** vars = malloc(lv->count * sizeof(Symbol*));
+    assert(vars != NULL);
+    for (unsigned int r = 0; r < lv->count; r++) {
+        vars[r] = lv->ranges[r].var;
+    }
+    qsort(vars, lv->count, sizeof(Symbol*), compareSymbols);
+    bool once = true;
+    for (unsigned int r = 1; r < lv->count && once; r++) {
+        once = vars[r - 1] != vars[r];
+    }
+    free(vars);
+    return once;
+}
+
+// The slot locals of the backends are only typed for the scalars
+static inline bool canShareSlot(const Symbol* var) {
+    return getVarType(var) == AST_TYPE_INT || getVarType(var) == AST_TYPE_BOOL;
+}
+
+// Slot taken by a live range, ordered by its end
+typedef struct ActiveSlot {
+    unsigned int end;
+    unsigned int slot;
+    ASTType type;
+} ActiveSlot;
+
+typedef struct ActiveSlots {
+    ActiveSlot* heap;
+    unsigned int count;
+} ActiveSlots;
+
+static void pushActiveSlot(ActiveSlots* active, ActiveSlot slot) {
+    unsigned int i = active->count++;
+    while (i > 0 && active->heap[(i - 1) / 2].end > slot.end) {
+        active->heap[i] = active->heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    active->heap[i] = slot;
+}
+
+static ActiveSlot popActiveSlot(ActiveSlots* active) {
+    assert(active->count > 0);
+    ActiveSlot top = active->heap[0];
+    ActiveSlot last = active->heap[--active->count];
+    unsigned int i = 0;
+    for (;;) {
+        unsigned int child = 2 * i + 1;
+        if (child >= active->count) {
+            break;
+        }
+        if (child + 1 < active->count && active->heap[child + 1].end < active->heap[child].end) {
+            child++;
+        }
+        if (active->heap[child].end >= last.end) {
+            break;
+        }
+        active->heap[i] = active->heap[child];
+        i = child;
+    }
+    active->heap[i] = last;
+    return top;
+}
+
+// Linear scan over the ranges by their start: a range takes a slot of its type whose range has already ended, or a
+// new slot. Returns the number of slots.
+static unsigned int colorRanges(const Liveness* lv, unsigned int* offsets) {
+    ActiveSlots active = { .heap = malloc(lv->count * sizeof(ActiveSlot)), .count = 0 };
+    unsigned int* free_slots[AST_TYPE_COUNT];
+    unsigned int free_counts[AST_TYPE_COUNT] = { 0 };
+    for (unsigned int t = 0; t < AST_TYPE_COUNT; t++) {
+        free_slots[t] = malloc(lv->count * sizeof(unsigned int));
+        assert(free_slots[t] != NULL);
+    }
+    assert(active.heap != NULL);
+
+    unsigned int slot_count = 0;
+    for (unsigned int r = 0; r < lv->count; r++) {
+        const LiveRange* range = &lv->ranges[r];
+        while (active.count > 0 && active.heap[0].end < range->start) {
+            ActiveSlot ended = popActiveSlot(&active);
+            free_slots[ended.type][free_counts[ended.type]++] = ended.slot;
+        }
+
+        const ASTType type = getVarType(range->var);
+        offsets[r] = free_counts[type] > 0 ? free_slots[type][--free_counts[type]] : slot_count++;
+        pushActiveSlot(&active, (ActiveSlot){ .end = range->end, .slot = offsets[r], .type = type });
+    }
+
+    for (unsigned int t = 0; t < AST_TYPE_COUNT; t++) {
+        free(free_slots[t]);
+    }
+    free(active.heap);
+    return slot_count;
+}
+
+// The ID nodes keep the slot of their var inline, so they have to follow the new layout
+static void updateIDSlots(ASTNode* node) {
+    switch (getNodeOpType(node->node_type)) {
+        case ZEROARY_OP:
+            if (node->node_type == AST_ID) {
+                node->slot = getVarOffset(node->id);
+            }
+            break;
+        case UNARY_OP:
+            updateIDSlots((ASTNode*) node->child);
+            break;
+        case BINARY_OP:
+            updateIDSlots((ASTNode*) node->left);
+            updateIDSlots((ASTNode*) node->right);
+            break;
+        case TERNARY_OP:
+            updateIDSlots(node->first);
+            updateIDSlots(node->second);
+            updateIDSlots(node->third);
+            break;
+        case N_ARY_OP:
+            for (unsigned int i = 0; i < node->stmt_count; i++) {
+                updateIDSlots((ASTNode*) node->stmts[i]);
+            }
+            break;
+        default:
+            assert(false);
+    }
+}
+
+bool assignFrameSlots(const ASTNode* ast, SymbolTable* st) {
+    assert(ast != NULL && st != NULL);
+
+    if (getTotalSymbolAmount(st) == 0) {
+        return false;
+    }
+
+    Liveness lv = { .ranges = NULL, .count = 0, .capacity = 0, .slot_count = getMaxOffset(st) + 1, .position = 0, .supported = true };
+    lv.current = malloc(lv.slot_count * sizeof(unsigned int));
+    assert(lv.current != NULL);
+    for (unsigned int i = 0; i < lv.slot_count; i++) {
+        lv.current[i] = NO_RANGE;
+    }
+    collectRanges(ast, &lv);
+    free(lv.current);
+
+    bool assigned = false;
+    if (lv.supported && declaresEachVarOnce(&lv, st)) {
+        // The variables of the outermost scope are the state that the program leaves
+        for (unsigned int r = 0; r < lv.count; r++) {
+            if (isGlobalVar(lv.ranges[r].var) || !canShareSlot(lv.ranges[r].var)) {
+                lv.ranges[r].end = UINT_MAX;
+            }
+        }
+
+        unsigned int* offsets = malloc(lv.count * sizeof(unsigned int));
+        Symbol** vars = malloc(lv.count * sizeof(Symbol*));
+        assert(offsets != NULL && vars != NULL);
+        // The layout of the scopes is kept when it is already as small
+        if (colorRanges(&lv, offsets) < getMaxOffset(st) + 1) {
+            for (unsigned int r = 0; r < lv.count; r++) {
+                vars[r] = lv.ranges[r].var;
+            }
+            assignVarSlots(st, vars, offsets, lv.count);
+            updateIDSlots((ASTNode*) ast);
+            assigned = true;
+        }
+        free(vars);
+        free(offsets);
+    }
+
+    free(lv.ranges);
+    return assigned;
+}
@@ -1,16 +1,27 @@
 #include "symbol.h"
 
 #include <assert.h>
+#include <stdio.h>
 #include <string.h>
+#include <stdint.h>
+
+#include "atom.h"
+#include "alloc.h"
 
 #define DEFAULT_TABLE_INITIAL_CAPACITY 5
 #define DEFAULT_SCOPE_INITIAL_CAPACITY 10
+#define INITIAL_BINDINGS_CAPACITY 16 // Must be a power of 2
+#define SCOPE_INDEX_MIN_SIZE 8 // Smaller scopes are scanned
 
 typedef struct Symbol {
-    char id[MAX_ID_SIZE];
+    Atom id;
     ASTType type;
     unsigned int offset;
+    unsigned int index;      // Position in its scope, as the offset stops following it once the slots are assigned
     unsigned int redef_level;
+    bool shares_slot;
+    const struct Scope* scope;
+    struct Symbol* shadowed; // Definition of the same id hidden by this one
 } Symbol;
 
 typedef struct Scope {
@@ -20,8 +31,16 @@ typedef struct Scope {
     unsigned int capacity;
     unsigned int offset;
     Symbol** variables;
+    Symbol** id_index; // Open addressing, keyed by atom, once the scope has SCOPE_INDEX_MIN_SIZE variables
+    unsigned int id_index_capacity;
 } Scope;
 
+// Innermost visible definition of an id. Entries are never removed, their symbol becomes NULL instead.
+typedef struct Binding {
+    Atom id;
+    Symbol* symbol;
+} Binding;
+
 typedef struct SymbolTable {
     Scope** scopes;
     unsigned int size;
@@ -29,19 +48,37 @@ typedef struct SymbolTable {
     Scope* current_scope;
     unsigned int max_offset;
     unsigned int total_symbol_amount;
+    Binding* bindings; // Open addressing, keyed by atom
+    unsigned int bindings_size;
+    unsigned int bindings_capacity;
+    Symbol** offset_index; // Last defined symbol of each frame slot
+    unsigned int offset_index_capacity;
+    Scope* temp_scope; // Last scope of the temporaries, which has no parent and is never current
+    bool slots_assigned; // The offsets no longer follow the scopes, so only temporaries can be defined
 } SymbolTable;
 
-#define newScope() malloc(sizeof(Scope))
+static inline Scope* newScope() {
+    countASTAlloc(AST_ALLOC_SCOPE, 1, sizeof(Scope));
+    return malloc(sizeof(Scope));
+}
+
+static inline Symbol* newSymbol() {
+    countASTAlloc(AST_ALLOC_SYMBOL, 1, sizeof(Symbol));
+    return malloc(sizeof(Symbol));
+}
 
 static Scope* initScope(Scope* scope, unsigned int index, const Scope* parent, unsigned int initial_capacity, unsigned int offset) {
     assert(scope != NULL);
     scope->index = index;
     scope->variables = malloc(initial_capacity * sizeof(Symbol*));
     assert(scope->variables != NULL);
+    countASTAlloc(AST_ALLOC_SCOPE, 0, initial_capacity * sizeof(Symbol*));
     scope->capacity = initial_capacity;
     scope->size = 0;
     scope->parent = parent;
     scope->offset = offset;
+    scope->id_index = NULL;
+    scope->id_index_capacity = 0;
     return scope;
 }
 
@@ -53,6 +90,7 @@ static void deleteScope(Scope** scope) {
         free((*scope)->variables[i]);
     }
     free((*scope)->variables);
+    free((*scope)->id_index);
 
     free(*scope);
     *scope = NULL;
@@ -60,6 +98,7 @@ static void deleteScope(Scope** scope) {
 
 static inline void resizeScopeIfNeeded(Scope* scope) {
     if (scope->size == scope->capacity) {
+        countASTAlloc(AST_ALLOC_SCOPE, 0, (scope->capacity + 1) * sizeof(Symbol*));
         scope->capacity *= 2;
         scope->capacity++;
         scope->variables = realloc(scope->variables, scope->capacity * sizeof(Symbol*));
@@ -67,6 +106,129 @@ static inline void resizeScopeIfNeeded(Scope* scope) {
     }
 }
 
+static inline unsigned int hashAtom(Atom id) {
+    return (unsigned int) (((uintptr_t) id >> 3) * 2654435761u);
+}
+
+// Returns the binding of the id, or the empty entry where it would be inserted
+static inline Binding* findBinding(Binding* bindings, unsigned int capacity, Atom id) {
+    unsigned int mask = capacity - 1;
+    unsigned int i = hashAtom(id) & mask;
+    while (bindings[i].id != NULL && bindings[i].id != id) {
+        i = (i + 1) & mask;
+    }
+    return &bindings[i];
+}
+
+// Returns the variable of the scope with the id, or the empty entry where it would be inserted
+static inline Symbol** findInScopeIndex(Symbol** index, unsigned int capacity, Atom id) {
+    unsigned int mask = capacity - 1;
+    unsigned int i = hashAtom(id) & mask;
+    while (index[i] != NULL && index[i]->id != id) {
+        i = (i + 1) & mask;
+    }
+    return &index[i];
+}
+
+static void rebuildScopeIndex(Scope* scope) {
+    unsigned int capacity = INITIAL_BINDINGS_CAPACITY;
+    while (capacity < 4 * scope->size) {
+        capacity *= 2;
+    }
+
+    free(scope->id_index);
+    scope->id_index = calloc(capacity, sizeof(Symbol*));
+    assert(scope->id_index != NULL);
+    countASTAlloc(AST_ALLOC_SCOPE, 0, capacity * sizeof(Symbol*));
+    scope->id_index_capacity = capacity;
+
+    for (unsigned int i = 0; i < scope->size; i++) {
+        Symbol** entry = findInScopeIndex(scope->id_index, capacity, scope->variables[i]->id);
+        if (*entry == NULL) {
+            *entry = scope->variables[i];
+        }
+    }
+}
+
+// Called once var is the last variable of the scope
+static void indexVarInScope(Scope* scope, Symbol* var) {
+    // Keep the load factor under 1/2
+    if (scope->id_index == NULL || 2 * scope->size > scope->id_index_capacity) {
+        if (scope->size >= SCOPE_INDEX_MIN_SIZE) {
+            rebuildScopeIndex(scope);
+        }
+        return;
+    }
+
+    Symbol** entry = findInScopeIndex(scope->id_index, scope->id_index_capacity, var->id);
+    if (*entry == NULL) {
+        *entry = var;
+    }
+}
+
+static void initBindings(SymbolTable* st, unsigned int capacity) {
+    st->bindings = calloc(capacity, sizeof(Binding));
+    assert(st->bindings != NULL);
+    st->bindings_capacity = capacity;
+    st->bindings_size = 0;
+}
+
+static void resizeBindingsIfNeeded(SymbolTable* st) {
+    // Keep the load factor under 1/2
+    if (2 * (st->bindings_size + 1) <= st->bindings_capacity) {
+        return;
+    }
+
+    Binding* old_bindings = st->bindings;
+    unsigned int old_capacity = st->bindings_capacity;
+    initBindings(st, 2 * old_capacity);
+
+    for (unsigned int i = 0; i < old_capacity; i++) {
+        if (old_bindings[i].id != NULL) {
+            *findBinding(st->bindings, st->bindings_capacity, old_bindings[i].id) = old_bindings[i];
+            st->bindings_size++;
+        }
+    }
+    free(old_bindings);
+}
+
+// Makes var the visible definition of its id, hiding the previous one until its scope is left
+static void bindVar(SymbolTable* st, Symbol* var) {
+    resizeBindingsIfNeeded(st);
+
+    Binding* binding = findBinding(st->bindings, st->bindings_capacity, var->id);
+    if (binding->id == NULL) {
+        binding->id = var->id;
+        binding->symbol = NULL;
+        st->bindings_size++;
+    }
+    var->shadowed = binding->symbol;
+    binding->symbol = var;
+}
+
+static void unbindScope(SymbolTable* st, const Scope* scope) {
+    for (int i = scope->size - 1; i >= 0; i--) {
+        Symbol* var = scope->variables[i];
+        Binding* binding = findBinding(st->bindings, st->bindings_capacity, var->id);
+        assert(binding->symbol == var);
+        binding->symbol = var->shadowed;
+    }
+}
+
+static void indexVarOffset(SymbolTable* st, Symbol* var) {
+    if (var->offset >= st->offset_index_capacity) {
+        unsigned int capacity = 2 * st->offset_index_capacity + 1;
+        if (capacity <= var->offset) {
+            capacity = var->offset + 1;
+        }
+        st->offset_index = realloc(st->offset_index, capacity * sizeof(Symbol*));
+        assert(st->offset_index != NULL);
+        memset(st->offset_index + st->offset_index_capacity, 0, (capacity - st->offset_index_capacity) * sizeof(Symbol*));
+        st->offset_index_capacity = capacity;
+    }
+    st->offset_index[var->offset] = var;
+}
+
 static Scope* insertNewScope(SymbolTable* st, unsigned int initial_capacity) {
     assert(st != NULL && initial_capacity > 0);
 
@@ -96,6 +258,14 @@ SymbolTable* newSymbolTable(unsigned int initial_table_capacity, unsigned int in
 
     st->total_symbol_amount = 0;
 
+    initBindings(st, INITIAL_BINDINGS_CAPACITY);
+
+    st->offset_index = NULL;
+    st->offset_index_capacity = 0;
+
+    st->temp_scope = NULL;
+    st->slots_assigned = false;
+
     assert(st->current_scope != NULL);
     return st;
 }
@@ -116,26 +286,41 @@ SymbolTable* newSymbolTableClone(const SymbolTable* src_st) {
     clone_st->max_offset = src_st->max_offset;
     clone_st->current_scope = NULL;
     clone_st->total_symbol_amount = src_st->total_symbol_amount;
+    clone_st->temp_scope = NULL;
+    clone_st->slots_assigned = src_st->slots_assigned;
 
     for (unsigned int i = 0; i < src_st->size; i++) {
         Scope* src_scope = src_st->scopes[i];
-        Scope* clone_scope = malloc(sizeof(Scope));
+        Scope* clone_scope = newScope();
         assert(clone_scope != NULL);
         clone_st->scopes[i] = clone_scope;
 
         if (src_scope == src_st->current_scope) {
             clone_st->current_scope = clone_scope;
         }
+        if (src_scope == src_st->temp_scope) {
+            clone_st->temp_scope = clone_scope;
+        }
 
         clone_scope->variables = malloc(src_scope->capacity * sizeof(Symbol*));
         assert(clone_scope->variables != NULL);
+        countASTAlloc(AST_ALLOC_SCOPE, 0, src_scope->capacity * sizeof(Symbol*));
         clone_scope->capacity = src_scope->capacity;
         clone_scope->size = src_scope->size;
+        clone_scope->index = src_scope->index;
+        clone_scope->offset = src_scope->offset;
 
         for (unsigned int j = 0; j < clone_scope->size; j++) {
-            clone_scope->variables[j] = malloc(sizeof(Symbol));
+            clone_scope->variables[j] = newSymbol();
             assert(clone_scope->variables[j] != NULL);
             memcpy(clone_scope->variables[j], src_scope->variables[j], sizeof(Symbol));
+            clone_scope->variables[j]->scope = clone_scope;
+            clone_scope->variables[j]->shadowed = NULL;
+        }
+        clone_scope->id_index = NULL;
+        clone_scope->id_index_capacity = 0;
+        if (clone_scope->size >= SCOPE_INDEX_MIN_SIZE) {
+            rebuildScopeIndex(clone_scope);
         }
 
         if (src_scope->parent == NULL) {
@@ -149,6 +334,35 @@ SymbolTable* newSymbolTableClone(const SymbolTable* src_st) {
     }
 
     assert(clone_st->current_scope != NULL);
+
+    // Rebind the variables visible from the current scope, from the outermost scope inwards
+    initBindings(clone_st, src_st->bindings_capacity);
+    const Scope** chain = malloc(clone_st->size * sizeof(Scope*));
+    assert(chain != NULL);
+    unsigned int depth = 0;
+    for (const Scope* scope = clone_st->current_scope; scope != NULL; scope = scope->parent) {
+        chain[depth++] = scope;
+    }
+    while (depth > 0) {
+        const Scope* scope = chain[--depth];
+        for (unsigned int j = 0; j < scope->size; j++) {
+            bindVar(clone_st, scope->variables[j]);
+        }
+    }
+    free(chain);
+
+    // Each symbol is found in the clone by its scope and its position there
+    clone_st->offset_index = calloc(src_st->offset_index_capacity, sizeof(Symbol*));
+    assert(src_st->offset_index_capacity == 0 || clone_st->offset_index != NULL);
+    clone_st->offset_index_capacity = src_st->offset_index_capacity;
+    for (unsigned int i = 0; i < src_st->offset_index_capacity; i++) {
+        const Symbol* var = src_st->offset_index[i];
+        if (var != NULL) {
+            const Scope* clone_scope = clone_st->scopes[var->scope->index];
+            clone_st->offset_index[i] = clone_scope->variables[var->index];
+        }
+    }
+
     return clone_st;
 }
 
@@ -161,6 +375,8 @@ void deleteSymbolTable(SymbolTable** st) {
         deleteScope(&s);
     }
     free((*st)->scopes);
+    free((*st)->bindings);
+    free((*st)->offset_index);
 
     free(*st);
     *st = NULL;
@@ -212,6 +428,7 @@ bool leaveScope(SymbolTable* st) {
     if(st->current_scope->parent == NULL) {
         return false;
     }
+    unbindScope(st, st->current_scope);
     st->current_scope = (Scope*)st->current_scope->parent;
     return true;
 }
@@ -245,14 +462,16 @@ unsigned int getScopeIndex(const Scope* scope) {
     return scope->index;
 }
 
-Symbol* newSymbol() { return malloc(sizeof(Symbol)); }
-
 Symbol* initSymbol(Symbol* var, ASTType type, const char* id, unsigned int redef_level) {
     assert(var != NULL);
     var->type = type;
-    strncpy(var->id, id, MAX_ID_SIZE);
+    var->id = internAtom(id, MAX_ID_SIZE);
     var->offset = 0;
+    var->index = 0;
     var->redef_level = redef_level;
+    var->shares_slot = false;
+    var->scope = NULL;
+    var->shadowed = NULL;
     return var;
 }
 
@@ -260,9 +479,17 @@ Symbol* lookupVarInScope(const Scope* scope, const char* id) {
     assert(scope != NULL);
     assert(id != NULL);
 
+    Atom atom = findAtom(id, MAX_ID_SIZE);
+    if (atom == NULL) {
+        return NULL;
+    }
+
+    if (scope->id_index != NULL) {
+        return *findInScopeIndex(scope->id_index, scope->id_index_capacity, atom);
+    }
     for (unsigned int i = 0; i < scope->size; i++) {
         Symbol* var = scope->variables[i];
-        if (strncmp(var->id, id, MAX_ID_SIZE) == 0) {
+        if (var->id == atom) {
             return var;
         }
     }
@@ -277,16 +504,15 @@ struct SymbolScopePair lookupVarWithScope(const SymbolTable* st, const char* id)
     assert(st != NULL);
     assert(id != NULL);
 
-    Scope* current_scope = st->current_scope;
-    while (current_scope != NULL) {
-        Symbol* var = lookupVarInScope(current_scope, id);
+    Atom atom = findAtom(id, MAX_ID_SIZE);
+    if (atom != NULL) {
+        Symbol* var = findBinding(st->bindings, st->bindings_capacity, atom)->symbol;
         if (var != NULL) {
             return (struct SymbolScopePair){
                 .symbol = var,
-                .scope = current_scope,
+                .scope = (Scope*)var->scope,
             };
         }
-        current_scope = (Scope*)current_scope->parent;
     }
     return (struct SymbolScopePair){
         .symbol = NULL,
@@ -303,29 +529,25 @@ Symbol* lookupVar(const SymbolTable* st, const char* id) {
 Symbol* lookupLastVarWithOffset(const SymbolTable *st, unsigned int var_offset) {
     assert(st != NULL);
 
-    for (int i = st->size - 1; i >= 0; i--) {
-        Scope* current_scope = st->scopes[i];
-        if (current_scope->offset <= var_offset) {
-            for (unsigned int j = 0; j < current_scope->size; j++) {
-                Symbol* var = current_scope->variables[j];
-                if (getVarOffset(var) == var_offset) {
-                    return var;
-                }
-            }
-        }
+    if (var_offset >= st->offset_index_capacity) {
+        return NULL;
     }
-    return NULL;
+    return st->offset_index[var_offset];
 }
 
-static Symbol* insertVarInCurrentScope(SymbolTable* st, ASTType type, const char* id, unsigned int redef_level) {
+static Symbol* insertVarInScope(SymbolTable* st, Scope* scope, ASTType type, const char* id, unsigned int redef_level) {
     Symbol* var = initSymbol(newSymbol(), type, id, redef_level);
 
-    resizeScopeIfNeeded(st->current_scope);
+    resizeScopeIfNeeded(scope);
 
-    unsigned int index = st->current_scope->size++;
-    st->current_scope->variables[index] = var;
+    unsigned int index = scope->size++;
+    scope->variables[index] = var;
+    var->scope = scope;
+    var->index = index;
+    indexVarInScope(scope, var);
 
-    var->offset = st->current_scope->offset + index;
+    var->offset = scope->offset + index;
+    indexVarOffset(st, var);
 
     unsigned int current_offset = getVarOffset(var);
     if (current_offset > st->max_offset) {
@@ -337,6 +559,13 @@ static Symbol* insertVarInCurrentScope(SymbolTable* st, ASTType type, const char
     return var;
 }
 
+static Symbol* insertVarInCurrentScope(SymbolTable* st, ASTType type, const char* id, unsigned int redef_level) {
+    assert(!st->slots_assigned);
+    Symbol* var = insertVarInScope(st, st->current_scope, type, id, redef_level);
+    bindVar(st, var);
+    return var;
+}
+
 ASTResult defineVar(SymbolTable* st, ASTType type, const char* id, bool redef) {
     assert(st != NULL);
     assert(id != NULL);
@@ -359,6 +588,61 @@ ASTResult defineVar(SymbolTable* st, ASTType type, const char* id, bool redef) {
     }
 }
 
+Symbol* defineTempVar(SymbolTable* st, ASTType type) {
+    assert(st != NULL);
+
+    // The temporaries take the slots after the last one in use, so a new scope is started once the program has
+    // defined variables past the ones of the last scope
+    Scope* scope = st->temp_scope;
+    if (scope == NULL || scope->offset + scope->size != st->max_offset + 1) {
+        resizeTableIfNeeded(st);
+        unsigned int offset = st->total_symbol_amount > 0 ? st->max_offset + 1 : 0;
+        scope = initScope(newScope(), st->size, NULL, DEFAULT_SCOPE_INITIAL_CAPACITY, offset);
+        st->scopes[st->size++] = scope;
+        st->temp_scope = scope;
+    }
+
+    char id[MAX_ID_SIZE + 1];
+    snprintf(id, sizeof(id), "%s%u", TEMP_VAR_PREFIX, scope->offset + scope->size);
+    return insertVarInScope(st, scope, type, id, 0);
+}
+
+bool isTempVar(const Symbol* var) {
+    assert(var != NULL);
+    return var->scope->parent == NULL && var->scope->index > 0;
+}
+
+bool isGlobalVar(const Symbol* var) {
+    assert(var != NULL);
+    return var->scope->index == 0;
+}
+
+void assignVarSlots(SymbolTable* st, Symbol* const* vars, const unsigned int* offsets, unsigned int count) {
+    assert(st != NULL && (vars != NULL || count == 0) && (offsets != NULL || count == 0));
+    assert(count == st->total_symbol_amount);
+
+    if (st->offset_index != NULL) {
+        memset(st->offset_index, 0, st->offset_index_capacity * sizeof(Symbol*));
+    }
+    st->max_offset = 0;
+    for (unsigned int i = 0; i < count; i++) {
+        Symbol* var = vars[i];
+        Symbol* prev = lookupLastVarWithOffset(st, offsets[i]);
+        var->offset = offsets[i];
+        var->shares_slot = prev != NULL;
+        if (prev != NULL) {
+            prev->shares_slot = true;
+        }
+        indexVarOffset(st, var);
+        if (var->offset > st->max_offset) {
+            st->max_offset = var->offset;
+        }
+    }
+    // The next temporaries start a new scope after the last slot
+    st->temp_scope = NULL;
+    st->slots_assigned = true;
+}
+
 ASTResult getVarReference(const SymbolTable* st, const char* id) {
     assert(st != NULL);
     assert(id != NULL);
@@ -390,6 +674,11 @@ unsigned int getVarOffset(const Symbol* var) {
     return var->offset;
 }
 
+bool isVarSlotShared(const Symbol* var) {
+    assert(var != NULL);
+    return var->shares_slot;
+}
+
 unsigned int getVarRedefLevel(const Symbol* var) {
     assert(var != NULL);
     return var->redef_level;
@@ -0,0 +1,77 @@
+#include <unity.h>
+
+#include "ast.h"
+#include "arena.h"
+#include "alloc_stats.h"
+
+#include "test_utils.h"
+
+void setUp (void) {
+    resetASTAllocStats();
+}
+
+void tearDown (void) {
+    setCurrentASTArena(NULL);
+}
+
+#define counter(stats, kind) (stats).counters[kind]
+
+void resetClearsTheCounters() {
+    ASTNode* node = newASTInt(1);
+    resetASTAllocStats();
+
+    ASTAllocStats stats = getASTAllocStats();
+    for (ASTAllocKind k = 0; k < AST_ALLOC_KINDS_COUNT; k++) {
+        TEST_ASSERT_EQUAL_UINT(0, counter(stats, k).count);
+        TEST_ASSERT_EQUAL_UINT(0, counter(stats, k).bytes);
+    }
+    deleteASTNode(&node);
+}
+
+void nodesAreCountedWithAndWithoutArena() {
+    ASTNode* heap = newASTAdd(newASTInt(1), newASTInt(2)).result_value;
+
+    ASTArena* arena = newASTArenaDefault();
+    setCurrentASTArena(arena);
+    ASTNode* in_arena = newASTInt(3);
+    setCurrentASTArena(NULL);
+
+    ASTAllocStats stats = getASTAllocStats();
+    TEST_ASSERT_EQUAL_UINT(4, counter(stats, AST_ALLOC_NODE).count);
+    TEST_ASSERT_EQUAL_UINT(4 * sizeof(ASTNode), counter(stats, AST_ALLOC_NODE).bytes);
+
+    deleteASTNode(&in_arena);
+    deleteASTArena(&arena);
+    deleteASTNode(&heap);
+}
+
+void symbolsAndScopesAreCounted() {
+    SymbolTable* st = newSymbolTableDefault();
+    defineVar(st, AST_TYPE_INT, "x", false);
+    enterScopeDefault(st);
+    defineVar(st, AST_TYPE_INT, "y", false);
+    defineVar(st, AST_TYPE_BOOL, "z", false);
+    leaveScope(st);
+
+    ASTAllocStats stats = getASTAllocStats();
+    TEST_ASSERT_EQUAL_UINT(3, counter(stats, AST_ALLOC_SYMBOL).count);
+    TEST_ASSERT_EQUAL_UINT(2, counter(stats, AST_ALLOC_SCOPE).count);
+    TEST_ASSERT_TRUE(counter(stats, AST_ALLOC_SCOPE).bytes > 0);
+
+    // A clone allocates its own copies
+    SymbolTable* clone = newSymbolTableClone(st);
+    ASTAllocStats after = getASTAllocStats();
+    TEST_ASSERT_EQUAL_UINT(2 * counter(stats, AST_ALLOC_SYMBOL).count, counter(after, AST_ALLOC_SYMBOL).count);
+    TEST_ASSERT_EQUAL_UINT(2 * counter(stats, AST_ALLOC_SCOPE).count, counter(after, AST_ALLOC_SCOPE).count);
+
+    deleteSymbolTable(&clone);
+    deleteSymbolTable(&st);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(resetClearsTheCounters);
+    RUN_TEST(nodesAreCountedWithAndWithoutArena);
+    RUN_TEST(symbolsAndScopesAreCounted);
+    return UNITY_END();
+}
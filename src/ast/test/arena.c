@@ -0,0 +1,88 @@
+#include <unity.h>
+
+#include <stdint.h>
+
+#include "ast.h"
+#include "arena.h"
+
+#include "test_utils.h"
+
+static ASTArena* arena = NULL;
+
+void setUp (void) {
+    arena = newASTArena(4 * sizeof(ASTNode));
+}
+
+void tearDown (void) {
+    setCurrentASTArena(NULL);
+    deleteASTArena(&arena);
+}
+
+void deleteASTArenaSetsVarNull() {
+    ASTArena* a = newASTArenaDefault();
+    deleteASTArena(&a);
+    TEST_ASSERT_NULL(a);
+}
+
+void allocationsAreAlignedAndSequential() {
+    char* first = ASTArenaAlloc(arena, 1);
+    char* second = ASTArenaAlloc(arena, 1);
+
+    TEST_ASSERT_EQUAL_INT(0, (uintptr_t) first % _Alignof(ASTNode));
+    TEST_ASSERT_EQUAL_INT(0, (uintptr_t) second % _Alignof(ASTNode));
+    TEST_ASSERT_EQUAL_PTR(first + _Alignof(ASTNode), second);
+    TEST_ASSERT_EQUAL_UINT(1, getASTArenaChunkCount(arena));
+}
+
+void chunksGrowGeometrically() {
+    for (int i = 0; i < 4; i++) {
+        ASTArenaAlloc(arena, sizeof(ASTNode));
+    }
+    TEST_ASSERT_EQUAL_UINT(1, getASTArenaChunkCount(arena));
+
+    // The second chunk holds twice as many nodes as the first one
+    for (int i = 0; i < 8; i++) {
+        ASTArenaAlloc(arena, sizeof(ASTNode));
+    }
+    TEST_ASSERT_EQUAL_UINT(2, getASTArenaChunkCount(arena));
+
+    ASTArenaAlloc(arena, sizeof(ASTNode));
+    TEST_ASSERT_EQUAL_UINT(3, getASTArenaChunkCount(arena));
+
+    // Requests larger than a chunk get their own
+    ASTArenaAlloc(arena, 1024 * sizeof(ASTNode));
+    TEST_ASSERT_EQUAL_UINT(4, getASTArenaChunkCount(arena));
+}
+
+void nodesAreAllocatedFromTheCurrentArena() {
+    TEST_ASSERT_NULL(setCurrentASTArena(arena));
+    TEST_ASSERT_EQUAL_PTR(arena, getCurrentASTArena());
+
+    ASTNode* left = newASTInt(1);
+    ASTNode* right = newASTInt(2);
+    ASTNode* ast = newASTAdd(left, right).result_value;
+
+    TEST_ASSERT_TRUE(ast->in_arena);
+    TEST_ASSERT_EQUAL_PTR(left + 1, right);
+    TEST_ASSERT_EQUAL_PTR(right + 1, ast);
+    TEST_ASSERT_EQUAL_UINT(3 * sizeof(ASTNode), getASTArenaUsedBytes(arena));
+
+    // Arena nodes are only released with the arena
+    deleteASTNode(&ast);
+    TEST_ASSERT_NULL(ast);
+
+    TEST_ASSERT_EQUAL_PTR(arena, setCurrentASTArena(NULL));
+
+    ASTNode* heap = newASTInt(3);
+    TEST_ASSERT_FALSE(heap->in_arena);
+    deleteASTNode(&heap);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(deleteASTArenaSetsVarNull);
+    RUN_TEST(allocationsAreAlignedAndSequential);
+    RUN_TEST(chunksGrowGeometrically);
+    RUN_TEST(nodesAreAllocatedFromTheCurrentArena);
+    return UNITY_END();
+}
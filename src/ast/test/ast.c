@@ -81,6 +81,25 @@ void testEqualASTBinary() {
     ASSERT_NOT_EQUAL_AST(ast1, ast2);
 }
 
+void testHasSideEffects() {
+    SymbolTable* st = newSymbolTableDefault();
+    Symbol* var = defineVar(st, AST_TYPE_INT, "x", false).result_value;
+
+    ASTNode* ast = newASTAdd(newASTID(var), newASTInt(1)).result_value;
+    TEST_ASSERT_FALSE(hasSideEffects(ast));
+    deleteASTNode(&ast);
+
+    ast = newASTAdd(newASTInt(1), newASTAssignment(newASTID(var), newASTInt(1)).result_value).result_value;
+    TEST_ASSERT_TRUE(hasSideEffects(ast));
+    deleteASTNode(&ast);
+
+    ast = newASTTernaryCond(newASTBool(true), newASTInt(1), newASTInc(newASTID(var), false).result_value).result_value;
+    TEST_ASSERT_TRUE(hasSideEffects(ast));
+    deleteASTNode(&ast);
+
+    deleteSymbolTable(&st);
+}
+
 int main() {
     UNITY_BEGIN();
     RUN_TEST(thereIsNoUnknownOperator);
@@ -91,5 +110,6 @@ int main() {
     RUN_TEST(testEqualASTLeafs);
     RUN_TEST(testEqualASTUnary);
     RUN_TEST(testEqualASTBinary);
+    RUN_TEST(testHasSideEffects);
     return UNITY_END();
 }
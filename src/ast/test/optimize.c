@@ -0,0 +1,237 @@
+#include <unity.h>
+
+#include <limits.h>
+
+#include "ast.h"
+#include "optimize.h"
+
+#include "test_utils.h"
+
+static SymbolTable* st = NULL;
+static Symbol* x = NULL;
+static Symbol* z = NULL;
+
+void setUp (void) {
+    st = newSymbolTableDefault();
+    x = defineVar(st, AST_TYPE_INT, "x", false).result_value;
+    z = defineVar(st, AST_TYPE_BOOL, "z", false).result_value;
+}
+
+void tearDown (void) {
+    deleteSymbolTable(&st);
+}
+
+#define ASSERT_FOLDS_TO(ast, expected) do {\
+    ASTNode* folded_ = ast;\
+    optimizeAST(&folded_, st, AST_OPT_CONSTANT_FOLDING);\
+    ASSERT_EQUAL_AST(folded_, expected);\
+} while (0)
+
+void foldArithmetic() {
+    // (2 + 3) * -4
+    ASTNode* ast = newASTMul(newASTAdd(newASTInt(2), newASTInt(3)).result_value, newASTUSub(newASTInt(4)).result_value).result_value;
+    ASSERT_FOLDS_TO(ast, newASTInt(-20));
+
+    ASSERT_FOLDS_TO(newASTLogicalNot(newASTCmpLT(newASTInt(1), newASTInt(2)).result_value).result_value, newASTBool(false));
+}
+
+void foldPreservesTraps() {
+    // Division by zero is left for the execution to report
+    ASSERT_FOLDS_TO(newASTDiv(newASTInt(1), newASTInt(0)).result_value, newASTDiv(newASTInt(1), newASTInt(0)).result_value);
+
+    // INT_MIN has no literal, so the overflowing sum stays as it is
+    ASSERT_FOLDS_TO(newASTAdd(newASTInt(INT_MAX), newASTInt(1)).result_value, newASTAdd(newASTInt(INT_MAX), newASTInt(1)).result_value);
+}
+
+void simplifyIdentities() {
+    ASSERT_FOLDS_TO(newASTAdd(newASTID(x), newASTInt(0)).result_value, newASTID(x));
+    ASSERT_FOLDS_TO(newASTMul(newASTInt(1), newASTID(x)).result_value, newASTID(x));
+    ASSERT_FOLDS_TO(newASTMul(newASTID(x), newASTInt(0)).result_value, newASTInt(0));
+    ASSERT_FOLDS_TO(newASTLogicalAnd(newASTBool(true), newASTID(z)).result_value, newASTID(z));
+
+    // The operand is still evaluated for its side effects
+    ASTNode* inc = newASTInc(newASTID(x), false).result_value;
+    ASSERT_FOLDS_TO(newASTMul(inc, newASTInt(0)).result_value,
+        newASTMul(newASTInc(newASTID(x), false).result_value, newASTInt(0)).result_value);
+}
+
+void foldCmpChain() {
+    // 1 < 2 < x
+    ASTNode* ast = newASTCmpLT(newASTCmpLT(newASTInt(1), newASTInt(2)).result_value, newASTID(x)).result_value;
+    ASSERT_FOLDS_TO(ast, newASTCmpLT(newASTInt(2), newASTID(x)).result_value);
+
+    // 2 < 1 < x
+    ast = newASTCmpLT(newASTCmpLT(newASTInt(2), newASTInt(1)).result_value, newASTID(x)).result_value;
+    ASSERT_FOLDS_TO(ast, newASTBool(false));
+}
+
+void foldConstantConditions() {
+    ASTNode* ast = newASTTernaryCond(newASTBool(false), newASTID(x), newASTInt(3)).result_value;
+    ASSERT_FOLDS_TO(ast, newASTInt(3));
+
+    ast = newASTIf(newASTCmpGT(newASTInt(1), newASTInt(2)).result_value, newASTAssignment(newASTID(x), newASTInt(1)).result_value).result_value;
+    ASSERT_FOLDS_TO(ast, newASTNoOp());
+
+    ast = newASTIfElse(newASTBool(true), newASTAssignment(newASTID(x), newASTInt(1)).result_value, newASTNoOp()).result_value;
+    ASSERT_FOLDS_TO(ast, newASTAssignment(newASTID(x), newASTInt(1)).result_value);
+
+    ast = newASTWhile(newASTBool(false), newASTScope(newASTInc(newASTID(x), false).result_value)).result_value;
+    ASSERT_FOLDS_TO(ast, newASTNoOp());
+}
+
+void foldKeepsCompoundAssignmentOperator() {
+    // x += 2 * 3
+    ASTNode* ast = newASTCompoundAssignment(AST_ADD, newASTID(x), newASTMul(newASTInt(2), newASTInt(3)).result_value).result_value;
+    ASSERT_FOLDS_TO(ast, newASTCompoundAssignment(AST_ADD, newASTID(x), newASTInt(6)).result_value);
+}
+
+static ASTNode* newDecl(Symbol* var, ASTNode* value) {
+    return newASTBinaryOP(AST_ID_DECL_ASSIGN, newASTID(var), value).result_value;
+}
+
+void hoistLoopInvariants() {
+    Symbol* n = defineVar(st, AST_TYPE_INT, "n", false).result_value;
+
+    // while (x < n * 4) { x += n / 2 + 8 / n; print(n * 4); }
+    ASTNode* cond = newASTCmpLT(newASTID(x), newASTMul(newASTID(n), newASTInt(4)).result_value).result_value;
+    ASTNode* sum = newASTAdd(newASTDiv(newASTID(n), newASTInt(2)).result_value, newASTDiv(newASTInt(8), newASTID(n)).result_value).result_value;
+    ASTNode* body = newASTStatementList(newASTCompoundAssignment(AST_ADD, newASTID(x), sum).result_value,
+        newASTPrint(newASTMul(newASTID(n), newASTInt(4)).result_value));
+    ASTNode* ast = newASTWhile(cond, newASTScope(body)).result_value;
+    optimizeAST(&ast, st, AST_OPT_LOOP_INVARIANTS);
+
+    // The same expressions share a temporary, and 8 / n is not evaluated before it is known that n is not 0
+    Symbol* t0 = lookupLastVarWithOffset(st, getVarOffset(n) + 1);
+    Symbol* t1 = lookupLastVarWithOffset(st, getVarOffset(n) + 2);
+    TEST_ASSERT_TRUE(isTempVar(t0) && isTempVar(t1));
+    TEST_ASSERT_EQUAL_INT(getVarOffset(t1), getMaxOffset(st));
+
+    // { _t0 = n * 4; _t1 = n / 2; while (x < _t0) { x += _t1 + 8 / n; print(_t0); } }
+    ASTNode* decls = newASTStatementList(newDecl(t0, newASTMul(newASTID(n), newASTInt(4)).result_value),
+        newDecl(t1, newASTDiv(newASTID(n), newASTInt(2)).result_value));
+    sum = newASTAdd(newASTID(t1), newASTDiv(newASTInt(8), newASTID(n)).result_value).result_value;
+    body = newASTStatementList(newASTCompoundAssignment(AST_ADD, newASTID(x), sum).result_value, newASTPrint(newASTID(t0)));
+    ASTNode* loop = newASTWhile(newASTCmpLT(newASTID(x), newASTID(t0)).result_value, newASTScope(body)).result_value;
+    ASSERT_EQUAL_AST(ast, newASTScope(newASTStatementList(decls, loop)));
+}
+
+// for (i = 0; i < 10; i++) { x += i * 8; }
+static ASTNode* newInductionLoop(Symbol* i, ASTNode* init, ASTNode* body) {
+    ASTNode* cond = newASTCmpLT(newASTID(i), newASTInt(10)).result_value;
+    return newASTFor(init, cond, newASTInc(newASTID(i), false).result_value, newASTScope(body)).result_value;
+}
+
+void reduceInductionProducts() {
+    Symbol* i = defineVar(st, AST_TYPE_INT, "i", false).result_value;
+
+    ASTNode* init = newASTAssignment(newASTID(i), newASTInt(0)).result_value;
+    ASTNode* product = newASTMul(newASTID(i), newASTInt(8)).result_value;
+    ASTNode* ast = newInductionLoop(i, init, newASTCompoundAssignment(AST_ADD, newASTID(x), product).result_value);
+    optimizeAST(&ast, st, AST_OPT_STRENGTH_REDUCTION);
+
+    Symbol* d = lookupLastVarWithOffset(st, getVarOffset(i) + 1);
+    TEST_ASSERT_TRUE(isTempVar(d));
+
+    // The derived variable starts from the init: { i = 0; _t = i * 8 - 8; for (; i < 10; i++) { _t += 8; x += _t; } }
+    ASTNode* start = newDecl(d, newASTWrapSub(newASTWrapMul(newASTID(i), newASTInt(8)).result_value, newASTInt(8)).result_value);
+    ASTNode* step = newASTAssignment(newASTID(d), newASTWrapAdd(newASTID(d), newASTInt(8)).result_value).result_value;
+    ASTNode* body = newASTStatementList(step, newASTCompoundAssignment(AST_ADD, newASTID(x), newASTID(d)).result_value);
+    init = newASTAssignment(newASTID(i), newASTInt(0)).result_value;
+    ASTNode* expected = newASTStatementList(newASTStatementList(init, start), newInductionLoop(i, newASTNoOp(), body));
+    ASSERT_EQUAL_AST(ast, newASTScope(expected));
+}
+
+void reduceProductsByIntMin() {
+    Symbol* i = defineVar(st, AST_TYPE_INT, "i", false).result_value;
+    Symbol* c = defineVar(st, AST_TYPE_INT, "c", false).result_value;
+
+    // for (i = 0; i < 10; i++) { x = x ^ i * c; }, with c == INT_MIN the loop computes 0 * c and 1 * c but not -c
+    ASTNode* init = newASTAssignment(newASTID(i), newASTInt(0)).result_value;
+    ASTNode* product = newASTMul(newASTID(i), newASTID(c)).result_value;
+    ASTNode* xor = newASTAssignment(newASTID(x), newASTBitwiseXor(newASTID(x), product).result_value).result_value;
+    ASTNode* ast = newInductionLoop(i, init, xor);
+    optimizeAST(&ast, st, AST_OPT_STRENGTH_REDUCTION);
+
+    // { i = 0; _t = i * c - c; for (; i < 10; i++) { _t += c; x = x ^ _t; } }, with wrapping arithmetic for _t
+    Symbol* d = lookupLastVarWithOffset(st, getVarOffset(c) + 1);
+    TEST_ASSERT_TRUE(isTempVar(d));
+    ASTNode* start = newDecl(d, newASTWrapSub(newASTWrapMul(newASTID(i), newASTID(c)).result_value, newASTID(c)).result_value);
+    ASTNode* step = newASTAssignment(newASTID(d), newASTWrapAdd(newASTID(d), newASTID(c)).result_value).result_value;
+    xor = newASTAssignment(newASTID(x), newASTBitwiseXor(newASTID(x), newASTID(d)).result_value).result_value;
+    init = newASTAssignment(newASTID(i), newASTInt(0)).result_value;
+    ASTNode* expected = newASTStatementList(newASTStatementList(init, start), newInductionLoop(i, newASTNoOp(), newASTStatementList(step, xor)));
+    ASSERT_EQUAL_AST(ast, newASTScope(expected));
+}
+
+// while (i < 10) { if (z) { continue; } x += i * 8; i++; }
+static ASTNode* newLoopWithContinue(Symbol* i) {
+    ASTNode* skip = newASTIf(newASTID(z), newASTScope(newASTContinue())).result_value;
+    ASTNode* add = newASTCompoundAssignment(AST_ADD, newASTID(x), newASTMul(newASTID(i), newASTInt(8)).result_value).result_value;
+    ASTNode* body = newASTStatementList(newASTStatementList(skip, add), newASTInc(newASTID(i), false).result_value);
+    return newASTWhile(newASTCmpLT(newASTID(i), newASTInt(10)).result_value, newASTScope(body)).result_value;
+}
+
+void keepProductsOfLoopWithContinue() {
+    Symbol* i = defineVar(st, AST_TYPE_INT, "i", false).result_value;
+
+    // The increment of i is skipped by the continue, so the products can not follow it
+    ASTNode* ast = newLoopWithContinue(i);
+    optimizeAST(&ast, st, AST_OPT_STRENGTH_REDUCTION);
+    ASSERT_EQUAL_AST(ast, newLoopWithContinue(i));
+    TEST_ASSERT_EQUAL_INT(getVarOffset(i), getMaxOffset(st));
+}
+
+void evaluateAccumulationInClosedForm() {
+    Symbol* i = defineVar(st, AST_TYPE_INT, "i", false).result_value;
+
+    // for (i = 0; i < 10; i++) { x += i; }
+    ASTNode* init = newASTAssignment(newASTID(i), newASTInt(0)).result_value;
+    ASTNode* ast = newInductionLoop(i, init, newASTCompoundAssignment(AST_ADD, newASTID(x), newASTID(i)).result_value);
+    optimizeAST(&ast, st, AST_OPT_CONSTANT_FOLDING | AST_OPT_SCALAR_EVOLUTION);
+
+    // { i = 0; { x += 45; i += 10; } }, with wrapping additions
+    ASTNode* values = newASTStatementList(
+        newASTAssignment(newASTID(x), newASTWrapAdd(newASTID(x), newASTInt(45)).result_value).result_value,
+        newASTAssignment(newASTID(i), newASTWrapAdd(newASTID(i), newASTInt(10)).result_value).result_value);
+    init = newASTAssignment(newASTID(i), newASTInt(0)).result_value;
+    ASSERT_EQUAL_AST(ast, newASTScope(newASTStatementList(init, newASTScope(values))));
+    TEST_ASSERT_EQUAL_INT(getVarOffset(i), getMaxOffset(st));
+}
+
+void keepLoopForBoundsOutOfClosedForm() {
+    Symbol* i = defineVar(st, AST_TYPE_INT, "i", false).result_value;
+
+    // while (i < x) { i += 2; } may wrap around past INT_MAX
+    ASTNode* update = newASTCompoundAssignment(AST_ADD, newASTID(i), newASTInt(2)).result_value;
+    ASTNode* ast = newASTWhile(newASTCmpLT(newASTID(i), newASTID(x)).result_value, newASTScope(update)).result_value;
+    optimizeAST(&ast, st, AST_OPT_SCALAR_EVOLUTION);
+
+    TEST_ASSERT_EQUAL_INT(AST_IF_ELSE, ast->node_type);
+    TEST_ASSERT_EQUAL_INT(AST_SCOPE, ast->second->node_type);
+    TEST_ASSERT_EQUAL_INT(AST_WHILE, ast->third->child->node_type);
+    deleteASTNode(&ast);
+
+    // The sum does not have a closed form once the body prints
+    ASTNode* body = newASTStatementList(newASTPrint(newASTID(i)), newASTInc(newASTID(i), false).result_value);
+    ast = newASTWhile(newASTCmpLT(newASTID(i), newASTInt(10)).result_value, newASTScope(body)).result_value;
+    optimizeAST(&ast, st, AST_OPT_SCALAR_EVOLUTION);
+    TEST_ASSERT_EQUAL_INT(AST_WHILE, ast->node_type);
+    deleteASTNode(&ast);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(foldArithmetic);
+    RUN_TEST(foldPreservesTraps);
+    RUN_TEST(simplifyIdentities);
+    RUN_TEST(foldCmpChain);
+    RUN_TEST(foldConstantConditions);
+    RUN_TEST(foldKeepsCompoundAssignmentOperator);
+    RUN_TEST(hoistLoopInvariants);
+    RUN_TEST(reduceInductionProducts);
+    RUN_TEST(reduceProductsByIntMin);
+    RUN_TEST(keepProductsOfLoopWithContinue);
+    RUN_TEST(evaluateAccumulationInClosedForm);
+    RUN_TEST(keepLoopForBoundsOutOfClosedForm);
+    return UNITY_END();
+}
@@ -0,0 +1,130 @@
+#include <unity.h>
+
+#include "ast.h"
+#include "optimize.h"
+
+static SymbolTable* st = NULL;
+static ASTNode* ast = NULL;
+static Symbol* a = NULL;
+
+void setUp (void) {
+    st = newSymbolTableDefault();
+    a = NULL;
+    ast = NULL;
+}
+
+void tearDown (void) {
+    if (ast != NULL) {
+        deleteASTNode(&ast);
+    }
+    deleteSymbolTable(&st);
+}
+
+static ASTNode* declare(const char* id, ASTType type, ASTNode* value) {
+    return newASTIDDeclaration(type, id, value, false, st).result_value;
+}
+
+static Symbol* var(const char* id) {
+    return lookupVar(st, id);
+}
+
+static ASTNode* id(const char* id) {
+    return newASTID(var(id));
+}
+
+void shareTheSlotOfAVarAfterItsLastAccess() {
+    // var a = 1; { var x = a + 1; var y = x * 2; var z = y - 3; print(z); }
+    ASTNode* decl_a = declare("a", AST_TYPE_INT, newASTInt(1));
+    a = var("a");
+    enterScopeDefault(st);
+    ASTNode* decl_x = declare("x", AST_TYPE_INT, newASTAdd(id("a"), newASTInt(1)).result_value);
+    ASTNode* decl_y = declare("y", AST_TYPE_INT, newASTMul(id("x"), newASTInt(2)).result_value);
+    ASTNode* decl_z = declare("z", AST_TYPE_INT, newASTSub(id("y"), newASTInt(3)).result_value);
+    ASTNode* scope = newASTScope(newASTStatementList(newASTStatementList(decl_x, decl_y), newASTStatementList(decl_z, newASTPrint(id("z")))));
+    Symbol* x = var("x");
+    Symbol* z = var("z");
+    leaveScope(st);
+    ast = newASTStatementList(decl_a, scope);
+
+    TEST_ASSERT_TRUE(assignFrameSlots(ast, st));
+    TEST_ASSERT_EQUAL_INT(1, getMaxOffset(st));
+    TEST_ASSERT_EQUAL_INT(0, getVarOffset(a));
+    TEST_ASSERT_EQUAL_INT(1, getVarOffset(x));
+    TEST_ASSERT_EQUAL_INT(1, getVarOffset(z));
+    TEST_ASSERT_FALSE(isVarSlotShared(a));
+    TEST_ASSERT_TRUE(isVarSlotShared(x));
+    TEST_ASSERT_EQUAL_PTR(z, lookupLastVarWithOffset(st, 1));
+    // The ID nodes follow their vars
+    TEST_ASSERT_EQUAL_INT(1, decl_z->left->slot);
+    TEST_ASSERT_EQUAL_INT(1, decl_z->right->left->slot);
+}
+
+void keepTheSlotsOfVarsLiveInALoop() {
+    // { var n = 3; var i = 0; while (i < n) { var t = i * 2; var s = t + 1; print(s); i++; } var u = 5; print(u); }
+    enterScopeDefault(st);
+    ASTNode* decl_n = declare("n", AST_TYPE_INT, newASTInt(3));
+    ASTNode* decl_i = declare("i", AST_TYPE_INT, newASTInt(0));
+    Symbol* n = var("n");
+    Symbol* i = var("i");
+    enterScopeDefault(st);
+    ASTNode* decl_t = declare("t", AST_TYPE_INT, newASTMul(id("i"), newASTInt(2)).result_value);
+    ASTNode* decl_s = declare("s", AST_TYPE_INT, newASTAdd(id("t"), newASTInt(1)).result_value);
+    ASTNode* body = newASTScope(newASTStatementList(newASTStatementList(decl_t, decl_s), newASTStatementList(newASTPrint(id("s")), newASTInc(id("i"), false).result_value)));
+    Symbol* t = var("t");
+    Symbol* s = var("s");
+    leaveScope(st);
+    ASTNode* loop = newASTWhile(newASTCmpLT(id("i"), id("n")).result_value, body).result_value;
+    ASTNode* decl_u = declare("u", AST_TYPE_INT, newASTInt(5));
+    Symbol* u = var("u");
+    ASTNode* stmts = newASTStatementList(newASTStatementList(decl_n, decl_i), newASTStatementList(loop, newASTStatementList(decl_u, newASTPrint(id("u")))));
+    leaveScope(st);
+    ast = newASTScope(stmts);
+
+    TEST_ASSERT_TRUE(assignFrameSlots(ast, st));
+    TEST_ASSERT_EQUAL_INT(2, getMaxOffset(st));
+    TEST_ASSERT_NOT_EQUAL(getVarOffset(n), getVarOffset(t));
+    TEST_ASSERT_NOT_EQUAL(getVarOffset(i), getVarOffset(t));
+    TEST_ASSERT_NOT_EQUAL(getVarOffset(n), getVarOffset(i));
+    TEST_ASSERT_EQUAL_INT(getVarOffset(t), getVarOffset(s));
+    // The loop is over when u is declared
+    TEST_ASSERT_TRUE(getVarOffset(u) <= getMaxOffset(st));
+}
+
+void keepTheSlotsOfVarsOfDifferentTypes() {
+    // { var x = 1; print(x); var z = true; print(z); }
+    enterScopeDefault(st);
+    ASTNode* decl_x = declare("x", AST_TYPE_INT, newASTInt(1));
+    Symbol* x = var("x");
+    ASTNode* decl_z = declare("z", AST_TYPE_BOOL, newASTBool(true));
+    Symbol* z = var("z");
+    ast = newASTScope(newASTStatementList(newASTStatementList(decl_x, newASTPrint(id("x"))), newASTStatementList(decl_z, newASTPrint(id("z")))));
+    leaveScope(st);
+
+    TEST_ASSERT_FALSE(assignFrameSlots(ast, st));
+    TEST_ASSERT_EQUAL_INT(0, getVarOffset(x));
+    TEST_ASSERT_EQUAL_INT(1, getVarOffset(z));
+}
+
+void keepTheSlotsOfVarsNotDeclaredByTheAST() {
+    // { var x = a; var y = x; print(y); }, with a defined by the caller
+    a = defineVar(st, AST_TYPE_INT, "a", false).result_value;
+    enterScopeDefault(st);
+    ASTNode* decl_x = declare("x", AST_TYPE_INT, id("a"));
+    ASTNode* decl_y = declare("y", AST_TYPE_INT, id("x"));
+    Symbol* y = var("y");
+    ast = newASTScope(newASTStatementList(newASTStatementList(decl_x, decl_y), newASTPrint(id("y"))));
+    leaveScope(st);
+
+    TEST_ASSERT_FALSE(assignFrameSlots(ast, st));
+    TEST_ASSERT_EQUAL_INT(2, getVarOffset(y));
+    TEST_ASSERT_FALSE(isVarSlotShared(y));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(shareTheSlotOfAVarAfterItsLastAccess);
+    RUN_TEST(keepTheSlotsOfVarsLiveInALoop);
+    RUN_TEST(keepTheSlotsOfVarsOfDifferentTypes);
+    RUN_TEST(keepTheSlotsOfVarsNotDeclaredByTheAST);
+    return UNITY_END();
+}
@@ -222,9 +222,10 @@ void newASTStatementListWithAnotherStatement() {
     ASTNode* stmt2 = newASTAssignment(id_node, newASTInt(VALUE)).result_value;
     ASTNode* ast = newASTStatementList(stmt1, stmt2);
 
-    ASSERT_IS_VALID_AST_NODE(ast, AST_STATEMENT_SEQ, BINARY_OP, stmt1->size + stmt2->size + 1);
-    TEST_ASSERT_EQUAL_PTR(stmt1, ast->left);
-    TEST_ASSERT_EQUAL_PTR(stmt2, ast->right);
+    ASSERT_IS_VALID_AST_NODE(ast, AST_STATEMENT_SEQ, N_ARY_OP, stmt1->size + stmt2->size + 1);
+    TEST_ASSERT_EQUAL_UINT(2, ast->stmt_count);
+    TEST_ASSERT_EQUAL_PTR(stmt1, ast->stmts[0]);
+    TEST_ASSERT_EQUAL_PTR(stmt2, ast->stmts[1]);
 
     deleteASTNode(&ast);
 }
@@ -240,13 +241,36 @@ void newASTStatementListWithStatementList() {
     ASTNode* list = newASTStatementList(stmt2, stmt3);
     ASTNode* ast = newASTStatementList(stmt1, list);
 
-    ASSERT_IS_VALID_AST_NODE(ast, AST_STATEMENT_SEQ, BINARY_OP, stmt1->size + stmt2->size + stmt3->size + 2);
-    TEST_ASSERT_EQUAL_PTR(stmt1, ast->left);
-    TEST_ASSERT_EQUAL_INT(AST_STATEMENT_SEQ, ast->right->node_type);
+    // The inner list is flattened into the outer one
+    ASSERT_IS_VALID_AST_NODE(ast, AST_STATEMENT_SEQ, N_ARY_OP, stmt1->size + stmt2->size + stmt3->size + 1);
+    TEST_ASSERT_EQUAL_UINT(3, ast->stmt_count);
+    TEST_ASSERT_EQUAL_PTR(stmt1, ast->stmts[0]);
+    TEST_ASSERT_EQUAL_PTR(stmt2, ast->stmts[1]);
+    TEST_ASSERT_EQUAL_PTR(stmt3, ast->stmts[2]);
 
     deleteASTNode(&ast);
 }
 
+void appendManyStatements() {
+    const unsigned int count = 200000;
+
+    ASTNode* ast = newASTNoOp();
+    for (unsigned int i = 1; i < count; i++) {
+        ast = appendASTStatement(ast, newASTPrint(newASTInt(i)));
+    }
+
+    ASSERT_IS_VALID_AST_NODE(ast, AST_STATEMENT_SEQ, N_ARY_OP, 1 + 1 + 2 * (count - 1));
+    TEST_ASSERT_EQUAL_UINT(count, ast->stmt_count);
+    TEST_ASSERT_EQUAL_INT(AST_NO_OP, ast->stmts[0]->node_type);
+    TEST_ASSERT_EQUAL_INT(count - 1, ast->stmts[count - 1]->child->n);
+
+    ASTNode* cp = copyAST(ast);
+    TEST_ASSERT_TRUE(equalAST(ast, cp));
+
+    deleteASTNode(&cp);
+    deleteASTNode(&ast);
+}
+
 void testEqualASTLeafs() {
     ASTResult res = defineVar(st, AST_TYPE_INT, "n", false);
     ASSERT_IS_OK(res);
@@ -602,6 +626,7 @@ int main() {
     RUN_TEST(newASTStatementListWithNull);
     RUN_TEST(newASTStatementListWithAnotherStatement);
     RUN_TEST(newASTStatementListWithStatementList);
+    RUN_TEST(appendManyStatements);
     RUN_TEST(testEqualASTLeafs);
     RUN_TEST(prefixIncOfLvalReturnsOk);
     RUN_TEST(prefixIncOfNonLvalReturnsErr);
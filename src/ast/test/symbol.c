@@ -2,6 +2,8 @@
 
 #include <assert.h>
 #include <stdbool.h>
+#include <stdio.h>
+#include <pthread.h>
 #include <unity.h>
 
 static SymbolTable* st;
@@ -16,6 +18,8 @@ void tearDown(void) {
 
 #define TABLE_CAPACITY 1
 #define SCOPE_CAPACITY 1
+#define VAR_COUNT 10000
+#define THREAD_COUNT 4
 
 void newSymbolTableReturnsValidEmptyTable() {
     st = newSymbolTable(TABLE_CAPACITY, SCOPE_CAPACITY);
@@ -330,6 +334,159 @@ void offsetOfVarsInConcurrentScopesIsEqual() {
     TEST_ASSERT_EQUAL_INT(getVarOffset(var_k), getMaxOffset(st));
 }
 
+void leavingScopeRestoresShadowedVar() {
+    st = newSymbolTable(TABLE_CAPACITY, SCOPE_CAPACITY);
+    ASTResult res = defineVar(st, AST_TYPE_INT, "n", false);
+    TEST_ASSERT_TRUE(isOK(res));
+    Symbol* outer = res.result_value;
+
+    enterScope(st, SCOPE_CAPACITY);
+    res = defineVar(st, AST_TYPE_BOOL, "n", true);
+    TEST_ASSERT_TRUE(isOK(res));
+    TEST_ASSERT_EQUAL_PTR(res.result_value, lookupVar(st, "n"));
+
+    TEST_ASSERT_TRUE(leaveScope(st));
+    TEST_ASSERT_EQUAL_PTR(outer, lookupVar(st, "n"));
+}
+
+void lookupVarAmongManyVars() {
+    st = newSymbolTable(TABLE_CAPACITY, SCOPE_CAPACITY);
+
+    char id[MAX_ID_SIZE];
+    for (int i = 0; i < VAR_COUNT; i++) {
+        sprintf(id, "v%d", i);
+        TEST_ASSERT_TRUE(isOK(defineVar(st, AST_TYPE_INT, id, false)));
+    }
+    enterScope(st, SCOPE_CAPACITY);
+
+    for (int i = 0; i < VAR_COUNT; i++) {
+        sprintf(id, "v%d", i);
+        Symbol* var = lookupVar(st, id);
+        TEST_ASSERT_NOT_NULL(var);
+        TEST_ASSERT_EQUAL_INT(i, getVarOffset(var));
+    }
+    TEST_ASSERT_NULL(lookupVar(st, "v-1"));
+
+    Scope* scope = getScope(st, 0);
+    SymbolTable* clone_st = newSymbolTableClone(st);
+    for (int i = 0; i < VAR_COUNT; i++) {
+        sprintf(id, "v%d", i);
+        TEST_ASSERT_EQUAL_PTR(lookupLastVarWithOffset(st, i), lookupVarInScope(scope, id));
+        TEST_ASSERT_EQUAL_PTR(lookupLastVarWithOffset(clone_st, i), lookupVarInScope(getScope(clone_st, 0), id));
+    }
+    TEST_ASSERT_NULL(lookupVarInScope(scope, "v-1"));
+    deleteSymbolTable(&clone_st);
+}
+
+void varsWithSameIdShareTheirId() {
+    st = newSymbolTable(TABLE_CAPACITY, SCOPE_CAPACITY);
+    char id[] = "n";
+    Symbol* outer = defineVar(st, AST_TYPE_INT, id, false).result_value;
+    enterScope(st, SCOPE_CAPACITY);
+    Symbol* inner = defineVar(st, AST_TYPE_INT, "n", true).result_value;
+
+    TEST_ASSERT_EQUAL_PTR(getVarId(outer), getVarId(inner));
+    TEST_ASSERT_TRUE(getVarId(outer) != id);
+}
+
+static void* defineManyVars(void* arg) {
+    SymbolTable* table = arg;
+    char id[MAX_ID_SIZE];
+    for (int i = 0; i < VAR_COUNT; i++) {
+        sprintf(id, "v%d", i);
+        defineVar(table, AST_TYPE_INT, id, false);
+    }
+    return NULL;
+}
+
+void varsDefinedConcurrentlyShareTheirId() {
+    SymbolTable* tables[THREAD_COUNT];
+    pthread_t threads[THREAD_COUNT];
+    for (int i = 0; i < THREAD_COUNT; i++) {
+        tables[i] = newSymbolTable(TABLE_CAPACITY, SCOPE_CAPACITY);
+        TEST_ASSERT_EQUAL_INT(0, pthread_create(&threads[i], NULL, &defineManyVars, tables[i]));
+    }
+    for (int i = 0; i < THREAD_COUNT; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    for (unsigned int offset = 0; offset < VAR_COUNT; offset++) {
+        const char* id = getVarId(lookupLastVarWithOffset(tables[0], offset));
+        for (int i = 1; i < THREAD_COUNT; i++) {
+            TEST_ASSERT_EQUAL_PTR(id, getVarId(lookupLastVarWithOffset(tables[i], offset)));
+        }
+    }
+    for (int i = 0; i < THREAD_COUNT; i++) {
+        deleteSymbolTable(&tables[i]);
+    }
+}
+
+void lookupLastVarWithOffsetReturnsLastDefinedVar() {
+    st = newSymbolTable(TABLE_CAPACITY, SCOPE_CAPACITY);
+    enterScope(st, SCOPE_CAPACITY);
+    Symbol* inner = defineVar(st, AST_TYPE_INT, "n", false).result_value;
+    TEST_ASSERT_EQUAL_PTR(inner, lookupLastVarWithOffset(st, 0));
+    TEST_ASSERT_TRUE(leaveScope(st));
+
+    // Reuses the slot of the variable of the scope that was left
+    Symbol* outer = defineVar(st, AST_TYPE_INT, "m", false).result_value;
+    TEST_ASSERT_EQUAL_INT(getVarOffset(inner), getVarOffset(outer));
+    TEST_ASSERT_EQUAL_PTR(outer, lookupLastVarWithOffset(st, 0));
+    TEST_ASSERT_NULL(lookupLastVarWithOffset(st, 1));
+
+    SymbolTable* clone_st = newSymbolTableClone(st);
+    TEST_ASSERT_EQUAL_PTR(lookupVar(clone_st, "m"), lookupLastVarWithOffset(clone_st, 0));
+    deleteSymbolTable(&clone_st);
+}
+
+void tempVarsTakeTheNextSlotsAndAreNotVisible() {
+    st = newSymbolTable(TABLE_CAPACITY, SCOPE_CAPACITY);
+    Symbol* n = defineVar(st, AST_TYPE_INT, "n", false).result_value;
+    Symbol* t = defineTempVar(st, AST_TYPE_BOOL);
+    Symbol* u = defineTempVar(st, AST_TYPE_INT);
+
+    TEST_ASSERT_EQUAL_INT(getVarOffset(n) + 1, getVarOffset(t));
+    TEST_ASSERT_EQUAL_INT(getVarOffset(t) + 1, getVarOffset(u));
+    TEST_ASSERT_EQUAL_INT(getVarOffset(u), getMaxOffset(st));
+    TEST_ASSERT_TRUE(isTempVar(t));
+    TEST_ASSERT_FALSE(isTempVar(n));
+    TEST_ASSERT_NULL(lookupVar(st, getVarId(t)));
+    TEST_ASSERT_EQUAL_PTR(u, lookupLastVarWithOffset(st, getVarOffset(u)));
+
+    SymbolTable* clone_st = newSymbolTableClone(st);
+    Symbol* clone_u = lookupLastVarWithOffset(clone_st, getVarOffset(u));
+    TEST_ASSERT_TRUE(clone_u != u && isTempVar(clone_u));
+    TEST_ASSERT_EQUAL_PTR(getVarId(u), getVarId(clone_u));
+    TEST_ASSERT_EQUAL_INT(getVarOffset(u) + 1, getVarOffset(defineTempVar(clone_st, AST_TYPE_INT)));
+    deleteSymbolTable(&clone_st);
+}
+
+void assignedSlotsAreSharedAndKeptByTheClone() {
+    st = newSymbolTable(TABLE_CAPACITY, SCOPE_CAPACITY);
+    Symbol* n = defineVar(st, AST_TYPE_INT, "n", false).result_value;
+    enterScope(st, SCOPE_CAPACITY);
+    Symbol* m = defineVar(st, AST_TYPE_INT, "m", false).result_value;
+    Symbol* k = defineVar(st, AST_TYPE_INT, "k", false).result_value;
+    Symbol* vars[] = { n, m, k };
+    unsigned int offsets[] = { 0, 1, 1 };
+    assignVarSlots(st, vars, offsets, 3);
+
+    TEST_ASSERT_EQUAL_INT(1, getMaxOffset(st));
+    TEST_ASSERT_EQUAL_INT(1, getVarOffset(k));
+    TEST_ASSERT_TRUE(isVarSlotShared(m) && isVarSlotShared(k));
+    TEST_ASSERT_FALSE(isVarSlotShared(n));
+    TEST_ASSERT_TRUE(isGlobalVar(n));
+    TEST_ASSERT_FALSE(isGlobalVar(m));
+    TEST_ASSERT_EQUAL_PTR(k, lookupLastVarWithOffset(st, 1));
+    // The temporaries still go after the last slot
+    TEST_ASSERT_EQUAL_INT(2, getVarOffset(defineTempVar(st, AST_TYPE_INT)));
+
+    SymbolTable* clone_st = newSymbolTableClone(st);
+    TEST_ASSERT_EQUAL_PTR(lookupVar(clone_st, "k"), lookupLastVarWithOffset(clone_st, 1));
+    TEST_ASSERT_TRUE(isVarSlotShared(lookupVar(clone_st, "k")));
+    deleteSymbolTable(&clone_st);
+}
+
 void cloneEmptyTableReturnsNewEmptyTable() {
     st = newSymbolTable(TABLE_CAPACITY, SCOPE_CAPACITY);
     SymbolTable* clone_st = newSymbolTableClone(st);
@@ -446,6 +603,13 @@ int main() {
     RUN_TEST(cloneTableWithConcurrentScopesReturnsIdenticalTable);
     RUN_TEST(cloneTableWithNestedScopesReturnsIdenticalTable);
     RUN_TEST(cloneTableReturnsIdenticalTable);
+    RUN_TEST(leavingScopeRestoresShadowedVar);
+    RUN_TEST(lookupVarAmongManyVars);
+    RUN_TEST(varsWithSameIdShareTheirId);
+    RUN_TEST(varsDefinedConcurrentlyShareTheirId);
+    RUN_TEST(lookupLastVarWithOffsetReturnsLastDefinedVar);
     RUN_TEST(cloneEmptyTableReturnsNewEmptyTable);
+    RUN_TEST(tempVarsTakeTheNextSlotsAndAreNotVisible);
+    RUN_TEST(assignedSlotsAreSharedAndKeptByTheClone);
     return UNITY_END();
 }
\ No newline at end of file
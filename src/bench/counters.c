@@ -0,0 +1,96 @@
+#include "counters.h"
+
+#include <assert.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+
+static const uint64_t PerfEventConfig[] = {
+    [COUNTER_INSTRUCTIONS]  = PERF_COUNT_HW_INSTRUCTIONS,
+    [COUNTER_BRANCHES]      = PERF_COUNT_HW_BRANCH_INSTRUCTIONS,
+    [COUNTER_BRANCH_MISSES] = PERF_COUNT_HW_BRANCH_MISSES,
+};
+
+static int openPerfEvent(uint64_t config) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+#endif
+
+static double nowMs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+void openCounters(Counters* c) {
+    assert(c != NULL);
+    memset(c, 0, sizeof(Counters));
+
+    c->available = false;
+#ifdef __linux__
+    c->available = true;
+    for (CounterType t = 0; t < COUNTER_TYPES_COUNT; t++) {
+        c->fds[t] = openPerfEvent(PerfEventConfig[t]);
+        c->available = c->available && c->fds[t] >= 0;
+    }
+    if (!c->available) {
+        closeCounters(c);
+    }
+#else
+    for (CounterType t = 0; t < COUNTER_TYPES_COUNT; t++) {
+        c->fds[t] = -1;
+    }
+#endif
+}
+
+void closeCounters(Counters* c) {
+    assert(c != NULL);
+    for (CounterType t = 0; t < COUNTER_TYPES_COUNT; t++) {
+        if (c->fds[t] >= 0) {
+            close(c->fds[t]);
+        }
+        c->fds[t] = -1;
+    }
+    c->available = false;
+}
+
+void startCounters(Counters* c) {
+    assert(c != NULL);
+#ifdef __linux__
+    if (c->available) {
+        for (CounterType t = 0; t < COUNTER_TYPES_COUNT; t++) {
+            ioctl(c->fds[t], PERF_EVENT_IOC_RESET, 0);
+            ioctl(c->fds[t], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#endif
+    c->start_ms = nowMs();
+}
+
+void stopCounters(Counters* c) {
+    assert(c != NULL);
+    c->elapsed_ms = nowMs() - c->start_ms;
+#ifdef __linux__
+    if (c->available) {
+        for (CounterType t = 0; t < COUNTER_TYPES_COUNT; t++) {
+            ioctl(c->fds[t], PERF_EVENT_IOC_DISABLE, 0);
+            if (read(c->fds[t], &c->values[t], sizeof(uint64_t)) != sizeof(uint64_t)) {
+                c->values[t] = 0;
+            }
+        }
+    }
+#endif
+}
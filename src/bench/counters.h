@@ -0,0 +1,31 @@
+#ifndef _COUNTERS_H_
+#define _COUNTERS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum CounterType {
+    COUNTER_INSTRUCTIONS,
+    COUNTER_BRANCHES,
+    COUNTER_BRANCH_MISSES,
+    COUNTER_TYPES_COUNT
+} CounterType;
+
+typedef struct Counters {
+    int fds[COUNTER_TYPES_COUNT];
+    uint64_t values[COUNTER_TYPES_COUNT];
+    bool available;
+    double elapsed_ms;
+    double start_ms;
+} Counters;
+
+// Hardware counters are read through perf_event_open on Linux, elsewhere only the elapsed time is measured
+void openCounters(Counters* c);
+
+void closeCounters(Counters* c);
+
+void startCounters(Counters* c);
+
+void stopCounters(Counters* c);
+
+#endif
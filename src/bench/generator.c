@@ -0,0 +1,96 @@
+#include "generator.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "utils/iostream.h"
+
+static const char* ProgramShapeStr[] = {
+    [SHAPE_DECLARATIONS]     = "decls",
+    [SHAPE_NESTED_SCOPES]    = "scopes",
+    [SHAPE_LONG_EXPRESSIONS] = "exps",
+    [SHAPE_HOT_LOOPS]        = "loops",
+    [SHAPE_REDEFS]           = "redefs",
+};
+
+// The terms keep the values of the expressions small, so that they never overflow
+static const char* TermOps[] = { "^", "+", "|", "^", "&" };
+
+#define TERM_OPS_COUNT (sizeof(TermOps) / sizeof(TermOps[0]))
+
+const char* ProgramShapeToStr(ProgramShape shape) {
+    assert((sizeof(ProgramShapeStr)/sizeof(ProgramShapeStr[0])) == PROGRAM_SHAPES_COUNT);
+    assert(shape < PROGRAM_SHAPES_COUNT);
+    return ProgramShapeStr[shape];
+}
+
+bool ProgramShapeFromStr(const char* str, ProgramShape* shape) {
+    assert(str != NULL && shape != NULL);
+    for (ProgramShape s = 0; s < PROGRAM_SHAPES_COUNT; s++) {
+        if (strcmp(str, ProgramShapeStr[s]) == 0) {
+            *shape = s;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void generateUnit(const IOStream* stream, ProgramShape shape, unsigned int loop_iterations, unsigned int i) {
+    switch (shape) {
+        case SHAPE_DECLARATIONS: {
+            IOStreamWritef(stream, "var d%u = d%u %s %u;\n", i + 1, i, TermOps[i % TERM_OPS_COUNT], i % 1024);
+            break;
+        } case SHAPE_NESTED_SCOPES: {
+            for (unsigned int d = 0; d < GENERATOR_NESTING_DEPTH; d++) {
+                IOStreamWritef(stream, "{ var n%u = %u; ", d, d);
+            }
+            for (unsigned int d = 0; d < GENERATOR_NESTING_DEPTH; d++) {
+                IOStreamWriteChar(stream, '}');
+            }
+            IOStreamWriteChar(stream, '\n');
+            break;
+        } case SHAPE_LONG_EXPRESSIONS: {
+            IOStreamWritef(stream, "e = (e & 1023)");
+            for (unsigned int t = 1; t <= GENERATOR_EXPRESSION_TERMS; t++) {
+                IOStreamWritef(stream, " %s %u", TermOps[(i + t) % TERM_OPS_COUNT], t);
+            }
+            IOStreamWriteStr(stream, ";\n");
+            break;
+        } case SHAPE_HOT_LOOPS: {
+            IOStreamWritef(stream, "for (var i = 0; i < %u; i++) { h = h + i & 65535; }\n", loop_iterations);
+            break;
+        } case SHAPE_REDEFS: {
+            for (unsigned int d = 0; d < GENERATOR_NESTING_DEPTH; d++) {
+                IOStreamWriteStr(stream, "{ redef var r = r + 1 & 1023; ");
+            }
+            for (unsigned int d = 0; d < GENERATOR_NESTING_DEPTH; d++) {
+                IOStreamWriteChar(stream, '}');
+            }
+            IOStreamWriteChar(stream, '\n');
+            break;
+        } default:
+            assert(false);
+    }
+}
+
+char* generateProgram(ProgramShape shape, unsigned int units, unsigned int loop_iterations, size_t* len) {
+    assert(shape < PROGRAM_SHAPES_COUNT && len != NULL);
+    assert(loop_iterations <= GENERATOR_MAX_LOOP_ITERATIONS);
+
+    char* src = NULL;
+    size_t size = 0;
+    IOStream* stream = openIOStreamFromMemmory(&src, &size);
+
+    // The variables that the units read
+    IOStreamWriteStr(stream, "var d0 = 0; var e = 0; var h = 0; var r = 0;\n");
+    for (unsigned int i = 0; i < units; i++) {
+        generateUnit(stream, shape, loop_iterations, i);
+    }
+
+    IOStreamClose(&stream);
+    assert(src != NULL);
+    *len = size - 1;
+    return src;
+}
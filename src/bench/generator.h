@@ -0,0 +1,32 @@
+#ifndef _GENERATOR_H_
+#define _GENERATOR_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <limits.h>
+
+typedef enum ProgramShape {
+    SHAPE_DECLARATIONS,    // Straight-line declarations, each reading the previous one
+    SHAPE_NESTED_SCOPES,   // Blocks of nested scopes with a declaration in each
+    SHAPE_LONG_EXPRESSIONS,
+    SHAPE_HOT_LOOPS,       // Loops of a given number of iterations
+    SHAPE_REDEFS,          // Blocks of nested scopes that redefine the same variable
+    PROGRAM_SHAPES_COUNT
+} ProgramShape;
+
+#define GENERATOR_NESTING_DEPTH 32
+#define GENERATOR_EXPRESSION_TERMS 64
+#define GENERATOR_DEFAULT_LOOP_ITERATIONS 100
+#define GENERATOR_MAX_LOOP_ITERATIONS (INT_MAX - 65536)  // The sums of the loops stay below 65536 plus the index
+
+const char* ProgramShapeToStr(ProgramShape shape);
+
+// Returns false if the string is not the name of a shape
+bool ProgramShapeFromStr(const char* str, ProgramShape* shape);
+
+// Generates the source of a program with the given number of repetitions of the shape, where each hot loop runs
+// loop_iterations iterations. The programs do not print, their ints never overflow and their size grows linearly
+// with the number of units. The returned string must be freed by the caller.
+char* generateProgram(ProgramShape shape, unsigned int units, unsigned int loop_iterations, size_t* len);
+
+#endif
@@ -0,0 +1,188 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#include "in/in.h"
+#include "out/out.h"
+
+#include "counters.h"
+#include "scaling.h"
+
+#define DEFAULT_ITERATIONS 1000000
+#define REPETITIONS 3
+#define MAX_PROGRAM_SIZE 1024
+
+#define USAGE_MSG "Usage: %s [iterations]\n       %s scaling [max-nodes [shape [loop-iterations]]]\n" \
+    "The shape is decls, scopes, exps, loops, redefs or all.\n"
+#define ALL_SHAPES "all"
+#define PARSE_ERR_MSG "Error parsing the workload %s\n"
+
+// Same shapes as examples/loops.txt, without the prints so that only the dispatch is measured
+typedef struct Workload {
+    const char* name;
+    const char* fmt;
+} Workload;
+
+static const Workload Workloads[] = {
+    { "while",    "var N = %d; var s = 0; var i = 0; while (i < N) { s += i; i++; }" },
+    { "do-while", "var N = %d; var s = 0; var j = 0; do { s ^= j; j++; } while (j < N)" },
+    { "for",      "var N = %d; var s = 0; for (var k = 0; k < N; k++) { s = s + k * 3; }" },
+    { "for-cont", "var N = %d; var s = 0; for (var k = 0; k < N; k++) { if (k %% 2 == 0) { continue; } if (k == N - 1) { break; } s += k; }" },
+    { "nested",   "var N = %d; var s = 0; for (var i = 0; i < N / 100; i++) { for (var j = 0; j < 100; j++) { s += i < j ? 1 : 0 <= j <= 50 ? 2 : 3; } }" },
+};
+
+#define WORKLOADS_COUNT (sizeof(Workloads) / sizeof(Workloads[0]))
+
+typedef enum BenchMode {
+    BENCH_TREE_WALKER,
+    BENCH_SWITCH,
+    BENCH_THREADED,
+    BENCH_JIT,
+    BENCH_TIERED,
+    BENCH_MODES_COUNT
+} BenchMode;
+
+static const char* BenchModeStr[] = {
+    [BENCH_TREE_WALKER] = "tree-walker",
+    [BENCH_SWITCH]      = "switch",
+    [BENCH_THREADED]    = "threaded",
+    [BENCH_JIT]         = "jit",
+    [BENCH_TIERED]      = "tiered",
+};
+
+static bool isBenchModeAvailable(BenchMode mode) {
+    switch (mode) {
+        case BENCH_TREE_WALKER: return true;
+        case BENCH_SWITCH:      return isDispatchModeAvailable(DISPATCH_SWITCH);
+        case BENCH_THREADED:    return isDispatchModeAvailable(DISPATCH_THREADED);
+        case BENCH_JIT:         return isJITAvailable();
+        case BENCH_TIERED:      return true;
+        default:
+            assert(false);
+            return false;
+    }
+}
+
+static void run(BenchMode mode, const ASTNode* ast, const SymbolTable* st, const Program* program, const JITCode* jit) {
+    switch (mode) {
+        case BENCH_TREE_WALKER: {
+            Frame* frame = executeASTWithMode(ast, st, EXEC_MODE_TREE_WALKER);
+            deleteFrame(&frame);
+            break;
+        } case BENCH_SWITCH:
+          case BENCH_THREADED: {
+            Frame* frame = newFrame(getMaxOffset(st) + 1);
+            executeProgramWithDispatch(program, frame, mode == BENCH_SWITCH ? DISPATCH_SWITCH : DISPATCH_THREADED);
+            deleteFrame(&frame);
+            break;
+        } case BENCH_JIT: {
+            Frame* frame = newFrame(getMaxOffset(st) + 1);
+            executeJITCode(jit, frame);
+            deleteFrame(&frame);
+            break;
+        } case BENCH_TIERED: {
+            Frame* frame = executeASTWithMode(ast, st, EXEC_MODE_TIERED);
+            deleteFrame(&frame);
+            break;
+        } default:
+            assert(false);
+    }
+}
+
+static bool benchWorkload(const Workload* w, int iterations, Counters* c) {
+    char src[MAX_PROGRAM_SIZE];
+    snprintf(src, MAX_PROGRAM_SIZE, w->fmt, iterations);
+
+    InContext* ctx = inInitWithString(src);
+    ParseResult res = inParse(ctx);
+    inDelete(&ctx);
+
+    if (!res.status || res.ast == NULL) {
+        fprintf(stderr, PARSE_ERR_MSG, w->name);
+        return false;
+    }
+
+    Program* program = newProgramFromAST(res.ast, res.st);
+    JITCode* jit = isJITAvailable() ? newJITCodeFromProgram(program) : NULL;
+
+    for (BenchMode mode = 0; mode < BENCH_MODES_COUNT; mode++) {
+        if (!isBenchModeAvailable(mode) || (mode == BENCH_JIT && jit == NULL)) {
+            continue;
+        }
+
+        // Keep the best of the repetitions
+        Counters best = {0};
+        for (int r = 0; r < REPETITIONS; r++) {
+            startCounters(c);
+            run(mode, res.ast, res.st, program, jit);
+            stopCounters(c);
+            if (r == 0 || c->elapsed_ms < best.elapsed_ms) {
+                best = *c;
+            }
+        }
+
+        printf("%-10s %-12s %10.2f", w->name, BenchModeStr[mode], best.elapsed_ms);
+        if (best.available) {
+            uint64_t instructions = best.values[COUNTER_INSTRUCTIONS];
+            uint64_t branches = best.values[COUNTER_BRANCHES];
+            uint64_t misses = best.values[COUNTER_BRANCH_MISSES];
+            printf(" %14llu %14llu %12.2f %12llu %8.2f%%",
+                (unsigned long long) instructions, (unsigned long long) branches,
+                branches > 0 ? (double) instructions / branches : 0.0,
+                (unsigned long long) misses,
+                branches > 0 ? 100.0 * misses / branches : 0.0);
+        }
+        printf("\n");
+    }
+
+    if (jit != NULL) {
+        deleteJITCode(&jit);
+    }
+    deleteProgram(&program);
+    deleteParseResult(&res);
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc >= 2 && strcmp(argv[1], "scaling") == 0) {
+        int max_nodes = SCALING_MAX_NODES;
+        ProgramShape shape = 0;
+        bool all_shapes = argc < 4 || strcmp(argv[3], ALL_SHAPES) == 0;
+        long loop_iterations = GENERATOR_DEFAULT_LOOP_ITERATIONS;
+        if (argc > 5 || (argc >= 3 && (max_nodes = atoi(argv[2])) < SCALING_MIN_NODES)
+            || (!all_shapes && !ProgramShapeFromStr(argv[3], &shape))
+            || (argc == 5 && ((loop_iterations = atol(argv[4])) <= 0 || loop_iterations > GENERATOR_MAX_LOOP_ITERATIONS))) {
+            fprintf(stderr, USAGE_MSG, argv[0], argv[0]);
+            return 1;
+        }
+        return runScaling(max_nodes, all_shapes ? NULL : &shape, loop_iterations) ? 0 : 1;
+    }
+
+    int iterations = DEFAULT_ITERATIONS;
+    if (argc > 2 || (argc == 2 && (iterations = atoi(argv[1])) <= 0)) {
+        fprintf(stderr, USAGE_MSG, argv[0], argv[0]);
+        return 1;
+    }
+
+    Counters c;
+    openCounters(&c);
+    if (!c.available) {
+        printf("Hardware counters unavailable, only reporting the elapsed time.\n");
+    }
+
+    printf("%-10s %-12s %10s", "workload", "mode", "time (ms)");
+    if (c.available) {
+        printf(" %14s %14s %12s %12s %9s", "instructions", "branches", "instr/branch", "br-misses", "miss-rate");
+    }
+    printf("\n");
+
+    bool status = true;
+    for (unsigned int i = 0; i < WORKLOADS_COUNT; i++) {
+        status = benchWorkload(&Workloads[i], iterations, &c) && status;
+    }
+
+    closeCounters(&c);
+    return status ? 0 : 1;
+}
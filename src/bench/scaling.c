@@ -0,0 +1,180 @@
+#include "scaling.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "in/in.h"
+#include "out/out.h"
+
+#include "generator.h"
+
+#define SIZE_STEP 10
+#define CALIBRATION_UNITS 16
+#define TIME_BUDGET_MS 10000.0      // A shape stops growing once one of its phases takes longer than this
+#define SUPERLINEAR_EXPONENT 1.25   // Doubling the size more than 2^1.25 times the time
+#define MIN_SIGNIFICANT_MS 1.0      // Shorter times are too noisy to estimate the growth
+
+#define PARSE_ERR_MSG "Error parsing the generated %s program of %u units\n"
+
+typedef enum ScalingPhase {
+    SCALING_PARSE,
+    SCALING_EXECUTE,
+    SCALING_COMPILE_C,
+    SCALING_COMPILE_JAVA,
+    SCALING_PHASES_COUNT
+} ScalingPhase;
+
+static const char* ScalingPhaseStr[] = {
+    [SCALING_PARSE]        = "parse",
+    [SCALING_EXECUTE]      = "execute",
+    [SCALING_COMPILE_C]    = "compile-c",
+    [SCALING_COMPILE_JAVA] = "compile-java",
+};
+
+typedef struct Sample {
+    unsigned int nodes;
+    double ms[SCALING_PHASES_COUNT];
+} Sample;
+
+static double nowMs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static ParseResult parseProgram(ProgramShape shape, unsigned int units, unsigned int loop_iterations, double* ms) {
+    size_t len = 0;
+    char* src = generateProgram(shape, units, loop_iterations, &len);
+
+    double start = nowMs();
+    InContext* ctx = inInitWithString(src);
+    ParseResult res = inParse(ctx);
+    inDelete(&ctx);
+    *ms = nowMs() - start;
+
+    free(src);
+    if (!res.status || res.ast == NULL) {
+        fprintf(stderr, PARSE_ERR_MSG, ProgramShapeToStr(shape), units);
+    }
+    return res;
+}
+
+static double timeCompile(const ParseResult* res, bool (*compile_to)(const ASTNode* ast, const SymbolTable* st, const char* fname, const IOStream* stream)) {
+    char* code = NULL;
+    size_t size = 0;
+
+    double start = nowMs();
+    IOStream* stream = openIOStreamFromMemmory(&code, &size);
+    compile_to(res->ast, res->st, "bench", stream);
+    IOStreamClose(&stream);
+    double ms = nowMs() - start;
+
+    free(code);
+    return ms;
+}
+
+static bool measure(ProgramShape shape, unsigned int units, unsigned int loop_iterations, Sample* sample) {
+    ParseResult res = parseProgram(shape, units, loop_iterations, &sample->ms[SCALING_PARSE]);
+    if (!res.status || res.ast == NULL) {
+        return false;
+    }
+    sample->nodes = res.ast->size;
+
+    double start = nowMs();
+    Frame* frame = executeAST(res.ast, res.st);
+    sample->ms[SCALING_EXECUTE] = nowMs() - start;
+    deleteFrame(&frame);
+
+    sample->ms[SCALING_COMPILE_C] = timeCompile(&res, &outCompileToC);
+    sample->ms[SCALING_COMPILE_JAVA] = timeCompile(&res, &outCompileToJava);
+
+    deleteParseResult(&res);
+    return true;
+}
+
+// Nodes of the program without units and of each unit
+static bool calibrate(ProgramShape shape, unsigned int loop_iterations, unsigned int* base_nodes, unsigned int* unit_nodes) {
+    double ms = 0;
+    ParseResult base = parseProgram(shape, 0, loop_iterations, &ms);
+    ParseResult calibration = parseProgram(shape, CALIBRATION_UNITS, loop_iterations, &ms);
+    bool status = base.status && base.ast != NULL && calibration.status && calibration.ast != NULL;
+    if (status) {
+        *base_nodes = base.ast->size;
+        *unit_nodes = (calibration.ast->size - base.ast->size) / CALIBRATION_UNITS;
+    }
+    deleteParseResult(&base);
+    deleteParseResult(&calibration);
+    return status;
+}
+
+// Exponent k of time ~ nodes^k between two samples
+static inline double growthExponent(const Sample* previous, const Sample* current, ScalingPhase phase) {
+    return log(current->ms[phase] / previous->ms[phase]) / log((double) current->nodes / previous->nodes);
+}
+
+static bool scaleShape(ProgramShape shape, unsigned int max_nodes, unsigned int loop_iterations, unsigned int* superlinear_count) {
+    unsigned int base_nodes = 0;
+    unsigned int unit_nodes = 0;
+    if (!calibrate(shape, loop_iterations, &base_nodes, &unit_nodes)) {
+        return false;
+    }
+    assert(unit_nodes > 0);
+
+    Sample previous = {0};
+    for (unsigned int target = SCALING_MIN_NODES; target <= max_nodes; target *= SIZE_STEP) {
+        unsigned int units = target > base_nodes ? (target - base_nodes) / unit_nodes : 1;
+        Sample sample = {0};
+        if (!measure(shape, units > 0 ? units : 1, loop_iterations, &sample)) {
+            return false;
+        }
+
+        printf("%-8s %10u", ProgramShapeToStr(shape), sample.nodes);
+        bool over_budget = false;
+        for (ScalingPhase p = 0; p < SCALING_PHASES_COUNT; p++) {
+            printf(" %12.2f %7.1f", sample.ms[p], 1e6 * sample.ms[p] / sample.nodes);
+            if (previous.nodes == 0 || previous.ms[p] < MIN_SIGNIFICANT_MS) {
+                printf(" %6s", "-");
+            } else {
+                double k = growthExponent(&previous, &sample, p);
+                bool superlinear = k > SUPERLINEAR_EXPONENT;
+                printf(" %5.2f%c", k, superlinear ? '!' : ' ');
+                *superlinear_count += superlinear;
+            }
+            over_budget = over_budget || sample.ms[p] > TIME_BUDGET_MS;
+        }
+        printf("\n");
+        fflush(stdout);
+
+        previous = sample;
+        if (over_budget || target > max_nodes / SIZE_STEP) {
+            break;
+        }
+    }
+    return true;
+}
+
+bool runScaling(unsigned int max_nodes, const ProgramShape* shape, unsigned int loop_iterations) {
+    assert((sizeof(ScalingPhaseStr)/sizeof(ScalingPhaseStr[0])) == SCALING_PHASES_COUNT);
+
+    // Each phase has its time, the time per node and the exponent of its growth since the previous size
+    printf("%-8s %10s", "shape", "nodes");
+    for (ScalingPhase p = 0; p < SCALING_PHASES_COUNT; p++) {
+        printf(" %12s %7s %6s", ScalingPhaseStr[p], "ns/node", "k");
+    }
+    printf("\n");
+
+    bool status = true;
+    unsigned int superlinear_count = 0;
+    for (ProgramShape s = 0; s < PROGRAM_SHAPES_COUNT; s++) {
+        if (shape == NULL || *shape == s) {
+            status = scaleShape(s, max_nodes, loop_iterations, &superlinear_count) && status;
+        }
+    }
+
+    printf("Times in ms. k is the exponent of the growth of the time with the nodes since the previous size, "
+           "marked with ! above %.2f (%u).\n", SUPERLINEAR_EXPONENT, superlinear_count);
+    return status;
+}
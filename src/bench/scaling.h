@@ -0,0 +1,16 @@
+#ifndef _SCALING_H_
+#define _SCALING_H_
+
+#include <stdbool.h>
+
+#include "generator.h"
+
+#define SCALING_MIN_NODES 1000
+#define SCALING_MAX_NODES 10000000
+
+// Times the phases on generated programs of the shape, or of every shape if it is NULL, from SCALING_MIN_NODES to
+// max_nodes nodes in steps of 10x, and prints how each phase grows with the size. The hot loops run loop_iterations
+// iterations. Returns false if a program could not be parsed.
+bool runScaling(unsigned int max_nodes, const ProgramShape* shape, unsigned int loop_iterations);
+
+#endif
@@ -1,10 +1,15 @@
 #include <stdbool.h>
+#include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <pthread.h>
 
+#include "ast/optimize.h"
 #include "in/in.h"
 #include "out/out.h"
 
+#include "stats.h"
+
 #if defined(_WIN32) || defined(_WIN64)
 #define PATH_SEPARATOR '\\'
 #else
@@ -16,25 +21,205 @@
 #define PARSE_AST_ERR_MSG "Error parsing the file %s\n"
 #define COMPILE_AST_ERR "Error compiling the file %s\n"
 #define COMPILED_MSG "Compiled file %s\n"
+#define HISTOGRAM_FILE_ENV "MYLANG_HISTOGRAM"
+#define HISTOGRAM_MODE_WARN_MSG "Only the tree walker records the histogram, running with -x tree instead of -x %s\n"
+#define USAGE_MSG "Usage: %s [-j jobs] [-x tree|bytecode|jit|tiered|iterative] [-l] [--stats[=text|json]] [--profile] [--session] [file...]\n"
+
+#define SESSION_PROMPT "> "
+#define SESSION_CONTINUATION_PROMPT ". "
+#define SESSION_INITIAL_FRAME_SIZE 64
+
+// Names of the execution modes of the interactive mode
+static const char* ExecModeStr[] = {
+    [EXEC_MODE_BYTECODE]    = "bytecode",
+    [EXEC_MODE_TREE_WALKER] = "tree",
+    [EXEC_MODE_JIT]         = "jit",
+    [EXEC_MODE_TIERED]      = "tiered",
+    [EXEC_MODE_ITERATIVE]   = "iterative",
+};
+
+static const StatsPhase BackendCodegenPhase[] = {
+    [BACKEND_C]       = PHASE_CODEGEN_C,
+    [BACKEND_JAVA]    = PHASE_CODEGEN_JAVA,
+    [BACKEND_LIBRARY] = PHASE_CODEGEN_LIBRARY,
+};
 
-void compile(const char* out_file_path_no_ext, size_t len, const char* file_name, const ASTNode* ast, const SymbolTable* st, const char* ext, bool (*compile_to)(const ASTNode* ast, const SymbolTable* st, const char* fname, const IOStream* stream));
-bool intrepert(InContext* ctx);
-static inline void compileFile(const char* file_path);
+// Compilation of one file by a worker. Its messages are kept until they are printed in the order of the files.
+typedef struct CompileJob {
+    const char* file_path;
+    FileStats* stats;
+    bool status;
+    bool done;
+    char* out;
+    size_t out_size;
+    char* err;
+    size_t err_size;
+} CompileJob;
+
+typedef struct JobQueue {
+    CompileJob* jobs;
+    bool library;
+    unsigned int count;
+    unsigned int next;
+    pthread_mutex_t lock;
+    pthread_cond_t job_done;
+} JobQueue;
+
+bool compile(const char* out_file_path_no_ext, size_t len, const char* file_name, const ASTNode* ast, const SymbolTable* st, const char* ext, bool (*compile_to)(const ASTNode* ast, const SymbolTable* st, const char* fname, const IOStream* stream), StatsBackend backend, FileStats* stats, FILE* out, FILE* err);
+bool intrepert(InContext* ctx, ExecMode mode, bool profile);
+static void runSession(ExecMode mode);
+static bool profileFile(const char* file_path);
+static const char* getHistogramPath();
+static bool dumpHistogram();
+static inline bool compileFile(const char* file_path, bool library, FileStats* stats, FILE* out, FILE* err);
+static inline bool compileFileTimed(const char* file_path, bool library, FileStats* stats, FILE* out, FILE* err);
+static bool compileFiles(const char** file_paths, unsigned int count, unsigned int jobs, bool library, FileStats* stats);
+static inline void optimize(ParseResult* res, unsigned int optimizations);
+static bool parseExecMode(const char* str, ExecMode* mode);
 
 int main(int argc, char *argv[]) {
-    if (argc == 1) {
+    unsigned int jobs = 1;
+    bool jobs_given = false;
+    bool library = false;
+    StatsFormat stats_format = STATS_NONE;
+    bool profile = false;
+    bool session = false;
+    ExecMode mode = EXEC_MODE_BYTECODE;
+    bool mode_given = false;
+    const char** file_paths = malloc(argc * sizeof(char*));
+    assert(file_paths != NULL);
+    unsigned int count = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "-j", 2) == 0) {
+            const char* n = argv[i][2] != '\0' ? &argv[i][2] : (i + 1 < argc ? argv[++i] : "");
+            int value = atoi(n);
+            if (value <= 0) {
+                fprintf(stderr, USAGE_MSG, argv[0]);
+                free(file_paths);
+                return 1;
+            }
+            jobs = value;
+            jobs_given = true;
+        } else if (strcmp(argv[i], "-l") == 0) {
+            library = true;
+        } else if (strcmp(argv[i], "--profile") == 0) {
+            profile = true;
+        } else if (strcmp(argv[i], "--session") == 0) {
+            session = true;
+        } else if (strncmp(argv[i], "--stats", 7) == 0) {
+            const char* str = argv[i][7] == '=' ? &argv[i][8] : "text";
+            if ((argv[i][7] != '\0' && argv[i][7] != '=') || !parseStatsFormat(str, &stats_format)) {
+                fprintf(stderr, USAGE_MSG, argv[0]);
+                free(file_paths);
+                return 1;
+            }
+        } else if (strncmp(argv[i], "-x", 2) == 0) {
+            const char* str = argv[i][2] != '\0' ? &argv[i][2] : (i + 1 < argc ? argv[++i] : "");
+            if (!parseExecMode(str, &mode)) {
+                fprintf(stderr, USAGE_MSG, argv[0]);
+                free(file_paths);
+                return 1;
+            }
+            mode_given = true;
+        } else {
+            file_paths[count++] = argv[i];
+        }
+    }
+
+    // The histogram counts the nodes that the tree walker executes, the other modes would leave it empty
+    if (getHistogramPath() != NULL && mode != EXEC_MODE_TREE_WALKER) {
+        if (mode_given) {
+            fprintf(stderr, HISTOGRAM_MODE_WARN_MSG, ExecModeStr[mode]);
+        }
+        mode = EXEC_MODE_TREE_WALKER;
+    }
+
+    bool status = true;
+    if (count == 0 && session) {
+        runSession(mode);
+    } else if (count == 0 && !jobs_given) {
         InContext* ctx = inInitWithStdin();
-        while( !(intrepert(ctx)) );
+        while( !(intrepert(ctx, mode, profile)) );
         inDelete(&ctx);
+    } else if (count == 0) {
+        fprintf(stderr, NO_FILE_ERR_MSG);
+        status = false;
+    } else if (profile) {
+        for (unsigned int i = 0; i < count; i++) {
+            status = profileFile(file_paths[i]) && status;
+        }
     } else {
-        for (int i = 1; i < argc; i++) {
-            compileFile(argv[i]);
+        FileStats* stats = malloc(count * sizeof(FileStats));
+        assert(stats != NULL);
+        for (unsigned int i = 0; i < count; i++) {
+            initFileStats(&stats[i], file_paths[i]);
+        }
+
+        double start_ms = getWallTimeMs();
+        status = compileFiles(file_paths, count, jobs, library, stats);
+        if (stats_format != STATS_NONE) {
+            printStats(stdout, stats, count, getWallTimeMs() - start_ms, stats_format);
         }
+        free(stats);
     }
-    return 0;
+
+    status = dumpHistogram() && status;
+
+    free(file_paths);
+    return status ? 0 : 1;
+}
+
+// The file named by $MYLANG_HISTOGRAM in the builds with the evaluator histograms, NULL if they are not recorded
+static const char* getHistogramPath() {
+    const char* path = getenv(HISTOGRAM_FILE_ENV);
+    return isEvalHistogramEnabled() && path != NULL && path[0] != '\0' ? path : NULL;
+}
+
+static bool dumpHistogram() {
+    const char* path = getHistogramPath();
+    if (path == NULL) {
+        return true;
+    }
+
+    FILE* file = fopen(path, "w");
+    if (file == NULL) {
+        fprintf(stderr, OPEN_FILE_ERR_MSG, path);
+        return false;
+    }
+    IOStream* stream = openIOStreamFromFile(file);
+    dumpEvalHistogram(stream);
+    IOStreamClose(&stream);
+    return true;
+}
+
+static bool parseExecMode(const char* str, ExecMode* mode) {
+    for (ExecMode m = 0; m < EXEC_MODE_COUNT; m++) {
+        if (strcmp(str, ExecModeStr[m]) == 0) {
+            *mode = m;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Runs the program with the tree walker and reports its hot spots to stderr
+static Frame* executeProfiled(const ASTNode* ast, const SymbolTable* st, const char* src) {
+    Profile* profile = newProfile();
+    Frame* frame = newFrame(getMaxOffset(st) + 1);
+    executeASTStatementsProfiled(ast, st, frame, profile);
+    endOutputSink(getOutputSink());
+
+    fflush(stdout);
+    IOStream* stream = openIOStreamFromStderr();
+    printProfile(profile, src, DEFAULT_PROFILE_REPORT_SIZE, stream);
+    IOStreamClose(&stream);
+
+    deleteProfile(&profile);
+    return frame;
 }
 
-bool intrepert(InContext* ctx) {
+bool intrepert(InContext* ctx, ExecMode mode, bool profile) {
     printf("> ");
 
     ParseResult res = inParse(ctx);
@@ -54,19 +239,153 @@ bool intrepert(InContext* ctx) {
 
     printf("Parsed stdin: %d AST nodes and %d symbols.\n", res.ast->size, getTotalSymbolAmount(res.st));
 
-    Frame* frame = executeAST(res.ast, res.st);
+    // The profile is of the program as written, so that its statements keep their locations
+    Frame* frame = NULL;
+    if (profile) {
+        frame = executeProfiled(res.ast, res.st, NULL);
+    } else {
+        // The optimizer recurses over the AST, so the iterative mode, meant for the ASTs too deep for that, runs it as parsed
+        if (mode != EXEC_MODE_ITERATIVE) {
+            optimize(&res, AST_OPT_ALL);
+        }
+        frame = executeASTWithMode(res.ast, res.st, mode);
+    }
 
     IOStream* stream = openIOStreamFromStdout();
     printSymbolTable(res.st, frame, stream);
     IOStreamClose(&stream);
 
     deleteFrame(&frame);
-    deleteASTNode(&res.ast);
-    deleteSymbolTable(&res.st);
+    deleteParseResult(&res);
 
     return feof(stdin) != 0;
 }
 
+// Reads the next input of the session, which continues on the next line while its lines end in '\'. Returns NULL at
+// the end of stdin.
+static char* readSessionInput() {
+    char* input = NULL;
+    size_t size = 0;
+    char* line = NULL;
+    size_t capacity = 0;
+    ssize_t len = 0;
+
+    printf(SESSION_PROMPT);
+    fflush(stdout);
+    while ((len = getline(&line, &capacity, stdin)) > 0) {
+        input = realloc(input, size + len + 1);
+        assert(input != NULL);
+        memcpy(input + size, line, len + 1);
+        size += len;
+
+        if (len < 2 || line[len - 2] != '\\' || line[len - 1] != '\n') {
+            break;
+        }
+        printf(SESSION_CONTINUATION_PROMPT);
+        fflush(stdout);
+    }
+    free(line);
+    return input;
+}
+
+// The inputs are parsed one at a time into the same symbol table and only their statements are executed, on a frame
+// that grows with the variables, so the variables are kept between inputs and an input costs the same however long the
+// session is. After each input it prints the variables that the input defined.
+static void runSession(ExecMode mode) {
+    SymbolTable* st = newSymbolTableDefault();
+    Frame* frame = resizeFrame(newFrame(0), SESSION_INITIAL_FRAME_SIZE);
+
+    char* input = NULL;
+    while ((input = readSessionInput()) != NULL) {
+        // The variables of the session are the ones of its outermost scope, which take the first slots of the frame
+        const unsigned int first_offset = getScopeSize(getCurrentScope(st));
+        InContext* ctx = inInitWithString(input);
+        ParseResult res = inParseIntoSt(ctx, st);
+        assert(res.st == st);
+        const unsigned int end_offset = getScopeSize(getCurrentScope(st));
+
+        // The optimizer may add temporaries, so the frame is sized after it
+        if (res.status && res.ast != NULL && mode != EXEC_MODE_ITERATIVE) {
+            optimize(&res, AST_OPT_ALL);
+        }
+
+        unsigned int frame_size = getMaxOffset(st) + 1;
+        if (frame_size > frame->size) {
+            frame = resizeFrame(frame, frame_size > 2 * frame->size ? frame_size : 2 * frame->size);
+        }
+        // The variables of an input with errors stay defined, and start at 0 like the ones of the next inputs
+        memset(frame->values + first_offset, 0, (end_offset - first_offset) * sizeof(int));
+
+        if (!res.status) {
+            fprintf(stderr, PARSE_AST_ERR_MSG, "stdin");
+        } else if (res.ast != NULL) {
+            executeASTWithFrame(res.ast, st, frame, mode);
+
+            IOStream* stream = openIOStreamFromStdout();
+            printSymbolTableSlots(st, frame, first_offset, end_offset, stream);
+            IOStreamClose(&stream);
+        }
+
+        if (res.arena != NULL) {
+            deleteASTArena(&res.arena);
+        }
+        inDelete(&ctx);
+        free(input);
+    }
+    printf("\n");
+
+    deleteFrame(&frame);
+    deleteSymbolTable(&st);
+}
+
+static char* readFile(const char* file_path) {
+    FILE* file = fopen(file_path, "r");
+    if (file == NULL) {
+        return NULL;
+    }
+
+    size_t capacity = 4096;
+    size_t size = 0;
+    char* src = malloc(capacity);
+    assert(src != NULL);
+    size_t n = 0;
+    while ((n = fread(src + size, 1, capacity - size - 1, file)) > 0) {
+        size += n;
+        if (size == capacity - 1) {
+            capacity *= 2;
+            src = realloc(src, capacity);
+            assert(src != NULL);
+        }
+    }
+    src[size] = '\0';
+    fclose(file);
+    return src;
+}
+
+static bool profileFile(const char* file_path) {
+    char* src = readFile(file_path);
+    if (src == NULL) {
+        fprintf(stderr, OPEN_FILE_ERR_MSG, file_path);
+        return false;
+    }
+
+    InContext* ctx = inInitWithString(src);
+    ParseResult res = inParse(ctx);
+    inDelete(&ctx);
+
+    bool status = res.status;
+    if (!res.status) {
+        fprintf(stderr, PARSE_AST_ERR_MSG, file_path);
+    } else if (res.ast != NULL) {
+        Frame* frame = executeProfiled(res.ast, res.st, src);
+        deleteFrame(&frame);
+        deleteParseResult(&res);
+    }
+
+    free(src);
+    return status;
+}
+
 void getOutputInfo(const char* file_path, size_t len, char* out_file_path_no_ext, size_t* len_no_ext, const char** file_name) {
     const char* last_dot = strrchr(file_path, '.');
     if(last_dot == file_path) {
@@ -82,33 +401,60 @@ void getOutputInfo(const char* file_path, size_t len, char* out_file_path_no_ext
     *len_no_ext = chars_to_copy;
 }
 
-static inline void compileFile(const char* file_path) {
-    FILE *in_file = fopen(file_path, "r");
-    if (in_file == NULL) {
-        fprintf(stderr, OPEN_FILE_ERR_MSG, file_path);
-        return;
+// The allocations of the file are counted from the thread that compiles it, which does it from start to end
+static inline bool compileFile(const char* file_path, bool library, FileStats* stats, FILE* out, FILE* err) {
+    resetASTAllocStats();
+    stats->status = compileFileTimed(file_path, library, stats, out, err);
+    stats->allocs = getASTAllocStats();
+    return stats->status;
+}
+
+static inline bool compileFileTimed(const char* file_path, bool library, FileStats* stats, FILE* out, FILE* err) {
+    PhaseTimer timer;
+    startPhase(&timer);
+
+    // The regular files are scanned in place, the rest (like pipes) through a stream
+    FILE* in_file = NULL;
+    InContext* ctx = inInitWithMappedFile(file_path);
+    if (ctx == NULL) {
+        in_file = fopen(file_path, "r");
+        if (in_file == NULL) {
+            fprintf(err, OPEN_FILE_ERR_MSG, file_path);
+            return false;
+        }
+        ctx = inInitWithFile(in_file);
     }
 
-    InContext* ctx = inInitWithFile(in_file);
+    inSetErrorStream(ctx, err);
     ParseResult res = inParse(ctx);
 
     inDelete(&ctx);
-    fclose(in_file);
+    if (in_file != NULL) {
+        fclose(in_file);
+    }
+    stopPhase(&timer, stats, PHASE_PARSE);
 
     if (!res.status) {
-        fprintf(stderr, PARSE_AST_ERR_MSG, file_path);
+        fprintf(err, PARSE_AST_ERR_MSG, file_path);
         assert(res.ast == NULL);
         assert(res.st == NULL);
-        return;
+        return false;
     }
 
     if(res.ast == NULL) {
-        printf("Nothing to compile!\n");
+        fprintf(out, "Nothing to compile!\n");
         assert(res.st == NULL);
-        return;
+        return true;
     }
 
-    printf("Parsed file %s: %d AST nodes and %d symbols.\n", file_path, res.ast->size, getTotalSymbolAmount(res.st));
+    fprintf(out, "Parsed file %s: %d AST nodes and %d symbols.\n", file_path, res.ast->size, getTotalSymbolAmount(res.st));
+    stats->node_count = res.ast->size;
+    stats->symbol_count = getTotalSymbolAmount(res.st);
+
+    startPhase(&timer);
+    // Nothing dumps the state of a compiled program, so its variables can share slots
+    optimize(&res, AST_OPT_ALL | AST_OPT_FRAME_SLOTS);
+    stopPhase(&timer, stats, PHASE_OPTIMIZE);
 
     size_t len = strlen(file_path);
     char out_file_path_no_ext[len + 1];
@@ -116,34 +462,152 @@ static inline void compileFile(const char* file_path) {
     const char* file_name = NULL;
     getOutputInfo(file_path, len, out_file_path_no_ext, &len_no_ext, &file_name);
 
-    compile(out_file_path_no_ext, len_no_ext, file_name, res.ast, res.st, ".c", &outCompileToC);
-    compile(out_file_path_no_ext, len_no_ext, file_name, res.ast, res.st, ".java", &outCompileToJava);
+    bool status = compile(out_file_path_no_ext, len_no_ext, file_name, res.ast, res.st, ".c", &outCompileToC, BACKEND_C, stats, out, err);
+    status = compile(out_file_path_no_ext, len_no_ext, file_name, res.ast, res.st, ".java", &outCompileToJava, BACKEND_JAVA, stats, out, err) && status;
+    if (library) {
+        status = compile(out_file_path_no_ext, len_no_ext, file_name, res.ast, res.st, ".lib.c", &outCompileToCLibrary, BACKEND_LIBRARY, stats, out, err) && status;
+    }
 
-    deleteASTNode(&res.ast);
-    deleteSymbolTable(&res.st);
+    deleteParseResult(&res);
+    return status;
 }
 
-void compile(const char* out_file_path_no_ext, size_t len, const char* file_name, const ASTNode* ast, const SymbolTable* st, const char* ext, bool (*compile_to)(const ASTNode* ast, const SymbolTable* st, const char* fname, const IOStream* stream)) {
+static void* compileWorker(void* arg) {
+    JobQueue* queue = arg;
+
+    while (true) {
+        pthread_mutex_lock(&queue->lock);
+        unsigned int index = queue->next++;
+        pthread_mutex_unlock(&queue->lock);
+
+        if (index >= queue->count) {
+            return NULL;
+        }
+
+        CompileJob* job = &queue->jobs[index];
+        FILE* out = open_memstream(&job->out, &job->out_size);
+        FILE* err = open_memstream(&job->err, &job->err_size);
+        assert(out != NULL && err != NULL);
+
+        job->status = compileFile(job->file_path, queue->library, job->stats, out, err);
+
+        fclose(out);
+        fclose(err);
+
+        pthread_mutex_lock(&queue->lock);
+        job->done = true;
+        pthread_cond_broadcast(&queue->job_done);
+        pthread_mutex_unlock(&queue->lock);
+    }
+}
+
+// Returns false if any of the files failed to compile
+static bool compileFiles(const char** file_paths, unsigned int count, unsigned int jobs, bool library, FileStats* stats) {
+    if (jobs == 1 || count == 1) {
+        bool status = true;
+        for (unsigned int i = 0; i < count; i++) {
+            status = compileFile(file_paths[i], library, &stats[i], stdout, stderr) && status;
+        }
+        return status;
+    }
+
+    JobQueue queue = { .library = library, .count = count, .next = 0 };
+    queue.jobs = calloc(count, sizeof(CompileJob));
+    assert(queue.jobs != NULL);
+    for (unsigned int i = 0; i < count; i++) {
+        queue.jobs[i].file_path = file_paths[i];
+        queue.jobs[i].stats = &stats[i];
+    }
+    pthread_mutex_init(&queue.lock, NULL);
+    pthread_cond_init(&queue.job_done, NULL);
+
+    unsigned int worker_count = jobs < count ? jobs : count;
+    pthread_t* workers = malloc(worker_count * sizeof(pthread_t));
+    assert(workers != NULL);
+    for (unsigned int i = 0; i < worker_count; i++) {
+        int res = pthread_create(&workers[i], NULL, &compileWorker, &queue);
+        assert(res == 0);
+        (void) res;
+    }
+
+    // The messages of each file are printed as soon as it and all the files before it are done
+    bool status = true;
+    for (unsigned int i = 0; i < count; i++) {
+        CompileJob* job = &queue.jobs[i];
+
+        pthread_mutex_lock(&queue.lock);
+        while (!job->done) {
+            pthread_cond_wait(&queue.job_done, &queue.lock);
+        }
+        pthread_mutex_unlock(&queue.lock);
+
+        fwrite(job->out, 1, job->out_size, stdout);
+        fflush(stdout);
+        fwrite(job->err, 1, job->err_size, stderr);
+        free(job->out);
+        free(job->err);
+
+        status = job->status && status;
+    }
+
+    for (unsigned int i = 0; i < worker_count; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    free(workers);
+
+    pthread_cond_destroy(&queue.job_done);
+    pthread_mutex_destroy(&queue.lock);
+    free(queue.jobs);
+
+    return status;
+}
+
+static inline void optimize(ParseResult* res, unsigned int optimizations) {
+    // The new nodes go to the arena of the parse, so that they are released with the rest of the AST
+    ASTArena* previous_arena = setCurrentASTArena(res->arena);
+    optimizeAST(&res->ast, res->st, optimizations);
+    setCurrentASTArena(previous_arena);
+}
+
+// The code is generated in memory and then written to the file, so that the two are measured apart
+bool compile(const char* out_file_path_no_ext, size_t len, const char* file_name, const ASTNode* ast, const SymbolTable* st, const char* ext, bool (*compile_to)(const ASTNode* ast, const SymbolTable* st, const char* fname, const IOStream* stream), StatsBackend backend, FileStats* stats, FILE* out, FILE* err) {
     size_t ext_len = strlen(ext);
     char out_file_path[len + ext_len + 1];
     strncpy(out_file_path, out_file_path_no_ext, len);
     strncpy(out_file_path + len, ext, ext_len);
     out_file_path[len + ext_len] = '\0';
 
-    FILE* out_file = fopen(out_file_path, "w+");
-    if(out_file == NULL) {
-        fprintf(stderr, OPEN_FILE_ERR_MSG, out_file_path);
-        return;
-    }
-
-    IOStream* stream = openIOStreamFromFile(out_file);
-
+    PhaseTimer timer;
+    startPhase(&timer);
+    char* code = NULL;
+    size_t size = 0;
+    IOStream* stream = openIOStreamFromMemmory(&code, &size);
     bool status = compile_to(ast, st, file_name, stream);
     IOStreamClose(&stream);
+    size_t code_len = code != NULL ? size - 1 : 0;
+    stopPhase(&timer, stats, BackendCodegenPhase[backend]);
+
     if(!status) {
-        fprintf(stderr, COMPILE_AST_ERR, out_file_path);
-        return;
+        fprintf(err, COMPILE_AST_ERR, out_file_path);
+        free(code);
+        return false;
+    }
+    stats->bytes[backend] += code_len;
+
+    startPhase(&timer);
+    FILE* out_file = fopen(out_file_path, "w+");
+    if(out_file != NULL) {
+        status = fwrite(code, 1, code_len, out_file) == code_len;
+        status = fclose(out_file) == 0 && status;
+    }
+    stopPhase(&timer, stats, PHASE_IO);
+    free(code);
+
+    if(out_file == NULL || !status) {
+        fprintf(err, OPEN_FILE_ERR_MSG, out_file_path);
+        return false;
     }
 
-    printf(COMPILED_MSG, out_file_path);
+    fprintf(out, COMPILED_MSG, out_file_path);
+    return true;
 }
@@ -0,0 +1,174 @@
+#include "stats.h"
+
+#include <assert.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+
+static const char* StatsFormatStr[] = {
+    [STATS_NONE] = "none",
+    [STATS_TEXT] = "text",
+    [STATS_JSON] = "json",
+};
+
+static const char* StatsPhaseStr[] = {
+    [PHASE_PARSE]           = "parse",
+    [PHASE_OPTIMIZE]        = "optimize",
+    [PHASE_CODEGEN_C]       = "codegen_c",
+    [PHASE_CODEGEN_JAVA]    = "codegen_java",
+    [PHASE_CODEGEN_LIBRARY] = "codegen_library",
+    [PHASE_IO]              = "io",
+};
+
+static const char* StatsBackendStr[] = {
+    [BACKEND_C]       = "c",
+    [BACKEND_JAVA]    = "java",
+    [BACKEND_LIBRARY] = "library",
+};
+
+bool parseStatsFormat(const char* str, StatsFormat* format) {
+    assert((sizeof(StatsFormatStr)/sizeof(StatsFormatStr[0])) == STATS_FORMATS_COUNT);
+    for (StatsFormat f = STATS_TEXT; f < STATS_FORMATS_COUNT; f++) {
+        if (strcmp(str, StatsFormatStr[f]) == 0) {
+            *format = f;
+            return true;
+        }
+    }
+    return false;
+}
+
+void initFileStats(FileStats* stats, const char* file_path) {
+    assert(stats != NULL);
+    memset(stats, 0, sizeof(FileStats));
+    stats->file_path = file_path;
+}
+
+static inline double clockMs(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+double getWallTimeMs() {
+    return clockMs(CLOCK_MONOTONIC);
+}
+
+void startPhase(PhaseTimer* timer) {
+    assert(timer != NULL);
+    timer->wall_start_ms = clockMs(CLOCK_MONOTONIC);
+    timer->cpu_start_ms = clockMs(CLOCK_THREAD_CPUTIME_ID);
+}
+
+void stopPhase(const PhaseTimer* timer, FileStats* stats, StatsPhase phase) {
+    assert(timer != NULL && stats != NULL && phase < STATS_PHASES_COUNT);
+    stats->phases[phase].wall_ms += clockMs(CLOCK_MONOTONIC) - timer->wall_start_ms;
+    stats->phases[phase].cpu_ms += clockMs(CLOCK_THREAD_CPUTIME_ID) - timer->cpu_start_ms;
+}
+
+static void addFileStats(FileStats* total, const FileStats* stats) {
+    total->status = total->status && stats->status;
+    total->node_count += stats->node_count;
+    total->symbol_count += stats->symbol_count;
+    for (StatsPhase p = 0; p < STATS_PHASES_COUNT; p++) {
+        total->phases[p].wall_ms += stats->phases[p].wall_ms;
+        total->phases[p].cpu_ms += stats->phases[p].cpu_ms;
+    }
+    for (StatsBackend b = 0; b < STATS_BACKENDS_COUNT; b++) {
+        total->bytes[b] += stats->bytes[b];
+    }
+    for (ASTAllocKind k = 0; k < AST_ALLOC_KINDS_COUNT; k++) {
+        total->allocs.counters[k].count += stats->allocs.counters[k].count;
+        total->allocs.counters[k].bytes += stats->allocs.counters[k].bytes;
+    }
+}
+
+static void printFileStatsText(FILE* out, const FileStats* stats) {
+    fprintf(out, "  %-16s %12s %12s\n", "phase", "wall (ms)", "cpu (ms)");
+    for (StatsPhase p = 0; p < STATS_PHASES_COUNT; p++) {
+        fprintf(out, "  %-16s %12.3f %12.3f\n", StatsPhaseStr[p], stats->phases[p].wall_ms, stats->phases[p].cpu_ms);
+    }
+    fprintf(out, "  output:");
+    for (StatsBackend b = 0; b < STATS_BACKENDS_COUNT; b++) {
+        fprintf(out, "%s %s %zu B", b == 0 ? "" : ",", StatsBackendStr[b], stats->bytes[b]);
+    }
+    fprintf(out, "\n  allocations:");
+    for (ASTAllocKind k = 0; k < AST_ALLOC_KINDS_COUNT; k++) {
+        fprintf(out, "%s %s %lu (%zu B)", k == 0 ? "" : ",", ASTAllocKindToStr(k), stats->allocs.counters[k].count, stats->allocs.counters[k].bytes);
+    }
+    fprintf(out, "\n");
+}
+
+static void printJSONString(FILE* out, const char* str) {
+    fputc('"', out);
+    for (const char* c = str; *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\') {
+            fprintf(out, "\\%c", *c);
+        } else if ((unsigned char) *c < 0x20) {
+            fprintf(out, "\\u%04x", *c);
+        } else {
+            fputc(*c, out);
+        }
+    }
+    fputc('"', out);
+}
+
+static void printFileStatsJSON(FILE* out, const FileStats* stats) {
+    fprintf(out, "\"status\":%s,\"nodes\":%u,\"symbols\":%u,\"phases\":{", stats->status ? "true" : "false", stats->node_count, stats->symbol_count);
+    for (StatsPhase p = 0; p < STATS_PHASES_COUNT; p++) {
+        fprintf(out, "%s\"%s\":{\"wall_ms\":%.3f,\"cpu_ms\":%.3f}", p == 0 ? "" : ",", StatsPhaseStr[p], stats->phases[p].wall_ms, stats->phases[p].cpu_ms);
+    }
+    fprintf(out, "},\"bytes\":{");
+    for (StatsBackend b = 0; b < STATS_BACKENDS_COUNT; b++) {
+        fprintf(out, "%s\"%s\":%zu", b == 0 ? "" : ",", StatsBackendStr[b], stats->bytes[b]);
+    }
+    fprintf(out, "},\"allocs\":{");
+    for (ASTAllocKind k = 0; k < AST_ALLOC_KINDS_COUNT; k++) {
+        fprintf(out, "%s\"%s\":{\"count\":%lu,\"bytes\":%zu}", k == 0 ? "" : ",", ASTAllocKindToStr(k), stats->allocs.counters[k].count, stats->allocs.counters[k].bytes);
+    }
+    fprintf(out, "}");
+}
+
+void printStats(FILE* out, const FileStats* files, unsigned int count, double wall_ms, StatsFormat format) {
+    assert(out != NULL && (files != NULL || count == 0));
+    assert((sizeof(StatsPhaseStr)/sizeof(StatsPhaseStr[0])) == STATS_PHASES_COUNT);
+    assert((sizeof(StatsBackendStr)/sizeof(StatsBackendStr[0])) == STATS_BACKENDS_COUNT);
+
+    FileStats total;
+    initFileStats(&total, NULL);
+    total.status = true;
+    for (unsigned int i = 0; i < count; i++) {
+        addFileStats(&total, &files[i]);
+    }
+
+    // ru_maxrss is in kilobytes on Linux
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    double cpu_ms = clockMs(CLOCK_PROCESS_CPUTIME_ID);
+
+    switch (format) {
+        case STATS_TEXT: {
+            for (unsigned int i = 0; i < count; i++) {
+                fprintf(out, "Stats for %s: %u AST nodes and %u symbols%s\n", files[i].file_path, files[i].node_count, files[i].symbol_count, files[i].status ? "" : " (failed)");
+                printFileStatsText(out, &files[i]);
+            }
+            fprintf(out, "Total for %u file%s: %u AST nodes and %u symbols\n", count, count == 1 ? "" : "s", total.node_count, total.symbol_count);
+            printFileStatsText(out, &total);
+            fprintf(out, "  run: wall %.3f ms, cpu %.3f ms, peak RSS %ld KiB\n", wall_ms, cpu_ms, usage.ru_maxrss);
+            break;
+        } case STATS_JSON: {
+            fprintf(out, "{\"files\":[");
+            for (unsigned int i = 0; i < count; i++) {
+                fprintf(out, "%s{\"file\":", i == 0 ? "" : ",");
+                printJSONString(out, files[i].file_path);
+                fputc(',', out);
+                printFileStatsJSON(out, &files[i]);
+                fputc('}', out);
+            }
+            fprintf(out, "],\"total\":{");
+            printFileStatsJSON(out, &total);
+            fprintf(out, ",\"wall_ms\":%.3f,\"cpu_ms\":%.3f,\"peak_rss_kb\":%ld}}\n", wall_ms, cpu_ms, usage.ru_maxrss);
+            break;
+        } default:
+            assert(false);
+    }
+}
@@ -0,0 +1,71 @@
+#ifndef _CLI_STATS_H_
+#define _CLI_STATS_H_
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "ast/alloc_stats.h"
+
+typedef enum StatsFormat {
+    STATS_NONE,
+    STATS_TEXT,
+    STATS_JSON,
+    STATS_FORMATS_COUNT
+} StatsFormat;
+
+// Lexing, parsing and type checking happen together in the parser, reading the input file included.
+// The code generation phases write to memory, writing the output files is accounted as I/O.
+typedef enum StatsPhase {
+    PHASE_PARSE,
+    PHASE_OPTIMIZE,
+    PHASE_CODEGEN_C,
+    PHASE_CODEGEN_JAVA,
+    PHASE_CODEGEN_LIBRARY,
+    PHASE_IO,
+    STATS_PHASES_COUNT
+} StatsPhase;
+
+typedef enum StatsBackend {
+    BACKEND_C,
+    BACKEND_JAVA,
+    BACKEND_LIBRARY,
+    STATS_BACKENDS_COUNT
+} StatsBackend;
+
+typedef struct PhaseTime {
+    double wall_ms;
+    double cpu_ms;  // Of the thread that compiled the file
+} PhaseTime;
+
+typedef struct FileStats {
+    const char* file_path;
+    bool status;
+    unsigned int node_count;
+    unsigned int symbol_count;
+    PhaseTime phases[STATS_PHASES_COUNT];
+    size_t bytes[STATS_BACKENDS_COUNT];
+    ASTAllocStats allocs;
+} FileStats;
+
+typedef struct PhaseTimer {
+    double wall_start_ms;
+    double cpu_start_ms;
+} PhaseTimer;
+
+bool parseStatsFormat(const char* str, StatsFormat* format);
+
+void initFileStats(FileStats* stats, const char* file_path);
+
+void startPhase(PhaseTimer* timer);
+
+// Adds the time since the timer started to the phase
+void stopPhase(const PhaseTimer* timer, FileStats* stats, StatsPhase phase);
+
+// Elapsed time since an arbitrary point, in milliseconds
+double getWallTimeMs();
+
+// Prints the stats of each file and their totals, with the wall time of the whole run, the CPU time of the process
+// and its peak resident set size
+void printStats(FILE* out, const FileStats* files, unsigned int count, double wall_ms, StatsFormat format);
+
+#endif
@@ -0,0 +1,158 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#include "out/histogram.h"
+
+// Merges the histograms dumped by the evaluator (see out/histogram.h) by adding the counts of the same rows, and
+// prints them sorted by kind and by decreasing count
+
+#define MAX_FIELD_SIZE 64
+#define MAX_LINE_SIZE (3 * MAX_FIELD_SIZE + 32)
+#define INITIAL_CAPACITY 1024
+
+#define USAGE_MSG "Usage: %s file.csv...\n"
+#define OPEN_FILE_ERR_MSG "Could not open the file %s\n"
+#define PARSE_ERR_MSG "Invalid row in %s:%u: %s"
+
+typedef struct Row {
+    char kind[MAX_FIELD_SIZE];
+    char parent[MAX_FIELD_SIZE];
+    char child[MAX_FIELD_SIZE];
+    unsigned long count;
+} Row;
+
+typedef struct Rows {
+    Row* rows;
+    unsigned int size;
+    unsigned int capacity;
+} Rows;
+
+static void pushRow(Rows* rows, const Row* row) {
+    if (rows->size == rows->capacity) {
+        rows->capacity = rows->capacity == 0 ? INITIAL_CAPACITY : 2 * rows->capacity;
+        rows->rows = realloc(rows->rows, rows->capacity * sizeof(Row));
+        assert(rows->rows != NULL);
+    }
+    rows->rows[rows->size++] = *row;
+}
+
+// Splits the next comma separated field, which can be empty
+static bool readField(char** line, char* field) {
+    char* end = strpbrk(*line, ",\r\n");
+    size_t len = end != NULL ? (size_t)(end - *line) : strlen(*line);
+    if (len >= MAX_FIELD_SIZE) {
+        return false;
+    }
+    memcpy(field, *line, len);
+    field[len] = '\0';
+    *line += len + (end != NULL && *end == ',');
+    return true;
+}
+
+static bool parseRow(char* line, Row* row) {
+    char count[MAX_FIELD_SIZE];
+    char* end = NULL;
+    if (!readField(&line, row->kind) || !readField(&line, row->parent) || !readField(&line, row->child) || !readField(&line, count)) {
+        return false;
+    }
+    row->count = strtoul(count, &end, 10);
+    return end != count && *end == '\0';
+}
+
+static bool readHistogram(const char* path, Rows* rows) {
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        fprintf(stderr, OPEN_FILE_ERR_MSG, path);
+        return false;
+    }
+
+    char line[MAX_LINE_SIZE];
+    unsigned int lineno = 0;
+    bool status = true;
+    while (fgets(line, MAX_LINE_SIZE, file) != NULL) {
+        lineno++;
+        if (strncmp(line, HISTOGRAM_CSV_HEADER, strlen(HISTOGRAM_CSV_HEADER)) == 0 || line[0] == '\n') {
+            continue;
+        }
+
+        Row row;
+        if (!parseRow(line, &row)) {
+            fprintf(stderr, PARSE_ERR_MSG, path, lineno, line);
+            status = false;
+            continue;
+        }
+        pushRow(rows, &row);
+    }
+
+    fclose(file);
+    return status;
+}
+
+static int compareKeys(const void* a, const void* b) {
+    const Row* r1 = a;
+    const Row* r2 = b;
+    int c = strcmp(r1->kind, r2->kind);
+    if (c == 0) {
+        c = strcmp(r1->parent, r2->parent);
+    }
+    if (c == 0) {
+        c = strcmp(r1->child, r2->child);
+    }
+    return c;
+}
+
+static int compareCounts(const void* a, const void* b) {
+    const Row* r1 = a;
+    const Row* r2 = b;
+    int c = strcmp(r1->kind, r2->kind);
+    if (c == 0) {
+        c = r1->count < r2->count ? 1 : (r1->count > r2->count ? -1 : 0);
+    }
+    return c != 0 ? c : compareKeys(a, b);
+}
+
+// Adds up the rows with the same key, in place
+static void mergeRows(Rows* rows) {
+    if (rows->size == 0) {
+        return;
+    }
+
+    qsort(rows->rows, rows->size, sizeof(Row), &compareKeys);
+    unsigned int size = 1;
+    for (unsigned int i = 1; i < rows->size; i++) {
+        if (compareKeys(&rows->rows[size - 1], &rows->rows[i]) == 0) {
+            rows->rows[size - 1].count += rows->rows[i].count;
+        } else {
+            rows->rows[size++] = rows->rows[i];
+        }
+    }
+    rows->size = size;
+
+    qsort(rows->rows, rows->size, sizeof(Row), &compareCounts);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, USAGE_MSG, argv[0]);
+        return 1;
+    }
+
+    Rows rows = { NULL, 0, 0 };
+    bool status = true;
+    for (int i = 1; i < argc; i++) {
+        status = readHistogram(argv[i], &rows) && status;
+    }
+
+    mergeRows(&rows);
+
+    printf("%s\n", HISTOGRAM_CSV_HEADER);
+    for (unsigned int i = 0; i < rows.size; i++) {
+        printf("%s,%s,%s,%lu\n", rows.rows[i].kind, rows.rows[i].parent, rows.rows[i].child, rows.rows[i].count);
+    }
+
+    free(rows.rows);
+    return status ? 0 : 1;
+}
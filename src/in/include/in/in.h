@@ -5,6 +5,7 @@
 #include <stdbool.h>
 
 #include "ast/ast.h"
+#include "ast/arena.h"
 
 typedef struct InContext InContext;
 
@@ -12,6 +13,7 @@ typedef struct ParseResult {
     bool status;
     ASTNode* ast;
     SymbolTable* st;
+    ASTArena* arena; // Owns every node of ast
 } ParseResult;
 
 InContext* inInitWithFile(FILE* file);
@@ -20,12 +22,35 @@ InContext* inInitWithString(const char* string);
 
 InContext* inInitWithStdin();
 
+// Zero bytes that must end the buffer of inInitWithBuffer
+#define IN_BUFFER_PADDING 2
+
+// Scans the buffer in place, without copying it. The buffer belongs to the caller and must outlive the context, end
+// with IN_BUFFER_PADDING zero bytes (included in size) and be writable, as the scanner changes it while it scans.
+// Returns NULL if the buffer does not end with the padding.
+InContext* inInitWithBuffer(char* buffer, size_t size);
+
+// Maps the file into memory and scans it in place, without reading it through a stream. Returns NULL if the file can
+// not be mapped (e.g. it is not a regular file), in which case it can still be read with inInitWithFile.
+InContext* inInitWithMappedFile(const char* file_path);
+
 void inDelete(InContext** ctx);
 
+// Where the syntax and semantic errors are reported, stderr by default
+void inSetErrorStream(InContext* ctx, FILE* err);
+
 ParseResult inParse(const InContext* ctx);
 
+// Deletes st if the input has errors
 ParseResult inParseWithSt(const InContext* ctx, SymbolTable* st);
 
+// Adds the input to st, which is kept if the input has errors (in its outermost scope, with the symbols defined before
+// the error), so that a session can parse its inputs one at a time into the same symbol table
+ParseResult inParseIntoSt(const InContext* ctx, SymbolTable* st);
+
+// Releases the AST (in O(chunks) of its arena) and the symbol table
+void deleteParseResult(ParseResult* res);
+
 int inLex(const InContext* ctx, void* yylval_param);
 
 unsigned int inGetLineNumber(const InContext* ctx);
@@ -5,12 +5,21 @@
 
 #include "actions.h"
 
+static _Thread_local FILE* error_stream = NULL;
+
+FILE* setErrorStream(FILE* stream) {
+  FILE* previous = error_stream;
+  error_stream = stream;
+  return previous;
+}
+
 static inline void printError(int lineno, const char* type, const char * s, va_list args) {
   fflush(stdout);
 
-  fprintf(stderr, "[%s ERROR] (line %d): ", type, lineno);
-  vfprintf(stderr, s, args);
-  fprintf(stderr, "\n");
+  FILE* stream = error_stream != NULL ? error_stream : stderr;
+  fprintf(stream, "[%s ERROR] (line %d): ", type, lineno);
+  vfprintf(stream, s, args);
+  fprintf(stream, "\n");
 }
 
 void syntaxError(int lineno, const char* s, ...) {
@@ -1,12 +1,19 @@
 #ifndef _ACTIONS_H_
 #define _ACTIONS_H_
 
+#include <stdio.h>
+
 #include "ast/ast.h"
 
 #define LINE() yyget_lineno(scanner)
 
+#define LOCATE(node, loc) setASTLocation(node, (loc).first_line, (loc).first_column)
+
 #define TRY(v, action) if( (v = handleErrors(action, LINE())) == NULL ) { YYABORT; }
 
+// Stream where the errors of the calling thread are reported, NULL for stderr. Returns the previous one.
+FILE* setErrorStream(FILE* stream);
+
 void syntaxError(int lineno, const char* s, ...);
 void vsyntaxError(int lineno, const char* s, va_list args);
 
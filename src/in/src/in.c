@@ -1,13 +1,29 @@
 #include <assert.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "in.h"
 
 #include "parser.h"
 #include "lexer.h"
+#include "actions.h"
+
+#if defined(__unix__)
+#define HAS_MMAP 1
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#else
+#define HAS_MMAP 0
+#endif
 
 typedef struct InContext {
     yyscan_t scanner;
     YY_BUFFER_STATE input_buffer;
+    FILE* err;
+    char* mapping;          // Source of inInitWithMappedFile, released with the context
+    size_t mapping_size;
 } InContext;
 
 #define newInContext() (malloc(sizeof(struct InContext)))
@@ -16,6 +32,8 @@ InContext* inInitWithFile(FILE* file) {
     assert(file != NULL);
     InContext* ctx = newInContext();
     yylex_init(&ctx->scanner);
+    ctx->err = stderr;
+    ctx->mapping = NULL;
     ctx->input_buffer = NULL;
     yyset_in(file, ctx->scanner);
     return ctx;
@@ -25,6 +43,8 @@ InContext* inInitWithString(const char* string) {
     assert(string != NULL);
     InContext* ctx = newInContext();
     yylex_init(&ctx->scanner);
+    ctx->err = stderr;
+    ctx->mapping = NULL;
     ctx->input_buffer = yy_scan_string(string, ctx->scanner);
     yyset_lineno(1, ctx->scanner);
     return ctx;
@@ -33,15 +53,130 @@ InContext* inInitWithString(const char* string) {
 InContext* inInitWithStdin() {
     InContext* ctx = newInContext();
     yylex_init(&ctx->scanner);
+    ctx->err = stderr;
+    ctx->mapping = NULL;
     ctx->input_buffer = NULL;
     return ctx;
 }
 
+InContext* inInitWithBuffer(char* buffer, size_t size) {
+    assert(buffer != NULL);
+    InContext* ctx = newInContext();
+    yylex_init(&ctx->scanner);
+    ctx->err = stderr;
+    ctx->mapping = NULL;
+    ctx->input_buffer = yy_scan_buffer(buffer, size, ctx->scanner);
+    if(ctx->input_buffer == NULL) {
+        // Without the padding
+        yylex_destroy(ctx->scanner);
+        free(ctx);
+        return NULL;
+    }
+    yyset_lineno(1, ctx->scanner);
+    return ctx;
+}
+
+#if HAS_MMAP
+
+// The file is mapped over anonymous pages, which are zero, so that the padding is there even when the file ends at the
+// end of a page. The scanner writes into the buffer while it scans, so the mapping is private: only the pages that it
+// writes are copied.
+static char* mapFile(const char* file_path, size_t* mapping_size) {
+    int fd = open(file_path, O_RDONLY);
+    if(fd < 0) {
+        return NULL;
+    }
+
+    struct stat sb;
+    if(fstat(fd, &sb) != 0 || !S_ISREG(sb.st_mode)) {
+        close(fd);
+        return NULL;
+    }
+    size_t size = sb.st_size;
+
+    char* mapping = mmap(NULL, size + IN_BUFFER_PADDING, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(mapping == MAP_FAILED) {
+        close(fd);
+        return NULL;
+    }
+    if(size > 0) {
+        if(mmap(mapping, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+            munmap(mapping, size + IN_BUFFER_PADDING);
+            close(fd);
+            return NULL;
+        }
+        madvise(mapping, size, MADV_SEQUENTIAL);
+    }
+    close(fd);
+
+    *mapping_size = size + IN_BUFFER_PADDING;
+    return mapping;
+}
+
+static void unmapFile(char* mapping, size_t mapping_size) {
+    munmap(mapping, mapping_size);
+}
+
+#else
+
+// Without mmap, the file is read into a buffer with the padding
+static char* mapFile(const char* file_path, size_t* mapping_size) {
+    FILE* file = fopen(file_path, "rb");
+    if(file == NULL) {
+        return NULL;
+    }
+
+    size_t capacity = 4096;
+    size_t size = 0;
+    char* buffer = malloc(capacity);
+    assert(buffer != NULL);
+    size_t n = 0;
+    while((n = fread(buffer + size, 1, capacity - size - IN_BUFFER_PADDING, file)) > 0) {
+        size += n;
+        if(size == capacity - IN_BUFFER_PADDING) {
+            capacity *= 2;
+            buffer = realloc(buffer, capacity);
+            assert(buffer != NULL);
+        }
+    }
+    fclose(file);
+
+    memset(buffer + size, 0, IN_BUFFER_PADDING);
+    *mapping_size = size + IN_BUFFER_PADDING;
+    return buffer;
+}
+
+static void unmapFile(char* mapping, size_t mapping_size) {
+    (void) mapping_size;
+    free(mapping);
+}
+
+#endif
+
+InContext* inInitWithMappedFile(const char* file_path) {
+    assert(file_path != NULL);
+
+    size_t mapping_size = 0;
+    char* mapping = mapFile(file_path, &mapping_size);
+    if(mapping == NULL) {
+        return NULL;
+    }
+
+    InContext* ctx = inInitWithBuffer(mapping, mapping_size);
+    assert(ctx != NULL);
+    ctx->mapping = mapping;
+    ctx->mapping_size = mapping_size;
+    return ctx;
+}
+
 void inDelete(InContext** ctx) {
     assert(ctx != NULL);
     if(*ctx != NULL) {
         yy_delete_buffer((*ctx)->input_buffer, (*ctx)->scanner);
         yylex_destroy((*ctx)->scanner);
+        if((*ctx)->mapping != NULL) {
+            unmapFile((*ctx)->mapping, (*ctx)->mapping_size);
+        }
         free(*ctx);
         *ctx = NULL;
     }
@@ -51,10 +186,12 @@ ParseResult inParse(const InContext* ctx) {
     return inParseWithSt(ctx, newSymbolTableDefault());
 }
 
-ParseResult inParseWithSt(const InContext* ctx, SymbolTable* st) {
+static ParseResult parse(const InContext* ctx, SymbolTable* st, bool keep_st) {
     assert(st != NULL);
 
     ASTNode* ast = NULL;
+    ASTArena* arena = newASTArenaDefault();
+    const Scope* scope = getCurrentScope(st);
 
     ParseContext parse_ctx = {
         .ast = &ast,
@@ -62,32 +199,70 @@ ParseResult inParseWithSt(const InContext* ctx, SymbolTable* st) {
         .nested_comment_level = 0
     };
 
+    ASTArena* previous_arena = setCurrentASTArena(arena);
+    FILE* previous_err = setErrorStream(ctx->err);
     bool status = !yyparse(ctx->scanner, &parse_ctx);
+    setErrorStream(previous_err);
+    setCurrentASTArena(previous_arena);
 
-    if(!status) {
-        if(ast != NULL) {
-            deleteASTNode(&ast);
-        }
+    if(!status || ast == NULL) {
+        ast = NULL;
+        deleteASTArena(&arena);
+    }
 
-        if(st != NULL) {
+    if(!status) {
+        if(!keep_st) {
             deleteSymbolTable(&st);
+        } else {
+            // The error may be in the middle of a scope
+            while(getCurrentScope(st) != scope && leaveScope(st));
         }
     }
 
     return (ParseResult){
         .status = status,
         .ast = ast,
-        .st = st
+        .st = st,
+        .arena = arena
     };
 }
 
+ParseResult inParseWithSt(const InContext* ctx, SymbolTable* st) {
+    return parse(ctx, st, false);
+}
+
+ParseResult inParseIntoSt(const InContext* ctx, SymbolTable* st) {
+    return parse(ctx, st, true);
+}
+
+void deleteParseResult(ParseResult* res) {
+    assert(res != NULL);
+
+    if(res->arena != NULL) {
+        deleteASTArena(&res->arena);
+    } else if(res->ast != NULL) {
+        deleteASTNode(&res->ast);
+    }
+    res->ast = NULL;
+
+    if(res->st != NULL) {
+        deleteSymbolTable(&res->st);
+    }
+}
+
+void inSetErrorStream(InContext* ctx, FILE* err) {
+    assert(ctx != NULL && err != NULL);
+    ctx->err = err;
+}
+
 int inLex(const InContext* ctx, void* yylval_param) {
     ParseContext parse_ctx = {
         .ast = NULL,
         .st = NULL,
         .nested_comment_level = 0
     };
-    return yylex((YYSTYPE*)yylval_param, ctx->scanner, &parse_ctx);
+    YYLTYPE yylloc_param;
+    return yylex((YYSTYPE*)yylval_param, &yylloc_param, ctx->scanner, &parse_ctx);
 }
 
 unsigned int inGetLineNumber(const InContext* ctx) {
@@ -2,7 +2,7 @@
 %define parse.error verbose
 
 %define api.pure full
-//%locations
+%locations
 %parse-param {yyscan_t scanner} {ParseContext* ctx}
 %lex-param   {yyscan_t scanner} {ParseContext* ctx}
 
@@ -20,10 +20,10 @@
 }
 
 %code provides {
-   void yyerror(yyscan_t scanner, ParseContext* ctx, const char * s, ...);
+   void yyerror(YYLTYPE* yylloc, yyscan_t scanner, ParseContext* ctx, const char * s, ...);
 
    #define YY_DECL \
-      int yylex(YYSTYPE* yylval_param, yyscan_t yyscanner, ParseContext* ctx)
+      int yylex(YYSTYPE* yylval_param, YYLTYPE* yylloc_param, yyscan_t yyscanner, ParseContext* ctx)
    YY_DECL;
 }
 
@@ -107,26 +107,27 @@ program
    | line_stmt END                     { *(ctx->ast) = $1; YYACCEPT; } 
    ;
 
+// Left recursive, so that the parser stack does not grow with the number of statements
 stmt_seq
    : stmt   { $$ = $1; }
-   | stmt stmt_seq                     { $$ = newASTStatementList($1, $2); }
+   | stmt_seq stmt                     { $$ = appendASTStatement($1, $2); }
    ;
 
 stmt
-   : line_stmt ';'                     { $$ = $1; }
-   | scope                             { $$ = $1; }
-   | cond_stmt                         { $$ = $1; }
-   | loop                              { $$ = $1; }
+   : line_stmt ';'                     { $$ = $1; LOCATE($$, @1); }
+   | scope                             { $$ = $1; LOCATE($$, @1); }
+   | cond_stmt                         { $$ = $1; LOCATE($$, @1); }
+   | loop                              { $$ = $1; LOCATE($$, @1); }
    ;
 
 line_stmt
-   : %empty                            { $$ = newASTNoOp(); }
-   | exp                               { $$ = $1; }
+   : %empty                            { $$ = newASTNoOp(); LOCATE($$, @$); }
+   | exp                               { $$ = $1; LOCATE($$, @1); }
 //[TODO]: Declarations without assignment are disabled while uninitialization verification is not implemented
 //   | decl                              { TRY($$, declaration($1.s1, $1.s2, NULL, $1.s3, ctx->st)); }
-   | decl '=' exp                      { TRY($$, declaration($1.s1, $1.s2,   $3, $1.s3, ctx->st)); }
-   | PRINT'('exp')'                    { $$ = newASTPrint($3); }
-   | PRINT_VAR '(' ID ')'              { TRY($$, handlePrintVar($3, ctx->st)); }
+   | decl '=' exp                      { TRY($$, declaration($1.s1, $1.s2,   $3, $1.s3, ctx->st)); LOCATE($$, @1); }
+   | PRINT'('exp')'                    { $$ = newASTPrint($3); LOCATE($$, @1); }
+   | PRINT_VAR '(' ID ')'              { TRY($$, handlePrintVar($3, ctx->st)); LOCATE($$, @1); }
    ;
 
 decl
@@ -167,7 +168,7 @@ loop
 
 exp
    : const_exp                         { $$ = $1; }
-   | assign_exp                        { $$ = $1; }
+   | assign_exp                        { $$ = $1; LOCATE($$, @1); }
    ;
 
 assign_exp
@@ -195,13 +196,14 @@ assign_exp
    | const_exp LOGICAL_OR_ASS exp      { TRY($$, newASTCompoundAssignment(AST_LOGICAL_OR, $1, $3)); }
    ;
 
+// Every expression but the assignments is reduced here once, which gives it its location
 const_exp
-   : primitive_exp                     { $$ = $1; }
-   | arithmetic_exp                    { $$ = $1; }
-   | bitwise_exp                       { $$ = $1; }
-   | logical_exp                       { $$ = $1; }
-   | cmp_exp                           { $$ = $1; }
-   | cond_exp                          { $$ = $1; }
+   : primitive_exp                     { $$ = $1; LOCATE($$, @1); }
+   | arithmetic_exp                    { $$ = $1; LOCATE($$, @1); }
+   | bitwise_exp                       { $$ = $1; LOCATE($$, @1); }
+   | logical_exp                       { $$ = $1; LOCATE($$, @1); }
+   | cmp_exp                           { $$ = $1; LOCATE($$, @1); }
+   | cond_exp                          { $$ = $1; LOCATE($$, @1); }
    ;
 
 primitive_exp
@@ -259,7 +261,7 @@ cond_exp
 
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wunused-parameter"
-void yyerror(yyscan_t scanner, ParseContext* ctx, const char * s, ...) {
+void yyerror(YYLTYPE* yylloc, yyscan_t scanner, ParseContext* ctx, const char * s, ...) {
   va_list args;
   va_start(args, s);
 
@@ -1,5 +1,8 @@
 #include <unity.h>
 
+#include <stdio.h>
+#include <string.h>
+
 #include "in.h"
 
 #include "parser.h"
@@ -13,6 +16,12 @@ void tearDown (void) {}
     YYSTYPE yylval_param;\
     int tok;\
 
+#define TOKENIZE_CTX(init) {\
+    InContext* ctx = init;\
+    TEST_ASSERT_NOT_NULL(ctx);\
+    YYSTYPE yylval_param;\
+    int tok;\
+
 #define GET_NEXT_TOKEN(ctx) (tok = inLex(ctx, &yylval_param))
 
 #define ASSERT_TOKEN_IS_INT(val) do {\
@@ -123,6 +132,44 @@ void scanBoolValues() {
     ASSERT_NO_MORE_TOKENS();
 }
 
+void scanBufferInPlace() {
+    char buffer[] = "id + 0x1f\0"; // And the terminator of the literal
+
+    TOKENIZE_CTX(inInitWithBuffer(buffer, sizeof(buffer)));
+    ASSERT_TOKEN_IS_ID("id");
+    ASSERT_TOKEN_IS_OP('+');
+    ASSERT_TOKEN_IS_INT(31);
+    ASSERT_NO_MORE_TOKENS();
+}
+
+void rejectBufferWithoutPadding() {
+    char buffer[] = { '1', '2', '\0' };
+    TEST_ASSERT_NULL(inInitWithBuffer(buffer, sizeof(buffer)));
+}
+
+#define MAPPED_FILE_PATH "test_in_lexer_mapped.txt"
+#define MAPPED_FILE_SIZE 4096
+
+// A token that ends with the file, which ends at the end of a page
+void scanMappedFile() {
+    char content[MAPPED_FILE_SIZE];
+    memset(content, ' ', MAPPED_FILE_SIZE);
+    memcpy(content + MAPPED_FILE_SIZE - 5, "x - 7", 5);
+    FILE* file = fopen(MAPPED_FILE_PATH, "wb");
+    TEST_ASSERT_NOT_NULL(file);
+    fwrite(content, 1, MAPPED_FILE_SIZE, file);
+    fclose(file);
+
+    TOKENIZE_CTX(inInitWithMappedFile(MAPPED_FILE_PATH));
+    ASSERT_TOKEN_IS_ID("x");
+    ASSERT_TOKEN_IS_OP('-');
+    ASSERT_TOKEN_IS_INT(7);
+    ASSERT_NO_MORE_TOKENS();
+
+    remove(MAPPED_FILE_PATH);
+    TEST_ASSERT_NULL(inInitWithMappedFile(MAPPED_FILE_PATH));
+}
+
 int main() {
     UNITY_BEGIN();
     RUN_TEST(scanTokensWithSpaces);
@@ -133,6 +180,9 @@ int main() {
     RUN_TEST(scanIDWithNumber);
     RUN_TEST(scanIDWithUnderscore);
     RUN_TEST(scanBoolValues);
+    RUN_TEST(scanBufferInPlace);
+    RUN_TEST(rejectBufferWithoutPadding);
+    RUN_TEST(scanMappedFile);
     return UNITY_END();
 }
 
@@ -1,5 +1,8 @@
 #include <unity.h>
 
+#include <stdlib.h>
+#include <string.h>
+
 #include "ast/ast.h"
 
 #include "in.h"
@@ -56,6 +59,93 @@ void parseMultipleStatements() {
     ASSERT_MATCH_AST("int n = 0; n = 1;", ast, false);
 }
 
+void parseManyStatements() {
+    // Deeper than the default parser stack if the statements were nested
+    const unsigned int count = 100000;
+    const char* stmt = "print(1);";
+    size_t len = strlen(stmt);
+
+    char* str = malloc(count * len + 1);
+    TEST_ASSERT_NOT_NULL(str);
+    for (unsigned int i = 0; i < count; i++) {
+        memcpy(str + i * len, stmt, len);
+    }
+    str[count * len] = '\0';
+
+    InContext* ctx = inInitWithString(str);
+    ParseResult res = inParse(ctx);
+    TEST_ASSERT_TRUE(res.status);
+    TEST_ASSERT_EQUAL_INT(AST_STATEMENT_SEQ, res.ast->node_type);
+    TEST_ASSERT_EQUAL_UINT(count, res.ast->stmt_count);
+    TEST_ASSERT_EQUAL_INT(AST_PRINT, res.ast->stmts[count - 1]->node_type);
+
+    deleteParseResult(&res);
+    inDelete(&ctx);
+    free(str);
+}
+
+void parseStatementLocations() {
+    const char* str = "var x = 1;\n  x = x + 2; print(x);\n\nwhile (x < 10) {\n    x++;\n}";
+
+    InContext* ctx = inInitWithString(str);
+    ParseResult res = inParse(ctx);
+    TEST_ASSERT_TRUE(res.status);
+    TEST_ASSERT_EQUAL_UINT(4, res.ast->stmt_count);
+
+    const unsigned int lines[] = { 1, 2, 2, 4 };
+    const unsigned int columns[] = { 1, 3, 14, 1 };
+    for (unsigned int i = 0; i < res.ast->stmt_count; i++) {
+        TEST_ASSERT_EQUAL_UINT(lines[i], res.ast->stmts[i]->line);
+        TEST_ASSERT_EQUAL_UINT(columns[i], res.ast->stmts[i]->column);
+    }
+
+    // x + 2
+    const ASTNode* add = res.ast->stmts[1]->right;
+    TEST_ASSERT_EQUAL_INT(AST_ADD, add->node_type);
+    TEST_ASSERT_EQUAL_UINT(2, add->line);
+    TEST_ASSERT_EQUAL_UINT(7, add->column);
+
+    // x++, inside the body of the loop
+    const ASTNode* inc = res.ast->stmts[3]->right->child;
+    TEST_ASSERT_EQUAL_UINT(5, inc->line);
+    TEST_ASSERT_EQUAL_UINT(5, inc->column);
+
+    deleteParseResult(&res);
+    inDelete(&ctx);
+}
+
+static ParseResult parseIntoSt(const char* str) {
+    FILE* err = tmpfile();
+    InContext* ctx = inInitWithString(str);
+    inSetErrorStream(ctx, err);
+    ParseResult res = inParseIntoSt(ctx, st);
+    inDelete(&ctx);
+    fclose(err);
+    if (res.arena != NULL) {
+        deleteASTArena(&res.arena);
+    }
+    return res;
+}
+
+void parseIntoStKeepsTheSymbolsOfEachInput() {
+    const Scope* global = getCurrentScope(st);
+
+    TEST_ASSERT_TRUE(parseIntoSt("var x = 1;").status);
+    TEST_ASSERT_TRUE(parseIntoSt("var y = x + 1; x++;").status);
+    TEST_ASSERT_NOT_NULL(lookupVar(st, "x"));
+    TEST_ASSERT_NOT_NULL(lookupVar(st, "y"));
+
+    // The error is inside a scope, which is left
+    ParseResult res = parseIntoSt("{ var z = 2; z = ; }");
+    TEST_ASSERT_FALSE(res.status);
+    TEST_ASSERT_TRUE(res.st == st);
+    TEST_ASSERT_TRUE(getCurrentScope(st) == global);
+    TEST_ASSERT_NULL(lookupVar(st, "z"));
+
+    TEST_ASSERT_TRUE(parseIntoSt("x = y;").status);
+    TEST_ASSERT_EQUAL_UINT(2, getScopeSize(global));
+}
+
 void parseRestrainedExpression() {
     defineVar(st, AST_TYPE_INT, "n", false);
 
@@ -191,6 +281,7 @@ int main() {
     RUN_TEST(parseAssignement);
     RUN_TEST(parseSingleStatement);
     RUN_TEST(parseMultipleStatements);
+    RUN_TEST(parseManyStatements);
     RUN_TEST(parseRestrainedExpression);
     RUN_TEST(parseDeclarationAssignmentWithTypeInference);
     RUN_TEST(parsePrefixInc);
@@ -205,5 +296,7 @@ int main() {
     RUN_TEST(parseCompoundAssignmentMul);
     RUN_TEST(parseCompoundAssignmentBitwiseAnd);
     RUN_TEST(parseCompoundAssignmentLogicalAnd);
+    RUN_TEST(parseStatementLocations);
+    RUN_TEST(parseIntoStKeepsTheSymbolsOfEachInput);
     return UNITY_END();
 }
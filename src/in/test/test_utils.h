@@ -15,8 +15,7 @@
     TEST_ASSERT_TRUE_MESSAGE(_res.status, "Failed to parse string!");\
     TEST_ASSERT_TRUE_MESSAGE(equalAST(expected_ast, _res.ast), "ASTs are not equal!");\
     deleteASTNode(&expected_ast);\
-    deleteASTNode(&_res.ast);\
-    deleteSymbolTable(&_res.st);\
+    deleteParseResult(&_res);\
     inDelete(&_ctx);\
 } while (0)
 
@@ -27,8 +26,7 @@
     TEST_ASSERT_TRUE_MESSAGE(_res.status, "Failed to parse string!");\
     TEST_ASSERT_TRUE_MESSAGE(equalAST(expected_ast, _res.ast), "ASTs are not equal!");\
     deleteASTNode(&expected_ast);\
-    deleteASTNode(&_res.ast);\
-    deleteSymbolTable(&_s);\
+    deleteParseResult(&_res);\
     inDelete(&_ctx);\
 } while (0)
 
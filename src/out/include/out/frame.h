@@ -12,10 +12,18 @@ int printVar(const Symbol* var, const int* value, IOStream* stream);
 
 int printSymbolTable(const SymbolTable* st, const Frame* frame, IOStream* stream);
 
+// Prints only the variables of the slots [first_offset, end_offset), such as the ones defined by the last input of a
+// session
+int printSymbolTableSlots(const SymbolTable* st, const Frame* frame, unsigned int first_offset, unsigned int end_offset, IOStream* stream);
+
 Frame* newFrame(unsigned int size);
 
 void deleteFrame(Frame** frame);
 
+// Grows the frame to size slots, keeping its values and zeroing the new slots. The frame may move, so the returned one
+// replaces it. A frame is never shrunk.
+Frame* resizeFrame(Frame* frame, unsigned int size);
+
 int getFrameValue(const Frame* frame, unsigned int index);
 
 void setFrameValue(Frame* frame, unsigned int index, int value);
@@ -0,0 +1,31 @@
+#ifndef _HISTOGRAM_H_
+#define _HISTOGRAM_H_
+
+#include <stdbool.h>
+
+#include "utils/iostream.h"
+
+#include "ast/ast.h"
+
+// Executions of each type of node by the tree walker, and of each pair of the type of a node and the type of the node
+// that evaluated it. The counters are only updated when the out library is built with OUT_HISTOGRAM (the
+// BUILD_HISTOGRAM option of CMake), as they slow down the evaluator.
+typedef struct EvalHistogram {
+    unsigned long nodes[AST_NODE_TYPES_COUNT];
+    unsigned long pairs[AST_NODE_TYPES_COUNT + 1][AST_NODE_TYPES_COUNT]; // The parent AST_NODE_TYPES_COUNT is the root
+} EvalHistogram;
+
+#define HISTOGRAM_CSV_HEADER "kind,parent,child,count"
+
+bool isEvalHistogramEnabled();
+
+// Of the calling thread
+const EvalHistogram* getEvalHistogram();
+
+void resetEvalHistogram();
+
+// Writes the non zero counters as CSV rows "node,,<type>,<count>" and "pair,<parent type>,<child type>,<count>", with
+// an empty parent type for the root
+int dumpEvalHistogram(const IOStream* stream);
+
+#endif
@@ -10,9 +10,27 @@
 #include "ast/symbol.h"
 
 #include "frame.h"
+#include "sink.h"
+#include "profile.h"
+#include "histogram.h"
+
+typedef enum ExecMode {
+    EXEC_MODE_BYTECODE,     // Default
+    EXEC_MODE_TREE_WALKER,  // Reference mode
+    EXEC_MODE_JIT,          // Native code, falls back to the bytecode where the JIT is not available
+    EXEC_MODE_TIERED,       // Bytecode, with the hot loops compiled by the system C compiler
+    EXEC_MODE_ITERATIVE,    // Tree walker without recursion, for the ASTs too deep for the call stack
+    EXEC_MODE_COUNT
+} ExecMode;
 
 Frame* executeAST(const ASTNode* ast, const SymbolTable* st);
 
+Frame* executeASTWithMode(const ASTNode* ast, const SymbolTable* st, ExecMode mode);
+
+// Runs the program on a frame given by the caller, with at least getMaxOffset(st) + 1 slots, starting from the values
+// that it holds
+void executeASTWithFrame(const ASTNode* ast, const SymbolTable* st, Frame* frame, ExecMode mode);
+
 typedef struct EvalStatus {
     bool status;
     ASTNodeType node_type;
@@ -20,8 +38,81 @@ typedef struct EvalStatus {
 
 EvalStatus executeASTStatements(const ASTNode* ast, const SymbolTable* st, Frame* frame);
 
+// Same as executeASTStatements, but also adds the executions and time of each statement to the profile. Only this
+// entry point pays for the profiling.
+EvalStatus executeASTStatementsProfiled(const ASTNode* ast, const SymbolTable* st, Frame* frame, Profile* profile);
+
 int evalASTExpression(const ASTNode* node, const SymbolTable* st, Frame* frame);
 
+// Same as executeASTStatements and evalASTExpression, but with the stacks of the evaluation on the heap instead of the
+// call stack, so that the AST can be as deep as the memory allows. A break or a continue resumes its loop directly.
+EvalStatus executeASTIterative(const ASTNode* ast, const SymbolTable* st, Frame* frame);
+
+int evalASTExpressionIterative(const ASTNode* node, const SymbolTable* st, Frame* frame);
+
+// Values of a variable for each row of a batch
+typedef struct BatchColumn {
+    const Symbol* var;
+    const int* values;
+} BatchColumn;
+
+// Evaluates the expression for row_count rows, into out[row]. Each row gives the same value as evalASTExpression on a
+// frame of its own that holds the values of the columns in that row, and 0 in the slots without a column; the
+// assignments of the expression only change the slots of their row, and the columns are never written. Each node is
+// evaluated once for a chunk of rows, by a loop over them, instead of once per row.
+void evalASTExpressionBatch(const ASTNode* exp, const SymbolTable* st, const BatchColumn* columns, unsigned int column_count, unsigned int row_count, int* out);
+
+typedef struct Program Program;
+
+Program* newProgramFromAST(const ASTNode* ast, const SymbolTable* st);
+
+// Iterations after which a loop of a tiered program is compiled
+#define DEFAULT_TIER_UP_THRESHOLD 10000
+
+// The loops count their iterations, and once a loop reaches the threshold it is compiled through the C backend into a
+// shared object and continues natively. The shared objects are built with $CC (by default cc) and cached in
+// $MYLANG_CACHE_DIR (by default in /tmp/mylang-<uid>), keyed by the source, the compiler and its flags. A loop that can
+// not be compiled stays interpreted, which includes the loops that declare variables, as the frame keeps the values
+// that their last iteration left in them, and toggles. The program can run in several threads at once, each loop is
+// compiled only once. The AST and the symbol table must outlive the program.
+Program* newTieredProgramFromAST(const ASTNode* ast, const SymbolTable* st, unsigned int threshold);
+
+void deleteProgram(Program** program);
+
+unsigned int getProgramSize(const Program* program);
+
+unsigned int getProgramRegisterCount(const Program* program);
+
+unsigned int getProgramNativeLoopCount(const Program* program);
+
+typedef enum DispatchMode {
+    DISPATCH_THREADED,  // Computed goto, pre-resolved when the program is loaded
+    DISPATCH_SWITCH,    // Portable fallback
+    DISPATCH_MODES_COUNT
+} DispatchMode;
+
+bool isDispatchModeAvailable(DispatchMode mode);
+
+void executeProgram(const Program* program, Frame* frame);
+
+void executeProgramWithDispatch(const Program* program, Frame* frame, DispatchMode mode);
+
+int printProgram(const Program* program, const IOStream* stream);
+
+// Native code translated from the bytecode, only available on x86-64 Linux
+typedef struct JITCode JITCode;
+
+bool isJITAvailable();
+
+// Returns NULL if the program can not be translated, in which case it has to be interpreted
+JITCode* newJITCodeFromProgram(const Program* program);
+
+void deleteJITCode(JITCode** jit);
+
+size_t getJITCodeSize(const JITCode* jit);
+
+void executeJITCode(const JITCode* jit, Frame* frame);
+
 typedef struct OutSerializer {
     void (*parseType)(const IOStream* stream, const ASTType type, const bool in_exp);
     void (*typeOf)(const IOStream* stream, const ASTNode* node, const char* node_str);
@@ -29,6 +120,9 @@ typedef struct OutSerializer {
     bool (*condAssignNeedsTmp)();
     bool (*hasCompdAssign)(ASTNodeType node_type);
     bool print_redef_level;
+    bool vars_in_frame;     // The variables are the slots of an int* _frame instead of locals
+    bool int_wraps;         // The int arithmetic of the language wraps around, so the AST_WRAP_* nodes need no casts
+    bool wrap_int_ops;      // The int +, - and * are compiled like the AST_WRAP_* nodes, so that they wrap without -fwrapv
 } OutSerializer;
 
 void outCompileAST(const ASTNode* ast, const SymbolTable* st, const IOStream* stream, const OutSerializer* os, unsigned int indentation_level);
@@ -37,8 +131,77 @@ void compileASTExpression(const ASTNode* ast, const SymbolTable* st, const IOStr
 
 void compileASTStatements(const ASTNode* ast, const SymbolTable* st, const IOStream* stream, const OutSerializer* os, unsigned int indentation_level, bool print_new_line, bool print_semicolon);
 
+// Prefix of the locals of the slots that several variables share, followed by the slot
+#define SLOT_LOCAL_PREFIX "_s"
+
+// Name of the local of a variable, with its level of redefinition if print_redef_level
+void printId(const IOStream* stream, const Symbol* var, bool print_redef_level);
+
+// Declares the locals of the shared slots (see assignFrameSlots), once before the statements, as the variables of a
+// slot have different scopes
+void compileSharedSlots(const SymbolTable* st, const IOStream* stream, const OutSerializer* os, unsigned int indentation_level);
+
 bool outCompileToC(const ASTNode* ast, const SymbolTable* st, const char* file_name, const IOStream* stream);
 
+// Name of the function of a compiled loop: void _mylang_loop(int* frame, int (*print)(const char* fmt, ...))
+#define LOOP_FUNCTION_NAME "_mylang_loop"
+
+// Compiles a single loop into a C function that keeps the variables declared outside of it in the frame.
+// Returns false if the loop has constructs that the C backend does not support.
+bool outCompileLoopToC(const ASTNode* loop, const SymbolTable* st, const IOStream* stream);
+
+// Version of the interface between the libraries compiled by outCompileToCLibrary and openLibrary
+#define LIBRARY_ABI_VERSION 1
+
+// Name of the LibraryDescriptor that a compiled library exports
+#define LIBRARY_DESCRIPTOR_NAME "_mylang_library"
+
+// Compiles the program into the C source of a shared library, which runs it on a frame given by the caller and
+// describes the variables of the frame. The variables live in the frame, so the slots hold the same values as after
+// executeAST. The int additions, subtractions and multiplications wrap around like in the bytecode VM, whatever the
+// flags that the library is built with. Returns false if an expression writes a variable that it also accesses
+// elsewhere, as C does not evaluate it from left to right.
+bool outCompileToCLibrary(const ASTNode* ast, const SymbolTable* st, const char* file_name, const IOStream* stream);
+
+// Variable of the frame of a library
+typedef struct LibrarySymbol {
+    const char* id;
+    int type;               // ASTType
+    unsigned int offset;
+} LibrarySymbol;
+
+typedef struct LibraryDescriptor {
+    unsigned int abi_version;   // First, so that it can be checked before the rest is read
+    unsigned int frame_size;
+    unsigned int symbol_count;
+    const LibrarySymbol* symbols;
+    void (*run)(int* frame, int (*print)(const char* fmt, ...));
+} LibraryDescriptor;
+
+// Shared library compiled by outCompileToCLibrary, only available on unix
+typedef struct Library Library;
+
+// Returns NULL if the file can not be loaded or was compiled for another version of the interface
+Library* openLibrary(const char* path);
+
+void closeLibrary(Library** library);
+
+unsigned int getLibraryFrameSize(const Library* library);
+
+unsigned int getLibrarySymbolCount(const Library* library);
+
+const LibrarySymbol* getLibrarySymbol(const Library* library, unsigned int index);
+
+// Returns the first symbol with the id, or NULL if there is none
+const LibrarySymbol* findLibrarySymbol(const Library* library, const char* id);
+
+// Runs the program on a new frame, like executeAST
+Frame* executeLibrary(const Library* library);
+
+// Runs the program on the frame, which must have at least the frame size of the library. It can be called
+// repeatedly, with each run starting from the values that the frame holds.
+void executeLibraryWithFrame(const Library* library, Frame* frame);
+
 bool outCompileToJava(const ASTNode *ast, const SymbolTable *st, const char *file_name, const IOStream *stream);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,37 @@
+#ifndef _PROFILE_H_
+#define _PROFILE_H_
+
+#include <stdint.h>
+
+#include "utils/iostream.h"
+
+#include "ast/ast.h"
+
+// Executions and time of the statements run by executeASTStatementsProfiled. The time of a statement includes its
+// nested statements, its self time does not.
+typedef struct Profile Profile;
+
+typedef struct ProfileEntry {
+    const ASTNode* stmt;
+    unsigned long count;
+    uint64_t total_ns;
+    uint64_t self_ns;
+} ProfileEntry;
+
+#define DEFAULT_PROFILE_REPORT_SIZE 20
+
+Profile* newProfile();
+
+void deleteProfile(Profile** profile);
+
+// Statements executed at least once
+unsigned int getProfileSize(const Profile* profile);
+
+// NULL if the statement was never executed
+const ProfileEntry* getProfileEntry(const Profile* profile, const ASTNode* stmt);
+
+// Prints the statements that took the most self time, with their location and, for the loops, their iterations. When
+// the source of the program is given, each statement is annotated with its line.
+int printProfile(const Profile* profile, const char* src, unsigned int max_entries, const IOStream* stream);
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef _SINK_H_
+#define _SINK_H_
+
+#include <stdio.h>
+#include <stddef.h>
+
+#include "ast/type.h"
+#include "ast/symbol.h"
+
+typedef enum FlushPolicy {
+    FLUSH_LINE,     // After every line, for interactive use
+    FLUSH_FULL,     // When the buffer is full and when the execution ends
+    FLUSH_EXPLICIT, // Only when the buffer is full or flushOutputSink is called
+    FLUSH_POLICIES_COUNT
+} FlushPolicy;
+
+// Buffered output of the print statements of the interpreter
+typedef struct OutputSink OutputSink;
+
+#define OUTPUT_SINK_DEFAULT_CAPACITY (64 * 1024)
+
+OutputSink* newOutputSink(FILE* file, size_t capacity, FlushPolicy policy);
+
+#define newOutputSinkDefault(file, policy) newOutputSink(file, OUTPUT_SINK_DEFAULT_CAPACITY, policy)
+
+// Flushes the pending output before releasing the sink
+void deleteOutputSink(OutputSink** sink);
+
+FlushPolicy getOutputSinkFlushPolicy(const OutputSink* sink);
+
+void setOutputSinkFlushPolicy(OutputSink* sink, FlushPolicy policy);
+
+void flushOutputSink(OutputSink* sink);
+
+// Called when an execution ends, only flushes with FLUSH_FULL
+void endOutputSink(OutputSink* sink);
+
+void sinkWrite(OutputSink* sink, const char* str, size_t len);
+
+void sinkWriteStr(OutputSink* sink, const char* str);
+
+void sinkWriteInt(OutputSink* sink, int value);
+
+void sinkWriteValue(OutputSink* sink, ASTType type, int value);
+
+void sinkWriteVar(OutputSink* sink, const Symbol* var, int value);
+
+void sinkEndLine(OutputSink* sink);
+
+// Sink used by the prints of the calling thread. By default it writes to stdout and flushes every line only if
+// stdout is a terminal. Returns the previous sink, NULL restores the default one.
+OutputSink* setOutputSink(OutputSink* sink);
+
+OutputSink* getOutputSink();
+
+// Formats into the sink of the calling thread, for the prints of the natively compiled code
+int printToOutputSink(const char* fmt, ...);
+
+#endif
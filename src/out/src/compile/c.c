@@ -1,6 +1,7 @@
 #include <assert.h>
 #include <string.h>
 #include <ctype.h>
+#include <stdlib.h>
 
 #include "out.h"
 
@@ -24,8 +25,8 @@ static const char* ASTTypeCoverter[] = {
     [AST_TYPE_BOOL] = "_TYPE_BOOL",
 };
 
-static void print(const char* exp_str, const ASTType type, const char* id_str, const IOStream* stream) {
-    IOStreamWritef(stream, "printf(\"");
+static void printWith(const char* function, const char* exp_str, const ASTType type, const char* id_str, const IOStream* stream) {
+    IOStreamWritef(stream, "%s(\"", function);
     if(id_str != NULL) {
         IOStreamWritef(stream, "%s %s = ", ASTTypeToStr(type), id_str);
     }
@@ -48,6 +49,15 @@ static void print(const char* exp_str, const ASTType type, const char* id_str, c
     }
 }
 
+static void print(const char* exp_str, const ASTType type, const char* id_str, const IOStream* stream) {
+    printWith("printf", exp_str, type, id_str, stream);
+}
+
+// The compiled loops and libraries print through the function they receive, so that the output goes to the sink of the interpreter
+static void printLoop(const char* exp_str, const ASTType type, const char* id_str, const IOStream* stream) {
+    printWith("_print", exp_str, type, id_str, stream);
+}
+
 static const char* parseTypeToStr(const ASTType type, const bool in_exp) {
     if(in_exp) {
         return ASTTypeCoverter[type];
@@ -81,15 +91,47 @@ static bool hasCompdAssign(ASTNodeType node_type) {
 }
 #pragma GCC diagnostic pop
 
+// C has no compound assignment for the logical operators, which the sources built by cc have to expand
+static bool hasNativeCompdAssign(ASTNodeType node_type) {
+    return node_type != AST_LOGICAL_AND && node_type != AST_LOGICAL_OR;
+}
+
 const OutSerializer cSerializer = {
     &parseType,
     &typeOf,
     &print,
     &condAssignNeedsTmp,
     &hasCompdAssign,
+    false,
+    false,
+    false,
     false
 };
 
+const OutSerializer cLoopSerializer = {
+    &parseType,
+    &typeOf,
+    &printLoop,
+    &condAssignNeedsTmp,
+    &hasNativeCompdAssign,
+    false,
+    false,
+    false,
+    false
+};
+
+const OutSerializer cLibrarySerializer = {
+    &parseType,
+    &typeOf,
+    &printLoop,
+    &condAssignNeedsTmp,
+    &hasNativeCompdAssign,
+    false,
+    true,
+    false,
+    true
+};
+
 static void generateTypeEnum(const IOStream* stream) {
     assert((sizeof(ASTTypeCoverter)/sizeof(ASTTypeCoverter[0])) == AST_TYPE_COUNT);
 
@@ -104,12 +146,12 @@ static void generateTypeEnum(const IOStream* stream) {
     IOStreamWritef(stream, "};\n\n");
 }
 
-static void generateTempVars(const IOStream* stream) {
+static void generateTempVars(const IOStream* stream, const char* prefix) {
     for(int i = 0; i < AST_TYPE_COUNT; i++) {
         if(i == AST_TYPE_VOID || i == AST_TYPE_TYPE) {
             continue;
         }
-        IOStreamWritef(stream, "static %s _tmp_%s;\n", parseTypeToStr(i, false), ASTTypeToStr(i));
+        IOStreamWritef(stream, "%s%s _tmp_%s;\n", prefix, parseTypeToStr(i, false), ASTTypeToStr(i));
     }
     IOStreamWritef(stream, "\n");
 }
@@ -121,12 +163,295 @@ bool outCompileToC(const ASTNode* ast, const SymbolTable* st, const char* file_n
 
     IOStreamWritef(stream, "%s", PRE);
     generateTypeEnum(stream);
-    generateTempVars(stream);
+    generateTempVars(stream, "static ");
     //IOStreamWritef(stream, "#define typeof(e, t) (e, t)\n\n");
     IOStreamWritef(stream, "int main(int argc, char** argv) {\n");
+    compileSharedSlots(st, stream, &cSerializer, INITIAL_INDENTATION_LEVEL);
     compileASTStatements(ast, st, stream, &cSerializer, INITIAL_INDENTATION_LEVEL, true, true);
     IOStreamWritef(stream, "%s", POS);
 
     return true;
 }
 #pragma GCC diagnostic pop
+
+typedef struct LoopVars {
+    const Symbol** vars;
+    unsigned int count;
+    unsigned int capacity;
+} LoopVars;
+
+static void addLoopVar(LoopVars* l, const Symbol* var) {
+    for (unsigned int i = 0; i < l->count; i++) {
+        if (l->vars[i] == var) {
+            return;
+        }
+    }
+    if (l->count == l->capacity) {
+        l->capacity = 2 * l->capacity + 4;
+        l->vars = realloc(l->vars, l->capacity * sizeof(Symbol*));
+        assert(l->vars != NULL);
+    }
+    l->vars[l->count++] = var;
+}
+
+// Counts the accesses to the variable in the expression. The assignments built into the increments and compound
+// assignments are counted once, as they are in the C source.
+static unsigned int countVarAccesses(const ASTNode* ast, const Symbol* var) {
+    switch (ast->node_type) {
+        case AST_ID:
+            return ast->id == var;
+        case AST_INC:
+        case AST_DEC:
+        case AST_LOGICAL_TOGGLE:
+        case AST_BITWISE_TOGGLE:
+            return countVarAccesses(ast->child->left, var);
+        case AST_COMPD_ASSIGN:
+            return countVarAccesses(ast->child->left, var) + countVarAccesses(ast->child->right->right, var);
+        default:
+            break;
+    }
+
+    switch (getNodeOpType(ast->node_type)) {
+        case ZEROARY_OP:
+            return 0;
+        case UNARY_OP:
+            return countVarAccesses(ast->child, var);
+        case BINARY_OP:
+            return countVarAccesses(ast->left, var) + countVarAccesses(ast->right, var);
+        case TERNARY_OP:
+            return countVarAccesses(ast->first, var) + countVarAccesses(ast->second, var) + countVarAccesses(ast->third, var);
+        default:
+            assert(false);
+            return 0;
+    }
+}
+
+// Whether a variable written by the side effect is also accessed in the rest of the full expression
+static bool isWriteUnsequenced(const ASTNode* lval, const ASTNode* side_effect, const ASTNode* full_exp) {
+    switch (lval->node_type) {
+        case AST_ID:
+            return countVarAccesses(full_exp, lval->id) > countVarAccesses(side_effect, lval->id);
+        case AST_PARENTHESES:
+            return isWriteUnsequenced(lval->child, side_effect, full_exp);
+        case AST_TERNARY_COND:
+            return isWriteUnsequenced(lval->second, side_effect, full_exp) || isWriteUnsequenced(lval->third, side_effect, full_exp);
+        default:
+            assert(false);
+            return true;
+    }
+}
+
+static bool hasUnsequencedWrite(const ASTNode* ast, const ASTNode* full_exp, bool nested) {
+    const ASTNode* lval = NULL;
+    switch (ast->node_type) {
+        case AST_ID_ASSIGNMENT:
+            lval = ast->left;
+            break;
+        case AST_INC:
+        case AST_DEC:
+        case AST_LOGICAL_TOGGLE:
+        case AST_BITWISE_TOGGLE:
+        case AST_COMPD_ASSIGN:
+            lval = ast->child->left;
+            break;
+        default:
+            break;
+    }
+    if (lval != NULL && nested && isWriteUnsequenced(lval, ast, full_exp)) {
+        return true;
+    }
+
+    switch (getNodeOpType(ast->node_type)) {
+        case ZEROARY_OP:
+            return false;
+        case UNARY_OP:
+            return hasUnsequencedWrite(ast->child, full_exp, true);
+        case BINARY_OP:
+            return hasUnsequencedWrite(ast->left, full_exp, true) || hasUnsequencedWrite(ast->right, full_exp, true);
+        case TERNARY_OP:
+            return hasUnsequencedWrite(ast->first, full_exp, true) || hasUnsequencedWrite(ast->second, full_exp, true)
+                || hasUnsequencedWrite(ast->third, full_exp, true);
+        default:
+            assert(false);
+            return true;
+    }
+}
+
+// Whether the statements have an expression that writes a variable that it also accesses elsewhere, as C leaves the
+// order of evaluation of the operands unspecified while the interpreter evaluates them from left to right
+static bool hasUnspecifiedOrder(const ASTNode* ast) {
+    switch (ast->node_type) {
+        case AST_STATEMENT_SEQ:
+            for (unsigned int i = 0; i < ast->stmt_count; i++) {
+                if (hasUnspecifiedOrder(ast->stmts[i])) {
+                    return true;
+                }
+            }
+            return false;
+        case AST_SCOPE:
+        case AST_PRINT:
+        case AST_FOR:
+            return hasUnspecifiedOrder(ast->child);
+        case AST_IF:
+        case AST_WHILE:
+        case AST_DO_WHILE:
+            return hasUnspecifiedOrder(ast->left) || hasUnspecifiedOrder(ast->right);
+        case AST_IF_ELSE:
+            return hasUnspecifiedOrder(ast->first) || hasUnspecifiedOrder(ast->second) || hasUnspecifiedOrder(ast->third);
+        case AST_ID_DECL_ASSIGN:
+            return hasUnsequencedWrite(ast->right, ast->right, false);
+        case AST_ID_DECLARATION:
+        case AST_PRINT_VAR:
+        case AST_BREAK:
+        case AST_CONTINUE:
+        case AST_NO_OP:
+            return false;
+        default:
+            return hasUnsequencedWrite(ast, ast, false);
+    }
+}
+
+// Collects the variables used in the AST. Returns false if it has nodes that can not be compiled inside an
+// expression, or declarations, as the frame keeps the last values of the variables declared in the loop.
+static bool collectLoopVars(const ASTNode* ast, LoopVars* used) {
+    switch (ast->node_type) {
+        case AST_LOGICAL_TOGGLE:
+        case AST_BITWISE_TOGGLE:
+        case AST_ID_DECLARATION:
+        case AST_ID_DECL_ASSIGN:
+            return false;
+        case AST_ID:
+            addLoopVar(used, ast->id);
+            return true;
+        default:
+            break;
+    }
+
+    switch (getNodeOpType(ast->node_type)) {
+        case ZEROARY_OP:
+            return true;
+        case UNARY_OP:
+            return collectLoopVars(ast->child, used);
+        case BINARY_OP:
+            return collectLoopVars(ast->left, used) && collectLoopVars(ast->right, used);
+        case TERNARY_OP:
+            return collectLoopVars(ast->first, used) && collectLoopVars(ast->second, used)
+                && collectLoopVars(ast->third, used);
+        case N_ARY_OP:
+            for (unsigned int i = 0; i < ast->stmt_count; i++) {
+                if (!collectLoopVars(ast->stmts[i], used)) {
+                    return false;
+                }
+            }
+            return true;
+        default:
+            assert(false);
+            return false;
+    }
+}
+
+bool outCompileLoopToC(const ASTNode* loop, const SymbolTable* st, const IOStream* stream) {
+    assert(loop != NULL && st != NULL && stream != NULL);
+    assert(loop->node_type == AST_WHILE || loop->node_type == AST_DO_WHILE || loop->node_type == AST_FOR);
+
+    // The init of a for loop already ran when the loop is entered, so it is compiled with an empty one
+    ASTNode no_op = { .node_type = AST_NO_OP };
+    const ASTNode* for_stmts[] = { &no_op, NULL };
+    ASTNode for_seq = { .node_type = AST_STATEMENT_SEQ, .stmts = for_stmts, .stmt_count = 2, .stmt_capacity = 2 };
+    ASTNode for_loop = { .node_type = AST_FOR, .child = &for_seq };
+    if (loop->node_type == AST_FOR) {
+        for_stmts[1] = loop->child->stmts[1];
+        loop = &for_loop;
+    }
+
+    LoopVars used = { .vars = NULL, .count = 0, .capacity = 0 };
+    bool status = collectLoopVars(loop, &used) && !hasUnspecifiedOrder(loop);
+
+    if (status) {
+        IOStreamWritef(stream, "%s", PRE);
+        generateTypeEnum(stream);
+        generateTempVars(stream, "static ");
+
+        IOStreamWritef(stream, "void %s(int* _frame, int (*_print)(const char*, ...)) {\n", LOOP_FUNCTION_NAME);
+        // The variables are declared before the loop, so the ones that it uses never share a slot with each other
+        for (unsigned int i = 0; i < used.count; i++) {
+            const Symbol* var = used.vars[i];
+            IOStreamWritef(stream, "    %s ", parseTypeToStr(getVarType(var), false));
+            printId(stream, var, false);
+            IOStreamWritef(stream, " = _frame[%u];\n", getVarOffset(var));
+        }
+        compileASTStatements(loop, st, stream, &cLoopSerializer, INITIAL_INDENTATION_LEVEL, true, true);
+        for (unsigned int i = 0; i < used.count; i++) {
+            IOStreamWritef(stream, "    _frame[%u] = ", getVarOffset(used.vars[i]));
+            printId(stream, used.vars[i], false);
+            IOStreamWritef(stream, ";\n");
+        }
+        IOStreamWritef(stream, "}\n");
+    }
+
+    free(used.vars);
+    return status;
+}
+
+// Returns the number of symbols written
+static unsigned int generateLibrarySymbols(const SymbolTable* st, unsigned int slot_count, const IOStream* stream) {
+    // The same variables as the dump of the frame, the last one declared in each slot except the temporaries
+    unsigned int count = 0;
+    for (unsigned int i = 0; i < slot_count; i++) {
+        const Symbol* var = lookupLastVarWithOffset(st, i);
+        assert(var != NULL);
+        count += !isTempVar(var);
+    }
+
+    IOStreamWritef(stream, "typedef struct _Symbol {\n    const char* id;\n    int type;\n    unsigned int offset;\n} _Symbol;\n\n");
+    if (count == 0) {
+        IOStreamWritef(stream, "static const _Symbol* const _symbols = NULL;\n\n");
+        return 0;
+    }
+
+    IOStreamWritef(stream, "static const _Symbol _symbols[] = {\n");
+    for (unsigned int i = 0; i < slot_count; i++) {
+        const Symbol* var = lookupLastVarWithOffset(st, i);
+        if (!isTempVar(var)) {
+            IOStreamWritef(stream, "    { \"%s\", %s, %u },\n", getVarId(var), ASTTypeCoverter[getVarType(var)], i);
+        }
+    }
+    IOStreamWritef(stream, "};\n\n");
+    return count;
+}
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+bool outCompileToCLibrary(const ASTNode* ast, const SymbolTable* st, const char* file_name, const IOStream* stream) {
+    assert(ast != NULL && st != NULL && stream != NULL);
+
+    if (hasUnspecifiedOrder(ast)) {
+        return false;
+    }
+
+    unsigned int slot_count = getTotalSymbolAmount(st) > 0 ? getMaxOffset(st) + 1 : 0;
+
+    IOStreamWritef(stream, "%s", PRE);
+    generateTypeEnum(stream);
+    unsigned int symbol_count = generateLibrarySymbols(st, slot_count, stream);
+
+    // The temporaries are locals so that the library can run in several threads at once. A break or continue
+    // outside of any loop ends the program, as it leaves the do while.
+    IOStreamWritef(stream, "static void _run(int* _frame, int (*_print)(const char*, ...)) {\n");
+    generateTempVars(stream, "    ");
+    IOStreamWritef(stream, "    do {\n");
+    compileASTStatements(ast, st, stream, &cLibrarySerializer, INITIAL_INDENTATION_LEVEL + 1, true, true);
+    IOStreamWritef(stream, "    } while (0);\n}\n\n");
+
+    IOStreamWritef(stream, "const struct {\n"
+        "    unsigned int abi_version;\n"
+        "    unsigned int frame_size;\n"
+        "    unsigned int symbol_count;\n"
+        "    const _Symbol* symbols;\n"
+        "    void (*run)(int* frame, int (*print)(const char* fmt, ...));\n"
+        "} %s = { %u, %u, %u, _symbols, &_run };\n",
+        LIBRARY_DESCRIPTOR_NAME, LIBRARY_ABI_VERSION, slot_count, symbol_count);
+
+    return true;
+}
+#pragma GCC diagnostic pop
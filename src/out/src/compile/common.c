@@ -13,8 +13,13 @@ static inline int getPrecedence(const ASTNode* node) {
     switch (node->node_type) {
         case AST_INT:
         case AST_BOOL:
+        case AST_TYPE:
+        case AST_TYPE_OF:
         case AST_ID:
         case AST_PARENTHESES:
+        case AST_WRAP_ADD:  // Compiled as a cast or between parentheses
+        case AST_WRAP_SUB:
+        case AST_WRAP_MUL:
             return 14;
         case AST_INC:
         case AST_DEC:
@@ -59,6 +64,8 @@ static inline int getPrecedence(const ASTNode* node) {
             return 2;
         case AST_ID_ASSIGNMENT:
         case AST_COMPD_ASSIGN:
+        case AST_LOGICAL_TOGGLE:
+        case AST_BITWISE_TOGGLE:
             return 1;
         default:
             printf("Precedence not defined for %s\n", nodeTypeToStr(node->node_type));
@@ -153,36 +160,101 @@ static inline void compileChildExpression(const ASTNode* node, const ASTNode* ch
     assert(child != NULL);
 
     bool need_parentheses = needParentheses(node, child);
-    if (need_parentheses) { IOStreamWritef(stream, "("); }
+    if (need_parentheses) { IOStreamWriteChar(stream, '('); }
 
     compileASTExpression(child, st, stream, os, false);
 
-    if (need_parentheses) { IOStreamWritef(stream, ")"); }
+    if (need_parentheses) { IOStreamWriteChar(stream, ')'); }
 }
 
 static inline void compileBinaryOP(const ASTNode* node, const char* op_symbol, const SymbolTable* st, const OutSerializer* os, const IOStream* stream) {
     compileChildExpression(node, node->left, st, os, stream);
-    IOStreamWritef(stream, op_symbol);
+    IOStreamWriteStr(stream, op_symbol);
     compileChildExpression(node, node->right, st, os, stream);
 }
 
+static inline bool isWrappingOP(const ASTNode* node, const OutSerializer* os) {
+    switch (node->node_type) {
+        case AST_WRAP_ADD:
+        case AST_WRAP_SUB:
+        case AST_WRAP_MUL:
+            return true;
+        case AST_ADD:
+        case AST_SUB:
+        case AST_MUL:
+            return os->wrap_int_ops && node->value_type == AST_TYPE_INT;
+        default:
+            return false;
+    }
+}
+
+static inline const char* getWrappingOPSymbol(const ASTNode* node) {
+    switch (node->node_type) {
+        case AST_WRAP_ADD:
+        case AST_ADD:
+            return " + ";
+        case AST_WRAP_SUB:
+        case AST_SUB:
+            return " - ";
+        default:
+            return " * ";
+    }
+}
+
+// The signed overflow of C is undefined, so the operation is done on unsigned ints and converted back to int, unless
+// its result is the operand of another one
+static void compileWrappingOP(const ASTNode* node, const SymbolTable* st, const OutSerializer* os, const IOStream* stream, bool is_operand) {
+    IOStreamWriteStr(stream, os->int_wraps || is_operand ? "(" : "(int) (");
+    for (unsigned int i = 0; i < 2; i++) {
+        const ASTNode* operand = i == 0 ? node->left : node->right;
+        if (i == 1) {
+            IOStreamWriteStr(stream, getWrappingOPSymbol(node));
+        }
+
+        if (isWrappingOP(operand, os)) {
+            compileWrappingOP(operand, st, os, stream, true);
+            continue;
+        }
+        if (!os->int_wraps) { IOStreamWriteLiteral(stream, "(unsigned int) "); }
+        // The operand of a cast binds tighter than any binary operator
+        bool need_parentheses = getPrecedence(operand) < 13;
+        if (need_parentheses) { IOStreamWriteChar(stream, '('); }
+        compileASTExpression(operand, st, stream, os, false);
+        if (need_parentheses) { IOStreamWriteChar(stream, ')'); }
+    }
+    IOStreamWriteChar(stream, ')');
+}
+
 void printId(const IOStream* stream, const Symbol* var, bool print_redef_level) {
     const char* id = getVarId(var);
-    if (print_redef_level) {
+    // The variables that share a slot are the same local
+    if (isVarSlotShared(var)) {
+        IOStreamWritef(stream, "%s%u", SLOT_LOCAL_PREFIX, getVarOffset(var));
+    } else if (print_redef_level) {
         unsigned int redef_level = getVarRedefLevel(var);
         if (redef_level > 0) {
             IOStreamWritef(stream, "%s_%d_", id, redef_level);
         } else {
-            IOStreamWritef(stream, "%s", id);
+            IOStreamWriteStr(stream, id);
         }
     } else {
-        IOStreamWritef(stream, "%s", id);
+        IOStreamWriteStr(stream, id);
+    }
+}
+
+// Variables that live in the frame are accessed through their slot
+static void compileVar(const IOStream* stream, const Symbol* var, const OutSerializer* os, bool print_redef_level) {
+    if (os->vars_in_frame) {
+        IOStreamWritef(stream, "_frame[%u]", getVarOffset(var));
+    } else {
+        printId(stream, var, print_redef_level);
     }
 }
 
 static void writeTmpVar(const ASTType type, const IOStream* stream) {
     const char* tmp_var_type = ASTTypeToStr(type);
-    IOStreamWritef(stream, "_tmp_%s", tmp_var_type);
+    IOStreamWriteLiteral(stream, "_tmp_");
+    IOStreamWriteStr(stream, tmp_var_type);
 }
 
 void compileAssignment(const ASTNode* node, const SymbolTable* st, const OutSerializer* os, const IOStream* stream, bool is_stmt) {
@@ -192,7 +264,8 @@ void compileAssignment(const ASTNode* node, const SymbolTable* st, const OutSeri
     const ASTNode* rval = node->right;
 
     if (lval->node_type == AST_ID) {
-        IOStreamWritef(stream, "%s = ", getVarId(lval->id));
+        compileVar(stream, lval->id, os, false);
+        IOStreamWriteLiteral(stream, " = ");
         compileASTExpression(rval, st, stream, os, false);
     } else {
         assert(lval->node_type == AST_PARENTHESES);
@@ -201,9 +274,9 @@ void compileAssignment(const ASTNode* node, const SymbolTable* st, const OutSeri
         if (is_stmt) {
             if (lval->node_type != AST_ID && os->condAssignNeedsTmp()) {
                 writeTmpVar(lval->value_type, stream);
-                IOStreamWritef(stream, " = ");
+                IOStreamWriteLiteral(stream, " = ");
             }
-            IOStreamWritef(stream, "(");
+            IOStreamWriteChar(stream, '(');
         }
 
         ASTResult res = newASTAssignment(copyAST(lval->child->second), copyAST(rval));
@@ -219,7 +292,7 @@ void compileAssignment(const ASTNode* node, const SymbolTable* st, const OutSeri
         deleteASTNode(&new_node);
 
         if (is_stmt) {
-            IOStreamWritef(stream, ")");
+            IOStreamWriteChar(stream, ')');
         }
     }
 }
@@ -229,7 +302,7 @@ void compileCompoundAssignment(const ASTNode* node, const SymbolTable* st, const
 
     const ASTNodeType op_type = node->child->right->node_type;
 
-    if (!os->hasCompdAssign(op_type)) {
+    if (!os->hasCompdAssign(op_type) || isWrappingOP(node->child->right, os)) {
         compileAssignment(node->child, st, os, stream, is_stmt);
         return;
     }
@@ -255,7 +328,10 @@ void compileCompoundAssignment(const ASTNode* node, const SymbolTable* st, const
     }
 
     if (lval->node_type == AST_ID) {
-        IOStreamWritef(stream, "%s %s ", getVarId(lval->id), op_symbol);
+        compileVar(stream, lval->id, os, false);
+        IOStreamWriteChar(stream, ' ');
+        IOStreamWriteStr(stream, op_symbol);
+        IOStreamWriteChar(stream, ' ');
         compileASTExpression(rval, st, stream, os, false);
     } else {
         assert(lval->node_type == AST_PARENTHESES);
@@ -264,9 +340,9 @@ void compileCompoundAssignment(const ASTNode* node, const SymbolTable* st, const
         if (is_stmt) {
             if (lval->node_type != AST_ID && os->condAssignNeedsTmp()) {
                 writeTmpVar(lval->value_type, stream);
-                IOStreamWritef(stream, " = ");
+                IOStreamWriteLiteral(stream, " = ");
             }
-            IOStreamWritef(stream, "(");
+            IOStreamWriteChar(stream, '(');
         }
 
         ASTResult res = newASTCompoundAssignment(op_type, copyAST(lval->child->second), copyAST(rval));
@@ -282,7 +358,7 @@ void compileCompoundAssignment(const ASTNode* node, const SymbolTable* st, const
         deleteASTNode(&new_node);
 
         if (is_stmt) {
-            IOStreamWritef(stream, ")");
+            IOStreamWriteChar(stream, ')');
         }
     }
 }
@@ -290,15 +366,17 @@ void compileCompoundAssignment(const ASTNode* node, const SymbolTable* st, const
 void compileUnaryCompoundAssignment(const ASTNode* node, const SymbolTable* st, const OutSerializer* os, const IOStream* stream, bool is_stmt) {
     assert(node != NULL);
 
-    if (node->child->left->node_type == AST_ID) {
+    // An increment that has to wrap is compiled as the assignment of its addition, like the ones of the other lvalues
+    bool wraps = isWrappingOP(node->child->right, os);
+    if (node->child->left->node_type == AST_ID && !wraps) {
         if (node->node_type == AST_INC || node->node_type == AST_DEC) {
             char* op_symbol = node->node_type == AST_INC ? "++" : "--";
             if (node->is_prefix) {
-                IOStreamWritef(stream, op_symbol);
+                IOStreamWriteStr(stream, op_symbol);
                 compileASTExpression(node->child->left, st, stream, os, false);
             } else {
                 compileASTExpression(node->child->left, st, stream, os, false);
-                IOStreamWritef(stream, op_symbol);
+                IOStreamWriteStr(stream, op_symbol);
             }
         } else {
             assert(node->node_type == AST_LOGICAL_TOGGLE || node->node_type == AST_BITWISE_TOGGLE);
@@ -308,17 +386,22 @@ void compileUnaryCompoundAssignment(const ASTNode* node, const SymbolTable* st,
             } else {
                 if (os->condAssignNeedsTmp() && is_stmt) {
                     writeTmpVar(node->child->value_type, stream);
-                    IOStreamWritef(stream, " = ");
+                    IOStreamWriteLiteral(stream, " = ");
                 }
                 char* op_symbol = node->node_type == AST_LOGICAL_TOGGLE ? "!" : (node->child->value_type == AST_TYPE_BOOL ? "!" : "~");
-                IOStreamWritef(stream, "%s(", op_symbol);
+                IOStreamWriteStr(stream, op_symbol);
+                IOStreamWriteChar(stream, '(');
                 compileASTExpression(node->child, st, stream, os, false);
-                IOStreamWritef(stream, ")");
+                IOStreamWriteChar(stream, ')');
             }
         }
     } else {
         if (node->is_prefix) {
+            // The assignment binds looser than the increment that it replaces
+            bool need_parentheses = wraps && !is_stmt;
+            if (need_parentheses) { IOStreamWriteChar(stream, '('); }
             compileAssignment(node->child, st, os, stream, is_stmt);
+            if (need_parentheses) { IOStreamWriteChar(stream, ')'); }
         } else {
             ASTNode* new_node = copyAST(node->child);
             ASTResult res;
@@ -341,18 +424,45 @@ void compileUnaryCompoundAssignment(const ASTNode* node, const SymbolTable* st,
 void compileIDDeclaration(Symbol* var, const ASTNode* value, const SymbolTable* st, const IOStream* stream, const OutSerializer* os) {
     assert(var != NULL &&  st != NULL);
 
-    os->parseType(stream, getVarType(var), false);
+    // The slot already exists, and a declaration without a value leaves it as it is
+    if (os->vars_in_frame) {
+        if(value != NULL) {
+            compileVar(stream, var, os, false);
+            IOStreamWriteLiteral(stream, " = ");
+            compileASTExpression(value, st, stream, os, true);
+        }
+        return;
+    }
 
-    IOStreamWritef(stream, " ");
+    // The local of a shared slot is declared by compileSharedSlots
+    if (!isVarSlotShared(var)) {
+        os->parseType(stream, getVarType(var), false);
+        IOStreamWriteChar(stream, ' ');
+    }
 
     printId(stream, var, os->print_redef_level);
 
     if(value != NULL) {
-        IOStreamWritef(stream, " = ");
+        IOStreamWriteLiteral(stream, " = ");
         compileASTExpression(value, st, stream, os, true);
     }
 }
 
+void compileSharedSlots(const SymbolTable* st, const IOStream* stream, const OutSerializer* os, unsigned int indentation_level) {
+    assert(st != NULL && !os->vars_in_frame);
+
+    const unsigned int slot_count = getTotalSymbolAmount(st) > 0 ? getMaxOffset(st) + 1 : 0;
+    for (unsigned int i = 0; i < slot_count; i++) {
+        const Symbol* var = lookupLastVarWithOffset(st, i);
+        if (var == NULL || !isVarSlotShared(var)) {
+            continue;
+        }
+        indent(stream, indentation_level);
+        os->parseType(stream, getVarType(var), false);
+        IOStreamWritef(stream, " %s%u = %s;\n", SLOT_LOCAL_PREFIX, i, getVarType(var) == AST_TYPE_BOOL ? "false" : "0");
+    }
+}
+
 static inline const char* compare(const ASTNodeType node_type) {
     switch (node_type) {
         case AST_CMP_EQ:  return "==";
@@ -384,26 +494,41 @@ void compileCmpExp(const ASTNode* ast, const SymbolTable* st, const IOStream* st
     if(isCmpExp(ast->left)) { // left is chained
         compileCmpExp(ast->left, st, stream, os, true);
     } else {
-        compileASTExpression(ast->left, st, stream, os, false);
+        compileChildExpression(ast, ast->left, st, os, stream);
     }
 
-    IOStreamWritef(stream, " %s ", compare(ast->node_type));
+    IOStreamWriteChar(stream, ' ');
+    IOStreamWriteStr(stream, compare(ast->node_type));
+    IOStreamWriteChar(stream, ' ');
 
     if(is_chained) {
         if(needsTempVar(ast->right->node_type)) {
-            IOStreamWritef(stream, "(");
+            IOStreamWriteChar(stream, '(');
             writeTmpVar(ast->right->value_type, stream);
-            IOStreamWritef(stream, " = ");
+            IOStreamWriteLiteral(stream, " = ");
             compileASTExpression(ast->right, st, stream, os, false);
-            IOStreamWritef(stream, ") && ");
+            IOStreamWriteLiteral(stream, ") && ");
             writeTmpVar(ast->right->value_type, stream);
         } else {
             compileASTExpression(ast->right, st, stream, os, false);
-            IOStreamWritef(stream, " && ");
+            IOStreamWriteLiteral(stream, " && ");
             compileASTExpression(ast->right, st, stream, os, false);
         }
     } else {
-        compileASTExpression(ast->right, st, stream, os, false);
+        compileChildExpression(ast, ast->right, st, os, stream);
+    }
+}
+
+// Two signs in a row would be read as an increment or decrement
+static inline bool startsWithSign(const ASTNode* node, char sign) {
+    switch (node->node_type) {
+        case AST_INT:          return sign == '-' && node->n < 0;
+        case AST_USUB:
+        case AST_SET_NEGATIVE: return sign == '-';
+        case AST_UADD:         return sign == '+';
+        case AST_INC:          return sign == '+' && node->is_prefix;
+        case AST_DEC:          return sign == '-' && node->is_prefix;
+        default:               return false;
     }
 }
 
@@ -412,54 +537,63 @@ void compileASTExpression(const ASTNode* node, const SymbolTable* st, const IOSt
 
     switch (node->node_type) {
         case AST_INT:
-            IOStreamWritef(stream, "%d", node->n);
+            IOStreamWriteInt(stream, node->n);
             break;
         case AST_BOOL:
-            IOStreamWritef(stream, "%s", node->z ? "true" : "false");
+            IOStreamWriteStr(stream, node->z ? "true" : "false");
             break;
         case AST_TYPE:
             os->parseType(stream, node->t, true);
             break;
         case AST_ID:
-            printId(stream, node->id, os->print_redef_level);
+            compileVar(stream, node->id, os, os->print_redef_level);
             break;
         case AST_ADD:
-            compileBinaryOP(node, " + ", st, os, stream);
-            break;
         case AST_SUB:
-            compileBinaryOP(node, " - ", st, os, stream);
-            break;
         case AST_MUL:
-            compileBinaryOP(node, "*", st, os, stream);
+            if (isWrappingOP(node, os)) {
+                compileWrappingOP(node, st, os, stream, false);
+            } else if (node->node_type == AST_MUL) {
+                compileBinaryOP(node, "*", st, os, stream);
+            } else {
+                compileBinaryOP(node, node->node_type == AST_ADD ? " + " : " - ", st, os, stream);
+            }
             break;
         case AST_DIV:
             compileBinaryOP(node, "/", st, os, stream);
             break;
         case AST_MOD:
-            compileBinaryOP(node, "%%", st, os, stream);
+            compileBinaryOP(node, "%", st, os, stream);
+            break;
+        case AST_WRAP_ADD:
+        case AST_WRAP_SUB:
+        case AST_WRAP_MUL:
+            compileWrappingOP(node, st, os, stream, false);
             break;
         case AST_USUB:
-            IOStreamWritef(stream, "-");
+            IOStreamWriteChar(stream, '-');
+            if (startsWithSign(node->child, '-')) { IOStreamWriteChar(stream, ' '); }
             compileChildExpression(node, node->child, st, os, stream);
             break;
         case AST_UADD:
-            IOStreamWritef(stream, "+");
+            IOStreamWriteChar(stream, '+');
+            if (startsWithSign(node->child, '+')) { IOStreamWriteChar(stream, ' '); }
             compileChildExpression(node, node->child, st, os, stream);
             break;
         case AST_ABS: {
-            IOStreamWritef(stream, "abs(");
+            IOStreamWriteLiteral(stream, "abs(");
             compileASTExpression(node->child, st, stream, os, false);
-            IOStreamWritef(stream, ")");
+            IOStreamWriteChar(stream, ')');
             break;
         } case AST_SET_POSITIVE: {
-            IOStreamWritef(stream, "abs(");
+            IOStreamWriteLiteral(stream, "abs(");
             compileASTExpression(node->child, st, stream, os, false);
-            IOStreamWritef(stream, ")");
+            IOStreamWriteChar(stream, ')');
             break;
         } case AST_SET_NEGATIVE: {
-            IOStreamWritef(stream, "-abs(");
+            IOStreamWriteLiteral(stream, "-abs(");
             compileASTExpression(node->child, st, stream, os, false);
-            IOStreamWritef(stream, ")");
+            IOStreamWriteChar(stream, ')');
             break;
         } case AST_BITWISE_AND:
             compileBinaryOP(node, "&", st, os, stream);
@@ -472,9 +606,9 @@ void compileASTExpression(const ASTNode* node, const SymbolTable* st, const IOSt
             break;
         case AST_BITWISE_NOT:
             if(node->child->value_type == AST_TYPE_BOOL) {
-                IOStreamWritef(stream, "!");
+                IOStreamWriteChar(stream, '!');
             } else {
-                IOStreamWritef(stream, "~");
+                IOStreamWriteChar(stream, '~');
             }
             compileChildExpression(node, node->child, st, os, stream);
             break;
@@ -485,7 +619,7 @@ void compileASTExpression(const ASTNode* node, const SymbolTable* st, const IOSt
             compileBinaryOP(node, " >> ", st, os, stream);
             break;
         case AST_LOGICAL_NOT:
-            IOStreamWritef(stream, "!");
+            IOStreamWriteChar(stream, '!');
             compileChildExpression(node, node->child, st, os, stream);
             break;
         case AST_LOGICAL_AND:
@@ -523,9 +657,9 @@ void compileASTExpression(const ASTNode* node, const SymbolTable* st, const IOSt
 
             break;
         } case AST_PARENTHESES:
-            IOStreamWritef(stream, "(");
+            IOStreamWriteChar(stream, '(');
             compileASTExpression(node->child, st, stream, os, false);
-            IOStreamWritef(stream, ")");
+            IOStreamWriteChar(stream, ')');
             break;
         case AST_CMP_EQ:
         case AST_CMP_NEQ:
@@ -537,9 +671,9 @@ void compileASTExpression(const ASTNode* node, const SymbolTable* st, const IOSt
             break;
         } case AST_TERNARY_COND: {
             compileChildExpression(node, node->first, st, os, stream);
-            IOStreamWritef(stream, " ? ");
+            IOStreamWriteLiteral(stream, " ? ");
             compileChildExpression(node, node->second, st, os, stream);
-            IOStreamWritef(stream, " : ");
+            IOStreamWriteLiteral(stream, " : ");
             compileChildExpression(node, node->third, st, os, stream);
             break;
         } default:
@@ -549,15 +683,15 @@ void compileASTExpression(const ASTNode* node, const SymbolTable* st, const IOSt
 
 void compileScope(const ASTNode* scope_node, const SymbolTable* st, const IOStream* stream, const OutSerializer* os,
                   unsigned int indentation_level, bool print_new_line) {
-    IOStreamWritef(stream, "{\n");
+    IOStreamWriteLiteral(stream, "{\n");
 
     compileASTStatements(scope_node->child, st, stream, os, indentation_level + 1, true, true);
 
     indent(stream, indentation_level);
-    IOStreamWritef(stream, "}");
+    IOStreamWriteChar(stream, '}');
 
     if (print_new_line) {
-        IOStreamWritef(stream, "\n");
+        IOStreamWriteChar(stream, '\n');
     }
 }
 
@@ -568,22 +702,22 @@ void compileIf(const ASTNode* ast, const SymbolTable* st, const IOStream* stream
     const ASTNode* cond = ast->node_type == AST_IF ? ast->left : ast->first;
     const ASTNode* then = ast->node_type == AST_IF ? ast->right : ast->second;
 
-    IOStreamWritef(stream, "if (");
+    IOStreamWriteLiteral(stream, "if (");
     compileASTExpression(cond, st, stream, os, true);
-    IOStreamWritef(stream, ") ");
+    IOStreamWriteLiteral(stream, ") ");
 
     if (then->node_type == AST_SCOPE) {
         compileScope(then, st, stream, os, indentation_level, false);
     } else {
-        IOStreamWritef(stream, "{ ");
+        IOStreamWriteLiteral(stream, "{ ");
         compileASTStatements(then, st, stream, os, 0, false, true);
-        IOStreamWritef(stream, " }");
+        IOStreamWriteLiteral(stream, " }");
     }
 
     if (ast->node_type == AST_IF) {
-        IOStreamWritef(stream, "\n");
+        IOStreamWriteChar(stream, '\n');
     } else {
-        IOStreamWritef(stream, " else ");
+        IOStreamWriteLiteral(stream, " else ");
 
         if (ast->third->node_type == AST_IF || ast->third->node_type == AST_IF_ELSE) {
             compileIf(ast->third, st, stream, os, indentation_level);
@@ -598,8 +732,9 @@ void compileASTStatements(const ASTNode* ast, const SymbolTable* st, const IOStr
     assert(st != NULL);
 
     if(ast->node_type == AST_STATEMENT_SEQ) {
-        compileASTStatements(ast->left, st, stream, os, indentation_level, print_new_line, print_semicolon);
-        compileASTStatements(ast->right, st, stream, os, indentation_level, print_new_line, print_semicolon);
+        for (unsigned int i = 0; i < ast->stmt_count; i++) {
+            compileASTStatements(ast->stmts[i], st, stream, os, indentation_level, print_new_line, print_semicolon);
+        }
         return;
     }
 
@@ -632,7 +767,7 @@ void compileASTStatements(const ASTNode* ast, const SymbolTable* st, const IOStr
             char* ptr;
             size_t size;
             IOStream* s = openIOStreamFromMemmory(&ptr, &size);
-            printId(s, ast->child->id, os->print_redef_level);
+            compileVar(s, ast->child->id, os, os->print_redef_level);
             IOStreamClose(&s);
 
             os->print(ptr, ast->child->value_type, getVarId(ast->child->id), stream);
@@ -654,11 +789,11 @@ void compileASTStatements(const ASTNode* ast, const SymbolTable* st, const IOStr
             return; // Skip the ;
         }
         case AST_WHILE: {
-            IOStreamWritef(stream, "while (");
+            IOStreamWriteLiteral(stream, "while (");
             compileASTExpression(ast->left, st, stream, os, true);
-            IOStreamWritef(stream, ")");
+            IOStreamWriteChar(stream, ')');
             if (ast->right->node_type == AST_SCOPE) {
-                IOStreamWritef(stream, " ");
+                IOStreamWriteChar(stream, ' ');
                 compileScope(ast->right, st, stream, os, indentation_level, true);
             } else if (ast->right->node_type == AST_NO_OP) {
                 compileASTStatements(ast->right, st, stream, os, 0, true, true);
@@ -668,39 +803,39 @@ void compileASTStatements(const ASTNode* ast, const SymbolTable* st, const IOStr
             return; // Skip the ;
         }
         case AST_DO_WHILE: {
-            IOStreamWritef(stream, "do ");
+            IOStreamWriteLiteral(stream, "do ");
             if (ast->left->node_type == AST_SCOPE) {
                 compileScope(ast->left, st, stream, os, indentation_level, false);
             } else if (ast->left->node_type == AST_NO_OP) {
-                IOStreamWritef(stream, "{ }");
+                IOStreamWriteLiteral(stream, "{ }");
             } else {
                 assert(false);
             }
-            IOStreamWritef(stream, " while (");
+            IOStreamWriteLiteral(stream, " while (");
             compileASTExpression(ast->right, st, stream, os, true);
-            IOStreamWritef(stream, ")");
+            IOStreamWriteChar(stream, ')');
             break;
         }
         case AST_FOR: {
-            const ASTNode* init = ast->child->left;
-            const ASTNode* cond = ast->child->right->left;
-            const ASTNode* scope = ast->child->right->right;
+            const ASTNode* init = ast->child->stmts[0];
+            const ASTNode* cond = ast->child->stmts[1]->left;
+            const ASTNode* scope = ast->child->stmts[1]->right;
             assert(scope->node_type == AST_SCOPE);
-            const ASTNode* update = scope->child->right;
-            const ASTNode* body = scope->child->left;
+            const ASTNode* update = scope->child->stmts[1];
+            const ASTNode* body = scope->child->stmts[0];
 
-            IOStreamWritef(stream, "for (");
+            IOStreamWriteLiteral(stream, "for (");
             compileASTStatements(init, st, stream, os, 0, false, true);
-            IOStreamWritef(stream, " ");
+            IOStreamWriteChar(stream, ' ');
             compileASTStatements(cond, st, stream, os, 0, false, true);
             if (update->node_type != AST_NO_OP) {
-                IOStreamWritef(stream, " ");
+                IOStreamWriteChar(stream, ' ');
                 compileASTStatements(update, st, stream, os, 0, false, false);
             }
-            IOStreamWritef(stream, ")");
+            IOStreamWriteChar(stream, ')');
 
             if (body->node_type == AST_SCOPE) {
-                IOStreamWritef(stream, " ");
+                IOStreamWriteChar(stream, ' ');
                 compileScope(body, st, stream, os, indentation_level, true);
             } else if (body->node_type == AST_NO_OP) {
                 compileASTStatements(body, st, stream, os, 0, true, true);
@@ -710,11 +845,11 @@ void compileASTStatements(const ASTNode* ast, const SymbolTable* st, const IOStr
             return; // Skip the ;
         }
         case AST_BREAK: {
-            IOStreamWritef(stream, "break");
+            IOStreamWriteLiteral(stream, "break");
             break;
         }
         case AST_CONTINUE: {
-            IOStreamWritef(stream, "continue");
+            IOStreamWriteLiteral(stream, "continue");
             break;
         }
         default: {
@@ -728,10 +863,10 @@ void compileASTStatements(const ASTNode* ast, const SymbolTable* st, const IOStr
     }
 
     if(print_semicolon) {
-        IOStreamWritef(stream, ";");
+        IOStreamWriteChar(stream, ';');
     }
 
     if (print_new_line) {
-        IOStreamWritef(stream, "\n");
+        IOStreamWriteChar(stream, '\n');
     }
 }
@@ -106,7 +106,10 @@ const OutSerializer javaSerializer = {
     &print,
     &condAssignNeedsTmp,
     &hasCompdAssign,
-    true
+    true,
+    false,
+    true,
+    false
 };
 
 static void printClassName(const IOStream* stream, const char* file_name) {
@@ -157,6 +160,7 @@ bool outCompileToJava(const ASTNode* ast, const SymbolTable* st, const char* fil
     generateTypeEnum(stream);
     generateTempVars(stream);
     IOStreamWritef(stream, "\n%s", PRE);
+    compileSharedSlots(st, stream, &javaSerializer, INITIAL_INDENTATION_LEVEL);
     compileASTStatements(ast, st, stream, &javaSerializer, INITIAL_INDENTATION_LEVEL, true, true);
     IOStreamWritef(stream, "%s", POS);
 
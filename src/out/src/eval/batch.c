@@ -0,0 +1,404 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+
+#include "out.h"
+
+// Evaluates an expression for many rows at once. The rows are processed in chunks of BATCH_SIZE, and each node is
+// evaluated once per chunk, by a loop over the rows of the chunk, into a vector with a value per row. The short
+// circuits, the ternary conditions and the chained comparisons evaluate their operands only for the rows that the
+// tree walker would, through a selection vector with the indexes of those rows.
+
+// Rows per chunk, so that the vectors of a chunk stay in the cache
+#define BATCH_SIZE 1024
+
+// Runs the statement for each selected row i, with a plain loop when all the rows are selected so that it vectorizes
+#define FOR_EACH_ROW(sel, n, i, stmt) do {\
+    if ((sel) == NULL) {\
+        for (unsigned int i = 0; i < (n); i++) { stmt; }\
+    } else {\
+        for (unsigned int k_ = 0; k_ < (n); k_++) { const unsigned int i = (sel)[k_]; stmt; }\
+    }\
+} while (0)
+
+// Vectors of BATCH_SIZE values that are not in use, reused by the nodes
+typedef struct VectorPool {
+    void** vectors;
+    unsigned int count;
+    unsigned int capacity;
+} VectorPool;
+
+typedef struct Batch {
+    int** slots;            // Values of each slot for the rows of the chunk, only written if the slot is written
+    bool* written;          // Slots assigned by the expression, which are copied into scratch vectors
+    int** scratch;
+    int* zeros;             // Slots without a column that are only read
+    unsigned int slot_count;
+    VectorPool pool;
+} Batch;
+
+static void* acquireVector(Batch* b) {
+    if (b->pool.count > 0) {
+        return b->pool.vectors[--b->pool.count];
+    }
+    void* vector = malloc(BATCH_SIZE * sizeof(int));
+    assert(vector != NULL);
+    return vector;
+}
+
+static void releaseVector(Batch* b, void* vector) {
+    if (b->pool.count == b->pool.capacity) {
+        b->pool.capacity = 2 * b->pool.capacity + 8;
+        b->pool.vectors = realloc(b->pool.vectors, b->pool.capacity * sizeof(void*));
+        assert(b->pool.vectors != NULL);
+    }
+    b->pool.vectors[b->pool.count++] = vector;
+}
+
+static void collectWrittenSlots(const ASTNode* node, bool* written, bool is_lval) {
+    switch (node->node_type) {
+        case AST_ID:
+            if (is_lval) {
+                written[getVarOffset(node->id)] = true;
+            }
+            return;
+        case AST_ID_ASSIGNMENT:
+            collectWrittenSlots(node->left, written, true);
+            collectWrittenSlots(node->right, written, false);
+            return;
+        case AST_TERNARY_COND:
+            // The condition of a ternary lvalue is only read
+            collectWrittenSlots(node->first, written, false);
+            collectWrittenSlots(node->second, written, is_lval);
+            collectWrittenSlots(node->third, written, is_lval);
+            return;
+        case AST_PARENTHESES:
+            collectWrittenSlots(node->child, written, is_lval);
+            return;
+        default:
+            break;
+    }
+
+    switch (getNodeOpType(node->node_type)) {
+        case ZEROARY_OP:
+            break;
+        case UNARY_OP:
+            collectWrittenSlots(node->child, written, false);
+            break;
+        case BINARY_OP:
+            collectWrittenSlots(node->left, written, false);
+            collectWrittenSlots(node->right, written, false);
+            break;
+        default:
+            assert(false);
+    }
+}
+
+// Splits the selected rows by the truth of their values, into the ones where it is true and the rest. Returns the
+// number of true rows.
+static unsigned int splitRows(const unsigned int* sel, unsigned int n, const int* values, unsigned int* when_true, unsigned int* when_false) {
+    unsigned int t = 0;
+    unsigned int f = 0;
+    FOR_EACH_ROW(sel, n, i, {
+        if (values[i]) {
+            when_true[t++] = i;
+        } else {
+            when_false[f++] = i;
+        }
+    });
+    return t;
+}
+
+static const int* evalBatch(const ASTNode* node, Batch* b, const unsigned int* sel, unsigned int n, int* out);
+
+// Evaluates the operand into out, unless its values are already in a vector that nothing else writes
+static inline void evalInto(const ASTNode* node, Batch* b, const unsigned int* sel, unsigned int n, int* out) {
+    const int* values = evalBatch(node, b, sel, n, out);
+    if (values != out) {
+        FOR_EACH_ROW(sel, n, i, out[i] = values[i]);
+    }
+}
+
+// Writes the slot of the lvalue of each selected row to targets
+static void evalLValBatch(const ASTNode* lval, Batch* b, const unsigned int* sel, unsigned int n, unsigned int* targets) {
+    switch (lval->node_type) {
+        case AST_ID: {
+            const unsigned int slot = getVarOffset(lval->id);
+            FOR_EACH_ROW(sel, n, i, targets[i] = slot);
+            break;
+        } case AST_PARENTHESES:
+            evalLValBatch(lval->child, b, sel, n, targets);
+            break;
+        case AST_TERNARY_COND: {
+            int* cond = acquireVector(b);
+            unsigned int* when_true = acquireVector(b);
+            unsigned int* when_false = acquireVector(b);
+            const int* values = evalBatch(lval->first, b, sel, n, cond);
+            const unsigned int t = splitRows(sel, n, values, when_true, when_false);
+            evalLValBatch(lval->second, b, when_true, t, targets);
+            evalLValBatch(lval->third, b, when_false, n - t, targets);
+            releaseVector(b, when_false);
+            releaseVector(b, when_true);
+            releaseVector(b, cond);
+            break;
+        } default:
+            assert(false);
+    }
+}
+
+static const int* evalAssignmentBatch(const ASTNode* node, Batch* b, const unsigned int* sel, unsigned int n, int* out) {
+    // The lvalue is resolved before the value is computed, as in the tree walker
+    if (node->left->node_type == AST_ID) {
+        const int* values = evalBatch(node->right, b, sel, n, out);
+        int* slot = b->slots[getVarOffset(node->left->id)];
+        FOR_EACH_ROW(sel, n, i, slot[i] = values[i]);
+        return values;
+    }
+
+    unsigned int* targets = acquireVector(b);
+    evalLValBatch(node->left, b, sel, n, targets);
+    const int* values = evalBatch(node->right, b, sel, n, out);
+    FOR_EACH_ROW(sel, n, i, b->slots[targets[i]][i] = values[i]);
+    releaseVector(b, targets);
+    return values;
+}
+
+// Evaluates a comparison into out, and its right operand into carry for the comparison that chains it
+static void evalCmpBatch(const ASTNode* node, Batch* b, const unsigned int* sel, unsigned int n, int* out, int* carry) {
+    const unsigned int* rows = sel;
+    unsigned int row_count = n;
+    unsigned int* when_true = NULL;
+    if (isCmpExp(node->left)) {
+        // The right operand is only evaluated for the rows where the chain still holds, which compare its carry
+        evalCmpBatch(node->left, b, sel, n, out, carry);
+        when_true = acquireVector(b);
+        unsigned int* when_false = acquireVector(b);
+        row_count = splitRows(sel, n, out, when_true, when_false);
+        releaseVector(b, when_false);
+        rows = when_true;
+    } else {
+        evalInto(node->left, b, sel, n, carry);
+    }
+
+    int* r = acquireVector(b);
+    evalInto(node->right, b, rows, row_count, r);
+    switch (node->node_type) {
+        case AST_CMP_EQ:  FOR_EACH_ROW(rows, row_count, i, out[i] = carry[i] == r[i]); break;
+        case AST_CMP_NEQ: FOR_EACH_ROW(rows, row_count, i, out[i] = carry[i] != r[i]); break;
+        case AST_CMP_LT:  FOR_EACH_ROW(rows, row_count, i, out[i] = carry[i] <  r[i]); break;
+        case AST_CMP_LTE: FOR_EACH_ROW(rows, row_count, i, out[i] = carry[i] <= r[i]); break;
+        case AST_CMP_GT:  FOR_EACH_ROW(rows, row_count, i, out[i] = carry[i] >  r[i]); break;
+        case AST_CMP_GTE: FOR_EACH_ROW(rows, row_count, i, out[i] = carry[i] >= r[i]); break;
+        default:
+            assert(false);
+    }
+    FOR_EACH_ROW(rows, row_count, i, carry[i] = r[i]);
+    releaseVector(b, r);
+    if (when_true != NULL) {
+        releaseVector(b, when_true);
+    }
+}
+
+#define BINARY_BATCH(exp) {\
+        int* l = acquireVector(b);\
+        evalInto(node->left, b, sel, n, l);\
+        const int* r = evalBatch(node->right, b, sel, n, out);\
+        FOR_EACH_ROW(sel, n, i, out[i] = (exp));\
+        releaseVector(b, l);\
+        return out;\
+    }
+
+#define UNARY_BATCH(exp) {\
+        const int* v = evalBatch(node->child, b, sel, n, out);\
+        FOR_EACH_ROW(sel, n, i, out[i] = (exp));\
+        return out;\
+    }
+
+// Returns the vector with the values of the selected rows, which is either out or the vector of a slot that the
+// expression never writes
+static const int* evalBatch(const ASTNode* node, Batch* b, const unsigned int* sel, unsigned int n, int* out) {
+    assert(node != NULL);
+
+    switch (node->node_type) {
+        case AST_INT:
+        case AST_BOOL:
+        case AST_TYPE: {
+            const int value = node->node_type == AST_INT ? node->n : (node->node_type == AST_BOOL ? node->z : (int) node->t);
+            FOR_EACH_ROW(sel, n, i, out[i] = value);
+            return out;
+        } case AST_ID: {
+            const unsigned int slot = getVarOffset(node->id);
+            if (!b->written[slot]) {
+                return b->slots[slot];
+            }
+            // Copied, as the rest of the expression may assign it before the value is used
+            const int* values = b->slots[slot];
+            FOR_EACH_ROW(sel, n, i, out[i] = values[i]);
+            return out;
+        }
+        case AST_ADD:         BINARY_BATCH(l[i] + r[i])
+        case AST_SUB:         BINARY_BATCH(l[i] - r[i])
+        case AST_MUL:         BINARY_BATCH(l[i] * r[i])
+        case AST_DIV:         BINARY_BATCH(l[i] / r[i])
+        case AST_MOD:         BINARY_BATCH(l[i] % r[i])
+        case AST_BITWISE_OR:  BINARY_BATCH(l[i] | r[i])
+        case AST_BITWISE_AND: BINARY_BATCH(l[i] & r[i])
+        case AST_BITWISE_XOR: BINARY_BATCH(l[i] ^ r[i])
+        case AST_L_SHIFT:     BINARY_BATCH(l[i] << r[i])
+        case AST_R_SHIFT:     BINARY_BATCH(l[i] >> r[i])
+        case AST_WRAP_ADD:    BINARY_BATCH(WRAP_INT_OP(l[i], +, r[i]))
+        case AST_WRAP_SUB:    BINARY_BATCH(WRAP_INT_OP(l[i], -, r[i]))
+        case AST_WRAP_MUL:    BINARY_BATCH(WRAP_INT_OP(l[i], *, r[i]))
+        case AST_USUB:        UNARY_BATCH(- v[i])
+        case AST_UADD:
+        case AST_PARENTHESES:
+        case AST_COMPD_ASSIGN:
+            return evalBatch(node->child, b, sel, n, out);
+        case AST_BITWISE_NOT:
+            if (node->child->value_type == AST_TYPE_BOOL) {
+                UNARY_BATCH(!v[i])
+            }
+            UNARY_BATCH(~v[i])
+        case AST_ABS:          UNARY_BATCH(v[i] >= 0 ? v[i] : - v[i])
+        case AST_SET_POSITIVE: UNARY_BATCH((v[i] < 0)*(~(v[i])+1) + (1 - (v[i] < 0))*v[i])
+        case AST_SET_NEGATIVE: UNARY_BATCH((1 - (v[i] < 0))*(~(v[i])+1) + (v[i] < 0)*v[i])
+        case AST_LOGICAL_NOT:  UNARY_BATCH(!v[i])
+        case AST_INC:
+            if (node->is_prefix) {
+                return evalBatch(node->child, b, sel, n, out);
+            }
+            UNARY_BATCH(v[i] - 1)
+        case AST_DEC:
+            if (node->is_prefix) {
+                return evalBatch(node->child, b, sel, n, out);
+            }
+            UNARY_BATCH(v[i] + 1)
+        case AST_LOGICAL_TOGGLE:
+            if (node->is_prefix) {
+                UNARY_BATCH(v[i] != 0)
+            }
+            UNARY_BATCH(v[i] == 0)
+        case AST_BITWISE_TOGGLE:
+            if (node->is_prefix) {
+                return evalBatch(node->child, b, sel, n, out);
+            } else if (node->child->value_type == AST_TYPE_BOOL) {
+                UNARY_BATCH(!v[i])
+            }
+            UNARY_BATCH(~v[i])
+        case AST_TYPE_OF: {
+            evalBatch(node->child, b, sel, n, out);
+            const int type = node->child->value_type;
+            FOR_EACH_ROW(sel, n, i, out[i] = type);
+            return out;
+        } case AST_ID_ASSIGNMENT:
+            return evalAssignmentBatch(node, b, sel, n, out);
+        case AST_LOGICAL_AND:
+        case AST_LOGICAL_OR: {
+            // The right operand is only evaluated for the rows that the left one does not decide
+            const bool is_and = node->node_type == AST_LOGICAL_AND;
+            int* l = acquireVector(b);
+            unsigned int* when_true = acquireVector(b);
+            unsigned int* when_false = acquireVector(b);
+            evalInto(node->left, b, sel, n, l);
+            const unsigned int t = splitRows(sel, n, l, when_true, when_false);
+            if (is_and) {
+                FOR_EACH_ROW(when_false, n - t, i, out[i] = false);
+                evalInto(node->right, b, when_true, t, out);
+            } else {
+                FOR_EACH_ROW(when_true, t, i, out[i] = true);
+                evalInto(node->right, b, when_false, n - t, out);
+            }
+            releaseVector(b, when_false);
+            releaseVector(b, when_true);
+            releaseVector(b, l);
+            return out;
+        } case AST_TERNARY_COND: {
+            int* cond = acquireVector(b);
+            unsigned int* when_true = acquireVector(b);
+            unsigned int* when_false = acquireVector(b);
+            evalInto(node->first, b, sel, n, cond);
+            const unsigned int t = splitRows(sel, n, cond, when_true, when_false);
+            evalInto(node->second, b, when_true, t, out);
+            evalInto(node->third, b, when_false, n - t, out);
+            releaseVector(b, when_false);
+            releaseVector(b, when_true);
+            releaseVector(b, cond);
+            return out;
+        } case AST_CMP_EQ:
+          case AST_CMP_NEQ:
+          case AST_CMP_LT:
+          case AST_CMP_LTE:
+          case AST_CMP_GT:
+          case AST_CMP_GTE: {
+            int* carry = acquireVector(b);
+            evalCmpBatch(node, b, sel, n, out, carry);
+            releaseVector(b, carry);
+            return out;
+        } default:
+            assert(false);
+            return out;
+    }
+}
+
+void evalASTExpressionBatch(const ASTNode* exp, const SymbolTable* st, const BatchColumn* columns, unsigned int column_count, unsigned int row_count, int* out) {
+    assert(exp != NULL && st != NULL && out != NULL);
+    assert(isExp(exp));
+    assert(columns != NULL || column_count == 0);
+
+    Batch b = { .slot_count = getMaxOffset(st) + 1, .pool = { .vectors = NULL, .count = 0, .capacity = 0 } };
+    b.slots = malloc(b.slot_count * sizeof(int*));
+    b.written = calloc(b.slot_count, sizeof(bool));
+    b.scratch = calloc(b.slot_count, sizeof(int*));
+    b.zeros = calloc(BATCH_SIZE, sizeof(int));
+    assert(b.slots != NULL && b.written != NULL && b.scratch != NULL && b.zeros != NULL);
+    collectWrittenSlots(exp, b.written, false);
+
+    // The last column of a slot is the one that counts, as when the columns are stored in a frame one after the other
+    const int** inputs = calloc(b.slot_count, sizeof(int*));
+    assert(inputs != NULL);
+    for (unsigned int c = 0; c < column_count; c++) {
+        const unsigned int slot = getVarOffset(columns[c].var);
+        assert(slot < b.slot_count && (columns[c].values != NULL || row_count == 0));
+        inputs[slot] = columns[c].values;
+    }
+    for (unsigned int s = 0; s < b.slot_count; s++) {
+        if (b.written[s]) {
+            b.scratch[s] = malloc(BATCH_SIZE * sizeof(int));
+            assert(b.scratch[s] != NULL);
+        }
+    }
+
+    for (unsigned int first = 0; first < row_count; first += BATCH_SIZE) {
+        const unsigned int n = row_count - first < BATCH_SIZE ? row_count - first : BATCH_SIZE;
+        for (unsigned int s = 0; s < b.slot_count; s++) {
+            if (!b.written[s]) {
+                b.slots[s] = inputs[s] != NULL ? (int*) inputs[s] + first : b.zeros;
+            } else if (inputs[s] != NULL) {
+                memcpy(b.scratch[s], inputs[s] + first, n * sizeof(int));
+                b.slots[s] = b.scratch[s];
+            } else {
+                memset(b.scratch[s], 0, n * sizeof(int));
+                b.slots[s] = b.scratch[s];
+            }
+        }
+        int* chunk_out = out + first;
+        const int* values = evalBatch(exp, &b, NULL, n, chunk_out);
+        if (values != chunk_out) {
+            memcpy(chunk_out, values, n * sizeof(int));
+        }
+    }
+
+    for (unsigned int s = 0; s < b.slot_count; s++) {
+        free(b.scratch[s]);
+    }
+    for (unsigned int v = 0; v < b.pool.count; v++) {
+        free(b.pool.vectors[v]);
+    }
+    free(b.pool.vectors);
+    free(inputs);
+    free(b.zeros);
+    free(b.scratch);
+    free(b.written);
+    free(b.slots);
+}
@@ -0,0 +1,815 @@
+#include <stdlib.h>
+#include <limits.h>
+#include <assert.h>
+#include <stdbool.h>
+
+#include "out.h"
+
+#include "bytecode.h"
+
+#define DEFAULT_PROGRAM_INITIAL_CAPACITY 64
+#define NO_JUMP (-1)
+
+typedef struct OpCodeInfo {
+    const char* str;
+    bool writes_register;
+    OpCode branch;  // Jump fused with a comparison, OP_HALT for the other op codes
+    OpCode negated; // Comparison with the opposite result
+} OpCodeInfo;
+
+// Lookup Table
+static const OpCodeInfo OpCodeTable[] = {
+    [OP_HALT]         = {"HALT",         false, OP_HALT,  OP_HALT},
+    [OP_LOADK]        = {"LOADK",        true,  OP_HALT,  OP_HALT},
+    [OP_MOV]          = {"MOV",          true,  OP_HALT,  OP_HALT},
+    [OP_ADD]          = {"ADD",          true,  OP_HALT,  OP_HALT},
+    [OP_ADDK]         = {"ADDK",         true,  OP_HALT,  OP_HALT},
+    [OP_SUB]          = {"SUB",          true,  OP_HALT,  OP_HALT},
+    [OP_MUL]          = {"MUL",          true,  OP_HALT,  OP_HALT},
+    [OP_DIV]          = {"DIV",          true,  OP_HALT,  OP_HALT},
+    [OP_MOD]          = {"MOD",          true,  OP_HALT,  OP_HALT},
+    [OP_BITWISE_OR]   = {"BITWISE_OR",   true,  OP_HALT,  OP_HALT},
+    [OP_BITWISE_AND]  = {"BITWISE_AND",  true,  OP_HALT,  OP_HALT},
+    [OP_BITWISE_XOR]  = {"BITWISE_XOR",  true,  OP_HALT,  OP_HALT},
+    [OP_L_SHIFT]      = {"L_SHIFT",      true,  OP_HALT,  OP_HALT},
+    [OP_R_SHIFT]      = {"R_SHIFT",      true,  OP_HALT,  OP_HALT},
+    [OP_NEG]          = {"NEG",          true,  OP_HALT,  OP_HALT},
+    [OP_NOT]          = {"NOT",          true,  OP_HALT,  OP_HALT},
+    [OP_BITWISE_NOT]  = {"BITWISE_NOT",  true,  OP_HALT,  OP_HALT},
+    [OP_ABS]          = {"ABS",          true,  OP_HALT,  OP_HALT},
+    [OP_SET_POSITIVE] = {"SET_POSITIVE", true,  OP_HALT,  OP_HALT},
+    [OP_SET_NEGATIVE] = {"SET_NEGATIVE", true,  OP_HALT,  OP_HALT},
+    [OP_CMP_EQ]       = {"CMP_EQ",       true,  OP_JEQ,   OP_CMP_NEQ},
+    [OP_CMP_NEQ]      = {"CMP_NEQ",      true,  OP_JNEQ,  OP_CMP_EQ},
+    [OP_CMP_LT]       = {"CMP_LT",       true,  OP_JLT,   OP_CMP_GTE},
+    [OP_CMP_LTE]      = {"CMP_LTE",      true,  OP_JLTE,  OP_CMP_GT},
+    [OP_CMP_GT]       = {"CMP_GT",       true,  OP_JGT,   OP_CMP_LTE},
+    [OP_CMP_GTE]      = {"CMP_GTE",      true,  OP_JGTE,  OP_CMP_LT},
+    [OP_CMP_EQK]      = {"CMP_EQK",      true,  OP_JEQK,  OP_CMP_NEQK},
+    [OP_CMP_NEQK]     = {"CMP_NEQK",     true,  OP_JNEQK, OP_CMP_EQK},
+    [OP_CMP_LTK]      = {"CMP_LTK",      true,  OP_JLTK,  OP_CMP_GTEK},
+    [OP_CMP_LTEK]     = {"CMP_LTEK",     true,  OP_JLTEK, OP_CMP_GTK},
+    [OP_CMP_GTK]      = {"CMP_GTK",      true,  OP_JGTK,  OP_CMP_LTEK},
+    [OP_CMP_GTEK]     = {"CMP_GTEK",     true,  OP_JGTEK, OP_CMP_LTK},
+    [OP_JMP]          = {"JMP",          false, OP_HALT,  OP_HALT},
+    [OP_JZ]           = {"JZ",           false, OP_HALT,  OP_HALT},
+    [OP_JNZ]          = {"JNZ",          false, OP_HALT,  OP_HALT},
+    [OP_JEQ]          = {"JEQ",          false, OP_HALT,  OP_HALT},
+    [OP_JNEQ]         = {"JNEQ",         false, OP_HALT,  OP_HALT},
+    [OP_JLT]          = {"JLT",          false, OP_HALT,  OP_HALT},
+    [OP_JLTE]         = {"JLTE",         false, OP_HALT,  OP_HALT},
+    [OP_JGT]          = {"JGT",          false, OP_HALT,  OP_HALT},
+    [OP_JGTE]         = {"JGTE",         false, OP_HALT,  OP_HALT},
+    [OP_JEQK]         = {"JEQK",         false, OP_HALT,  OP_HALT},
+    [OP_JNEQK]        = {"JNEQK",        false, OP_HALT,  OP_HALT},
+    [OP_JLTK]         = {"JLTK",         false, OP_HALT,  OP_HALT},
+    [OP_JLTEK]        = {"JLTEK",        false, OP_HALT,  OP_HALT},
+    [OP_JGTK]         = {"JGTK",         false, OP_HALT,  OP_HALT},
+    [OP_JGTEK]        = {"JGTEK",        false, OP_HALT,  OP_HALT},
+    [OP_PRINT]        = {"PRINT",        false, OP_HALT,  OP_HALT},
+    [OP_PRINT_VAR]    = {"PRINT_VAR",    false, OP_HALT,  OP_HALT},
+    [OP_LOOP]         = {"LOOP",         false, OP_HALT,  OP_HALT},
+};
+
+const char* opCodeToStr(OpCode op) {
+    return op >= OP_CODES_COUNT ? "Unknown" : OpCodeTable[op].str;
+}
+
+bool opCodeWritesRegister(OpCode op) {
+    assert(op < OP_CODES_COUNT);
+    return OpCodeTable[op].writes_register;
+}
+
+// Pending break and continue jumps are chained through their targets until the loop is closed
+typedef struct LoopContext {
+    int break_chain;
+    int continue_chain;
+    struct LoopContext* parent;
+} LoopContext;
+
+typedef struct Compiler {
+    Program* program;
+    unsigned int temp_top;
+    unsigned int barrier;  // Position of the last jump target
+    LoopContext* loop;
+} Compiler;
+
+static unsigned int lowerExpression(Compiler* c, const ASTNode* node);
+static void lowerStatements(Compiler* c, const ASTNode* ast);
+
+static unsigned int emit(Compiler* c, OpCode op, int a, int b, int d) {
+    Program* p = c->program;
+    if (p->size == p->capacity) {
+        p->capacity *= 2;
+        p->code = realloc(p->code, p->capacity * sizeof(Instruction));
+        assert(p->code != NULL);
+    }
+
+    unsigned int pc = p->size++;
+    p->code[pc] = (Instruction){ .op = op, .a = a, .b = b, .c = d };
+    return pc;
+}
+
+static inline unsigned int label(Compiler* c) {
+    c->barrier = c->program->size;
+    return c->program->size;
+}
+
+static inline bool isFusedJump(OpCode op) {
+    return op >= OP_JEQ && op <= OP_JGTEK;
+}
+
+static inline void patchJump(Compiler* c, unsigned int pc, unsigned int target) {
+    Instruction* i = &c->program->code[pc];
+    if (i->op == OP_JMP || isFusedJump(i->op)) {
+        i->a = target;
+    } else {
+        assert(i->op == OP_JZ || i->op == OP_JNZ);
+        i->b = target;
+    }
+}
+
+static inline void patchJumpHere(Compiler* c, unsigned int pc) {
+    patchJump(c, pc, label(c));
+}
+
+static void patchChain(Compiler* c, int chain, unsigned int target) {
+    while (chain != NO_JUMP) {
+        Instruction* i = &c->program->code[chain];
+        assert(i->op == OP_JMP);
+        int next = i->a;
+        i->a = target;
+        chain = next;
+    }
+}
+
+static inline unsigned int newTemp(Compiler* c) {
+    unsigned int reg = c->program->slot_count + c->temp_top++;
+    if (reg >= c->program->register_count) {
+        c->program->register_count = reg + 1;
+    }
+    return reg;
+}
+
+static inline unsigned int releaseTemps(Compiler* c, unsigned int reg) {
+    // Frees every temporary above reg (reg itself is kept if it is a temporary)
+    Program* p = c->program;
+    c->temp_top = reg >= p->slot_count ? reg - p->slot_count + 1 : 0;
+    return reg;
+}
+
+static inline bool isSlot(const Compiler* c, unsigned int reg) {
+    return reg < c->program->slot_count;
+}
+
+static inline unsigned int slotOf(const Symbol* var) {
+    return getVarOffset(var);
+}
+
+// Copy src into dst, writing the result directly into dst when src was just computed
+static unsigned int moveInto(Compiler* c, unsigned int dst, unsigned int src) {
+    if (dst == src) {
+        return dst;
+    }
+
+    Program* p = c->program;
+    if (!isSlot(c, src) && p->size > 0 && c->barrier != p->size) {
+        Instruction* last = &p->code[p->size - 1];
+        if (opCodeWritesRegister(last->op) && last->a == (int)src) {
+            last->a = dst;
+            return dst;
+        }
+    }
+
+    emit(c, OP_MOV, dst, src, 0);
+    return dst;
+}
+
+// A slot read must be copied if the next operand may still write to it
+static unsigned int protect(Compiler* c, unsigned int reg, const ASTNode* next) {
+    if (isSlot(c, reg) && hasSideEffects(next)) {
+        return moveInto(c, newTemp(c), reg);
+    }
+    return reg;
+}
+
+// Emits a jump to target that is taken when cond is non zero (or zero if !when). When cond was just computed by a
+// comparison, the comparison itself becomes the jump.
+static unsigned int emitBranch(Compiler* c, unsigned int cond, bool when, int target) {
+    Program* p = c->program;
+    if (!isSlot(c, cond) && p->size > 0 && c->barrier != p->size) {
+        Instruction* last = &p->code[p->size - 1];
+        if (last->a == (int)cond && OpCodeTable[last->op].branch != OP_HALT) {
+            OpCode cmp = when ? last->op : OpCodeTable[last->op].negated;
+            last->op = OpCodeTable[cmp].branch;
+            last->a = target;
+            return p->size - 1;
+        }
+    }
+
+    return when ? emit(c, OP_JNZ, cond, target, 0) : emit(c, OP_JZ, cond, target, 0);
+}
+
+static inline bool isConstantOperand(const ASTNode* node, int* value) {
+    switch (node->node_type) {
+        case AST_INT:  *value = node->n; return true;
+        case AST_BOOL: *value = node->z; return true;
+        case AST_TYPE: *value = node->t; return true;
+        default:
+            return false;
+    }
+}
+
+static unsigned int loadConstant(Compiler* c, int value) {
+    unsigned int dst = newTemp(c);
+    emit(c, OP_LOADK, dst, value, 0);
+    return dst;
+}
+
+static unsigned int lowerBinaryOP(Compiler* c, OpCode op, const ASTNode* node) {
+    unsigned int mark = c->temp_top;
+
+    unsigned int l = protect(c, lowerExpression(c, node->left), node->right);
+    unsigned int r = lowerExpression(c, node->right);
+
+    c->temp_top = mark;
+    unsigned int dst = newTemp(c);
+    emit(c, op, dst, l, r);
+    return dst;
+}
+
+static unsigned int lowerUnaryOP(Compiler* c, OpCode op, const ASTNode* child) {
+    unsigned int mark = c->temp_top;
+
+    unsigned int v = lowerExpression(c, child);
+
+    c->temp_top = mark;
+    unsigned int dst = newTemp(c);
+    emit(c, op, dst, v, 0);
+    return dst;
+}
+
+// Adding or subtracting a constant takes a single instruction
+static unsigned int lowerAdd(Compiler* c, const ASTNode* node) {
+    OpCode op = node->node_type == AST_ADD || node->node_type == AST_WRAP_ADD ? OP_ADD : OP_SUB;
+
+    int k = 0;
+    const ASTNode* operand = NULL;
+    if (isConstantOperand(node->right, &k) && (op == OP_ADD || k != INT_MIN)) {
+        operand = node->left;
+        k = op == OP_ADD ? k : -k;
+    } else if (op == OP_ADD && isConstantOperand(node->left, &k)) {
+        operand = node->right;
+    } else {
+        return lowerBinaryOP(c, op, node);
+    }
+
+    unsigned int mark = c->temp_top;
+
+    unsigned int v = lowerExpression(c, operand);
+
+    c->temp_top = mark;
+    unsigned int dst = newTemp(c);
+    emit(c, OP_ADDK, dst, v, k);
+    return dst;
+}
+
+static unsigned int lowerLogicalOP(Compiler* c, OpCode jump_op, const ASTNode* node) {
+    unsigned int dst = newTemp(c);
+
+    moveInto(c, dst, lowerExpression(c, node->left));
+    releaseTemps(c, dst);
+    unsigned int short_circuit = emit(c, jump_op, dst, NO_JUMP, 0);
+
+    moveInto(c, dst, lowerExpression(c, node->right));
+    releaseTemps(c, dst);
+    patchJumpHere(c, short_circuit);
+
+    return dst;
+}
+
+static unsigned int lowerAssignment(Compiler* c, const ASTNode* lval, const ASTNode* rval) {
+    switch (lval->node_type) {
+        case AST_ID:
+            return moveInto(c, slotOf(lval->id), lowerExpression(c, rval));
+        case AST_PARENTHESES:
+            return lowerAssignment(c, lval->child, rval);
+        case AST_TERNARY_COND: {
+            // The l-value is resolved before the r-value is evaluated
+            unsigned int dst = newTemp(c);
+
+            unsigned int cond = lowerExpression(c, lval->first);
+            releaseTemps(c, dst);
+            unsigned int jump_else = emitBranch(c, cond, false, NO_JUMP);
+
+            moveInto(c, dst, lowerAssignment(c, lval->second, rval));
+            releaseTemps(c, dst);
+            unsigned int jump_end = emit(c, OP_JMP, NO_JUMP, 0, 0);
+
+            patchJumpHere(c, jump_else);
+            moveInto(c, dst, lowerAssignment(c, lval->third, rval));
+            releaseTemps(c, dst);
+            patchJumpHere(c, jump_end);
+
+            return dst;
+        }
+        default:
+            assert(false);
+            return 0;
+    }
+}
+
+static inline OpCode cmpOpCode(const ASTNodeType node_type) {
+    switch (node_type) {
+        case AST_CMP_EQ:  return OP_CMP_EQ;
+        case AST_CMP_NEQ: return OP_CMP_NEQ;
+        case AST_CMP_LT:  return OP_CMP_LT;
+        case AST_CMP_LTE: return OP_CMP_LTE;
+        case AST_CMP_GT:  return OP_CMP_GT;
+        case AST_CMP_GTE: return OP_CMP_GTE;
+        default:
+            assert(false);
+            return OP_HALT;
+    }
+}
+
+// Chained comparisons short-circuit and reuse the right operand of the previous comparison (the carry)
+static unsigned int lowerCmpExpression(Compiler* c, const ASTNode* node, unsigned int dst, int* false_chain) {
+    unsigned int l;
+    if (isCmpExp(node->left)) {
+        l = lowerCmpExpression(c, node->left, dst, false_chain);
+        *false_chain = emit(c, OP_JZ, dst, *false_chain, 0);
+    } else {
+        l = lowerExpression(c, node->left);
+    }
+
+    l = protect(c, l, node->right);
+    unsigned int r = lowerExpression(c, node->right);
+    emit(c, cmpOpCode(node->node_type), dst, l, r);
+
+    return r;
+}
+
+static inline OpCode cmpConstantOpCode(const ASTNodeType node_type, bool mirrored) {
+    switch (node_type) {
+        case AST_CMP_EQ:  return OP_CMP_EQK;
+        case AST_CMP_NEQ: return OP_CMP_NEQK;
+        case AST_CMP_LT:  return mirrored ? OP_CMP_GTK : OP_CMP_LTK;
+        case AST_CMP_LTE: return mirrored ? OP_CMP_GTEK : OP_CMP_LTEK;
+        case AST_CMP_GT:  return mirrored ? OP_CMP_LTK : OP_CMP_GTK;
+        case AST_CMP_GTE: return mirrored ? OP_CMP_LTEK : OP_CMP_GTEK;
+        default:
+            assert(false);
+            return OP_HALT;
+    }
+}
+
+static unsigned int lowerCmp(Compiler* c, const ASTNode* node) {
+    unsigned int dst = newTemp(c);
+
+    // A single comparison with a constant takes it inline. A constant on the left is moved to the right.
+    int k = 0;
+    if (!isCmpExp(node->left)) {
+        const ASTNode* operand = NULL;
+        bool mirrored = false;
+        if (isConstantOperand(node->right, &k)) {
+            operand = node->left;
+        } else if (isConstantOperand(node->left, &k)) {
+            operand = node->right;
+            mirrored = true;
+        }
+
+        if (operand != NULL) {
+            emit(c, cmpConstantOpCode(node->node_type, mirrored), dst, lowerExpression(c, operand), k);
+            return releaseTemps(c, dst);
+        }
+    }
+
+    int false_chain = NO_JUMP;
+    lowerCmpExpression(c, node, dst, &false_chain);
+
+    unsigned int end = label(c);
+    while (false_chain != NO_JUMP) {
+        int next = c->program->code[false_chain].b;
+        patchJump(c, false_chain, end);
+        false_chain = next;
+    }
+
+    return releaseTemps(c, dst);
+}
+
+static unsigned int lowerTernaryCond(Compiler* c, const ASTNode* node) {
+    unsigned int dst = newTemp(c);
+
+    unsigned int cond = lowerExpression(c, node->first);
+    releaseTemps(c, dst);
+    unsigned int jump_else = emitBranch(c, cond, false, NO_JUMP);
+
+    moveInto(c, dst, lowerExpression(c, node->second));
+    releaseTemps(c, dst);
+    unsigned int jump_end = emit(c, OP_JMP, NO_JUMP, 0, 0);
+
+    patchJumpHere(c, jump_else);
+    moveInto(c, dst, lowerExpression(c, node->third));
+    releaseTemps(c, dst);
+    patchJumpHere(c, jump_end);
+
+    return dst;
+}
+
+static unsigned int lowerUnaryCompoundAssign(Compiler* c, const ASTNode* node) {
+    unsigned int v = lowerExpression(c, node->child);
+    if (node->is_prefix) {
+        return v;
+    }
+
+    // Postfix returns the value before the assignment
+    switch (node->node_type) {
+        case AST_INC:
+        case AST_DEC: {
+            unsigned int dst = newTemp(c);
+            emit(c, OP_ADDK, dst, v, node->node_type == AST_INC ? -1 : 1);
+            return dst;
+        }
+        case AST_LOGICAL_TOGGLE: {
+            unsigned int dst = newTemp(c);
+            emit(c, OP_NOT, dst, v, 0);
+            return dst;
+        }
+        case AST_BITWISE_TOGGLE: {
+            unsigned int dst = newTemp(c);
+            emit(c, node->child->value_type == AST_TYPE_BOOL ? OP_NOT : OP_BITWISE_NOT, dst, v, 0);
+            return dst;
+        }
+        default:
+            assert(false);
+            return 0;
+    }
+}
+
+static unsigned int lowerExpression(Compiler* c, const ASTNode* node) {
+    assert(node != NULL);
+
+    switch (node->node_type) {
+        case AST_INT:
+            return loadConstant(c, node->n);
+        case AST_BOOL:
+            return loadConstant(c, node->z);
+        case AST_TYPE:
+            return loadConstant(c, node->t);
+        case AST_ID:
+            return slotOf(node->id);
+        case AST_ADD:
+        case AST_SUB:         return lowerAdd(c, node);
+        case AST_MUL:         return lowerBinaryOP(c, OP_MUL, node);
+        case AST_DIV:         return lowerBinaryOP(c, OP_DIV, node);
+        case AST_MOD:         return lowerBinaryOP(c, OP_MOD, node);
+        case AST_BITWISE_OR:  return lowerBinaryOP(c, OP_BITWISE_OR, node);
+        case AST_BITWISE_AND: return lowerBinaryOP(c, OP_BITWISE_AND, node);
+        case AST_BITWISE_XOR: return lowerBinaryOP(c, OP_BITWISE_XOR, node);
+        case AST_L_SHIFT:     return lowerBinaryOP(c, OP_L_SHIFT, node);
+        case AST_R_SHIFT:     return lowerBinaryOP(c, OP_R_SHIFT, node);
+        // The arithmetic of the VM wraps around
+        case AST_WRAP_ADD:
+        case AST_WRAP_SUB:    return lowerAdd(c, node);
+        case AST_WRAP_MUL:    return lowerBinaryOP(c, OP_MUL, node);
+        case AST_USUB:        return lowerUnaryOP(c, OP_NEG, node->child);
+        case AST_ABS:          return lowerUnaryOP(c, OP_ABS, node->child);
+        case AST_SET_POSITIVE: return lowerUnaryOP(c, OP_SET_POSITIVE, node->child);
+        case AST_SET_NEGATIVE: return lowerUnaryOP(c, OP_SET_NEGATIVE, node->child);
+        case AST_LOGICAL_NOT:  return lowerUnaryOP(c, OP_NOT, node->child);
+        case AST_BITWISE_NOT: {
+            // The operand type is known statically
+            OpCode op = node->child->value_type == AST_TYPE_BOOL ? OP_NOT : OP_BITWISE_NOT;
+            return lowerUnaryOP(c, op, node->child);
+        }
+        case AST_UADD:
+        case AST_PARENTHESES:
+        case AST_COMPD_ASSIGN:
+            return lowerExpression(c, node->child);
+        case AST_LOGICAL_AND:
+            return lowerLogicalOP(c, OP_JZ, node);
+        case AST_LOGICAL_OR:
+            return lowerLogicalOP(c, OP_JNZ, node);
+        case AST_ID_ASSIGNMENT:
+            return lowerAssignment(c, node->left, node->right);
+        case AST_INC:
+        case AST_DEC:
+        case AST_LOGICAL_TOGGLE:
+        case AST_BITWISE_TOGGLE:
+            return lowerUnaryCompoundAssign(c, node);
+        case AST_TYPE_OF: {
+            unsigned int mark = c->temp_top;
+            lowerExpression(c, node->child);
+            c->temp_top = mark;
+            return loadConstant(c, node->child->value_type);
+        }
+        case AST_CMP_EQ:
+        case AST_CMP_NEQ:
+        case AST_CMP_LT:
+        case AST_CMP_LTE:
+        case AST_CMP_GT:
+        case AST_CMP_GTE:
+            return lowerCmp(c, node);
+        case AST_TERNARY_COND:
+            return lowerTernaryCond(c, node);
+        default:
+            assert(false);
+            return 0;
+    }
+}
+
+// Counts the iterations of the loop in a tiered program, at a point where it can be restarted natively.
+// Returns the index of the loop, or NO_JUMP if the program is not tiered.
+static int emitLoopCounter(Compiler* c, const ASTNode* ast) {
+    Program* p = c->program;
+    if (p->tier_up_threshold == 0) {
+        return NO_JUMP;
+    }
+
+    if (p->loop_count == p->loop_capacity) {
+        p->loop_capacity = 2 * p->loop_capacity + 1;
+        p->loops = realloc(p->loops, p->loop_capacity * sizeof(Loop));
+        assert(p->loops != NULL);
+    }
+    unsigned int index = p->loop_count++;
+    p->loops[index] = (Loop) {
+        .ast = ast,
+        .exit = 0
+    };
+    emit(c, OP_LOOP, index, 0, 0);
+    return index;
+}
+
+static inline void closeLoopCounter(Compiler* c, int index, unsigned int exit) {
+    if (index != NO_JUMP) {
+        c->program->loops[index].exit = exit;
+    }
+}
+
+static void lowerLoopBody(Compiler* c, const ASTNode* body, LoopContext* loop) {
+    loop->break_chain = NO_JUMP;
+    loop->continue_chain = NO_JUMP;
+    loop->parent = c->loop;
+
+    c->loop = loop;
+    lowerStatements(c, body);
+    c->loop = loop->parent;
+}
+
+static void lowerStatements(Compiler* c, const ASTNode* ast) {
+    assert(ast != NULL);
+
+    unsigned int mark = c->temp_top;
+
+    switch (ast->node_type) {
+        case AST_ID_DECLARATION: {
+            assert(ast->child->node_type == AST_ID);
+            break;
+        } case AST_ID_DECL_ASSIGN: {
+            assert(ast->left->node_type == AST_ID);
+            moveInto(c, slotOf(ast->left->id), lowerExpression(c, ast->right));
+            break;
+        } case AST_STATEMENT_SEQ: {
+            for (unsigned int i = 0; i < ast->stmt_count; i++) {
+                lowerStatements(c, ast->stmts[i]);
+            }
+            break;
+        } case AST_PRINT: {
+            unsigned int v = lowerExpression(c, ast->child);
+            emit(c, OP_PRINT, v, ast->child->value_type, 0);
+            break;
+        } case AST_PRINT_VAR: {
+            assert(ast->child->node_type == AST_ID);
+            Program* p = c->program;
+            if (p->symbol_count == p->symbol_capacity) {
+                p->symbol_capacity = 2 * p->symbol_capacity + 1;
+                p->symbols = realloc(p->symbols, p->symbol_capacity * sizeof(Symbol*));
+                assert(p->symbols != NULL);
+            }
+            unsigned int index = p->symbol_count++;
+            p->symbols[index] = ast->child->id;
+            emit(c, OP_PRINT_VAR, slotOf(ast->child->id), index, 0);
+            break;
+        } case AST_SCOPE: {
+            lowerStatements(c, ast->child);
+            break;
+        } case AST_IF: {
+            unsigned int cond = lowerExpression(c, ast->left);
+            c->temp_top = mark;
+            unsigned int jump_end = emitBranch(c, cond, false, NO_JUMP);
+            lowerStatements(c, ast->right);
+            patchJumpHere(c, jump_end);
+            break;
+        } case AST_IF_ELSE: {
+            unsigned int cond = lowerExpression(c, ast->first);
+            c->temp_top = mark;
+            unsigned int jump_else = emitBranch(c, cond, false, NO_JUMP);
+            lowerStatements(c, ast->second);
+            unsigned int jump_end = emit(c, OP_JMP, NO_JUMP, 0, 0);
+            patchJumpHere(c, jump_else);
+            lowerStatements(c, ast->third);
+            patchJumpHere(c, jump_end);
+            break;
+        }
+        case AST_NO_OP: break;
+        case AST_WHILE: {
+            // The condition is placed after the body so each iteration takes a single jump
+            LoopContext loop;
+            unsigned int jump_cond = emit(c, OP_JMP, NO_JUMP, 0, 0);
+            unsigned int body = label(c);
+            lowerLoopBody(c, ast->right, &loop);
+
+            unsigned int cond_pc = label(c);
+            patchJump(c, jump_cond, cond_pc);
+            patchChain(c, loop.continue_chain, cond_pc);
+            int counter = emitLoopCounter(c, ast);
+            emitBranch(c, lowerExpression(c, ast->left), true, body);
+
+            unsigned int end = label(c);
+            patchChain(c, loop.break_chain, end);
+            closeLoopCounter(c, counter, end);
+            break;
+        }
+        case AST_DO_WHILE: {
+            LoopContext loop;
+            unsigned int body = label(c);
+            int counter = emitLoopCounter(c, ast);
+            lowerLoopBody(c, ast->left, &loop);
+
+            patchChain(c, loop.continue_chain, label(c));
+            emitBranch(c, lowerExpression(c, ast->right), true, body);
+
+            unsigned int end = label(c);
+            patchChain(c, loop.break_chain, end);
+            closeLoopCounter(c, counter, end);
+            break;
+        }
+        case AST_FOR: {
+            const ASTNode* init = ast->child->stmts[0];
+            const ASTNode* cond = ast->child->stmts[1]->left;
+            const ASTNode* scope = ast->child->stmts[1]->right;
+            assert(scope->node_type == AST_SCOPE);
+            const ASTNode* update = scope->child->stmts[1];
+            const ASTNode* body = scope->child->stmts[0];
+
+            lowerStatements(c, init);
+
+            LoopContext loop;
+            unsigned int jump_cond = emit(c, OP_JMP, NO_JUMP, 0, 0);
+            unsigned int body_pc = label(c);
+            lowerLoopBody(c, body, &loop);
+
+            patchChain(c, loop.continue_chain, label(c));
+            lowerStatements(c, update);
+
+            unsigned int cond_pc = label(c);
+            patchJump(c, jump_cond, cond_pc);
+            int counter = emitLoopCounter(c, ast);
+            emitBranch(c, lowerExpression(c, cond), true, body_pc);
+
+            unsigned int end = label(c);
+            patchChain(c, loop.break_chain, end);
+            closeLoopCounter(c, counter, end);
+            break;
+        }
+        case AST_BREAK: {
+            assert(c->loop != NULL);
+            c->loop->break_chain = emit(c, OP_JMP, c->loop->break_chain, 0, 0);
+            break;
+        }
+        case AST_CONTINUE: {
+            assert(c->loop != NULL);
+            c->loop->continue_chain = emit(c, OP_JMP, c->loop->continue_chain, 0, 0);
+            break;
+        }
+        case AST_INC:
+        case AST_DEC:
+        case AST_LOGICAL_TOGGLE:
+        case AST_BITWISE_TOGGLE: {
+            // The value of the statement is discarded, only the assignment matters
+            lowerExpression(c, ast->child);
+            break;
+        }
+        default: {
+            if(isExp(ast)) {
+                lowerExpression(c, ast);
+            } else {
+                assert(false);
+            }
+        }
+    }
+
+    c->temp_top = mark;
+}
+
+Program* newProgramFromAST(const ASTNode* ast, const SymbolTable* st) {
+    return newTieredProgramFromAST(ast, st, 0);
+}
+
+Program* newTieredProgramFromAST(const ASTNode* ast, const SymbolTable* st, unsigned int threshold) {
+    assert(ast != NULL && st != NULL);
+
+    Program* p = malloc(sizeof(Program));
+    assert(p != NULL);
+    p->capacity = DEFAULT_PROGRAM_INITIAL_CAPACITY;
+    p->code = malloc(p->capacity * sizeof(Instruction));
+    assert(p->code != NULL);
+    p->size = 0;
+    p->slot_count = getMaxOffset(st) + 1;
+    p->register_count = p->slot_count;
+    p->symbols = NULL;
+    p->symbol_count = 0;
+    p->symbol_capacity = 0;
+    p->targets = NULL;
+    p->st = st;
+    p->loops = NULL;
+    p->loop_count = 0;
+    p->loop_capacity = 0;
+    p->runtime = NULL;
+    p->tier_up_threshold = threshold;
+
+    // A break or continue outside of any loop ends the program
+    LoopContext top_level = {
+        .break_chain = NO_JUMP,
+        .continue_chain = NO_JUMP,
+        .parent = NULL
+    };
+
+    Compiler c = {
+        .program = p,
+        .temp_top = 0,
+        .barrier = 0,
+        .loop = &top_level
+    };
+
+    lowerStatements(&c, ast);
+
+    unsigned int end = label(&c);
+    patchChain(&c, top_level.break_chain, end);
+    patchChain(&c, top_level.continue_chain, end);
+    emit(&c, OP_HALT, 0, 0, 0);
+
+    if (p->loop_count > 0) {
+        p->runtime = malloc(p->loop_count * sizeof(LoopRuntime));
+        assert(p->runtime != NULL);
+        for (unsigned int i = 0; i < p->loop_count; i++) {
+            LoopRuntime* loop = &p->runtime[i];
+            atomic_init(&loop->count, 0);
+            atomic_init(&loop->state, LOOP_COUNTING);
+            pthread_mutex_init(&loop->lock, NULL);
+            loop->library = NULL;
+            loop->function = NULL;
+        }
+    }
+
+    resolveDispatchTargets(p);
+
+    return p;
+}
+
+void deleteProgram(Program** program) {
+    assert(program != NULL && *program != NULL);
+    unloadNativeLoops(*program);
+    for (unsigned int i = 0; (*program)->runtime != NULL && i < (*program)->loop_count; i++) {
+        pthread_mutex_destroy(&(*program)->runtime[i].lock);
+    }
+    free((*program)->runtime);
+    free((*program)->loops);
+    free((*program)->code);
+    free((*program)->symbols);
+    free((*program)->targets);
+    free(*program);
+    *program = NULL;
+}
+
+unsigned int getProgramSize(const Program* program) {
+    assert(program != NULL);
+    return program->size;
+}
+
+unsigned int getProgramRegisterCount(const Program* program) {
+    assert(program != NULL);
+    return program->register_count;
+}
+
+unsigned int getProgramNativeLoopCount(const Program* program) {
+    assert(program != NULL);
+    unsigned int count = 0;
+    for (unsigned int i = 0; i < program->loop_count; i++) {
+        count += atomic_load_explicit(&program->runtime[i].state, memory_order_acquire) == LOOP_NATIVE;
+    }
+    return count;
+}
+
+int printProgram(const Program* program, const IOStream* stream) {
+    assert(program != NULL);
+    assert(stream != NULL);
+
+    int n = IOStreamWritef(stream, "(%u slots, %u registers)\n", program->slot_count, program->register_count);
+    for (unsigned int pc = 0; pc < program->size; pc++) {
+        const Instruction* i = &program->code[pc];
+        n += IOStreamWritef(stream, "%4u: %-12s %d %d %d\n", pc, opCodeToStr(i->op), i->a, i->b, i->c);
+    }
+    return n;
+}
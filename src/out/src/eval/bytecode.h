@@ -0,0 +1,147 @@
+#ifndef _BYTECODE_H_
+#define _BYTECODE_H_
+
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "ast/ast.h"
+
+#include "out.h"
+
+// Register based bytecode.
+// Registers [0, slot_count) are the Frame slots, the remaining ones are temporaries.
+// The K variants take a constant operand inline, and the conditional jumps on a comparison are fused with it.
+// The additions, subtractions and multiplications wrap around, as they also run the AST_WRAP_* nodes.
+typedef enum OpCode {
+    OP_HALT,
+    OP_LOADK,       // a = b
+    OP_MOV,         // a = R[b]
+    OP_ADD,         // a = R[b] + R[c]
+    OP_ADDK,        // a = R[b] + c
+    OP_SUB,
+    OP_MUL,
+    OP_DIV,
+    OP_MOD,
+    OP_BITWISE_OR,
+    OP_BITWISE_AND,
+    OP_BITWISE_XOR,
+    OP_L_SHIFT,
+    OP_R_SHIFT,
+    OP_NEG,         // a = -R[b]
+    OP_NOT,         // a = !R[b]
+    OP_BITWISE_NOT, // a = ~R[b]
+    OP_ABS,
+    OP_SET_POSITIVE,
+    OP_SET_NEGATIVE,
+    OP_CMP_EQ,      // a = R[b] == R[c]
+    OP_CMP_NEQ,
+    OP_CMP_LT,
+    OP_CMP_LTE,
+    OP_CMP_GT,
+    OP_CMP_GTE,
+    OP_CMP_EQK,     // a = R[b] == c
+    OP_CMP_NEQK,
+    OP_CMP_LTK,
+    OP_CMP_LTEK,
+    OP_CMP_GTK,
+    OP_CMP_GTEK,
+    OP_JMP,         // pc = a
+    OP_JZ,          // if (!R[a]) pc = b
+    OP_JNZ,         // if (R[a]) pc = b
+    OP_JEQ,         // if (R[b] == R[c]) pc = a
+    OP_JNEQ,
+    OP_JLT,
+    OP_JLTE,
+    OP_JGT,
+    OP_JGTE,
+    OP_JEQK,        // if (R[b] == c) pc = a
+    OP_JNEQK,
+    OP_JLTK,
+    OP_JLTEK,
+    OP_JGTK,
+    OP_JGTEK,
+    OP_PRINT,       // print R[a] with type b
+    OP_PRINT_VAR,   // print R[a] as symbols[b]
+    OP_LOOP,        // count an iteration of loops[a], which may continue natively (tiered programs only)
+    OP_CODES_COUNT  // Count of op codes
+} OpCode;
+
+typedef struct Instruction {
+    OpCode op;
+    int a;
+    int b;
+    int c;
+} Instruction;
+
+// Compiled loop, which reads and writes its variables in the frame and prints through print
+typedef void (*NativeLoop)(int* frame, int (*print)(const char* fmt, ...));
+
+typedef enum LoopState {
+    LOOP_COUNTING,      // Interpreted until it gets hot
+    LOOP_NATIVE,        // Every entry runs the native code
+    LOOP_INTERPRETED,   // Could not be compiled
+} LoopState;
+
+// Loop of a tiered program, fixed once the program is lowered
+typedef struct Loop {
+    const ASTNode* ast;     // AST_WHILE, AST_DO_WHILE or AST_FOR
+    unsigned int exit;      // First instruction after the loop
+} Loop;
+
+// Tiering state of a loop, shared by every thread that runs the program.
+// The function and the library are written under the lock before the state is set to LOOP_NATIVE with release order.
+typedef struct LoopRuntime {
+    atomic_uint count;      // Back-edge counter, increments lost to a race only delay the compilation
+    _Atomic(LoopState) state;
+    pthread_mutex_t lock;   // Serializes the compilation
+    void* library;          // Shared object with the native code
+    NativeLoop function;
+} LoopRuntime;
+
+typedef struct Program {
+    Instruction* code;
+    unsigned int size;
+    unsigned int capacity;
+    unsigned int slot_count;
+    unsigned int register_count;
+    const Symbol** symbols;
+    unsigned int symbol_count;
+    unsigned int symbol_capacity;
+    const void** targets;  // Handler address of each instruction (threaded dispatch only)
+    const SymbolTable* st;
+    Loop* loops;
+    unsigned int loop_count;
+    unsigned int loop_capacity;
+    LoopRuntime* runtime;  // One per loop, the only part of the program that changes while it runs
+    unsigned int tier_up_threshold;  // 0 if the program is not tiered
+} Program;
+
+const char* opCodeToStr(OpCode op);
+
+bool opCodeWritesRegister(OpCode op);
+
+void resolveDispatchTargets(Program* program);
+
+// Runtime of the print instructions, shared by the VM and the JIT
+void executePrint(int value, ASTType type);
+
+void executePrintVar(const Symbol* var, int value);
+
+static inline bool isLoopHot(LoopRuntime* loop, unsigned int threshold) {
+    LoopState state = atomic_load_explicit(&loop->state, memory_order_acquire);
+    if (state != LOOP_COUNTING) {
+        return state == LOOP_NATIVE;
+    }
+    unsigned int count = atomic_load_explicit(&loop->count, memory_order_relaxed) + 1;
+    atomic_store_explicit(&loop->count, count, memory_order_relaxed);
+    return count >= threshold;
+}
+
+// Compiles loops[index] the first time it is hot and runs it natively. Returns the pc to continue at, which is the
+// exit of the loop if it ran natively or next_pc if it has to stay interpreted. Safe to call from several threads.
+unsigned int tierUpLoop(const Program* program, unsigned int index, int* R, unsigned int next_pc);
+
+void unloadNativeLoops(Program* program);
+
+#endif
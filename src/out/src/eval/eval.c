@@ -8,15 +8,70 @@
 #include "out.h"
 
 #include "frame.h"
+#include "profile_sample.h"
+#include "histogram_count.h"
+
+#if defined(__GNUC__)
+#define ALWAYS_INLINE inline __attribute__((always_inline))
+#else
+#define ALWAYS_INLINE inline
+#endif
+
+typedef EvalStatus (*StatementExecutor)(const ASTNode* ast, const SymbolTable* st, Frame* frame);
+
+static ALWAYS_INLINE int evalExpression(const ASTNode* node, const SymbolTable* st, Frame* frame);
 
 Frame* executeAST(const ASTNode* ast, const SymbolTable* st) {
+    return executeASTWithMode(ast, st, EXEC_MODE_BYTECODE);
+}
+
+Frame* executeASTWithMode(const ASTNode* ast, const SymbolTable* st, ExecMode mode) {
     assert(ast != NULL && st != NULL);
     unsigned int frame_size = getMaxOffset(st) + 1;
     Frame* frame = newFrame(frame_size);
-    executeASTStatements(ast, st, frame);
+    executeASTWithFrame(ast, st, frame, mode);
     return frame;
 }
 
+void executeASTWithFrame(const ASTNode* ast, const SymbolTable* st, Frame* frame, ExecMode mode) {
+    assert(ast != NULL && st != NULL && frame != NULL);
+    assert(getMaxOffset(st) < frame->size);
+
+    switch (mode) {
+        case EXEC_MODE_BYTECODE: {
+            Program* program = newProgramFromAST(ast, st);
+            executeProgram(program, frame);
+            deleteProgram(&program);
+            break;
+        } case EXEC_MODE_JIT: {
+            Program* program = newProgramFromAST(ast, st);
+            JITCode* jit = newJITCodeFromProgram(program);
+            if (jit != NULL) {
+                executeJITCode(jit, frame);
+                deleteJITCode(&jit);
+            } else {
+                executeProgram(program, frame);
+            }
+            deleteProgram(&program);
+            break;
+        } case EXEC_MODE_TIERED: {
+            Program* program = newTieredProgramFromAST(ast, st, DEFAULT_TIER_UP_THRESHOLD);
+            executeProgram(program, frame);
+            deleteProgram(&program);
+            break;
+        } case EXEC_MODE_TREE_WALKER: {
+            executeASTStatements(ast, st, frame);
+            endOutputSink(getOutputSink());
+            break;
+        } case EXEC_MODE_ITERATIVE: {
+            executeASTIterative(ast, st, frame);
+            endOutputSink(getOutputSink());
+            break;
+        } default:
+            assert(false);
+    }
+}
+
 int evalID(const SymbolTable* st, const Symbol* var, const Frame* frame) {
     assert(st != NULL  && var != NULL && frame != NULL);
 
@@ -25,11 +80,12 @@ int evalID(const SymbolTable* st, const Symbol* var, const Frame* frame) {
     return getFrameValue(frame, index);
 }
 
-static Symbol* evalLVal(const ASTNode* lval, const SymbolTable* st, Frame* frame) {
+// Returns the ID node that is assigned
+static const ASTNode* evalLVal(const ASTNode* lval, const SymbolTable* st, Frame* frame) {
     assert(lval != NULL);
 
     if (lval->node_type == AST_ID) {
-        return lval->id;
+        return lval;
     } else if (lval->node_type == AST_TERNARY_COND) {
         bool cond = evalASTExpression(lval->first, st, frame);
         return evalLVal(cond ? lval->second : lval->third, st, frame);
@@ -46,11 +102,10 @@ int evalAssignment(const ASTNode* ast, const SymbolTable* st, Frame* frame) {
     assert(st != NULL);
     assert(frame != NULL);
 
-    Symbol* var = evalLVal(ast->left, st, frame);
+    const ASTNode* var = evalLVal(ast->left, st, frame);
 
     int value = evalASTExpression(ast->right, st, frame);
-    unsigned int index = getVarOffset(var);
-    setFrameValue(frame, index, value);
+    setFrameValue(frame, var->slot, value);
 
     return value;
 }
@@ -86,7 +141,9 @@ bool evalCmpExpression(const ASTNode* ast, const SymbolTable* st, Frame* frame,
 
 
 
-EvalStatus executeASTStatements(const ASTNode* ast, const SymbolTable* st, Frame* frame) {
+// Executes a statement, with its nested statements executed by the given executor. It is inlined in each executor with
+// its own address, so that the recursion is a direct call and the plain executor has no trace of the profiling.
+static ALWAYS_INLINE EvalStatus walkStatement(const ASTNode* ast, const SymbolTable* st, Frame* frame, StatementExecutor execute) {
     assert(ast != NULL && st != NULL);
 
     switch (ast->node_type) {
@@ -98,44 +155,39 @@ EvalStatus executeASTStatements(const ASTNode* ast, const SymbolTable* st, Frame
             assert(ast->left->node_type == AST_ID);
             assert(ast->left->id != NULL);
 
-            Symbol* var = ast->left->id;
             int value = evalASTExpression(ast->right, st, frame);
-            unsigned int index = getVarOffset(var);
-            setFrameValue(frame, index, value);
+            setFrameValue(frame, ast->left->slot, value);
             break;
         } case AST_STATEMENT_SEQ: {
-            EvalStatus s = executeASTStatements(ast->left, st, frame);
-            if (s.status) {
-                return s;
-            }
-            s = executeASTStatements(ast->right, st, frame);
-            if (s.status) {
-                return s;
+            for (unsigned int i = 0; i < ast->stmt_count; i++) {
+                EvalStatus s = execute(ast->stmts[i], st, frame);
+                if (s.status) {
+                    return s;
+                }
             }
             break;
         } case AST_PRINT: {
             const int value = evalASTExpression(ast->child, st, frame);
-            char buffer[TYPE_VALUE_BUFFER_SIZE];
-            ASTTypeValueToStr(ast->child->value_type, value, buffer);
-            printf("%s\n", buffer);
+            OutputSink* sink = getOutputSink();
+            sinkWriteValue(sink, ast->child->value_type, value);
+            sinkEndLine(sink);
             break;
         } case AST_PRINT_VAR: {
             assert(ast->child->node_type == AST_ID);
             const int value = evalASTExpression(ast->child, st, frame);
-            IOStream* s = openIOStreamFromStdout();
-            printVar(ast->child->id, &value, s);
-            IOStreamWritef(s, "\n");
-            IOStreamClose(&s);
+            OutputSink* sink = getOutputSink();
+            sinkWriteVar(sink, ast->child->id, value);
+            sinkEndLine(sink);
             break;
         } case AST_SCOPE: {
-            EvalStatus s = executeASTStatements(ast->child, st, frame);
+            EvalStatus s = execute(ast->child, st, frame);
             if (s.status) {
                 return s;
             }
             break;
         } case AST_IF: {
             if(evalASTExpression(ast->left, st, frame)) {
-                EvalStatus s = executeASTStatements(ast->right, st, frame);
+                EvalStatus s = execute(ast->right, st, frame);
                 if (s.status) {
                     return s;
                 }
@@ -143,12 +195,12 @@ EvalStatus executeASTStatements(const ASTNode* ast, const SymbolTable* st, Frame
             break;
         } case AST_IF_ELSE: {
             if(evalASTExpression(ast->first, st, frame)) {
-                EvalStatus s = executeASTStatements(ast->second, st, frame);
+                EvalStatus s = execute(ast->second, st, frame);
                 if (s.status) {
                     return s;
                 }
             } else {
-                EvalStatus s = executeASTStatements(ast->third, st, frame);
+                EvalStatus s = execute(ast->third, st, frame);
                 if (s.status) {
                     return s;
                 }
@@ -160,7 +212,7 @@ EvalStatus executeASTStatements(const ASTNode* ast, const SymbolTable* st, Frame
             assert(ast->right->node_type == AST_SCOPE);
             EvalStatus s;
             while (evalASTExpression(ast->left, st, frame)) {
-                s = executeASTStatements(ast->right, st, frame);
+                s = execute(ast->right, st, frame);
                 if (s.status) {
                     if (s.node_type == AST_BREAK) {
                         break;
@@ -176,7 +228,7 @@ EvalStatus executeASTStatements(const ASTNode* ast, const SymbolTable* st, Frame
             assert(ast->left->node_type == AST_SCOPE);
             EvalStatus s;
             do {
-                s = executeASTStatements(ast->left, st, frame);
+                s = execute(ast->left, st, frame);
                 if (s.status) {
                     if (s.node_type == AST_BREAK) {
                         break;
@@ -190,17 +242,17 @@ EvalStatus executeASTStatements(const ASTNode* ast, const SymbolTable* st, Frame
         }
         case AST_FOR: {
             //executeASTStatements(ast->child, st, frame);
-            const ASTNode* init = ast->child->left;
-            const ASTNode* cond = ast->child->right->left;
-            const ASTNode* scope = ast->child->right->right;
+            const ASTNode* init = ast->child->stmts[0];
+            const ASTNode* cond = ast->child->stmts[1]->left;
+            const ASTNode* scope = ast->child->stmts[1]->right;
             assert(scope->node_type == AST_SCOPE);
-            const ASTNode* update = scope->child->right;
-            const ASTNode* body = scope->child->left;
+            const ASTNode* update = scope->child->stmts[1];
+            const ASTNode* body = scope->child->stmts[0];
 
             EvalStatus s;
-            executeASTStatements(init, st, frame);
+            execute(init, st, frame);
             while(evalASTExpression(cond, st, frame)) {
-                s = executeASTStatements(body, st, frame);
+                s = execute(body, st, frame);
                 if (s.status) {
                     if (s.node_type == AST_BREAK) {
                         break;
@@ -209,7 +261,7 @@ EvalStatus executeASTStatements(const ASTNode* ast, const SymbolTable* st, Frame
                         assert(false);
                     }
                 }
-                executeASTStatements(update, st, frame);
+                execute(update, st, frame);
             }
             break;
         }
@@ -227,7 +279,8 @@ EvalStatus executeASTStatements(const ASTNode* ast, const SymbolTable* st, Frame
         }
         default: {
             if(isExp(ast)) {
-                evalASTExpression(ast, st, frame);
+                // Already counted by the executor as a statement
+                evalExpression(ast, st, frame);
             } else {
                 assert(false);
             }
@@ -240,7 +293,41 @@ EvalStatus executeASTStatements(const ASTNode* ast, const SymbolTable* st, Frame
     };
 }
 
-int evalASTExpression(const ASTNode* node, const SymbolTable* st, Frame* frame) {
+EvalStatus executeASTStatements(const ASTNode* ast, const SymbolTable* st, Frame* frame) {
+    HISTOGRAM_ENTER(ast);
+    EvalStatus s = walkStatement(ast, st, frame, &executeASTStatements);
+    HISTOGRAM_LEAVE();
+    return s;
+}
+
+static _Thread_local Profile* current_profile = NULL;
+
+static EvalStatus executeProfiledStatement(const ASTNode* ast, const SymbolTable* st, Frame* frame) {
+    HISTOGRAM_ENTER(ast);
+    EvalStatus s;
+    // The sequences only group the statements
+    if (ast->node_type == AST_STATEMENT_SEQ) {
+        s = walkStatement(ast, st, frame, &executeProfiledStatement);
+    } else {
+        ProfileSample sample;
+        startProfileSample(current_profile, &sample);
+        s = walkStatement(ast, st, frame, &executeProfiledStatement);
+        stopProfileSample(current_profile, &sample, ast);
+    }
+    HISTOGRAM_LEAVE();
+    return s;
+}
+
+EvalStatus executeASTStatementsProfiled(const ASTNode* ast, const SymbolTable* st, Frame* frame, Profile* profile) {
+    assert(profile != NULL);
+    Profile* previous = current_profile;
+    current_profile = profile;
+    EvalStatus s = executeProfiledStatement(ast, st, frame);
+    current_profile = previous;
+    return s;
+}
+
+static ALWAYS_INLINE int evalExpression(const ASTNode* node, const SymbolTable* st, Frame* frame) {
     assert(node != NULL);
 
     switch (node->node_type) {
@@ -272,12 +359,18 @@ int evalASTExpression(const ASTNode* node, const SymbolTable* st, Frame* frame)
             return evalASTExpression(node->left, st, frame) ^ evalASTExpression(node->right, st, frame);
         case AST_BITWISE_NOT: {
             int result = evalASTExpression(node->child, st, frame);
-            return node->child->value_type == AST_TYPE_BOOL ? !result : ~ result;
+            return node->value_type == AST_TYPE_BOOL ? !result : ~ result;
         }
         case AST_L_SHIFT:
             return evalASTExpression(node->left, st, frame) << evalASTExpression(node->right, st, frame);
         case AST_R_SHIFT:
             return evalASTExpression(node->left, st, frame) >> evalASTExpression(node->right, st, frame);
+        case AST_WRAP_ADD:
+            return WRAP_INT_OP(evalASTExpression(node->left, st, frame), +, evalASTExpression(node->right, st, frame));
+        case AST_WRAP_SUB:
+            return WRAP_INT_OP(evalASTExpression(node->left, st, frame), -, evalASTExpression(node->right, st, frame));
+        case AST_WRAP_MUL:
+            return WRAP_INT_OP(evalASTExpression(node->left, st, frame), *, evalASTExpression(node->right, st, frame));
         case AST_ABS: {
             int v = evalASTExpression(node->child, st, frame);
             return v >= 0 ? v : - v;
@@ -288,8 +381,7 @@ int evalASTExpression(const ASTNode* node, const SymbolTable* st, Frame* frame)
             int v = evalASTExpression(node->child, st, frame);
             return (1 - (v < 0))*(~(v)+1) + (v < 0)*v;
         } case AST_ID: {
-            Symbol* var = node->id;
-            return evalID(st, var, frame);
+            return getFrameValue(frame, node->slot);
         } case AST_LOGICAL_NOT: {
             return !evalASTExpression(node->child, st, frame);
         } case AST_LOGICAL_AND: {
@@ -317,7 +409,7 @@ int evalASTExpression(const ASTNode* node, const SymbolTable* st, Frame* frame)
             return node->is_prefix ? z : !z;
         } case AST_BITWISE_TOGGLE: {
             int n = evalASTExpression(node->child, st, frame);
-            return node->is_prefix ? n : (node->child->value_type == AST_TYPE_BOOL ? !n : ~ n);
+            return node->is_prefix ? n : (node->value_type == AST_TYPE_BOOL ? !n : ~ n);
         } case AST_COMPD_ASSIGN: {
             return evalASTExpression(node->child, st, frame);
         } case AST_TYPE_OF: {
@@ -339,4 +431,11 @@ int evalASTExpression(const ASTNode* node, const SymbolTable* st, Frame* frame)
         } default:
             assert(false);
     }
-}
\ No newline at end of file
+}
+
+int evalASTExpression(const ASTNode* node, const SymbolTable* st, Frame* frame) {
+    HISTOGRAM_ENTER(node);
+    int value = evalExpression(node, st, frame);
+    HISTOGRAM_LEAVE();
+    return value;
+}
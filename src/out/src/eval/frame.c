@@ -1,4 +1,7 @@
 #include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "ast/ast.h"
 
@@ -17,41 +20,71 @@ int printVar(const Symbol* var, const int* value, IOStream* stream) {
     return IOStreamWritef(stream, "%s %s = %s", ASTTypeToStr(getVarType(var)), getVarId(var), buffer);
 }
 
+#define DUMP_BUFFER_SIZE 4096
+
+typedef struct DumpBuffer {
+    char data[DUMP_BUFFER_SIZE];
+    unsigned int size;
+    IOStream* stream;
+    int n_bytes;
+} DumpBuffer;
+
+static inline void flushDumpBuffer(DumpBuffer* b) {
+    if (b->size > 0) {
+        b->n_bytes += IOStreamWrite(b->stream, b->data, b->size);
+        b->size = 0;
+    }
+}
+
+static void dumpVar(DumpBuffer* b, const Symbol* var, int value, const char* separator) {
+    char buffer[TYPE_VALUE_BUFFER_SIZE];
+    ASTTypeValueToStr(getVarType(var), value, buffer);
+
+    const char* fmt = "%s %s = %s%s";
+    const char* type = ASTTypeToStr(getVarType(var));
+    int len = snprintf(b->data + b->size, DUMP_BUFFER_SIZE - b->size, fmt, type, getVarId(var), buffer, separator);
+    assert(len >= 0 && len < DUMP_BUFFER_SIZE);
+    if ((unsigned int) len >= DUMP_BUFFER_SIZE - b->size) {
+        flushDumpBuffer(b);
+        len = snprintf(b->data, DUMP_BUFFER_SIZE, fmt, type, getVarId(var), buffer, separator);
+    }
+    b->size += len;
+}
+
 int printSymbolTable(const SymbolTable* st, const Frame* frame, IOStream* stream) {
+    assert(st != NULL);
+    unsigned int var_count = getTotalSymbolAmount(st) > 0 ? getMaxOffset(st) + 1 : 0;
+    return printSymbolTableSlots(st, frame, 0, var_count, stream);
+}
+
+// Writes the state in a single pass over the frame, in chunks instead of once per variable
+int printSymbolTableSlots(const SymbolTable* st, const Frame* frame, unsigned int first_offset, unsigned int end_offset, IOStream* stream) {
     assert(st != NULL);
     assert(frame != NULL);
     assert(stream != NULL);
+    assert(first_offset <= end_offset && end_offset <= frame->size);
 
-    unsigned int var_count = getMaxOffset(st) + 1;
-
-    int n_bytes = IOStreamWritef(stream, " (%d vars) [", var_count);
-    if(var_count > 0) {
-        Symbol* var = NULL;
-        unsigned int i = 0;
-        for(; i < var_count - 1; i++) {
-            var = lookupLastVarWithOffset(st, i);
-            assert(var != NULL);
-            if(frame != NULL) {
-                int value = getFrameValue(frame, i);
-                n_bytes += printVar(var, &value, stream);
-            } else {
-                n_bytes += printVar(var, NULL, stream);
-            }
-            n_bytes += IOStreamWritef(stream, ", ");
-        }
-        if(var_count > 0) {
-            var = lookupLastVarWithOffset(st, i);
-            assert(var != NULL);
-            if(frame != NULL) {
-                int value = getFrameValue(frame, i);
-                n_bytes += printVar(var, &value, stream);
-            } else {
-                n_bytes += printVar(var, NULL, stream);
-            }
+    // The temporaries of the optimizer are not part of the state
+    unsigned int var_count = 0;
+    for (unsigned int i = first_offset; i < end_offset; i++) {
+        const Symbol* var = lookupLastVarWithOffset(st, i);
+        assert(var != NULL);
+        var_count += !isTempVar(var);
+    }
+
+    DumpBuffer b = { .size = 0, .stream = stream, .n_bytes = 0 };
+    b.n_bytes += IOStreamWritef(stream, " (%d vars) [", var_count);
+    unsigned int dumped = 0;
+    for (unsigned int i = first_offset; i < end_offset; i++) {
+        const Symbol* var = lookupLastVarWithOffset(st, i);
+        if (!isTempVar(var)) {
+            dumped++;
+            dumpVar(&b, var, getFrameValue(frame, i), dumped < var_count ? ", " : "");
         }
     }
-    n_bytes += IOStreamWritef(stream, "]\n");
-    return n_bytes;
+    flushDumpBuffer(&b);
+    b.n_bytes += IOStreamWritef(stream, "]\n");
+    return b.n_bytes;
 }
 
 Frame* newFrame(unsigned int size) {
@@ -60,6 +93,19 @@ Frame* newFrame(unsigned int size) {
     return f;
 }
 
+Frame* resizeFrame(Frame* frame, unsigned int size) {
+    assert(frame != NULL);
+    if (size <= frame->size) {
+        return frame;
+    }
+
+    Frame* f = (Frame*) realloc(frame, sizeof(Frame) + size * sizeof(int));
+    assert(f != NULL);
+    memset(f->values + f->size, 0, (size - f->size) * sizeof(int));
+    f->size = size;
+    return f;
+}
+
 void deleteFrame(Frame** frame) {
     assert(frame != NULL && *frame != NULL);
     free(*frame);
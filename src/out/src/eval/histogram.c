@@ -0,0 +1,44 @@
+#include <string.h>
+#include <assert.h>
+
+#include "histogram_count.h"
+
+_Thread_local EvalHistogram eval_histogram;
+_Thread_local ASTNodeType eval_histogram_parent = AST_NODE_TYPES_COUNT;
+
+bool isEvalHistogramEnabled() {
+#ifdef OUT_HISTOGRAM
+    return true;
+#else
+    return false;
+#endif
+}
+
+const EvalHistogram* getEvalHistogram() {
+    return &eval_histogram;
+}
+
+void resetEvalHistogram() {
+    memset(&eval_histogram, 0, sizeof(EvalHistogram));
+    eval_histogram_parent = AST_NODE_TYPES_COUNT;
+}
+
+int dumpEvalHistogram(const IOStream* stream) {
+    assert(stream != NULL);
+
+    int n = IOStreamWritef(stream, "%s\n", HISTOGRAM_CSV_HEADER);
+    for (ASTNodeType t = 0; t < AST_NODE_TYPES_COUNT; t++) {
+        if (eval_histogram.nodes[t] > 0) {
+            n += IOStreamWritef(stream, "node,,%s,%lu\n", nodeTypeToStr(t), eval_histogram.nodes[t]);
+        }
+    }
+    for (ASTNodeType parent = 0; parent <= AST_NODE_TYPES_COUNT; parent++) {
+        for (ASTNodeType child = 0; child < AST_NODE_TYPES_COUNT; child++) {
+            if (eval_histogram.pairs[parent][child] > 0) {
+                const char* parent_str = parent < AST_NODE_TYPES_COUNT ? nodeTypeToStr(parent) : "";
+                n += IOStreamWritef(stream, "pair,%s,%s,%lu\n", parent_str, nodeTypeToStr(child), eval_histogram.pairs[parent][child]);
+            }
+        }
+    }
+    return n;
+}
@@ -0,0 +1,27 @@
+#ifndef _HISTOGRAM_COUNT_H_
+#define _HISTOGRAM_COUNT_H_
+
+#include "histogram.h"
+
+#ifdef OUT_HISTOGRAM
+
+extern _Thread_local EvalHistogram eval_histogram;
+extern _Thread_local ASTNodeType eval_histogram_parent;
+
+// Counts the node and its pair with the node being evaluated, which it replaces until HISTOGRAM_LEAVE
+#define HISTOGRAM_ENTER(node) \
+    const ASTNodeType _histogram_parent = eval_histogram_parent; \
+    eval_histogram.nodes[(node)->node_type]++; \
+    eval_histogram.pairs[_histogram_parent][(node)->node_type]++; \
+    eval_histogram_parent = (node)->node_type
+
+#define HISTOGRAM_LEAVE() eval_histogram_parent = _histogram_parent
+
+#else
+
+#define HISTOGRAM_ENTER(node) ((void) 0)
+#define HISTOGRAM_LEAVE() ((void) 0)
+
+#endif
+
+#endif
@@ -0,0 +1,502 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#include "out.h"
+
+#include "frame.h"
+
+// Tree walker that keeps the continuations of the nodes being evaluated and their operands in stacks on the heap, so
+// that the depth of the AST is only limited by the memory. A continuation is a node with the step that it resumes at.
+// The loops record their position in the stack, so that break and continue cut the stack down to the loop and resume
+// it at its exit or at its next iteration, instead of returning through every enclosing statement.
+
+#define INITIAL_STACK_CAPACITY 64
+#define NO_LOOP ((unsigned int) -1)
+
+// What an expression leaves on the operand stack once evaluated
+typedef enum ResultMode {
+    RESULT_VALUE,       // Its value
+    RESULT_DISCARD,     // Nothing, as it is a statement
+    RESULT_CHAIN,       // Its value and its right operand, as it is the left operand of a chained comparison
+} ResultMode;
+
+// Steps of the loops
+enum {
+    LOOP_ENTER,
+    LOOP_COND,
+    LOOP_TEST,
+    LOOP_UPDATE,
+    LOOP_EXIT,
+};
+
+typedef struct Continuation {
+    const ASTNode* node;
+    const ASTNode* lval;    // Assignments, the part of the lvalue being resolved
+    unsigned int step;
+    unsigned int extra;     // Expressions, the ResultMode. Loops, the position of the enclosing loop.
+} Continuation;
+
+typedef struct EvalStack {
+    Continuation* conts;
+    unsigned int conts_size;
+    unsigned int conts_capacity;
+    int* operands;
+    unsigned int operands_size;
+    unsigned int operands_capacity;
+    unsigned int loop;      // Position of the innermost loop being executed
+} EvalStack;
+
+static void initEvalStack(EvalStack* s) {
+    s->conts_capacity = INITIAL_STACK_CAPACITY;
+    s->conts = malloc(s->conts_capacity * sizeof(Continuation));
+    assert(s->conts != NULL);
+    s->conts_size = 0;
+    s->operands_capacity = INITIAL_STACK_CAPACITY;
+    s->operands = malloc(s->operands_capacity * sizeof(int));
+    assert(s->operands != NULL);
+    s->operands_size = 0;
+    s->loop = NO_LOOP;
+}
+
+static void freeEvalStack(EvalStack* s) {
+    free(s->conts);
+    free(s->operands);
+}
+
+static inline void pushOperand(EvalStack* s, int value) {
+    if (s->operands_size == s->operands_capacity) {
+        s->operands_capacity *= 2;
+        s->operands = realloc(s->operands, s->operands_capacity * sizeof(int));
+        assert(s->operands != NULL);
+    }
+    s->operands[s->operands_size++] = value;
+}
+
+static inline int popOperand(EvalStack* s) {
+    assert(s->operands_size > 0);
+    return s->operands[--s->operands_size];
+}
+
+static inline void pushContinuation(EvalStack* s, const ASTNode* node, unsigned int extra) {
+    if (s->conts_size == s->conts_capacity) {
+        s->conts_capacity *= 2;
+        s->conts = realloc(s->conts, s->conts_capacity * sizeof(Continuation));
+        assert(s->conts != NULL);
+    }
+    s->conts[s->conts_size++] = (Continuation) { .node = node, .lval = NULL, .step = 0, .extra = extra };
+}
+
+// The leaves are evaluated right away
+static inline void pushExpression(EvalStack* s, const Frame* frame, const ASTNode* node, ResultMode mode) {
+    if (mode == RESULT_VALUE) {
+        switch (node->node_type) {
+            case AST_INT:  pushOperand(s, node->n); return;
+            case AST_BOOL: pushOperand(s, node->z); return;
+            case AST_TYPE: pushOperand(s, node->t); return;
+            case AST_ID:   pushOperand(s, getFrameValue(frame, node->slot)); return;
+            default: break;
+        }
+    }
+    pushContinuation(s, node, mode);
+}
+
+// Pops the continuation of the expression and leaves its value as its mode requires
+static inline void completeExpression(EvalStack* s, int value) {
+    const Continuation* c = &s->conts[--s->conts_size];
+    assert(c->extra != RESULT_CHAIN);
+    if (c->extra == RESULT_VALUE) {
+        pushOperand(s, value);
+    }
+}
+
+// Replaces the continuation on the top of the stack by the one of the node, which is its tail
+static inline void replaceContinuation(EvalStack* s, const ASTNode* node) {
+    Continuation* c = &s->conts[s->conts_size - 1];
+    c->node = node;
+    c->step = 0;
+}
+
+static inline int applyUnaryOP(const ASTNode* node, int v) {
+    switch (node->node_type) {
+        case AST_USUB:           return - v;
+        case AST_UADD:           return + v;
+        case AST_BITWISE_NOT:    return node->child->value_type == AST_TYPE_BOOL ? !v : ~ v;
+        case AST_ABS:            return v >= 0 ? v : - v;
+        case AST_SET_POSITIVE:   return (v < 0)*(~(v)+1) + (1 - (v < 0))*v;
+        case AST_SET_NEGATIVE:   return (1 - (v < 0))*(~(v)+1) + (v < 0)*v;
+        case AST_LOGICAL_NOT:    return !v;
+        case AST_INC:            return node->is_prefix ? v : v - 1;
+        case AST_DEC:            return node->is_prefix ? v : v + 1;
+        case AST_LOGICAL_TOGGLE: return node->is_prefix ? (bool) v : !(bool) v;
+        case AST_BITWISE_TOGGLE: return node->is_prefix ? v : (node->child->value_type == AST_TYPE_BOOL ? !v : ~ v);
+        case AST_TYPE_OF:        return node->child->value_type;
+        case AST_COMPD_ASSIGN:
+        case AST_PARENTHESES:    return v;
+        default:
+            assert(false);
+            return 0;
+    }
+}
+
+static inline int applyBinaryOP(ASTNodeType node_type, int l, int r) {
+    switch (node_type) {
+        case AST_ADD:         return l + r;
+        case AST_SUB:         return l - r;
+        case AST_MUL:         return l * r;
+        case AST_DIV:         return l / r;
+        case AST_MOD:         return l % r;
+        case AST_BITWISE_OR:  return l | r;
+        case AST_BITWISE_AND: return l & r;
+        case AST_BITWISE_XOR: return l ^ r;
+        case AST_L_SHIFT:     return l << r;
+        case AST_R_SHIFT:     return l >> r;
+        case AST_WRAP_ADD:    return WRAP_INT_OP(l, +, r);
+        case AST_WRAP_SUB:    return WRAP_INT_OP(l, -, r);
+        case AST_WRAP_MUL:    return WRAP_INT_OP(l, *, r);
+        case AST_CMP_EQ:      return l == r;
+        case AST_CMP_NEQ:     return l != r;
+        case AST_CMP_LT:      return l <  r;
+        case AST_CMP_LTE:     return l <= r;
+        case AST_CMP_GT:      return l >  r;
+        case AST_CMP_GTE:     return l >= r;
+        default:
+            assert(false);
+            return 0;
+    }
+}
+
+// Cuts the stack down to the innermost loop and resumes it at the step
+static inline EvalStatus jumpToLoop(EvalStack* s, unsigned int step, ASTNodeType node_type) {
+    if (s->loop == NO_LOOP) {
+        return (EvalStatus) { .status = true, .node_type = node_type };
+    }
+    s->conts_size = s->loop + 1;
+    s->conts[s->loop].step = step;
+    return (EvalStatus) { .status = false, .node_type = AST_NODE_TYPES_COUNT };
+}
+
+// Runs the continuations above the base of the stack, which holds the ones of the caller
+static EvalStatus run(EvalStack* s, Frame* frame, unsigned int base) {
+    while (s->conts_size > base) {
+        Continuation* c = &s->conts[s->conts_size - 1];
+        const ASTNode* node = c->node;
+
+        switch (node->node_type) {
+            case AST_INT:  completeExpression(s, node->n); break;
+            case AST_BOOL: completeExpression(s, node->z); break;
+            case AST_TYPE: completeExpression(s, node->t); break;
+            case AST_ID:   completeExpression(s, getFrameValue(frame, node->slot)); break;
+            case AST_USUB:
+            case AST_UADD:
+            case AST_BITWISE_NOT:
+            case AST_ABS:
+            case AST_SET_POSITIVE:
+            case AST_SET_NEGATIVE:
+            case AST_LOGICAL_NOT:
+            case AST_INC:
+            case AST_DEC:
+            case AST_LOGICAL_TOGGLE:
+            case AST_BITWISE_TOGGLE:
+            case AST_TYPE_OF:
+            case AST_COMPD_ASSIGN:
+            case AST_PARENTHESES: {
+                if (c->step++ == 0) {
+                    pushExpression(s, frame, node->child, RESULT_VALUE);
+                } else {
+                    completeExpression(s, applyUnaryOP(node, popOperand(s)));
+                }
+                break;
+            }
+            case AST_ADD:
+            case AST_SUB:
+            case AST_MUL:
+            case AST_DIV:
+            case AST_MOD:
+            case AST_BITWISE_OR:
+            case AST_BITWISE_AND:
+            case AST_BITWISE_XOR:
+            case AST_L_SHIFT:
+            case AST_R_SHIFT:
+            case AST_WRAP_ADD:
+            case AST_WRAP_SUB:
+            case AST_WRAP_MUL: {
+                if (c->step == 0) {
+                    c->step = 1;
+                    pushExpression(s, frame, node->left, RESULT_VALUE);
+                } else if (c->step == 1) {
+                    c->step = 2;
+                    pushExpression(s, frame, node->right, RESULT_VALUE);
+                } else {
+                    int r = popOperand(s);
+                    int l = popOperand(s);
+                    completeExpression(s, applyBinaryOP(node->node_type, l, r));
+                }
+                break;
+            }
+            case AST_CMP_EQ:
+            case AST_CMP_NEQ:
+            case AST_CMP_LT:
+            case AST_CMP_LTE:
+            case AST_CMP_GT:
+            case AST_CMP_GTE: {
+                // A chained comparison is false as soon as one of its comparisons is, and otherwise compares the right
+                // operand of the previous one
+                if (c->step == 0) {
+                    c->step = 1;
+                    pushExpression(s, frame, node->left, isCmpExp(node->left) ? RESULT_CHAIN : RESULT_VALUE);
+                } else if (c->step == 1) {
+                    if (isCmpExp(node->left)) {
+                        int l = popOperand(s);
+                        if (!popOperand(s)) {
+                            s->conts_size--;
+                            if (c->extra == RESULT_CHAIN) {
+                                pushOperand(s, false);
+                                pushOperand(s, 0);
+                            } else if (c->extra == RESULT_VALUE) {
+                                pushOperand(s, false);
+                            }
+                            break;
+                        }
+                        pushOperand(s, l);
+                    }
+                    c->step = 2;
+                    pushExpression(s, frame, node->right, RESULT_VALUE);
+                } else {
+                    int r = popOperand(s);
+                    int l = popOperand(s);
+                    bool result = applyBinaryOP(node->node_type, l, r);
+                    if (c->extra == RESULT_CHAIN) {
+                        s->conts_size--;
+                        pushOperand(s, result);
+                        pushOperand(s, r);
+                    } else {
+                        completeExpression(s, result);
+                    }
+                }
+                break;
+            }
+            case AST_LOGICAL_AND:
+            case AST_LOGICAL_OR: {
+                if (c->step == 0) {
+                    c->step = 1;
+                    pushExpression(s, frame, node->left, RESULT_VALUE);
+                } else if (c->step == 1) {
+                    bool l = popOperand(s);
+                    if (l == (node->node_type == AST_LOGICAL_OR)) {
+                        completeExpression(s, l);
+                    } else {
+                        c->step = 2;
+                        pushExpression(s, frame, node->right, RESULT_VALUE);
+                    }
+                } else {
+                    completeExpression(s, popOperand(s));
+                }
+                break;
+            }
+            case AST_TERNARY_COND: {
+                if (c->step == 0) {
+                    c->step = 1;
+                    pushExpression(s, frame, node->first, RESULT_VALUE);
+                } else if (c->step == 1) {
+                    c->step = 2;
+                    pushExpression(s, frame, popOperand(s) ? node->second : node->third, RESULT_VALUE);
+                } else {
+                    completeExpression(s, popOperand(s));
+                }
+                break;
+            }
+            case AST_ID_ASSIGNMENT: {
+                // The lvalue is resolved first, evaluating the conditions of its ternaries, and then the value
+                if (c->step == 0) {
+                    c->lval = node->left;
+                    c->step = 1;
+                } else if (c->step == 1) {
+                    const ASTNode* lval = c->lval;
+                    while (lval->node_type == AST_PARENTHESES) {
+                        lval = lval->child;
+                    }
+                    c->lval = lval;
+                    if (lval->node_type == AST_TERNARY_COND) {
+                        c->step = 2;
+                        pushExpression(s, frame, lval->first, RESULT_VALUE);
+                    } else {
+                        assert(lval->node_type == AST_ID);
+                        c->step = 3;
+                        pushExpression(s, frame, node->right, RESULT_VALUE);
+                    }
+                } else if (c->step == 2) {
+                    c->lval = popOperand(s) ? c->lval->second : c->lval->third;
+                    c->step = 1;
+                } else {
+                    int value = popOperand(s);
+                    setFrameValue(frame, c->lval->slot, value);
+                    completeExpression(s, value);
+                }
+                break;
+            }
+            case AST_ID_DECLARATION:
+            case AST_NO_OP: {
+                s->conts_size--;
+                break;
+            }
+            case AST_ID_DECL_ASSIGN: {
+                if (c->step++ == 0) {
+                    pushExpression(s, frame, node->right, RESULT_VALUE);
+                } else {
+                    setFrameValue(frame, node->left->slot, popOperand(s));
+                    s->conts_size--;
+                }
+                break;
+            }
+            case AST_PRINT:
+            case AST_PRINT_VAR: {
+                if (c->step++ == 0) {
+                    pushExpression(s, frame, node->child, RESULT_VALUE);
+                } else {
+                    const int value = popOperand(s);
+                    OutputSink* sink = getOutputSink();
+                    if (node->node_type == AST_PRINT) {
+                        sinkWriteValue(sink, node->child->value_type, value);
+                    } else {
+                        sinkWriteVar(sink, node->child->id, value);
+                    }
+                    sinkEndLine(sink);
+                    s->conts_size--;
+                }
+                break;
+            }
+            case AST_STATEMENT_SEQ: {
+                unsigned int i = c->step++;
+                if (i + 1 < node->stmt_count) {
+                    pushContinuation(s, node->stmts[i], RESULT_DISCARD);
+                } else if (i + 1 == node->stmt_count) {
+                    replaceContinuation(s, node->stmts[i]);
+                    c->extra = RESULT_DISCARD;
+                } else {
+                    s->conts_size--;
+                }
+                break;
+            }
+            case AST_SCOPE: {
+                replaceContinuation(s, node->child);
+                break;
+            }
+            case AST_IF: {
+                if (c->step++ == 0) {
+                    pushExpression(s, frame, node->left, RESULT_VALUE);
+                } else if (popOperand(s)) {
+                    replaceContinuation(s, node->right);
+                } else {
+                    s->conts_size--;
+                }
+                break;
+            }
+            case AST_IF_ELSE: {
+                if (c->step++ == 0) {
+                    pushExpression(s, frame, node->first, RESULT_VALUE);
+                } else {
+                    replaceContinuation(s, popOperand(s) ? node->second : node->third);
+                }
+                break;
+            }
+            case AST_WHILE:
+            case AST_DO_WHILE:
+            case AST_FOR: {
+                // FOR(SEQ[init, WHILE(cond, SCOPE(SEQ[body, update]))])
+                const ASTNode* cond = node->node_type == AST_WHILE ? node->left : (node->node_type == AST_DO_WHILE ? node->right : node->child->stmts[1]->left);
+                const ASTNode* body = node->node_type == AST_WHILE ? node->right : (node->node_type == AST_DO_WHILE ? node->left : node->child->stmts[1]->right->child->stmts[0]);
+
+                switch (c->step) {
+                    case LOOP_ENTER: {
+                        c->extra = s->loop;
+                        s->loop = s->conts_size - 1;
+                        if (node->node_type == AST_DO_WHILE) {
+                            c->step = LOOP_COND;
+                            pushContinuation(s, body, RESULT_DISCARD);
+                        } else if (node->node_type == AST_FOR) {
+                            c->step = LOOP_COND;
+                            pushContinuation(s, node->child->stmts[0], RESULT_DISCARD);
+                        } else {
+                            c->step = LOOP_COND;
+                        }
+                        break;
+                    } case LOOP_COND: {
+                        c->step = LOOP_TEST;
+                        pushExpression(s, frame, cond, RESULT_VALUE);
+                        break;
+                    } case LOOP_TEST: {
+                        if (popOperand(s)) {
+                            c->step = node->node_type == AST_FOR ? LOOP_UPDATE : LOOP_COND;
+                            pushContinuation(s, body, RESULT_DISCARD);
+                        } else {
+                            c->step = LOOP_EXIT;
+                        }
+                        break;
+                    } case LOOP_UPDATE: {
+                        c->step = LOOP_COND;
+                        pushContinuation(s, node->child->stmts[1]->right->child->stmts[1], RESULT_DISCARD);
+                        break;
+                    } case LOOP_EXIT: {
+                        s->loop = c->extra;
+                        s->conts_size--;
+                        break;
+                    } default:
+                        assert(false);
+                }
+                break;
+            }
+            case AST_BREAK: {
+                EvalStatus status = jumpToLoop(s, LOOP_EXIT, AST_BREAK);
+                if (status.status) {
+                    return status;
+                }
+                break;
+            }
+            case AST_CONTINUE: {
+                const ASTNodeType loop_type = s->loop == NO_LOOP ? AST_NODE_TYPES_COUNT : s->conts[s->loop].node->node_type;
+                EvalStatus status = jumpToLoop(s, loop_type == AST_FOR ? LOOP_UPDATE : LOOP_COND, AST_CONTINUE);
+                if (status.status) {
+                    return status;
+                }
+                break;
+            }
+            default:
+                assert(false);
+        }
+    }
+
+    return (EvalStatus) {
+        .status = false,
+        .node_type = AST_NODE_TYPES_COUNT
+    };
+}
+
+// The symbol table is only checked, as the nodes hold the slots of their variables
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+EvalStatus executeASTIterative(const ASTNode* ast, const SymbolTable* st, Frame* frame) {
+    assert(ast != NULL && st != NULL && frame != NULL);
+
+    EvalStack s;
+    initEvalStack(&s);
+    pushContinuation(&s, ast, RESULT_DISCARD);
+    EvalStatus status = run(&s, frame, 0);
+    assert(status.status || s.operands_size == 0);
+    freeEvalStack(&s);
+    return status;
+}
+
+int evalASTExpressionIterative(const ASTNode* node, const SymbolTable* st, Frame* frame) {
+    assert(node != NULL && st != NULL && frame != NULL);
+
+    EvalStack s;
+    initEvalStack(&s);
+    pushExpression(&s, frame, node, RESULT_VALUE);
+    run(&s, frame, 0);
+    int value = popOperand(&s);
+    assert(s.operands_size == 0);
+    freeEvalStack(&s);
+    return value;
+}
+#pragma GCC diagnostic pop
@@ -0,0 +1,476 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <stdbool.h>
+
+#include "out.h"
+
+#include "bytecode.h"
+
+// The generated code follows the System V AMD64 calling convention
+#if defined(__x86_64__) && defined(__linux__) && !defined(OUT_NO_JIT)
+#define HAS_JIT 1
+#include <sys/mman.h>
+#include <unistd.h>
+#else
+#define HAS_JIT 0
+#endif
+
+typedef void (*JITFunction)(int* R);
+
+typedef struct JITCode {
+    void* code;             // Executable mapping
+    size_t size;            // Bytes of machine code
+    size_t mapped_size;
+    unsigned int slot_count;
+    unsigned int register_count;
+} JITCode;
+
+bool isJITAvailable() {
+    return HAS_JIT;
+}
+
+#if HAS_JIT
+
+#define DEFAULT_CODE_INITIAL_CAPACITY 256
+#define NO_REGISTER (-1)
+
+typedef enum X86Register {
+    EAX = 0,
+    ECX = 1,
+    EDX = 2,
+    EBX = 3,
+    ESI = 6,
+    EDI = 7
+} X86Register;
+
+typedef enum X86Condition {
+    CC_E  = 0x4,
+    CC_NE = 0x5,
+    CC_L  = 0xC,
+    CC_GE = 0xD,
+    CC_LE = 0xE,
+    CC_G  = 0xF
+} X86Condition;
+
+// rel32 field of a jump, resolved once the offsets of all the instructions are known
+typedef struct Patch {
+    size_t pos;
+    unsigned int target;
+} Patch;
+
+// Registers of the program live in an array pointed by rbx, and eax caches the last one that was read or written
+typedef struct Assembler {
+    uint8_t* buffer;
+    size_t size;
+    size_t capacity;
+    size_t* offsets;        // Native offset of each instruction
+    Patch* patches;
+    unsigned int patch_count;
+    int cached;             // Register whose value is in eax, NO_REGISTER if none
+} Assembler;
+
+static void reserve(Assembler* a, size_t n) {
+    if (a->size + n > a->capacity) {
+        while (a->size + n > a->capacity) {
+            a->capacity *= 2;
+        }
+        a->buffer = realloc(a->buffer, a->capacity);
+        assert(a->buffer != NULL);
+    }
+}
+
+static inline void emitByte(Assembler* a, uint8_t byte) {
+    reserve(a, 1);
+    a->buffer[a->size++] = byte;
+}
+
+static inline void emitBytes(Assembler* a, const uint8_t* bytes, size_t n) {
+    reserve(a, n);
+    memcpy(a->buffer + a->size, bytes, n);
+    a->size += n;
+}
+
+#define emitCode(a, ...) do { const uint8_t bytes[] = { __VA_ARGS__ }; emitBytes(a, bytes, sizeof(bytes)); } while (0)
+
+static inline void emitInt32(Assembler* a, int32_t value) {
+    emitBytes(a, (const uint8_t*) &value, sizeof(value));
+}
+
+static inline void emitInt64(Assembler* a, uint64_t value) {
+    emitBytes(a, (const uint8_t*) &value, sizeof(value));
+}
+
+// ModRM of the operand [rbx + 4 * index], with the shortest displacement
+static void emitRegisterOperand(Assembler* a, uint8_t reg, int index) {
+    assert(index >= 0 && index < INT32_MAX / 4);
+    int32_t disp = 4 * index;
+    if (disp <= INT8_MAX) {
+        emitByte(a, 0x40 | (reg << 3) | EBX);
+        emitByte(a, (uint8_t) disp);
+    } else {
+        emitByte(a, 0x80 | (reg << 3) | EBX);
+        emitInt32(a, disp);
+    }
+}
+
+// op reg, R[index] (or op R[index], reg depending on the op code)
+static inline void emitOp(Assembler* a, uint8_t op, uint8_t reg, int index) {
+    emitByte(a, op);
+    emitRegisterOperand(a, reg, index);
+}
+
+static inline void loadEAX(Assembler* a, int index) {
+    if (a->cached != index) {
+        emitOp(a, 0x8B, EAX, index);  // mov eax, R[index]
+        a->cached = index;
+    }
+}
+
+static inline void storeEAX(Assembler* a, int index) {
+    emitOp(a, 0x89, EAX, index);      // mov R[index], eax
+    a->cached = index;
+}
+
+static inline void emitCmpEAX(Assembler* a, int index) {
+    emitOp(a, 0x3B, EAX, index);      // cmp eax, R[index]
+}
+
+static inline void emitCmpEAXConstant(Assembler* a, int32_t value) {
+    emitByte(a, 0x3D);                // cmp eax, imm32
+    emitInt32(a, value);
+}
+
+static void emitJump(Assembler* a, int condition, unsigned int target) {
+    if (condition < 0) {
+        emitByte(a, 0xE9);            // jmp rel32
+    } else {
+        emitCode(a, 0x0F, 0x80 | condition);  // jcc rel32
+    }
+    a->patches[a->patch_count++] = (Patch) { .pos = a->size, .target = target };
+    emitInt32(a, 0);
+}
+
+static inline void emitCall(Assembler* a, uintptr_t function) {
+    emitCode(a, 0x48, 0xB8);          // movabs rax, imm64
+    emitInt64(a, function);
+    emitCode(a, 0xFF, 0xD0);          // call rax
+    a->cached = NO_REGISTER;
+}
+
+static X86Condition conditionOf(OpCode op) {
+    switch (op) {
+        case OP_CMP_EQ:  case OP_CMP_EQK:  case OP_JEQ:  case OP_JEQK:  return CC_E;
+        case OP_CMP_NEQ: case OP_CMP_NEQK: case OP_JNEQ: case OP_JNEQK: return CC_NE;
+        case OP_CMP_LT:  case OP_CMP_LTK:  case OP_JLT:  case OP_JLTK:  return CC_L;
+        case OP_CMP_LTE: case OP_CMP_LTEK: case OP_JLTE: case OP_JLTEK: return CC_LE;
+        case OP_CMP_GT:  case OP_CMP_GTK:  case OP_JGT:  case OP_JGTK:  return CC_G;
+        case OP_CMP_GTE: case OP_CMP_GTEK: case OP_JGTE: case OP_JGTEK: return CC_GE;
+        default:
+            assert(false);
+            return CC_E;
+    }
+}
+
+// Returns the target of a jump instruction, or -1 for the other op codes
+static int jumpTarget(const Instruction* i) {
+    switch (i->op) {
+        case OP_JMP:
+            return i->a;
+        case OP_JZ:
+        case OP_JNZ:
+            return i->b;
+        case OP_JEQ: case OP_JNEQ: case OP_JLT: case OP_JLTE: case OP_JGT: case OP_JGTE:
+        case OP_JEQK: case OP_JNEQK: case OP_JLTK: case OP_JLTEK: case OP_JGTK: case OP_JGTEK:
+            return i->a;
+        default:
+            return -1;
+    }
+}
+
+// Returns false if the op code can not be translated
+static bool translate(Assembler* a, const Program* program, const Instruction* i) {
+    switch (i->op) {
+        case OP_HALT: {
+            emitCode(a, 0x5B, 0xC3);  // pop rbx; ret
+            a->cached = NO_REGISTER;
+            break;
+        } case OP_LOADK: {
+            emitOp(a, 0xC7, 0, i->a); // mov R[a], imm32
+            emitInt32(a, i->b);
+            if (a->cached == i->a) {
+                a->cached = NO_REGISTER;
+            }
+            break;
+        } case OP_MOV: {
+            loadEAX(a, i->b);
+            storeEAX(a, i->a);
+            break;
+        } case OP_ADD:
+          case OP_SUB:
+          case OP_BITWISE_OR:
+          case OP_BITWISE_AND:
+          case OP_BITWISE_XOR: {
+            static const uint8_t alu[OP_CODES_COUNT] = {
+                [OP_ADD] = 0x03, [OP_SUB] = 0x2B, [OP_BITWISE_OR] = 0x0B, [OP_BITWISE_AND] = 0x23, [OP_BITWISE_XOR] = 0x33
+            };
+            loadEAX(a, i->b);
+            emitOp(a, alu[i->op], EAX, i->c);   // op eax, R[c]
+            storeEAX(a, i->a);
+            break;
+        } case OP_ADDK: {
+            loadEAX(a, i->b);
+            emitByte(a, 0x05);                  // add eax, imm32
+            emitInt32(a, i->c);
+            storeEAX(a, i->a);
+            break;
+        } case OP_MUL: {
+            loadEAX(a, i->b);
+            emitByte(a, 0x0F);
+            emitOp(a, 0xAF, EAX, i->c);         // imul eax, R[c]
+            storeEAX(a, i->a);
+            break;
+        } case OP_DIV:
+          case OP_MOD: {
+            loadEAX(a, i->b);
+            emitByte(a, 0x99);                  // cdq
+            emitOp(a, 0xF7, 7, i->c);           // idiv R[c]
+            if (i->op == OP_MOD) {
+                emitCode(a, 0x89, 0xD0);        // mov eax, edx
+            }
+            storeEAX(a, i->a);
+            break;
+        } case OP_L_SHIFT:
+          case OP_R_SHIFT: {
+            emitOp(a, 0x8B, ECX, i->c);         // mov ecx, R[c]
+            loadEAX(a, i->b);
+            emitCode(a, 0xD3, i->op == OP_L_SHIFT ? 0xE0 : 0xF8);  // shl/sar eax, cl
+            storeEAX(a, i->a);
+            break;
+        } case OP_NEG:
+          case OP_BITWISE_NOT: {
+            loadEAX(a, i->b);
+            emitCode(a, 0xF7, i->op == OP_NEG ? 0xD8 : 0xD0);      // neg/not eax
+            storeEAX(a, i->a);
+            break;
+        } case OP_NOT: {
+            loadEAX(a, i->b);
+            emitCode(a, 0x85, 0xC0);            // test eax, eax
+            emitCode(a, 0x0F, 0x94, 0xC0);      // sete al
+            emitCode(a, 0x0F, 0xB6, 0xC0);      // movzx eax, al
+            storeEAX(a, i->a);
+            break;
+        } case OP_ABS:
+          case OP_SET_POSITIVE:
+          case OP_SET_NEGATIVE: {
+            loadEAX(a, i->b);
+            emitCode(a, 0x89, 0xC1);            // mov ecx, eax
+            emitCode(a, 0xF7, 0xD9);            // neg ecx
+            emitCode(a, 0x85, 0xC0);            // test eax, eax
+            emitCode(a, 0x0F, i->op == OP_SET_NEGATIVE ? 0x4D : 0x4C, 0xC1);  // cmovge/cmovl eax, ecx
+            storeEAX(a, i->a);
+            break;
+        } case OP_CMP_EQ:
+          case OP_CMP_NEQ:
+          case OP_CMP_LT:
+          case OP_CMP_LTE:
+          case OP_CMP_GT:
+          case OP_CMP_GTE:
+          case OP_CMP_EQK:
+          case OP_CMP_NEQK:
+          case OP_CMP_LTK:
+          case OP_CMP_LTEK:
+          case OP_CMP_GTK:
+          case OP_CMP_GTEK: {
+            loadEAX(a, i->b);
+            if (i->op >= OP_CMP_EQK) {
+                emitCmpEAXConstant(a, i->c);
+            } else {
+                emitCmpEAX(a, i->c);
+            }
+            emitCode(a, 0x0F, 0x90 | conditionOf(i->op), 0xC0);     // setcc al
+            emitCode(a, 0x0F, 0xB6, 0xC0);                          // movzx eax, al
+            storeEAX(a, i->a);
+            break;
+        } case OP_JMP: {
+            emitJump(a, -1, i->a);
+            a->cached = NO_REGISTER;
+            break;
+        } case OP_JZ:
+          case OP_JNZ: {
+            loadEAX(a, i->a);
+            emitCode(a, 0x85, 0xC0);            // test eax, eax
+            emitJump(a, i->op == OP_JZ ? CC_E : CC_NE, i->b);
+            break;
+        } case OP_JEQ:
+          case OP_JNEQ:
+          case OP_JLT:
+          case OP_JLTE:
+          case OP_JGT:
+          case OP_JGTE:
+          case OP_JEQK:
+          case OP_JNEQK:
+          case OP_JLTK:
+          case OP_JLTEK:
+          case OP_JGTK:
+          case OP_JGTEK: {
+            loadEAX(a, i->b);
+            if (i->op >= OP_JEQK) {
+                emitCmpEAXConstant(a, i->c);
+            } else {
+                emitCmpEAX(a, i->c);
+            }
+            emitJump(a, conditionOf(i->op), i->a);
+            break;
+        } case OP_PRINT: {
+            emitOp(a, 0x8B, EDI, i->a);         // mov edi, R[a]
+            emitByte(a, 0xB8 | ESI);            // mov esi, imm32
+            emitInt32(a, i->b);
+            emitCall(a, (uintptr_t) &executePrint);
+            break;
+        } case OP_PRINT_VAR: {
+            emitCode(a, 0x48, 0xB8 | EDI);      // movabs rdi, imm64
+            emitInt64(a, (uint64_t) (uintptr_t) program->symbols[i->b]);
+            emitOp(a, 0x8B, ESI, i->a);         // mov esi, R[a]
+            emitCall(a, (uintptr_t) &executePrintVar);
+            break;
+        } case OP_LOOP: {
+            // The loop counters are only used by the tiered execution
+            break;
+        } default:
+            return false;
+    }
+    return true;
+}
+
+// Copies the code into a new mapping that is executable but no longer writable
+static void* mapCode(const uint8_t* buffer, size_t size, size_t* mapped_size) {
+    size_t page_size = sysconf(_SC_PAGESIZE);
+    *mapped_size = (size + page_size - 1) / page_size * page_size;
+
+    void* code = mmap(NULL, *mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (code == MAP_FAILED) {
+        return NULL;
+    }
+    memcpy(code, buffer, size);
+    if (mprotect(code, *mapped_size, PROT_READ | PROT_EXEC) != 0) {
+        munmap(code, *mapped_size);
+        return NULL;
+    }
+    return code;
+}
+
+JITCode* newJITCodeFromProgram(const Program* program) {
+    assert(program != NULL);
+
+    Assembler a = {
+        .buffer = malloc(DEFAULT_CODE_INITIAL_CAPACITY),
+        .size = 0,
+        .capacity = DEFAULT_CODE_INITIAL_CAPACITY,
+        .offsets = malloc(program->size * sizeof(size_t)),
+        .patches = malloc(program->size * sizeof(Patch)),
+        .patch_count = 0,
+        .cached = NO_REGISTER
+    };
+    bool* is_target = calloc(program->size, sizeof(bool));
+    assert(a.buffer != NULL && a.offsets != NULL && a.patches != NULL && is_target != NULL);
+
+    for (unsigned int pc = 0; pc < program->size; pc++) {
+        int target = jumpTarget(&program->code[pc]);
+        if (target >= 0) {
+            is_target[target] = true;
+        }
+    }
+
+    // The registers are addressed off rbx, which is callee-saved. Pushing it also aligns the stack for the calls.
+    emitCode(&a, 0x53);                 // push rbx
+    emitCode(&a, 0x48, 0x89, 0xFB);     // mov rbx, rdi
+
+    bool status = true;
+    for (unsigned int pc = 0; pc < program->size && status; pc++) {
+        if (is_target[pc]) {
+            a.cached = NO_REGISTER;
+        }
+        a.offsets[pc] = a.size;
+        status = translate(&a, program, &program->code[pc]);
+    }
+
+    JITCode* jit = NULL;
+    if (status) {
+        for (unsigned int p = 0; p < a.patch_count; p++) {
+            const Patch* patch = &a.patches[p];
+            int32_t rel = (int32_t) (a.offsets[patch->target] - (patch->pos + 4));
+            memcpy(a.buffer + patch->pos, &rel, sizeof(rel));
+        }
+
+        size_t mapped_size = 0;
+        void* code = mapCode(a.buffer, a.size, &mapped_size);
+        if (code != NULL) {
+            jit = malloc(sizeof(JITCode));
+            assert(jit != NULL);
+            jit->code = code;
+            jit->size = a.size;
+            jit->mapped_size = mapped_size;
+            jit->slot_count = program->slot_count;
+            jit->register_count = program->register_count;
+        }
+    }
+
+    free(is_target);
+    free(a.patches);
+    free(a.offsets);
+    free(a.buffer);
+
+    return jit;
+}
+
+void deleteJITCode(JITCode** jit) {
+    assert(jit != NULL && *jit != NULL);
+    munmap((*jit)->code, (*jit)->mapped_size);
+    free(*jit);
+    *jit = NULL;
+}
+
+void executeJITCode(const JITCode* jit, Frame* frame) {
+    assert(jit != NULL && frame != NULL);
+    assert(frame->size >= jit->slot_count);
+
+    int* R = malloc(jit->register_count * sizeof(int));
+    assert(R != NULL);
+    memcpy(R, frame->values, jit->slot_count * sizeof(int));
+
+    // ISO C has no conversion from object to function pointers
+    JITFunction function;
+    memcpy(&function, &jit->code, sizeof(function));
+    function(R);
+
+    memcpy(frame->values, R, jit->slot_count * sizeof(int));
+    free(R);
+
+    endOutputSink(getOutputSink());
+}
+
+#else
+
+JITCode* newJITCodeFromProgram(const Program* program) {
+    assert(program != NULL);
+    return NULL;
+}
+
+void deleteJITCode(JITCode** jit) {
+    assert(jit != NULL && *jit != NULL);
+    assert(false);
+}
+
+void executeJITCode(const JITCode* jit, Frame* frame) {
+    assert(jit != NULL && frame != NULL);
+    assert(false);
+}
+
+#endif
+
+size_t getJITCodeSize(const JITCode* jit) {
+    assert(jit != NULL);
+    return jit->size;
+}
@@ -0,0 +1,103 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+
+#include "out.h"
+
+#if defined(__unix__)
+#define HAS_LIBRARIES 1
+#include <dlfcn.h>
+#else
+#define HAS_LIBRARIES 0
+#endif
+
+typedef struct Library {
+    void* handle;
+    const LibraryDescriptor* descriptor;
+} Library;
+
+#if HAS_LIBRARIES
+
+Library* openLibrary(const char* path) {
+    assert(path != NULL);
+
+    void* handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    if (handle == NULL) {
+        return NULL;
+    }
+
+    const LibraryDescriptor* descriptor = dlsym(handle, LIBRARY_DESCRIPTOR_NAME);
+    if (descriptor == NULL || descriptor->abi_version != LIBRARY_ABI_VERSION) {
+        dlclose(handle);
+        return NULL;
+    }
+
+    Library* library = malloc(sizeof(Library));
+    assert(library != NULL);
+    library->handle = handle;
+    library->descriptor = descriptor;
+    return library;
+}
+
+void closeLibrary(Library** library) {
+    assert(library != NULL && *library != NULL);
+    dlclose((*library)->handle);
+    free(*library);
+    *library = NULL;
+}
+
+#else
+
+Library* openLibrary(const char* path) {
+    assert(path != NULL);
+    return NULL;
+}
+
+void closeLibrary(Library** library) {
+    assert(library != NULL && *library != NULL);
+    free(*library);
+    *library = NULL;
+}
+
+#endif
+
+unsigned int getLibraryFrameSize(const Library* library) {
+    assert(library != NULL);
+    return library->descriptor->frame_size;
+}
+
+unsigned int getLibrarySymbolCount(const Library* library) {
+    assert(library != NULL);
+    return library->descriptor->symbol_count;
+}
+
+const LibrarySymbol* getLibrarySymbol(const Library* library, unsigned int index) {
+    assert(library != NULL && index < library->descriptor->symbol_count);
+    return &library->descriptor->symbols[index];
+}
+
+const LibrarySymbol* findLibrarySymbol(const Library* library, const char* id) {
+    assert(library != NULL && id != NULL);
+    for (unsigned int i = 0; i < library->descriptor->symbol_count; i++) {
+        if (strcmp(library->descriptor->symbols[i].id, id) == 0) {
+            return &library->descriptor->symbols[i];
+        }
+    }
+    return NULL;
+}
+
+Frame* executeLibrary(const Library* library) {
+    assert(library != NULL);
+    Frame* frame = newFrame(library->descriptor->frame_size);
+    executeLibraryWithFrame(library, frame);
+    return frame;
+}
+
+void executeLibraryWithFrame(const Library* library, Frame* frame) {
+    assert(library != NULL && frame != NULL);
+    assert(frame->size >= library->descriptor->frame_size);
+
+    library->descriptor->run(frame->values, &printToOutputSink);
+    endOutputSink(getOutputSink());
+}
@@ -0,0 +1,199 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+
+#include "profile_sample.h"
+
+#define PROFILE_INITIAL_CAPACITY 64 // Power of 2
+#define MAX_STMT_TEXT_SIZE 48
+
+// Open addressing table of the entries, by the address of their statement
+typedef struct Profile {
+    ProfileEntry* entries;
+    unsigned int size;
+    unsigned int capacity;
+    uint64_t nested_ns; // Time of the statements nested in the one being measured
+} Profile;
+
+Profile* newProfile() {
+    Profile* profile = malloc(sizeof(Profile));
+    assert(profile != NULL);
+    profile->entries = calloc(PROFILE_INITIAL_CAPACITY, sizeof(ProfileEntry));
+    assert(profile->entries != NULL);
+    profile->size = 0;
+    profile->capacity = PROFILE_INITIAL_CAPACITY;
+    profile->nested_ns = 0;
+    return profile;
+}
+
+void deleteProfile(Profile** profile) {
+    assert(profile != NULL && *profile != NULL);
+    free((*profile)->entries);
+    free(*profile);
+    *profile = NULL;
+}
+
+static inline uint64_t nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static inline unsigned int hashStmt(const ASTNode* stmt, unsigned int capacity) {
+    // The low bits of the addresses are the same for all the nodes
+    uint64_t h = ((uintptr_t) stmt >> 4) * 0x9E3779B97F4A7C15ull;
+    return (unsigned int) (h >> 32) & (capacity - 1);
+}
+
+static ProfileEntry* findEntry(ProfileEntry* entries, unsigned int capacity, const ASTNode* stmt) {
+    unsigned int i = hashStmt(stmt, capacity);
+    while (entries[i].stmt != NULL && entries[i].stmt != stmt) {
+        i = (i + 1) & (capacity - 1);
+    }
+    return &entries[i];
+}
+
+static void growProfile(Profile* profile) {
+    unsigned int capacity = 2 * profile->capacity;
+    ProfileEntry* entries = calloc(capacity, sizeof(ProfileEntry));
+    assert(entries != NULL);
+    for (unsigned int i = 0; i < profile->capacity; i++) {
+        if (profile->entries[i].stmt != NULL) {
+            *findEntry(entries, capacity, profile->entries[i].stmt) = profile->entries[i];
+        }
+    }
+    free(profile->entries);
+    profile->entries = entries;
+    profile->capacity = capacity;
+}
+
+void startProfileSample(Profile* profile, ProfileSample* sample) {
+    assert(profile != NULL && sample != NULL);
+    sample->nested_ns = profile->nested_ns;
+    profile->nested_ns = 0;
+    sample->start_ns = nowNs();
+}
+
+void stopProfileSample(Profile* profile, const ProfileSample* sample, const ASTNode* stmt) {
+    assert(profile != NULL && sample != NULL && stmt != NULL);
+    uint64_t elapsed = nowNs() - sample->start_ns;
+
+    // At most half full
+    if (2 * (profile->size + 1) > profile->capacity) {
+        growProfile(profile);
+    }
+    ProfileEntry* entry = findEntry(profile->entries, profile->capacity, stmt);
+    if (entry->stmt == NULL) {
+        entry->stmt = stmt;
+        profile->size++;
+    }
+    entry->count++;
+    entry->total_ns += elapsed;
+    entry->self_ns += elapsed - profile->nested_ns;
+
+    profile->nested_ns = sample->nested_ns + elapsed;
+}
+
+unsigned int getProfileSize(const Profile* profile) {
+    assert(profile != NULL);
+    return profile->size;
+}
+
+const ProfileEntry* getProfileEntry(const Profile* profile, const ASTNode* stmt) {
+    assert(profile != NULL && stmt != NULL);
+    const ProfileEntry* entry = findEntry(profile->entries, profile->capacity, stmt);
+    return entry->stmt != NULL ? entry : NULL;
+}
+
+// Statement that runs once per iteration of the loop, NULL if the statement is not a loop
+static const ASTNode* getLoopBody(const ASTNode* stmt) {
+    switch (stmt->node_type) {
+        case AST_WHILE:    return stmt->right;
+        case AST_DO_WHILE: return stmt->left;
+        case AST_FOR:      return stmt->child->stmts[1]->right->child->stmts[0];
+        default:           return NULL;
+    }
+}
+
+static int compareSelfTime(const void* a, const void* b) {
+    const ProfileEntry* e1 = *(const ProfileEntry**) a;
+    const ProfileEntry* e2 = *(const ProfileEntry**) b;
+    return e1->self_ns < e2->self_ns ? 1 : (e1->self_ns > e2->self_ns ? -1 : 0);
+}
+
+// Copies the source from the position of the statement to the end of its line
+static void getStmtText(const char* src, const ASTNode* stmt, char* text) {
+    const char* line = src;
+    for (unsigned int l = 1; line != NULL && l < stmt->line; l++) {
+        line = strchr(line, '\n');
+        line = line != NULL ? line + 1 : NULL;
+    }
+
+    size_t len = 0;
+    if (line != NULL && strnlen(line, stmt->column) >= stmt->column) {
+        const char* start = line + stmt->column - 1;
+        while (len < MAX_STMT_TEXT_SIZE - 1 && start[len] != '\0' && start[len] != '\n' && start[len] != '\r') {
+            text[len] = start[len];
+            len++;
+        }
+    }
+    text[len] = '\0';
+}
+
+int printProfile(const Profile* profile, const char* src, unsigned int max_entries, const IOStream* stream) {
+    assert(profile != NULL && stream != NULL);
+
+    // The blocks are left out of the report, their time is in the statements that they hold
+    const ProfileEntry** sorted = malloc((profile->size + 1) * sizeof(ProfileEntry*));
+    assert(sorted != NULL);
+    unsigned int count = 0;
+    uint64_t total_ns = 0;
+    for (unsigned int i = 0; i < profile->capacity; i++) {
+        const ProfileEntry* entry = &profile->entries[i];
+        if (entry->stmt != NULL) {
+            total_ns += entry->self_ns;
+            if (entry->stmt->node_type != AST_SCOPE) {
+                sorted[count++] = entry;
+            }
+        }
+    }
+    qsort(sorted, count, sizeof(ProfileEntry*), &compareSelfTime);
+
+    int n = IOStreamWritef(stream, "Profile of %u statements, %.3f ms:\n", count, total_ns / 1e6);
+    n += IOStreamWritef(stream, "%12s %7s %12s %12s %12s  %-9s %s\n", "self (ms)", "%", "total (ms)", "count", "iterations", "line:col", "statement");
+
+    char text[MAX_STMT_TEXT_SIZE];
+    char location[24];
+    for (unsigned int i = 0; i < count && i < max_entries; i++) {
+        const ProfileEntry* entry = sorted[i];
+        const ASTNode* stmt = entry->stmt;
+
+        n += IOStreamWritef(stream, "%12.3f %6.1f%% %12.3f %12lu ", entry->self_ns / 1e6, total_ns > 0 ? 100.0 * entry->self_ns / total_ns : 0.0, entry->total_ns / 1e6, entry->count);
+
+        const ASTNode* body = getLoopBody(stmt);
+        const ProfileEntry* iterations = body != NULL ? getProfileEntry(profile, body) : NULL;
+        if (body != NULL) {
+            n += IOStreamWritef(stream, "%12lu", iterations != NULL ? iterations->count : 0);
+        } else {
+            n += IOStreamWritef(stream, "%12s", "-");
+        }
+
+        if (stmt->line > 0) {
+            snprintf(location, sizeof(location), "%u:%u", stmt->line, stmt->column);
+        } else {
+            snprintf(location, sizeof(location), "?");
+        }
+
+        text[0] = '\0';
+        if (src != NULL && stmt->line > 0) {
+            getStmtText(src, stmt, text);
+        }
+        n += IOStreamWritef(stream, "  %-9s %s\n", location, text[0] != '\0' ? text : nodeTypeToStr(stmt->node_type));
+    }
+
+    free(sorted);
+    return n;
+}
@@ -0,0 +1,18 @@
+#ifndef _PROFILE_SAMPLE_H_
+#define _PROFILE_SAMPLE_H_
+
+#include <stdint.h>
+
+#include "profile.h"
+
+// Measurement of one execution of a statement. The samples of the nested statements are taken in between.
+typedef struct ProfileSample {
+    uint64_t start_ns;
+    uint64_t nested_ns; // Of the enclosing statement, until this one ends
+} ProfileSample;
+
+void startProfileSample(Profile* profile, ProfileSample* sample);
+
+void stopProfileSample(Profile* profile, const ProfileSample* sample, const ASTNode* stmt);
+
+#endif
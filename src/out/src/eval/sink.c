@@ -0,0 +1,208 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "sink.h"
+
+#define PRINT_BUFFER_SIZE (2 * MAX_ID_SIZE + 64)
+
+typedef struct OutputSink {
+    FILE* file;
+    FlushPolicy policy;
+    size_t size;
+    size_t capacity;
+    char buffer[];
+} OutputSink;
+
+static OutputSink* default_sink = NULL;
+static pthread_once_t default_sink_once = PTHREAD_ONCE_INIT;
+static _Thread_local OutputSink* current_sink = NULL;
+
+OutputSink* newOutputSink(FILE* file, size_t capacity, FlushPolicy policy) {
+    assert(file != NULL && capacity > 0);
+    assert(policy < FLUSH_POLICIES_COUNT);
+
+    OutputSink* sink = malloc(sizeof(OutputSink) + capacity);
+    assert(sink != NULL);
+    sink->file = file;
+    sink->policy = policy;
+    sink->size = 0;
+    sink->capacity = capacity;
+    return sink;
+}
+
+void deleteOutputSink(OutputSink** sink) {
+    assert(sink != NULL && *sink != NULL);
+    assert(*sink != current_sink);
+
+    flushOutputSink(*sink);
+    free(*sink);
+    *sink = NULL;
+}
+
+FlushPolicy getOutputSinkFlushPolicy(const OutputSink* sink) {
+    assert(sink != NULL);
+    return sink->policy;
+}
+
+void setOutputSinkFlushPolicy(OutputSink* sink, FlushPolicy policy) {
+    assert(sink != NULL && policy < FLUSH_POLICIES_COUNT);
+    sink->policy = policy;
+}
+
+void flushOutputSink(OutputSink* sink) {
+    assert(sink != NULL);
+
+    // The file is also flushed so that the output is not reordered with other writes to it
+    if (sink->size > 0) {
+        fwrite(sink->buffer, 1, sink->size, sink->file);
+        sink->size = 0;
+    }
+    fflush(sink->file);
+}
+
+void endOutputSink(OutputSink* sink) {
+    assert(sink != NULL);
+    if (sink->policy == FLUSH_FULL) {
+        flushOutputSink(sink);
+    }
+}
+
+void sinkWrite(OutputSink* sink, const char* str, size_t len) {
+    assert(sink != NULL && str != NULL);
+
+    if (len > sink->capacity - sink->size) {
+        flushOutputSink(sink);
+        if (len > sink->capacity) {
+            fwrite(str, 1, len, sink->file);
+            return;
+        }
+    }
+    memcpy(sink->buffer + sink->size, str, len);
+    sink->size += len;
+}
+
+void sinkWriteStr(OutputSink* sink, const char* str) {
+    sinkWrite(sink, str, strlen(str));
+}
+
+void sinkWriteInt(OutputSink* sink, int value) {
+    char digits[TYPE_VALUE_BUFFER_SIZE];
+    char* end = digits + TYPE_VALUE_BUFFER_SIZE;
+    char* p = end;
+
+    // Negated as unsigned so that INT_MIN does not overflow
+    unsigned int n = value < 0 ? 0u - (unsigned int) value : (unsigned int) value;
+    do {
+        *--p = '0' + n % 10;
+        n /= 10;
+    } while (n > 0);
+    if (value < 0) {
+        *--p = '-';
+    }
+
+    sinkWrite(sink, p, end - p);
+}
+
+void sinkWriteValue(OutputSink* sink, ASTType type, int value) {
+    switch (type) {
+        case AST_TYPE_INT:
+            sinkWriteInt(sink, value);
+            break;
+        case AST_TYPE_BOOL:
+            if (value) {
+                sinkWrite(sink, "true", 4);
+            } else {
+                sinkWrite(sink, "false", 5);
+            }
+            break;
+        case AST_TYPE_TYPE:
+            assert(value < AST_TYPE_COUNT);
+            sinkWriteStr(sink, ASTTypeToStr(value));
+            break;
+        case AST_TYPE_VOID:
+            sinkWrite(sink, "void", 4);
+            break;
+        default:
+            assert(false);
+    }
+}
+
+void sinkWriteVar(OutputSink* sink, const Symbol* var, int value) {
+    assert(var != NULL);
+
+    sinkWriteStr(sink, ASTTypeToStr(getVarType(var)));
+    sinkWrite(sink, " ", 1);
+    sinkWriteStr(sink, getVarId(var));
+    sinkWrite(sink, " = ", 3);
+    sinkWriteValue(sink, getVarType(var), value);
+}
+
+void sinkEndLine(OutputSink* sink) {
+    sinkWrite(sink, "\n", 1);
+    if (sink->policy == FLUSH_LINE) {
+        flushOutputSink(sink);
+    }
+}
+
+static void flushDefaultSink() {
+    flushOutputSink(default_sink);
+}
+
+static void initDefaultSink() {
+    FlushPolicy policy = isatty(fileno(stdout)) ? FLUSH_LINE : FLUSH_FULL;
+    default_sink = newOutputSinkDefault(stdout, policy);
+    atexit(&flushDefaultSink);
+}
+
+OutputSink* setOutputSink(OutputSink* sink) {
+    OutputSink* previous = current_sink;
+    current_sink = sink;
+    return previous;
+}
+
+OutputSink* getOutputSink() {
+    if (current_sink != NULL) {
+        return current_sink;
+    }
+
+    // Threads may print for the first time concurrently
+    pthread_once(&default_sink_once, &initDefaultSink);
+    return default_sink;
+}
+
+int printToOutputSink(const char* fmt, ...) {
+    char buffer[PRINT_BUFFER_SIZE];
+    char* str = buffer;
+
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(buffer, PRINT_BUFFER_SIZE, fmt, args);
+    va_end(args);
+
+    if (n >= PRINT_BUFFER_SIZE) {
+        str = malloc(n + 1);
+        assert(str != NULL);
+        va_start(args, fmt);
+        vsnprintf(str, n + 1, fmt, args);
+        va_end(args);
+    }
+
+    OutputSink* sink = getOutputSink();
+    if (n > 0 && str[n - 1] == '\n') {
+        sinkWrite(sink, str, n - 1);
+        sinkEndLine(sink);
+    } else if (n > 0) {
+        sinkWrite(sink, str, n);
+    }
+
+    if (str != buffer) {
+        free(str);
+    }
+    return n;
+}
@@ -0,0 +1,241 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <errno.h>
+
+#include "out.h"
+
+#include "bytecode.h"
+
+// Compiling a loop needs a C compiler to spawn and a dynamic loader
+#if defined(__unix__) && !defined(OUT_NO_TIERED)
+#define HAS_TIERED 1
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#else
+#define HAS_TIERED 0
+#endif
+
+#define MAX_PATH_SIZE 4096
+#define MAX_EXT_SIZE 32
+#define DEFAULT_CC "cc"
+
+extern char** environ;
+
+#if HAS_TIERED
+
+// Wrapping keeps the semantics of the int arithmetic of the interpreter
+static const char* const CC_FLAGS[] = { "-O2", "-fwrapv", "-fPIC", "-shared", "-w" };
+#define CC_FLAG_COUNT (sizeof(CC_FLAGS) / sizeof(CC_FLAGS[0]))
+
+#define HASH_SEED 14695981039346656037ull
+
+// FNV-1a, continuing from h
+static uint64_t hash(uint64_t h, const char* str, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char) str[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+// The cache holds code that is loaded into the process, so it has to be a directory that only this user can write
+static bool openCacheDir(char* dir, size_t size) {
+    const char* env = getenv("MYLANG_CACHE_DIR");
+    int n = env != NULL && env[0] != '\0'
+        ? snprintf(dir, size, "%s", env)
+        : snprintf(dir, size, "/tmp/mylang-%u", (unsigned int) getuid());
+    if (n < 0 || (size_t) n >= size) {
+        return false;
+    }
+
+    mkdir(dir, 0700);
+
+    struct stat info;
+    return lstat(dir, &info) == 0 && S_ISDIR(info.st_mode) && info.st_uid == getuid()
+        && (info.st_mode & (S_IWGRP | S_IWOTH)) == 0;
+}
+
+static bool writeFile(const char* path, const char* data, size_t size) {
+    FILE* file = fopen(path, "w");
+    if (file == NULL) {
+        return false;
+    }
+    bool status = fwrite(data, 1, size, file) == size;
+    return fclose(file) == 0 && status;
+}
+
+static const char* getCompiler(void) {
+    const char* cc = getenv("CC");
+    return cc == NULL || cc[0] == '\0' ? DEFAULT_CC : cc;
+}
+
+// Runs the C compiler without a shell, discarding its messages
+static bool runCompiler(const char* cc, const char* src_path, const char* lib_path) {
+    char* argv[CC_FLAG_COUNT + 5];
+    unsigned int argc = 0;
+    argv[argc++] = (char*) cc;
+    for (unsigned int i = 0; i < CC_FLAG_COUNT; i++) {
+        argv[argc++] = (char*) CC_FLAGS[i];
+    }
+    argv[argc++] = "-o";
+    argv[argc++] = (char*) lib_path;
+    argv[argc++] = (char*) src_path;
+    argv[argc] = NULL;
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+    posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+
+    pid_t pid;
+    int res = posix_spawnp(&pid, cc, &actions, NULL, argv, environ);
+    posix_spawn_file_actions_destroy(&actions);
+    if (res != 0) {
+        return false;
+    }
+
+    int status;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) {
+            return false;
+        }
+    }
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+// The key covers everything the shared object depends on: the source, the compiler and its flags
+static unsigned long long cacheKey(const char* cc, const char* src, size_t size) {
+    uint64_t h = hash(HASH_SEED, cc, strlen(cc) + 1);
+    for (unsigned int i = 0; i < CC_FLAG_COUNT; i++) {
+        h = hash(h, CC_FLAGS[i], strlen(CC_FLAGS[i]) + 1);
+    }
+    return hash(h, src, size);
+}
+
+static bool cachePath(char* path, const char* dir, unsigned long long h, const char* ext) {
+    int n = snprintf(path, MAX_PATH_SIZE, "%s/loop-%016llx%s", dir, h, ext);
+    return n >= 0 && n < MAX_PATH_SIZE;
+}
+
+// Returns the path of the shared object of the source, building it if it is not in the cache yet
+static bool buildLibrary(const char* src, size_t size, char* lib_path) {
+    char dir[MAX_PATH_SIZE];
+    if (!openCacheDir(dir, MAX_PATH_SIZE)) {
+        return false;
+    }
+
+    const char* cc = getCompiler();
+    unsigned long long h = cacheKey(cc, src, size);
+    if (!cachePath(lib_path, dir, h, ".so")) {
+        return false;
+    }
+    if (access(lib_path, R_OK) == 0) {
+        return true;
+    }
+
+    // Built under a temporary name and renamed, so that concurrent runs never load a partial library
+    char ext[MAX_EXT_SIZE];
+    char src_path[MAX_PATH_SIZE];
+    char tmp_path[MAX_PATH_SIZE];
+    snprintf(ext, MAX_EXT_SIZE, ".%d.c", (int) getpid());
+    if (!cachePath(src_path, dir, h, ext)) {
+        return false;
+    }
+    snprintf(ext, MAX_EXT_SIZE, ".%d.so", (int) getpid());
+    if (!cachePath(tmp_path, dir, h, ext)) {
+        return false;
+    }
+
+    bool status = writeFile(src_path, src, size) && runCompiler(cc, src_path, tmp_path) && rename(tmp_path, lib_path) == 0;
+    remove(src_path);
+    if (!status) {
+        remove(tmp_path);
+    }
+    return status;
+}
+
+static bool compileLoop(const Program* program, const Loop* loop, LoopRuntime* runtime) {
+    char* src = NULL;
+    size_t size = 0;
+    IOStream* stream = openIOStreamFromMemmory(&src, &size);
+    bool status = outCompileLoopToC(loop->ast, program->st, stream);
+    IOStreamClose(&stream);
+
+    char lib_path[MAX_PATH_SIZE];
+    status = status && buildLibrary(src, strlen(src), lib_path);
+    free(src);
+    if (!status) {
+        return false;
+    }
+
+    void* library = dlopen(lib_path, RTLD_NOW | RTLD_LOCAL);
+    if (library == NULL) {
+        return false;
+    }
+    void* function = dlsym(library, LOOP_FUNCTION_NAME);
+    if (function == NULL) {
+        dlclose(library);
+        return false;
+    }
+
+    // ISO C has no conversion from object to function pointers
+    runtime->library = library;
+    memcpy(&runtime->function, &function, sizeof(runtime->function));
+    return true;
+}
+
+void unloadNativeLoops(Program* program) {
+    assert(program != NULL);
+    for (unsigned int i = 0; program->runtime != NULL && i < program->loop_count; i++) {
+        if (program->runtime[i].library != NULL) {
+            dlclose(program->runtime[i].library);
+            program->runtime[i].library = NULL;
+        }
+    }
+}
+
+#else
+
+static bool compileLoop(const Program* program, const Loop* loop, LoopRuntime* runtime) {
+    assert(program != NULL && loop != NULL && runtime != NULL);
+    return false;
+}
+
+void unloadNativeLoops(Program* program) {
+    assert(program != NULL);
+}
+
+#endif
+
+unsigned int tierUpLoop(const Program* program, unsigned int index, int* R, unsigned int next_pc) {
+    assert(program != NULL && index < program->loop_count && R != NULL);
+
+    const Loop* loop = &program->loops[index];
+    LoopRuntime* runtime = &program->runtime[index];
+    LoopState state = atomic_load_explicit(&runtime->state, memory_order_acquire);
+    if (state == LOOP_COUNTING) {
+        // Only the first thread to get the lock compiles, the others wait for its result
+        pthread_mutex_lock(&runtime->lock);
+        state = atomic_load_explicit(&runtime->state, memory_order_relaxed);
+        if (state == LOOP_COUNTING) {
+            state = compileLoop(program, loop, runtime) ? LOOP_NATIVE : LOOP_INTERPRETED;
+            atomic_store_explicit(&runtime->state, state, memory_order_release);
+        }
+        pthread_mutex_unlock(&runtime->lock);
+    }
+    if (state != LOOP_NATIVE) {
+        return next_pc;
+    }
+
+    // The loop is entered at a statement boundary, so the frame slots hold the whole state
+    runtime->function(R, &printToOutputSink);
+    return loop->exit;
+}
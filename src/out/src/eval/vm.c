@@ -0,0 +1,294 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "out.h"
+
+#include "bytecode.h"
+
+// Labels as values are a GCC/Clang extension, the switch loop is used everywhere else
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(OUT_NO_COMPUTED_GOTO)
+#define HAS_COMPUTED_GOTO 1
+#else
+#define HAS_COMPUTED_GOTO 0
+#endif
+
+void executePrint(int value, ASTType type) {
+    OutputSink* sink = getOutputSink();
+    sinkWriteValue(sink, type, value);
+    sinkEndLine(sink);
+}
+
+void executePrintVar(const Symbol* var, int value) {
+    OutputSink* sink = getOutputSink();
+    sinkWriteVar(sink, var, value);
+    sinkEndLine(sink);
+}
+
+static inline int setPositive(int v) {
+    return (v < 0)*(~(v)+1) + (1 - (v < 0))*v;
+}
+
+static inline int setNegative(int v) {
+    return (1 - (v < 0))*(~(v)+1) + (v < 0)*v;
+}
+
+static void runSwitch(const Program* program, int* R) {
+    const Instruction* code = program->code;
+    unsigned int pc = 0;
+    while (true) {
+        const Instruction* i = &code[pc++];
+        switch (i->op) {
+            case OP_HALT:         return;
+            case OP_LOADK:        R[i->a] = i->b; break;
+            case OP_MOV:          R[i->a] = R[i->b]; break;
+            case OP_ADD:          R[i->a] = WRAP_INT_OP(R[i->b], +, R[i->c]); break;
+            case OP_ADDK:         R[i->a] = WRAP_INT_OP(R[i->b], +, i->c); break;
+            case OP_SUB:          R[i->a] = WRAP_INT_OP(R[i->b], -, R[i->c]); break;
+            case OP_MUL:          R[i->a] = WRAP_INT_OP(R[i->b], *, R[i->c]); break;
+            case OP_DIV:          R[i->a] = R[i->b] / R[i->c]; break;
+            case OP_MOD:          R[i->a] = R[i->b] % R[i->c]; break;
+            case OP_BITWISE_OR:   R[i->a] = R[i->b] | R[i->c]; break;
+            case OP_BITWISE_AND:  R[i->a] = R[i->b] & R[i->c]; break;
+            case OP_BITWISE_XOR:  R[i->a] = R[i->b] ^ R[i->c]; break;
+            case OP_L_SHIFT:      R[i->a] = R[i->b] << R[i->c]; break;
+            case OP_R_SHIFT:      R[i->a] = R[i->b] >> R[i->c]; break;
+            case OP_NEG:          R[i->a] = - R[i->b]; break;
+            case OP_NOT:          R[i->a] = ! R[i->b]; break;
+            case OP_BITWISE_NOT:  R[i->a] = ~ R[i->b]; break;
+            case OP_ABS:          R[i->a] = R[i->b] >= 0 ? R[i->b] : - R[i->b]; break;
+            case OP_SET_POSITIVE: R[i->a] = setPositive(R[i->b]); break;
+            case OP_SET_NEGATIVE: R[i->a] = setNegative(R[i->b]); break;
+            case OP_CMP_EQ:       R[i->a] = R[i->b] == R[i->c]; break;
+            case OP_CMP_NEQ:      R[i->a] = R[i->b] != R[i->c]; break;
+            case OP_CMP_LT:       R[i->a] = R[i->b] <  R[i->c]; break;
+            case OP_CMP_LTE:      R[i->a] = R[i->b] <= R[i->c]; break;
+            case OP_CMP_GT:       R[i->a] = R[i->b] >  R[i->c]; break;
+            case OP_CMP_GTE:      R[i->a] = R[i->b] >= R[i->c]; break;
+            case OP_CMP_EQK:      R[i->a] = R[i->b] == i->c; break;
+            case OP_CMP_NEQK:     R[i->a] = R[i->b] != i->c; break;
+            case OP_CMP_LTK:      R[i->a] = R[i->b] <  i->c; break;
+            case OP_CMP_LTEK:     R[i->a] = R[i->b] <= i->c; break;
+            case OP_CMP_GTK:      R[i->a] = R[i->b] >  i->c; break;
+            case OP_CMP_GTEK:     R[i->a] = R[i->b] >= i->c; break;
+            case OP_JMP:          pc = i->a; break;
+            case OP_JZ:           if (!R[i->a]) pc = i->b; break;
+            case OP_JNZ:          if (R[i->a]) pc = i->b; break;
+            case OP_JEQ:          if (R[i->b] == R[i->c]) pc = i->a; break;
+            case OP_JNEQ:         if (R[i->b] != R[i->c]) pc = i->a; break;
+            case OP_JLT:          if (R[i->b] <  R[i->c]) pc = i->a; break;
+            case OP_JLTE:         if (R[i->b] <= R[i->c]) pc = i->a; break;
+            case OP_JGT:          if (R[i->b] >  R[i->c]) pc = i->a; break;
+            case OP_JGTE:         if (R[i->b] >= R[i->c]) pc = i->a; break;
+            case OP_JEQK:         if (R[i->b] == i->c) pc = i->a; break;
+            case OP_JNEQK:        if (R[i->b] != i->c) pc = i->a; break;
+            case OP_JLTK:         if (R[i->b] <  i->c) pc = i->a; break;
+            case OP_JLTEK:        if (R[i->b] <= i->c) pc = i->a; break;
+            case OP_JGTK:         if (R[i->b] >  i->c) pc = i->a; break;
+            case OP_JGTEK:        if (R[i->b] >= i->c) pc = i->a; break;
+            case OP_PRINT:        executePrint(R[i->a], i->b); break;
+            case OP_PRINT_VAR:    executePrintVar(program->symbols[i->b], R[i->a]); break;
+            case OP_LOOP:         if (isLoopHot(&program->runtime[i->a], program->tier_up_threshold)) pc = tierUpLoop(program, i->a, R, pc); break;
+            default:
+                assert(false);
+        }
+    }
+}
+
+#if HAS_COMPUTED_GOTO
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+
+// When called without a program, it only exports its label table so the targets can be resolved at load time
+static void runThreaded(const Program* program, int* R, const void* const** label_table) {
+    static const void* const labels[OP_CODES_COUNT] = {
+        [OP_HALT]         = &&op_halt,
+        [OP_LOADK]        = &&op_loadk,
+        [OP_MOV]          = &&op_mov,
+        [OP_ADD]          = &&op_add,
+        [OP_ADDK]         = &&op_addk,
+        [OP_SUB]          = &&op_sub,
+        [OP_MUL]          = &&op_mul,
+        [OP_DIV]          = &&op_div,
+        [OP_MOD]          = &&op_mod,
+        [OP_BITWISE_OR]   = &&op_bitwise_or,
+        [OP_BITWISE_AND]  = &&op_bitwise_and,
+        [OP_BITWISE_XOR]  = &&op_bitwise_xor,
+        [OP_L_SHIFT]      = &&op_l_shift,
+        [OP_R_SHIFT]      = &&op_r_shift,
+        [OP_NEG]          = &&op_neg,
+        [OP_NOT]          = &&op_not,
+        [OP_BITWISE_NOT]  = &&op_bitwise_not,
+        [OP_ABS]          = &&op_abs,
+        [OP_SET_POSITIVE] = &&op_set_positive,
+        [OP_SET_NEGATIVE] = &&op_set_negative,
+        [OP_CMP_EQ]       = &&op_cmp_eq,
+        [OP_CMP_NEQ]      = &&op_cmp_neq,
+        [OP_CMP_LT]       = &&op_cmp_lt,
+        [OP_CMP_LTE]      = &&op_cmp_lte,
+        [OP_CMP_GT]       = &&op_cmp_gt,
+        [OP_CMP_GTE]      = &&op_cmp_gte,
+        [OP_CMP_EQK]      = &&op_cmp_eqk,
+        [OP_CMP_NEQK]     = &&op_cmp_neqk,
+        [OP_CMP_LTK]      = &&op_cmp_ltk,
+        [OP_CMP_LTEK]     = &&op_cmp_ltek,
+        [OP_CMP_GTK]      = &&op_cmp_gtk,
+        [OP_CMP_GTEK]     = &&op_cmp_gtek,
+        [OP_JMP]          = &&op_jmp,
+        [OP_JZ]           = &&op_jz,
+        [OP_JNZ]          = &&op_jnz,
+        [OP_JEQ]          = &&op_jeq,
+        [OP_JNEQ]         = &&op_jneq,
+        [OP_JLT]          = &&op_jlt,
+        [OP_JLTE]         = &&op_jlte,
+        [OP_JGT]          = &&op_jgt,
+        [OP_JGTE]         = &&op_jgte,
+        [OP_JEQK]         = &&op_jeqk,
+        [OP_JNEQK]        = &&op_jneqk,
+        [OP_JLTK]         = &&op_jltk,
+        [OP_JLTEK]        = &&op_jltek,
+        [OP_JGTK]         = &&op_jgtk,
+        [OP_JGTEK]        = &&op_jgtek,
+        [OP_PRINT]        = &&op_print,
+        [OP_PRINT_VAR]    = &&op_print_var,
+        [OP_LOOP]         = &&op_loop,
+    };
+
+    if (program == NULL) {
+        *label_table = labels;
+        return;
+    }
+
+    const Instruction* code = program->code;
+    const void* const* targets = program->targets;
+    const Instruction* i = code;
+
+// Every handler ends with its own indirect jump to the next handler
+#define DISPATCH() goto *targets[i - code]
+#define NEXT() do { i++; DISPATCH(); } while (0)
+#define JUMP(target) do { i = &code[target]; DISPATCH(); } while (0)
+
+    DISPATCH();
+
+    op_halt:         return;
+    op_loadk:        R[i->a] = i->b; NEXT();
+    op_mov:          R[i->a] = R[i->b]; NEXT();
+    op_add:          R[i->a] = WRAP_INT_OP(R[i->b], +, R[i->c]); NEXT();
+    op_addk:         R[i->a] = WRAP_INT_OP(R[i->b], +, i->c); NEXT();
+    op_sub:          R[i->a] = WRAP_INT_OP(R[i->b], -, R[i->c]); NEXT();
+    op_mul:          R[i->a] = WRAP_INT_OP(R[i->b], *, R[i->c]); NEXT();
+    op_div:          R[i->a] = R[i->b] / R[i->c]; NEXT();
+    op_mod:          R[i->a] = R[i->b] % R[i->c]; NEXT();
+    op_bitwise_or:   R[i->a] = R[i->b] | R[i->c]; NEXT();
+    op_bitwise_and:  R[i->a] = R[i->b] & R[i->c]; NEXT();
+    op_bitwise_xor:  R[i->a] = R[i->b] ^ R[i->c]; NEXT();
+    op_l_shift:      R[i->a] = R[i->b] << R[i->c]; NEXT();
+    op_r_shift:      R[i->a] = R[i->b] >> R[i->c]; NEXT();
+    op_neg:          R[i->a] = - R[i->b]; NEXT();
+    op_not:          R[i->a] = ! R[i->b]; NEXT();
+    op_bitwise_not:  R[i->a] = ~ R[i->b]; NEXT();
+    op_abs:          R[i->a] = R[i->b] >= 0 ? R[i->b] : - R[i->b]; NEXT();
+    op_set_positive: R[i->a] = setPositive(R[i->b]); NEXT();
+    op_set_negative: R[i->a] = setNegative(R[i->b]); NEXT();
+    op_cmp_eq:       R[i->a] = R[i->b] == R[i->c]; NEXT();
+    op_cmp_neq:      R[i->a] = R[i->b] != R[i->c]; NEXT();
+    op_cmp_lt:       R[i->a] = R[i->b] <  R[i->c]; NEXT();
+    op_cmp_lte:      R[i->a] = R[i->b] <= R[i->c]; NEXT();
+    op_cmp_gt:       R[i->a] = R[i->b] >  R[i->c]; NEXT();
+    op_cmp_gte:      R[i->a] = R[i->b] >= R[i->c]; NEXT();
+    op_cmp_eqk:      R[i->a] = R[i->b] == i->c; NEXT();
+    op_cmp_neqk:     R[i->a] = R[i->b] != i->c; NEXT();
+    op_cmp_ltk:      R[i->a] = R[i->b] <  i->c; NEXT();
+    op_cmp_ltek:     R[i->a] = R[i->b] <= i->c; NEXT();
+    op_cmp_gtk:      R[i->a] = R[i->b] >  i->c; NEXT();
+    op_cmp_gtek:     R[i->a] = R[i->b] >= i->c; NEXT();
+    op_jmp:          JUMP(i->a);
+    op_jz:           if (!R[i->a]) JUMP(i->b); NEXT();
+    op_jnz:          if (R[i->a]) JUMP(i->b); NEXT();
+    op_jeq:          if (R[i->b] == R[i->c]) JUMP(i->a); NEXT();
+    op_jneq:         if (R[i->b] != R[i->c]) JUMP(i->a); NEXT();
+    op_jlt:          if (R[i->b] <  R[i->c]) JUMP(i->a); NEXT();
+    op_jlte:         if (R[i->b] <= R[i->c]) JUMP(i->a); NEXT();
+    op_jgt:          if (R[i->b] >  R[i->c]) JUMP(i->a); NEXT();
+    op_jgte:         if (R[i->b] >= R[i->c]) JUMP(i->a); NEXT();
+    op_jeqk:         if (R[i->b] == i->c) JUMP(i->a); NEXT();
+    op_jneqk:        if (R[i->b] != i->c) JUMP(i->a); NEXT();
+    op_jltk:         if (R[i->b] <  i->c) JUMP(i->a); NEXT();
+    op_jltek:        if (R[i->b] <= i->c) JUMP(i->a); NEXT();
+    op_jgtk:         if (R[i->b] >  i->c) JUMP(i->a); NEXT();
+    op_jgtek:        if (R[i->b] >= i->c) JUMP(i->a); NEXT();
+    op_print:        executePrint(R[i->a], i->b); NEXT();
+    op_print_var:    executePrintVar(program->symbols[i->b], R[i->a]); NEXT();
+    op_loop:         if (isLoopHot(&program->runtime[i->a], program->tier_up_threshold)) JUMP(tierUpLoop(program, i->a, R, i - code + 1)); NEXT();
+
+#undef DISPATCH
+#undef NEXT
+#undef JUMP
+}
+
+#pragma GCC diagnostic pop
+
+#endif
+
+void resolveDispatchTargets(Program* program) {
+    assert(program != NULL);
+
+#if HAS_COMPUTED_GOTO
+    const void* const* labels = NULL;
+    runThreaded(NULL, NULL, &labels);
+
+    program->targets = realloc(program->targets, program->size * sizeof(void*));
+    assert(program->targets != NULL);
+    for (unsigned int pc = 0; pc < program->size; pc++) {
+        program->targets[pc] = labels[program->code[pc].op];
+    }
+#endif
+}
+
+bool isDispatchModeAvailable(DispatchMode mode) {
+    switch (mode) {
+        case DISPATCH_SWITCH:   return true;
+        case DISPATCH_THREADED: return HAS_COMPUTED_GOTO;
+        default:
+            return false;
+    }
+}
+
+void executeProgram(const Program* program, Frame* frame) {
+    DispatchMode mode = isDispatchModeAvailable(DISPATCH_THREADED) ? DISPATCH_THREADED : DISPATCH_SWITCH;
+    executeProgramWithDispatch(program, frame, mode);
+}
+
+void executeProgramWithDispatch(const Program* program, Frame* frame, DispatchMode mode) {
+    assert(program != NULL && frame != NULL);
+    assert(frame->size >= program->slot_count);
+    assert(isDispatchModeAvailable(mode));
+
+    int* R = malloc(program->register_count * sizeof(int));
+    assert(R != NULL);
+    memcpy(R, frame->values, program->slot_count * sizeof(int));
+
+    switch (mode) {
+        case DISPATCH_SWITCH: {
+            runSwitch(program, R);
+            break;
+        }
+#if HAS_COMPUTED_GOTO
+        case DISPATCH_THREADED: {
+            assert(program->targets != NULL);
+            runThreaded(program, R, NULL);
+            break;
+        }
+#endif
+        default:
+            assert(false);
+    }
+
+    memcpy(frame->values, R, program->slot_count * sizeof(int));
+    free(R);
+
+    endOutputSink(getOutputSink());
+}
@@ -402,6 +402,40 @@ void compileBitwiseAndLogicalOperatorsPrecedence() {
     ASSERT_COMPILE_EXP_EQUALS(ast, &cSerializer, "true^false || true"); // No parentheses required
 }
 
+void compileConsecutiveSigns() {
+    // -(-x) and +(+x) without their parentheses, as the optimizer leaves them, must not become --x and ++x
+    st = newSymbolTableDefault();
+    ASTResult res = defineVar(st, AST_TYPE_INT, "x", false);
+    TEST_ASSERT_TRUE(isOK(res));
+    Symbol* x = res.result_value;
+
+    ast = newASTUSub(newASTUSub(newASTID(x)).result_value).result_value;
+    ASSERT_COMPILE_EXP_EQUALS(ast, &cSerializer, "- -x");
+    deleteASTNode(&ast);
+
+    ast = newASTUAdd(newASTUAdd(newASTID(x)).result_value).result_value;
+    ASSERT_COMPILE_EXP_EQUALS(ast, &cSerializer, "+ +x");
+    deleteASTNode(&ast);
+
+    ast = newASTUSub(newASTInt(-1)).result_value;
+    ASSERT_COMPILE_EXP_EQUALS(ast, &cSerializer, "- -1");
+    deleteASTNode(&ast);
+
+    ast = newASTUSub(newASTUAdd(newASTID(x)).result_value).result_value;
+    ASSERT_COMPILE_EXP_EQUALS(ast, &cSerializer, "-+x"); // No space required
+
+    deleteSymbolTable(&st);
+}
+
+void compileWrappingArithmetic() {
+    ast = newASTWrapMul(newASTInt(2), newASTAdd(newASTInt(1), newASTInt(3)).result_value).result_value;
+    ast = newASTWrapSub(ast, newASTInt(-2)).result_value;
+    ast = newASTMul(ast, newASTInt(5)).result_value;
+    // The signed overflow of C is undefined, so it computes with unsigned ints
+    ASSERT_COMPILE_EXP_EQUALS(ast, &cSerializer, "(int) (((unsigned int) 2 * (unsigned int) (1 + 3)) - (unsigned int) -2)*5");
+    ASSERT_COMPILE_EXP_EQUALS(ast, &javaSerializer, "((2 * (1 + 3)) - -2)*5");
+}
+
 int main() {
     UNITY_BEGIN();
     RUN_TEST(compileAddSequence);
@@ -422,6 +456,8 @@ int main() {
     RUN_TEST(compileLogicalOperators);
     RUN_TEST(compileBitwiseOperatorsOnBools);
     RUN_TEST(compileBitwiseAndLogicalOperatorsPrecedence);
+    RUN_TEST(compileConsecutiveSigns);
+    RUN_TEST(compileWrappingArithmetic);
     return UNITY_END();
 }
 
@@ -1,6 +1,7 @@
 #include <unity.h>
 
 #include "ast/ast.h"
+#include "ast/optimize.h"
 #include "out/out.h"
 
 #include "test_utils.h"
@@ -426,6 +427,27 @@ void compileConditionalCompoundAssignmentLogicalAndInJava() {
     ASSERT_COMPILE_STMT_EQUALS(ast, &javaSerializer, "_tmp_bool = (true ? (n = (true ? n : m) && true) : (m = (true ? n : m) && true));\n");
 }
 
+void compileSharedSlotAsOneLocal() {
+    // { var x = 1; var y = x + 1; print(y); }
+    enterScopeDefault(st);
+    ASTNode* decl_x = newASTIDDeclaration(AST_TYPE_INT, "x", newASTInt(1), false, st).result_value;
+    ASTNode* sum = newASTAdd(newASTID(lookupVar(st, "x")), newASTInt(1)).result_value;
+    ASTNode* decl_y = newASTIDDeclaration(AST_TYPE_INT, "y", sum, false, st).result_value;
+    ast = newASTScope(newASTStatementList(decl_x, newASTStatementList(decl_y, newASTPrint(newASTID(lookupVar(st, "y"))))));
+    leaveScope(st);
+    TEST_ASSERT_TRUE(assignFrameSlots(ast, st));
+
+    char* ptr = NULL;
+    size_t size = 0;
+    IOStream* stream = openIOStreamFromMemmory(&ptr, &size);
+    compileSharedSlots(st, stream, &javaSerializer, 0);
+    IOStreamClose(&stream);
+    TEST_ASSERT_EQUAL_STRING("int _s0 = 0;\n", ptr);
+    free(ptr);
+
+    ASSERT_COMPILE_STMT_EQUALS(ast, &cSerializer, "{\n    _s0 = 1;\n    _s0 = _s0 + 1;\n    printf(\"%d\\n\", _s0);\n}\n");
+}
+
 int main() {
     UNITY_BEGIN();
     RUN_TEST(testVarDeclaration);
@@ -457,5 +479,6 @@ int main() {
     RUN_TEST(compileConditionalCompoundAssignmentAddInJava);
     RUN_TEST(compileConditionalCompoundAssignmentLogicalAndInC);
     RUN_TEST(compileConditionalCompoundAssignmentLogicalAndInJava);
+    RUN_TEST(compileSharedSlotAsOneLocal);
     return UNITY_END();
 }
\ No newline at end of file
@@ -0,0 +1,108 @@
+#include <unity.h>
+
+#include "ast/ast.h"
+#include "out/out.h"
+
+static SymbolTable* st = NULL;
+static ASTNode* ast = NULL;
+static Symbol* a = NULL;
+static Symbol* b = NULL;
+static Symbol* p = NULL;
+
+// More than one chunk, with a partial one at the end
+#define ROW_COUNT 2500
+
+static int a_values[ROW_COUNT];
+static int b_values[ROW_COUNT];
+static int p_values[ROW_COUNT];
+static int out[ROW_COUNT];
+
+void setUp (void) {
+    st = newSymbolTableDefault();
+    a = defineVar(st, AST_TYPE_INT, "a", false).result_value;
+    b = defineVar(st, AST_TYPE_INT, "b", false).result_value;
+    p = defineVar(st, AST_TYPE_BOOL, "p", false).result_value;
+    for (int row = 0; row < ROW_COUNT; row++) {
+        a_values[row] = row % 17 - 8;
+        b_values[row] = row % 5;
+        p_values[row] = row % 3 == 0;
+    }
+    ast = NULL;
+}
+
+void tearDown (void) {
+    deleteASTNode(&ast);
+    deleteSymbolTable(&st);
+}
+
+// Each row gives the same value as the tree walker on a frame that only holds the values of the row
+static void assertMatchesEachRow(const BatchColumn* columns, unsigned int column_count) {
+    evalASTExpressionBatch(ast, st, columns, column_count, ROW_COUNT, out);
+
+    Frame* frame = newFrame(getMaxOffset(st) + 1);
+    for (int row = 0; row < ROW_COUNT; row++) {
+        for (unsigned int i = 0; i < frame->size; i++) {
+            setFrameValue(frame, i, 0);
+        }
+        for (unsigned int c = 0; c < column_count; c++) {
+            setFrameValue(frame, getVarOffset(columns[c].var), columns[c].values[row]);
+        }
+        TEST_ASSERT_EQUAL_INT(evalASTExpression(ast, st, frame), out[row]);
+    }
+    deleteFrame(&frame);
+}
+
+void evalArithmeticOverColumns() {
+    // a * 3 + b / 2
+    ast = newASTAdd(newASTMul(newASTID(a), newASTInt(3)).result_value, newASTDiv(newASTID(b), newASTInt(2)).result_value).result_value;
+    BatchColumn columns[] = { { a, a_values }, { b, b_values } };
+
+    evalASTExpressionBatch(ast, st, columns, 2, ROW_COUNT, out);
+    for (int row = 0; row < ROW_COUNT; row++) {
+        TEST_ASSERT_EQUAL_INT(a_values[row] * 3 + b_values[row] / 2, out[row]);
+    }
+}
+
+void varsWithoutColumnAreZero() {
+    // a - b
+    ast = newASTSub(newASTID(a), newASTID(b)).result_value;
+    BatchColumn columns[] = { { a, a_values } };
+
+    evalASTExpressionBatch(ast, st, columns, 1, ROW_COUNT, out);
+    TEST_ASSERT_EQUAL_INT_ARRAY(a_values, out, ROW_COUNT);
+}
+
+void shortCircuitOnlyAssignsTheRowsItEvaluates() {
+    // p || valueof(a = a + b) > 2 ? a : -a
+    ASTNode* sum = newASTAssignment(newASTID(a), newASTAdd(newASTID(a), newASTID(b)).result_value).result_value;
+    ASTNode* cond = newASTLogicalOr(newASTID(p), newASTCmpGT(sum, newASTInt(2)).result_value).result_value;
+    ast = newASTTernaryCond(cond, newASTID(a), newASTUSub(newASTID(a)).result_value).result_value;
+    BatchColumn columns[] = { { a, a_values }, { b, b_values }, { p, p_values } };
+
+    assertMatchesEachRow(columns, 3);
+    // The columns are only read
+    TEST_ASSERT_EQUAL_INT(-8, a_values[0]);
+    TEST_ASSERT_EQUAL_INT(-7, a_values[1]);
+}
+
+void evalChainedComparisonAndTernaryLVal() {
+    // -2 < a++ < b
+    ASTNode* chain = newASTCmpLT(newASTCmpLT(newASTInt(-2), newASTInc(newASTID(a), false).result_value).result_value, newASTID(b)).result_value;
+    // valueof((a < 0 ? a : b) = a * 2) + a + b
+    ASTNode* lval = newASTParentheses(newASTTernaryCond(newASTCmpLT(newASTID(a), newASTInt(0)).result_value, newASTID(a), newASTID(b)).result_value);
+    ASTNode* assignment = newASTAssignment(lval, newASTMul(newASTID(a), newASTInt(2)).result_value).result_value;
+    ASTNode* sum = newASTAdd(newASTAdd(assignment, newASTID(a)).result_value, newASTID(b)).result_value;
+    ast = newASTTernaryCond(chain, sum, newASTInt(100)).result_value;
+    BatchColumn columns[] = { { a, a_values }, { b, b_values } };
+
+    assertMatchesEachRow(columns, 2);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(evalArithmeticOverColumns);
+    RUN_TEST(varsWithoutColumnAreZero);
+    RUN_TEST(shortCircuitOnlyAssignsTheRowsItEvaluates);
+    RUN_TEST(evalChainedComparisonAndTernaryLVal);
+    return UNITY_END();
+}
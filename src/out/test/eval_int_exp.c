@@ -1,6 +1,7 @@
 #include <unity.h>
 
 #include <assert.h>
+#include <limits.h>
 
 #include "ast/ast.h"
 #include "out/out.h"
@@ -145,6 +146,19 @@ void testBitwiseXOR() {
     TEST_ASSERT_EQUAL_INT(6, result);
 }
 
+void testWrappingArithmetic() {
+    // INT_MIN * 1 - INT_MIN - INT_MIN + 65536 * 65536, which overflows on the way
+    ASTNode* ast = newASTWrapMul(newASTInt(INT_MIN), newASTInt(1)).result_value;
+    ast = newASTWrapSub(ast, newASTInt(INT_MIN)).result_value;
+    ast = newASTWrapSub(ast, newASTInt(INT_MIN)).result_value;
+    ast = newASTWrapAdd(ast, newASTWrapMul(newASTInt(65536), newASTInt(65536)).result_value).result_value;
+
+    int result = evalASTExpression(ast, NULL, NULL);
+    deleteASTNode(&ast);
+
+    TEST_ASSERT_EQUAL_INT(INT_MIN, result);
+}
+
 void testBitwiseNot() {
     ASTNode* ast = newASTBitwiseNot(newASTInt(5)).result_value;
 
@@ -190,6 +204,7 @@ int main() {
     RUN_TEST(testBitwiseAND);
     RUN_TEST(testBitwiseOR);
     RUN_TEST(testBitwiseXOR);
+    RUN_TEST(testWrappingArithmetic);
     RUN_TEST(testBitwiseNot);
     RUN_TEST(testBitwiseShiftLeft);
     RUN_TEST(testBitwiseShiftRight);
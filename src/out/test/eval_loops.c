@@ -3,6 +3,7 @@
 #include <assert.h>
 
 #include "ast/ast.h"
+#include "ast/optimize.h"
 #include "out/out.h"
 
 static SymbolTable* st = NULL;
@@ -12,6 +13,7 @@ static Frame* frame = NULL;
 static unsigned int n_index = 0;
 
 #define ITERATION_COUNT 10
+#define LONG_ITERATION_COUNT 100000
 
 void setUp (void) {
     st = newSymbolTable(2, 2);
@@ -184,6 +186,43 @@ void evalContinueForLoop() {
     TEST_ASSERT_EQUAL_INT(ITERATION_COUNT / 2 - 1, getFrameValue(frame, n_index));
 }
 
+static Frame* newZeroedFrame() {
+    Frame* f = newFrame(getMaxOffset(st) + 1);
+    for (unsigned int i = 0; i < f->size; i++) {
+        setFrameValue(f, i, 0);
+    }
+    setFrameValue(f, n_index, LONG_ITERATION_COUNT);
+    return f;
+}
+
+void evalAccumulationInClosedFormWithoutOverflow() {
+    Symbol* i = defineVar(st, AST_TYPE_INT, "i", false).result_value;
+    Symbol* x = defineVar(st, AST_TYPE_INT, "x", false).result_value;
+
+    // for (i = 0; i < n; i++) { x += i - n / 2; }, whose partial sums stay in range for n == LONG_ITERATION_COUNT
+    // while n * -(n / 2) and n * (n - 1) / 2 do not
+    ASTNode* init = newASTAssignment(newASTID(i), newASTInt(0)).result_value;
+    ASTNode* half = newASTDiv(copyAST(n_node), newASTInt(2)).result_value;
+    ASTNode* body = newASTCompoundAssignment(AST_ADD, newASTID(x), newASTSub(newASTID(i), half).result_value).result_value;
+    ASTNode* cond = newASTCmpLT(newASTID(i), n_node).result_value;
+    ast = newASTFor(init, cond, newASTInc(newASTID(i), false).result_value, newASTScope(body)).result_value;
+
+    ASTNode* closed_form = copyAST(ast);
+    optimizeAST(&closed_form, st, AST_OPT_CONSTANT_FOLDING | AST_OPT_SCALAR_EVOLUTION);
+    TEST_ASSERT_FALSE(equalAST(ast, closed_form));
+
+    Frame* reference = newZeroedFrame();
+    executeASTStatements(ast, st, reference);
+    frame = newZeroedFrame();
+    executeASTStatements(closed_form, st, frame);
+    deleteASTNode(&closed_form);
+
+    TEST_ASSERT_EQUAL_INT(-LONG_ITERATION_COUNT / 2, getFrameValue(reference, getVarOffset(x)));
+    TEST_ASSERT_EQUAL_INT(getFrameValue(reference, getVarOffset(x)), getFrameValue(frame, getVarOffset(x)));
+    TEST_ASSERT_EQUAL_INT(getFrameValue(reference, getVarOffset(i)), getFrameValue(frame, getVarOffset(i)));
+    deleteFrame(&reference);
+}
+
 int main() {
     UNITY_BEGIN();
     RUN_TEST(evalWhileLoopWithFalseConditionExecutesZeroTimes);
@@ -197,5 +236,6 @@ int main() {
     RUN_TEST(evalContinueWhileLoop);
     RUN_TEST(evalBreakForLoop);
     RUN_TEST(evalContinueForLoop);
+    RUN_TEST(evalAccumulationInClosedFormWithoutOverflow);
     return UNITY_END();
 }
\ No newline at end of file
@@ -0,0 +1,244 @@
+#include <unity.h>
+
+#include <assert.h>
+
+#include "ast/ast.h"
+#include "out/out.h"
+
+static SymbolTable* st = NULL;
+static ASTNode* ast = NULL;
+static Frame* frame = NULL;
+static Symbol* x = NULL;
+static Symbol* y = NULL;
+static Symbol* z = NULL;
+
+#define ITERATION_COUNT 10
+
+void setUp (void) {
+    st = newSymbolTableDefault();
+    x = defineVar(st, AST_TYPE_INT, "x", false).result_value;
+    y = defineVar(st, AST_TYPE_INT, "y", false).result_value;
+    z = defineVar(st, AST_TYPE_BOOL, "z", false).result_value;
+}
+
+void tearDown (void) {
+    if (frame != NULL) {
+        deleteFrame(&frame);
+    }
+    deleteASTNode(&ast);
+    deleteSymbolTable(&st);
+}
+
+static Frame* newZeroedFrame() {
+    Frame* f = newFrame(getMaxOffset(st) + 1);
+    for (unsigned int i = 0; i < f->size; i++) {
+        setFrameValue(f, i, 0);
+    }
+    return f;
+}
+
+// Executes the AST with the tree walker and with every dispatch mode of the bytecode VM and checks that the resulting frames match
+void execAST() {
+    assert(ast != NULL);
+
+    Frame* reference = newZeroedFrame();
+    executeASTStatements(ast, st, reference);
+
+    Program* program = newProgramFromAST(ast, st);
+    for (DispatchMode mode = 0; mode < DISPATCH_MODES_COUNT; mode++) {
+        if (!isDispatchModeAvailable(mode)) {
+            continue;
+        }
+
+        if (frame != NULL) {
+            deleteFrame(&frame);
+        }
+        frame = newZeroedFrame();
+        executeProgramWithDispatch(program, frame, mode);
+
+        TEST_ASSERT_EQUAL_INT_ARRAY(reference->values, frame->values, frame->size);
+    }
+    deleteProgram(&program);
+
+    deleteFrame(&reference);
+}
+
+#define value(var) getFrameValue(frame, getVarOffset(var))
+
+void execArithmeticExpression() {
+    ASTNode* exp = newASTMul(newASTAdd(newASTInt(2), newASTInt(3)).result_value, newASTUSub(newASTInt(4)).result_value).result_value;
+    ast = newASTAssignment(newASTID(x), exp).result_value;
+
+    execAST();
+
+    TEST_ASSERT_EQUAL_INT(-20, value(x));
+}
+
+void execOperandIsReadBeforeAssignmentInRightOperand() {
+    ASTNode* init = newASTAssignment(newASTID(x), newASTInt(1)).result_value;
+    ASTNode* exp = newASTAdd(newASTID(x), newASTAssignment(newASTID(x), newASTInt(5)).result_value).result_value;
+    ast = newASTStatementList(init, newASTAssignment(newASTID(y), exp).result_value);
+
+    execAST();
+
+    TEST_ASSERT_EQUAL_INT(6, value(y));
+    TEST_ASSERT_EQUAL_INT(5, value(x));
+}
+
+void execPostfixIncrementReturnsPreviousValue() {
+    ASTNode* init = newASTAssignment(newASTID(x), newASTInt(3)).result_value;
+    ASTNode* inc = newASTInc(newASTID(x), false).result_value;
+    ast = newASTStatementList(init, newASTAssignment(newASTID(y), inc).result_value);
+
+    execAST();
+
+    TEST_ASSERT_EQUAL_INT(3, value(y));
+    TEST_ASSERT_EQUAL_INT(4, value(x));
+}
+
+void execChainedCmpWithSideEffects() {
+    // z = 1 < (x = 2) < (y = 3)
+    ASTNode* cmp = newASTCmpLT(newASTInt(1), newASTParentheses(newASTAssignment(newASTID(x), newASTInt(2)).result_value)).result_value;
+    cmp = newASTCmpLT(cmp, newASTParentheses(newASTAssignment(newASTID(y), newASTInt(3)).result_value)).result_value;
+    ast = newASTAssignment(newASTID(z), cmp).result_value;
+
+    execAST();
+
+    TEST_ASSERT_TRUE(value(z));
+    TEST_ASSERT_EQUAL_INT(3, value(y));
+}
+
+void execChainedCmpShortCircuits() {
+    // z = 3 < (x = 2) < (y = 3)
+    ASTNode* cmp = newASTCmpLT(newASTInt(3), newASTParentheses(newASTAssignment(newASTID(x), newASTInt(2)).result_value)).result_value;
+    cmp = newASTCmpLT(cmp, newASTParentheses(newASTAssignment(newASTID(y), newASTInt(3)).result_value)).result_value;
+    ast = newASTAssignment(newASTID(z), cmp).result_value;
+
+    execAST();
+
+    TEST_ASSERT_FALSE(value(z));
+    TEST_ASSERT_EQUAL_INT(0, value(y));
+}
+
+void execAssignmentToTernaryLVal() {
+    // (z ? x : y) = 7
+    ASTNode* lval = newASTParentheses(newASTTernaryCond(newASTID(z), newASTID(x), newASTID(y)).result_value);
+    ast = newASTAssignment(lval, newASTInt(7)).result_value;
+
+    execAST();
+
+    TEST_ASSERT_EQUAL_INT(0, value(x));
+    TEST_ASSERT_EQUAL_INT(7, value(y));
+}
+
+void execLogicalShortCircuits() {
+    // z = false && (x = 1); z = true || (y = 1)
+    ASTNode* a = newASTLogicalAnd(newASTBool(false), newASTParentheses(newASTAssignment(newASTID(x), newASTInt(1)).result_value)).result_value;
+    ASTNode* o = newASTLogicalOr(newASTBool(true), newASTParentheses(newASTAssignment(newASTID(y), newASTInt(1)).result_value)).result_value;
+    ast = newASTStatementList(newASTAssignment(newASTID(z), a).result_value, newASTAssignment(newASTID(z), o).result_value);
+
+    execAST();
+
+    TEST_ASSERT_EQUAL_INT(0, value(x));
+    TEST_ASSERT_EQUAL_INT(0, value(y));
+    TEST_ASSERT_TRUE(value(z));
+}
+
+void execNestedLoopsWithBreakAndContinue() {
+    // while (x < 10) { x++; if (x % 2 == 0) continue; do { y++; if (y > 20) break; } while (true); }
+    ASTNode* inner_body = newASTStatementList(newASTInc(newASTID(y), false).result_value,
+        newASTIf(newASTCmpGT(newASTID(y), newASTInt(20)).result_value, newASTBreak()).result_value);
+    ASTNode* inner = newASTDoWhile(newASTScope(inner_body), newASTBool(true)).result_value;
+
+    ASTNode* even = newASTCmpEQ(newASTMod(newASTID(x), newASTInt(2)).result_value, newASTInt(0)).result_value;
+    ASTNode* body = newASTStatementList(newASTIf(even, newASTContinue()).result_value, inner);
+    body = newASTStatementList(newASTInc(newASTID(x), false).result_value, body);
+
+    ast = newASTWhile(newASTCmpLT(newASTID(x), newASTInt(ITERATION_COUNT)).result_value, newASTScope(body)).result_value;
+
+    execAST();
+
+    TEST_ASSERT_EQUAL_INT(ITERATION_COUNT, value(x));
+    TEST_ASSERT_EQUAL_INT(25, value(y));
+}
+
+void execTopLevelBreakStopsExecution() {
+    ASTNode* stmts = newASTStatementList(newASTBreak(), newASTAssignment(newASTID(y), newASTInt(2)).result_value);
+    ast = newASTStatementList(newASTAssignment(newASTID(x), newASTInt(1)).result_value, stmts);
+
+    execAST();
+
+    TEST_ASSERT_EQUAL_INT(1, value(x));
+    TEST_ASSERT_EQUAL_INT(0, value(y));
+}
+
+void loweringUsesFrameSlotsAsRegisters() {
+    ast = newASTAssignment(newASTID(x), newASTAdd(newASTID(x), newASTID(y)).result_value).result_value;
+
+    Program* program = newProgramFromAST(ast, st);
+
+    // The sum is written directly into the slot of x
+    TEST_ASSERT_EQUAL_UINT(2, getProgramSize(program));
+    TEST_ASSERT_EQUAL_UINT(getMaxOffset(st) + 2, getProgramRegisterCount(program));
+
+    deleteProgram(&program);
+}
+
+void execCmpWithConstants() {
+    // x = 5; z = 3 < x; if (x - 5 == 0) { y = 7 > x ? 1 : 2 } else { y = 3 }
+    ASTNode* init = newASTAssignment(newASTID(x), newASTInt(5)).result_value;
+    ASTNode* cmp = newASTAssignment(newASTID(z), newASTCmpLT(newASTInt(3), newASTID(x)).result_value).result_value;
+    ASTNode* cond = newASTCmpEQ(newASTSub(newASTID(x), newASTInt(5)).result_value, newASTInt(0)).result_value;
+    ASTNode* ternary = newASTTernaryCond(newASTCmpGT(newASTInt(7), newASTID(x)).result_value, newASTInt(1), newASTInt(2)).result_value;
+    ASTNode* then = newASTScope(newASTAssignment(newASTID(y), ternary).result_value);
+    ASTNode* otherwise = newASTScope(newASTAssignment(newASTID(y), newASTInt(3)).result_value);
+    ast = newASTStatementList(init, newASTStatementList(cmp, newASTIfElse(cond, then, otherwise).result_value));
+
+    execAST();
+
+    TEST_ASSERT_TRUE(value(z));
+    TEST_ASSERT_EQUAL_INT(1, value(y));
+}
+
+void loweringAddsConstantsInline() {
+    // x = x - 1
+    ast = newASTAssignment(newASTID(x), newASTSub(newASTID(x), newASTInt(1)).result_value).result_value;
+
+    Program* program = newProgramFromAST(ast, st);
+
+    // ADDK into the slot of x and HALT
+    TEST_ASSERT_EQUAL_UINT(2, getProgramSize(program));
+
+    deleteProgram(&program);
+}
+
+void loweringFusesCmpIntoBranch() {
+    // while (x < 10) { x = x + 1 }
+    ASTNode* body = newASTScope(newASTAssignment(newASTID(x), newASTAdd(newASTID(x), newASTInt(1)).result_value).result_value);
+    ast = newASTWhile(newASTCmpLT(newASTID(x), newASTInt(ITERATION_COUNT)).result_value, body).result_value;
+
+    Program* program = newProgramFromAST(ast, st);
+
+    // JMP to the condition, ADDK, the comparison jumping back to the body and HALT
+    TEST_ASSERT_EQUAL_UINT(4, getProgramSize(program));
+
+    deleteProgram(&program);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(execArithmeticExpression);
+    RUN_TEST(execOperandIsReadBeforeAssignmentInRightOperand);
+    RUN_TEST(execPostfixIncrementReturnsPreviousValue);
+    RUN_TEST(execChainedCmpWithSideEffects);
+    RUN_TEST(execChainedCmpShortCircuits);
+    RUN_TEST(execAssignmentToTernaryLVal);
+    RUN_TEST(execLogicalShortCircuits);
+    RUN_TEST(execNestedLoopsWithBreakAndContinue);
+    RUN_TEST(execTopLevelBreakStopsExecution);
+    RUN_TEST(loweringUsesFrameSlotsAsRegisters);
+    RUN_TEST(execCmpWithConstants);
+    RUN_TEST(loweringAddsConstantsInline);
+    RUN_TEST(loweringFusesCmpIntoBranch);
+    return UNITY_END();
+}
@@ -0,0 +1,91 @@
+#include <unity.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "ast/ast.h"
+#include "out/out.h"
+
+static SymbolTable* st = NULL;
+static ASTNode* ast = NULL;
+static Symbol* x = NULL;
+
+#define ITERATION_COUNT 10
+
+void setUp (void) {
+    st = newSymbolTableDefault();
+    x = defineVar(st, AST_TYPE_INT, "x", false).result_value;
+    resetEvalHistogram();
+}
+
+void tearDown (void) {
+    if (ast != NULL) {
+        deleteASTNode(&ast);
+    }
+    deleteSymbolTable(&st);
+}
+
+#define SKIP_WITHOUT_HISTOGRAM() if (!isEvalHistogramEnabled()) { TEST_IGNORE_MESSAGE("Built without OUT_HISTOGRAM"); }
+
+// while (x < ITERATION_COUNT) { x++ }
+static void executeLoop() {
+    ASTNode* inc = newASTInc(newASTID(x), false).result_value;
+    ast = newASTWhile(newASTCmpLT(newASTID(x), newASTInt(ITERATION_COUNT)).result_value, newASTScope(inc)).result_value;
+
+    Frame* frame = newFrame(getMaxOffset(st) + 1);
+    for (unsigned int i = 0; i < frame->size; i++) {
+        setFrameValue(frame, i, 0);
+    }
+    executeASTStatements(ast, st, frame);
+    deleteFrame(&frame);
+}
+
+void countsNodesAndPairs() {
+    SKIP_WITHOUT_HISTOGRAM();
+    executeLoop();
+
+    const EvalHistogram* h = getEvalHistogram();
+    TEST_ASSERT_EQUAL_UINT(1, h->nodes[AST_WHILE]);
+    TEST_ASSERT_EQUAL_UINT(ITERATION_COUNT + 1, h->nodes[AST_CMP_LT]);
+    TEST_ASSERT_EQUAL_UINT(ITERATION_COUNT, h->nodes[AST_INC]);
+    TEST_ASSERT_EQUAL_UINT(1, h->pairs[AST_NODE_TYPES_COUNT][AST_WHILE]);
+    TEST_ASSERT_EQUAL_UINT(ITERATION_COUNT + 1, h->pairs[AST_WHILE][AST_CMP_LT]);
+    TEST_ASSERT_EQUAL_UINT(ITERATION_COUNT + 1, h->pairs[AST_CMP_LT][AST_INT]);
+    TEST_ASSERT_EQUAL_UINT(ITERATION_COUNT + 1, h->pairs[AST_CMP_LT][AST_ID]);
+}
+
+void resetClearsTheCounters() {
+    SKIP_WITHOUT_HISTOGRAM();
+    executeLoop();
+    resetEvalHistogram();
+
+    const EvalHistogram* h = getEvalHistogram();
+    for (unsigned int i = 0; i < AST_NODE_TYPES_COUNT; i++) {
+        TEST_ASSERT_EQUAL_UINT(0, h->nodes[i]);
+    }
+}
+
+void dumpsCSV() {
+    SKIP_WITHOUT_HISTOGRAM();
+    executeLoop();
+
+    char* buffer = NULL;
+    size_t size = 0;
+    IOStream* stream = openIOStreamFromMemmory(&buffer, &size);
+    dumpEvalHistogram(stream);
+    IOStreamClose(&stream);
+
+    TEST_ASSERT_EQUAL_INT(0, strncmp(buffer, HISTOGRAM_CSV_HEADER "\n", strlen(HISTOGRAM_CSV_HEADER) + 1));
+    TEST_ASSERT_NOT_NULL(strstr(buffer, "node,,AST_WHILE,1\n"));
+    TEST_ASSERT_NOT_NULL(strstr(buffer, "pair,,AST_WHILE,1\n"));
+    TEST_ASSERT_NOT_NULL(strstr(buffer, "pair,AST_WHILE,AST_CMP_LT,11\n"));
+    free(buffer);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(countsNodesAndPairs);
+    RUN_TEST(resetClearsTheCounters);
+    RUN_TEST(dumpsCSV);
+    return UNITY_END();
+}
@@ -0,0 +1,110 @@
+#include <unity.h>
+
+#include "ast/ast.h"
+#include "ast/arena.h"
+#include "out/out.h"
+
+static SymbolTable* st = NULL;
+static ASTArena* arena = NULL;
+static Frame* frame = NULL;
+static Symbol* n = NULL;
+static Symbol* i = NULL;
+
+// Deep enough to overflow the call stack of the recursive tree walker
+#define DEEP_SIZE 500000
+#define ITERATION_COUNT 10
+
+void setUp (void) {
+    st = newSymbolTableDefault();
+    n = defineVar(st, AST_TYPE_INT, "n", false).result_value;
+    i = defineVar(st, AST_TYPE_INT, "i", false).result_value;
+    // The nodes are released all at once, as deleteASTNode also recurses
+    arena = newASTArenaDefault();
+    setCurrentASTArena(arena);
+    frame = newFrame(getMaxOffset(st) + 1);
+    for (unsigned int k = 0; k < frame->size; k++) {
+        setFrameValue(frame, k, 0);
+    }
+}
+
+void tearDown (void) {
+    setCurrentASTArena(NULL);
+    deleteASTArena(&arena);
+    deleteFrame(&frame);
+    deleteSymbolTable(&st);
+}
+
+static ASTNode* assign(Symbol* var, ASTNode* exp) {
+    return newASTAssignment(newASTID(var), exp).result_value;
+}
+
+void evalDeepExpression() {
+    // 1 + 1 + ... + 1
+    ASTNode* exp = newASTInt(1);
+    for (unsigned int k = 1; k < DEEP_SIZE; k++) {
+        exp = newASTAdd(exp, newASTInt(1)).result_value;
+    }
+
+    TEST_ASSERT_EQUAL_INT(DEEP_SIZE, evalASTExpressionIterative(exp, st, frame));
+}
+
+void breakFromDeeplyNestedStatements() {
+    // while (true) { if (true) { { ... { n++; break; } ... } } } n += 10
+    ASTNode* body = newASTStatementList(newASTInc(newASTID(n), false).result_value, newASTBreak());
+    for (unsigned int k = 0; k < DEEP_SIZE; k++) {
+        body = k % 2 == 0 ? newASTScope(body) : newASTIf(newASTBool(true), body).result_value;
+    }
+    ASTNode* loop = newASTWhile(newASTBool(true), newASTScope(body)).result_value;
+    ASTNode* ast = newASTStatementList(loop, assign(n, newASTAdd(newASTID(n), newASTInt(10)).result_value));
+
+    EvalStatus s = executeASTIterative(ast, st, frame);
+    TEST_ASSERT_FALSE(s.status);
+    TEST_ASSERT_EQUAL_INT(11, getFrameValue(frame, getVarOffset(n)));
+}
+
+// for (i = 0; i < ITERATION_COUNT; i++) { if (i % 2 == 0) { continue; } do { n++; if (n > 3 * i) { break; } } while (true); }
+static ASTNode* newNestedLoopsAST() {
+    ASTNode* skip = newASTIf(newASTCmpEQ(newASTMod(newASTID(i), newASTInt(2)).result_value, newASTInt(0)).result_value, newASTScope(newASTContinue())).result_value;
+    ASTNode* exit = newASTIf(newASTCmpGT(newASTID(n), newASTMul(newASTInt(3), newASTID(i)).result_value).result_value, newASTScope(newASTBreak())).result_value;
+    ASTNode* inner = newASTDoWhile(newASTScope(newASTStatementList(newASTInc(newASTID(n), false).result_value, exit)), newASTBool(true)).result_value;
+    ASTNode* cond = newASTCmpLT(newASTID(i), newASTInt(ITERATION_COUNT)).result_value;
+    return newASTFor(assign(i, newASTInt(0)), cond, newASTInc(newASTID(i), false).result_value, newASTScope(newASTStatementList(skip, inner))).result_value;
+}
+
+void nestedLoopsMatchTheTreeWalker() {
+    ASTNode* ast = newNestedLoopsAST();
+
+    Frame* reference = newFrame(frame->size);
+    for (unsigned int k = 0; k < frame->size; k++) {
+        setFrameValue(reference, k, 0);
+    }
+    executeASTStatements(ast, st, reference);
+    executeASTIterative(ast, st, frame);
+
+    TEST_ASSERT_EQUAL_INT(ITERATION_COUNT, getFrameValue(frame, getVarOffset(i)));
+    TEST_ASSERT_EQUAL_INT_ARRAY(reference->values, frame->values, frame->size);
+    deleteFrame(&reference);
+}
+
+void evalChainedComparisonAndTernaryLVal() {
+    // 1 < 2 < n++ is false and does not increment n after the first comparison that fails
+    ASTNode* chain = newASTCmpLT(newASTCmpLT(newASTInt(3), newASTInt(2)).result_value, newASTInc(newASTID(n), false).result_value).result_value;
+    TEST_ASSERT_EQUAL_INT(0, evalASTExpressionIterative(chain, st, frame));
+    TEST_ASSERT_EQUAL_INT(0, getFrameValue(frame, getVarOffset(n)));
+
+    // (n == 0 ? i : n) = 5
+    ASTNode* lval = newASTTernaryCond(newASTCmpEQ(newASTID(n), newASTInt(0)).result_value, newASTID(i), newASTID(n)).result_value;
+    ASTNode* ast = newASTAssignment(newASTParentheses(lval), newASTInt(5)).result_value;
+    TEST_ASSERT_EQUAL_INT(5, evalASTExpressionIterative(ast, st, frame));
+    TEST_ASSERT_EQUAL_INT(5, getFrameValue(frame, getVarOffset(i)));
+    TEST_ASSERT_EQUAL_INT(0, getFrameValue(frame, getVarOffset(n)));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(evalDeepExpression);
+    RUN_TEST(breakFromDeeplyNestedStatements);
+    RUN_TEST(nestedLoopsMatchTheTreeWalker);
+    RUN_TEST(evalChainedComparisonAndTernaryLVal);
+    return UNITY_END();
+}
@@ -0,0 +1,186 @@
+#include <unity.h>
+
+#include <stdio.h>
+#include <limits.h>
+#include <assert.h>
+
+#include "ast/ast.h"
+#include "out/out.h"
+
+static SymbolTable* st = NULL;
+static ASTNode* ast = NULL;
+static Frame* frame = NULL;
+static Symbol* x = NULL;
+static Symbol* y = NULL;
+static Symbol* z = NULL;
+
+#define ITERATION_COUNT 1000
+#define LARGE_VAR_COUNT 100
+#define READ_BUFFER_SIZE 256
+
+void setUp (void) {
+    st = newSymbolTableDefault();
+    x = defineVar(st, AST_TYPE_INT, "x", false).result_value;
+    y = defineVar(st, AST_TYPE_INT, "y", false).result_value;
+    z = defineVar(st, AST_TYPE_BOOL, "z", false).result_value;
+}
+
+void tearDown (void) {
+    if (frame != NULL) {
+        deleteFrame(&frame);
+    }
+    deleteASTNode(&ast);
+    deleteSymbolTable(&st);
+}
+
+static Frame* newZeroedFrame() {
+    Frame* f = newFrame(getMaxOffset(st) + 1);
+    for (unsigned int i = 0; i < f->size; i++) {
+        setFrameValue(f, i, 0);
+    }
+    return f;
+}
+
+// Executes the AST with the tree walker and with the JIT and checks that the resulting frames match
+void execAST() {
+    assert(ast != NULL);
+
+    if (!isJITAvailable()) {
+        TEST_IGNORE_MESSAGE("The JIT is not available on this platform");
+    }
+
+    Frame* reference = newZeroedFrame();
+    executeASTStatements(ast, st, reference);
+
+    Program* program = newProgramFromAST(ast, st);
+    JITCode* jit = newJITCodeFromProgram(program);
+    TEST_ASSERT_NOT_NULL(jit);
+
+    frame = newZeroedFrame();
+    executeJITCode(jit, frame);
+    TEST_ASSERT_EQUAL_INT_ARRAY(reference->values, frame->values, frame->size);
+
+    deleteJITCode(&jit);
+    deleteProgram(&program);
+    deleteFrame(&reference);
+}
+
+#define value(var) getFrameValue(frame, getVarOffset(var))
+
+static ASTNode* assign(Symbol* var, ASTNode* exp) {
+    return newASTAssignment(newASTID(var), exp).result_value;
+}
+
+void execArithmeticOperators() {
+    // x = 7; y = -3; x = ((x * y) / 2 - x % 4) ^ (y << 3) | (x >> 1) & ~y
+    ASTNode* mul = newASTMul(newASTID(x), newASTID(y)).result_value;
+    ASTNode* sub = newASTSub(newASTDiv(mul, newASTInt(2)).result_value, newASTMod(newASTID(x), newASTInt(4)).result_value).result_value;
+    ASTNode* xor = newASTBitwiseXor(newASTParentheses(sub), newASTLeftShift(newASTID(y), newASTInt(3)).result_value).result_value;
+    ASTNode* and = newASTBitwiseAnd(newASTRightShift(newASTID(x), newASTInt(1)).result_value, newASTBitwiseNot(newASTID(y)).result_value).result_value;
+    ASTNode* stmts = newASTStatementList(assign(y, newASTInt(-3)), assign(x, newASTBitwiseOr(xor, and).result_value));
+    ast = newASTStatementList(assign(x, newASTInt(7)), stmts);
+
+    execAST();
+
+    TEST_ASSERT_EQUAL_INT((((7 * -3) / 2 - 7 % 4) ^ (-3 * 8)) | ((7 >> 1) & ~(-3)), value(x));
+}
+
+void execUnaryOperators() {
+    // x = INT_MIN + 1; y = -x; z = !z; x = |x|; y = +-(y) + --(y)
+    ASTNode* abs = newASTAbs(newASTID(x)).result_value;
+    ASTNode* sum = newASTAdd(newASTSetPositive(newASTID(y)).result_value, newASTSetNegative(newASTID(y)).result_value).result_value;
+    ASTNode* stmts = newASTStatementList(assign(z, newASTLogicalNot(newASTID(z)).result_value), newASTStatementList(assign(x, abs), assign(y, sum)));
+    stmts = newASTStatementList(assign(y, newASTUSub(newASTID(x)).result_value), stmts);
+    ast = newASTStatementList(assign(x, newASTInt(INT_MIN + 1)), stmts);
+
+    execAST();
+
+    TEST_ASSERT_EQUAL_INT(INT_MAX, value(x));
+    TEST_ASSERT_EQUAL_INT(0, value(y));
+    TEST_ASSERT_TRUE(value(z));
+}
+
+void execCmpsAndBranches() {
+    // x = 5; z = 3 < x <= 5; if (x != 5) { y = 1 } else { y = x >= 6 ? 2 : 3 }
+    ASTNode* chained = newASTCmpLTE(newASTCmpLT(newASTInt(3), newASTID(x)).result_value, newASTInt(5)).result_value;
+    ASTNode* ternary = newASTTernaryCond(newASTCmpGTE(newASTID(x), newASTInt(6)).result_value, newASTInt(2), newASTInt(3)).result_value;
+    ASTNode* cond = newASTIfElse(newASTCmpNEQ(newASTID(x), newASTInt(5)).result_value, newASTScope(assign(y, newASTInt(1))), newASTScope(assign(y, ternary))).result_value;
+    ast = newASTStatementList(assign(x, newASTInt(5)), newASTStatementList(assign(z, chained), cond));
+
+    execAST();
+
+    TEST_ASSERT_TRUE(value(z));
+    TEST_ASSERT_EQUAL_INT(3, value(y));
+}
+
+void execNestedLoopsWithBreakAndContinue() {
+    // while (x < ITERATION_COUNT) { x++; if (x % 2 == 0) continue; do { y++; if (y > 2 * x) break; } while (true); }
+    ASTNode* limit = newASTMul(newASTInt(2), newASTID(x)).result_value;
+    ASTNode* inner_body = newASTStatementList(newASTInc(newASTID(y), false).result_value,
+        newASTIf(newASTCmpGT(newASTID(y), limit).result_value, newASTBreak()).result_value);
+    ASTNode* inner = newASTDoWhile(newASTScope(inner_body), newASTBool(true)).result_value;
+
+    ASTNode* even = newASTCmpEQ(newASTMod(newASTID(x), newASTInt(2)).result_value, newASTInt(0)).result_value;
+    ASTNode* body = newASTStatementList(newASTIf(even, newASTContinue()).result_value, inner);
+    body = newASTStatementList(newASTInc(newASTID(x), false).result_value, body);
+
+    ast = newASTWhile(newASTCmpLT(newASTID(x), newASTInt(ITERATION_COUNT)).result_value, newASTScope(body)).result_value;
+
+    execAST();
+
+    TEST_ASSERT_EQUAL_INT(ITERATION_COUNT, value(x));
+    TEST_ASSERT_EQUAL_INT(2 * (ITERATION_COUNT - 1) + 1, value(y));
+}
+
+void execManyVarsUsesLongDisplacements() {
+    // v0 = 1; v1 = v0 + 1; ... x = v99
+    char id[MAX_ID_SIZE];
+    Symbol* prev = x;
+    ast = assign(x, newASTInt(1));
+    for (int i = 0; i < LARGE_VAR_COUNT; i++) {
+        sprintf(id, "v%d", i);
+        Symbol* var = defineVar(st, AST_TYPE_INT, id, false).result_value;
+        ast = newASTStatementList(ast, assign(var, newASTAdd(newASTID(prev), newASTID(x)).result_value));
+        prev = var;
+    }
+    ast = newASTStatementList(ast, assign(y, newASTID(prev)));
+
+    execAST();
+
+    TEST_ASSERT_EQUAL_INT(LARGE_VAR_COUNT + 1, value(y));
+}
+
+void execPrintsToCurrentSink() {
+    FILE* file = tmpfile();
+    TEST_ASSERT_NOT_NULL(file);
+    OutputSink* sink = newOutputSinkDefault(file, FLUSH_FULL);
+    OutputSink* previous = setOutputSink(sink);
+
+    ASTNode* print_var = newASTPrintVar(newASTID(x));
+    ast = newASTStatementList(assign(x, newASTInt(-7)), newASTStatementList(newASTPrint(newASTBool(true)), print_var));
+
+    // Goes through the bytecode where the JIT is not available
+    frame = executeASTWithMode(ast, st, EXEC_MODE_JIT);
+
+    setOutputSink(previous);
+    deleteOutputSink(&sink);
+
+    char buffer[READ_BUFFER_SIZE];
+    rewind(file);
+    size_t n = fread(buffer, 1, READ_BUFFER_SIZE - 1, file);
+    buffer[n] = '\0';
+    fclose(file);
+
+    TEST_ASSERT_EQUAL_STRING("true\nint x = -7\n", buffer);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(execArithmeticOperators);
+    RUN_TEST(execUnaryOperators);
+    RUN_TEST(execCmpsAndBranches);
+    RUN_TEST(execNestedLoopsWithBreakAndContinue);
+    RUN_TEST(execManyVarsUsesLongDisplacements);
+    RUN_TEST(execPrintsToCurrentSink);
+    return UNITY_END();
+}
@@ -0,0 +1,232 @@
+#include <unity.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <limits.h>
+
+#include "ast/ast.h"
+#include "out/out.h"
+
+#include "test_utils.h"
+
+static SymbolTable* st = NULL;
+static ASTNode* ast = NULL;
+static Frame* frame = NULL;
+static Library* library = NULL;
+static Symbol* x = NULL;
+static Symbol* y = NULL;
+static Symbol* z = NULL;
+
+#define ITERATION_COUNT 1000
+#define READ_BUFFER_SIZE 256
+#define SRC_PATH "test_exec_library.c.tmp"
+#define LIB_PATH "./test_exec_library.so.tmp"
+// Signed overflow traps, as the library has to wrap around by itself
+#define COMPILE_CMD "${CC:-cc} -O2 -ftrapv -fPIC -shared -w -x c -o " LIB_PATH " " SRC_PATH " 2> /dev/null"
+
+void setUp (void) {
+    st = newSymbolTableDefault();
+    x = defineVar(st, AST_TYPE_INT, "x", false).result_value;
+    y = defineVar(st, AST_TYPE_INT, "y", false).result_value;
+    z = defineVar(st, AST_TYPE_BOOL, "z", false).result_value;
+}
+
+void tearDown (void) {
+    if (library != NULL) {
+        closeLibrary(&library);
+    }
+    if (frame != NULL) {
+        deleteFrame(&frame);
+    }
+    if (ast != NULL) {
+        deleteASTNode(&ast);
+    }
+    deleteSymbolTable(&st);
+    remove(SRC_PATH);
+    remove(LIB_PATH);
+}
+
+static Frame* newZeroedFrame(unsigned int size) {
+    Frame* f = newFrame(size);
+    for (unsigned int i = 0; i < f->size; i++) {
+        setFrameValue(f, i, 0);
+    }
+    return f;
+}
+
+// Compiles the AST into a shared library with the system C compiler and loads it
+static void loadAST() {
+    assert(ast != NULL);
+
+    FILE* file = fopen(SRC_PATH, "w");
+    TEST_ASSERT_NOT_NULL(file);
+    IOStream* stream = openIOStreamFromFile(file);
+    TEST_ASSERT_TRUE(outCompileToCLibrary(ast, st, "test", stream));
+    IOStreamClose(&stream);
+
+    if (system(COMPILE_CMD) != 0) {
+        TEST_IGNORE_MESSAGE("There is no C compiler to build the library");
+    }
+
+    library = openLibrary(LIB_PATH);
+    TEST_ASSERT_NOT_NULL(library);
+}
+
+// Executes the AST with the tree walker and as a library and checks that the resulting frames match
+void execAST() {
+    loadAST();
+    TEST_ASSERT_EQUAL_UINT(getMaxOffset(st) + 1, getLibraryFrameSize(library));
+
+    Frame* reference = newZeroedFrame(getMaxOffset(st) + 1);
+    executeASTStatements(ast, st, reference);
+
+    frame = newZeroedFrame(getLibraryFrameSize(library));
+    executeLibraryWithFrame(library, frame);
+    TEST_ASSERT_EQUAL_INT_ARRAY(reference->values, frame->values, frame->size);
+
+    deleteFrame(&reference);
+}
+
+#define value(var) getFrameValue(frame, getVarOffset(var))
+
+static ASTNode* assign(Symbol* var, ASTNode* exp) {
+    return newASTAssignment(newASTID(var), exp).result_value;
+}
+
+void compileVarsAsFrameSlots() {
+    // var t = x + 1; t += y; printvar(t); var u
+    ASTNode* decl = newASTIDDeclaration(AST_TYPE_INT, "t", newASTAdd(newASTID(x), newASTInt(1)).result_value, false, st).result_value;
+    Symbol* t = getVarReference(st, "t").result_value;
+    ASTNode* compd = newASTCompoundAssignment(AST_ADD, newASTID(t), newASTID(y)).result_value;
+    ASTNode* empty = newASTIDDeclaration(AST_TYPE_INT, "u", NULL, false, st).result_value;
+    ast = newASTStatementList(decl, newASTStatementList(compd, newASTStatementList(newASTPrintVar(newASTID(t)), empty)));
+
+    const char* str = "_frame[3] = (int) ((unsigned int) _frame[0] + (unsigned int) 1);\n"
+        "_frame[3] = (int) ((unsigned int) _frame[3] + (unsigned int) _frame[1]);\n"
+        "_print(\"int t = %d\\n\", _frame[3]);\n;\n";
+    ASSERT_COMPILE_STMT_EQUALS(ast, &cLibrarySerializer, str);
+}
+
+void execScopedAndShadowedVars() {
+    // x = 5; { var x = 7; y = x; var w = x * 2; }; z = x == 5
+    ASTNode* outer = assign(x, newASTInt(5));
+    enterScopeDefault(st);
+    ASTNode* inner_x = newASTIDDeclaration(AST_TYPE_INT, "x", newASTInt(7), true, st).result_value;
+    Symbol* shadow = getVarReference(st, "x").result_value;
+    ASTNode* w = newASTIDDeclaration(AST_TYPE_INT, "w", newASTMul(newASTID(shadow), newASTInt(2)).result_value, false, st).result_value;
+    ASTNode* scope = newASTScope(newASTStatementList(inner_x, newASTStatementList(assign(y, newASTID(shadow)), w)));
+    leaveScope(st);
+    ast = newASTStatementList(outer, newASTStatementList(scope, assign(z, newASTCmpEQ(newASTID(x), newASTInt(5)).result_value)));
+
+    execAST();
+
+    TEST_ASSERT_EQUAL_INT(7, value(y));
+    TEST_ASSERT_TRUE(value(z));
+    TEST_ASSERT_EQUAL_INT(14, getFrameValue(frame, getLibrarySymbol(library, getLibrarySymbolCount(library) - 1)->offset));
+}
+
+void execLoopsAndTopLevelBreak() {
+    // while (x < ITERATION_COUNT) { x++; y = y * 31 + x; }; break; y = 0
+    ASTNode* hash = newASTAdd(newASTMul(newASTID(y), newASTInt(31)).result_value, newASTID(x)).result_value;
+    ASTNode* body = newASTStatementList(newASTInc(newASTID(x), false).result_value, assign(y, hash));
+    ASTNode* loop = newASTWhile(newASTCmpLT(newASTID(x), newASTInt(ITERATION_COUNT)).result_value, newASTScope(body)).result_value;
+    ast = newASTStatementList(loop, newASTStatementList(newASTBreak(), assign(y, newASTInt(0))));
+
+    execAST();
+
+    TEST_ASSERT_EQUAL_INT(ITERATION_COUNT, value(x));
+    TEST_ASSERT_NOT_EQUAL(0, value(y));
+}
+
+void execWrappingArithmetic() {
+    // x = INT_MAX; x++; y = x - 1; y *= 2; z = ++y == -1
+    ASTNode* inc = newASTInc(newASTID(x), false).result_value;
+    ASTNode* sub = assign(y, newASTSub(newASTID(x), newASTInt(1)).result_value);
+    ASTNode* mul = newASTCompoundAssignment(AST_MUL, newASTID(y), newASTInt(2)).result_value;
+    ASTNode* cmp = assign(z, newASTCmpEQ(newASTInc(newASTID(y), true).result_value, newASTInt(-1)).result_value);
+    ast = newASTStatementList(assign(x, newASTInt(INT_MAX)), newASTStatementList(inc, newASTStatementList(sub, newASTStatementList(mul, cmp))));
+
+    loadAST();
+
+    frame = newZeroedFrame(getLibraryFrameSize(library));
+    executeLibraryWithFrame(library, frame);
+    TEST_ASSERT_EQUAL_INT(INT_MIN, value(x));
+    TEST_ASSERT_EQUAL_INT(-1, value(y));
+    TEST_ASSERT_TRUE(value(z));
+}
+
+void execWithoutVars() {
+    deleteSymbolTable(&st);
+    st = newSymbolTableDefault();
+    // print(1 + 2)
+    ast = newASTPrint(newASTAdd(newASTInt(1), newASTInt(2)).result_value);
+
+    loadAST();
+
+    TEST_ASSERT_EQUAL_UINT(0, getLibraryFrameSize(library));
+    TEST_ASSERT_EQUAL_UINT(0, getLibrarySymbolCount(library));
+    frame = executeLibrary(library);
+    TEST_ASSERT_EQUAL_UINT(0, frame->size);
+}
+
+void execSymbolMetadata() {
+    // y = 1
+    ast = assign(y, newASTInt(1));
+
+    loadAST();
+
+    TEST_ASSERT_EQUAL_UINT(3, getLibrarySymbolCount(library));
+    const LibrarySymbol* symbol = findLibrarySymbol(library, "z");
+    TEST_ASSERT_NOT_NULL(symbol);
+    TEST_ASSERT_EQUAL_STRING("z", symbol->id);
+    TEST_ASSERT_EQUAL_INT(AST_TYPE_BOOL, symbol->type);
+    TEST_ASSERT_EQUAL_UINT(getVarOffset(z), symbol->offset);
+    TEST_ASSERT_NULL(findLibrarySymbol(library, "w"));
+}
+
+void execRepeatedlyOnTheSameFrame() {
+    // x += 2; printvar(x)
+    ast = newASTStatementList(newASTCompoundAssignment(AST_ADD, newASTID(x), newASTInt(2)).result_value, newASTPrintVar(newASTID(x)));
+
+    loadAST();
+
+    FILE* file = tmpfile();
+    TEST_ASSERT_NOT_NULL(file);
+    OutputSink* sink = newOutputSinkDefault(file, FLUSH_FULL);
+    OutputSink* previous = setOutputSink(sink);
+
+    frame = newZeroedFrame(getLibraryFrameSize(library));
+    for (int i = 0; i < 3; i++) {
+        executeLibraryWithFrame(library, frame);
+    }
+
+    setOutputSink(previous);
+    deleteOutputSink(&sink);
+
+    char buffer[READ_BUFFER_SIZE];
+    rewind(file);
+    size_t n = fread(buffer, 1, READ_BUFFER_SIZE - 1, file);
+    buffer[n] = '\0';
+    fclose(file);
+
+    TEST_ASSERT_EQUAL_INT(6, value(x));
+    TEST_ASSERT_EQUAL_STRING("int x = 2\nint x = 4\nint x = 6\n", buffer);
+}
+
+void openMissingLibrary() {
+    TEST_ASSERT_NULL(openLibrary("./missing-library.so"));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(compileVarsAsFrameSlots);
+    RUN_TEST(execScopedAndShadowedVars);
+    RUN_TEST(execLoopsAndTopLevelBreak);
+    RUN_TEST(execWrappingArithmetic);
+    RUN_TEST(execWithoutVars);
+    RUN_TEST(execSymbolMetadata);
+    RUN_TEST(execRepeatedlyOnTheSameFrame);
+    RUN_TEST(openMissingLibrary);
+    return UNITY_END();
+}
@@ -0,0 +1,148 @@
+#include <unity.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "ast/ast.h"
+#include "out/out.h"
+
+static SymbolTable* st = NULL;
+static ASTNode* ast = NULL;
+static Profile* profile = NULL;
+static Symbol* x = NULL;
+static Symbol* y = NULL;
+
+#define ITERATION_COUNT 10
+
+void setUp (void) {
+    st = newSymbolTableDefault();
+    x = defineVar(st, AST_TYPE_INT, "x", false).result_value;
+    y = defineVar(st, AST_TYPE_INT, "y", false).result_value;
+    profile = newProfile();
+}
+
+void tearDown (void) {
+    deleteProfile(&profile);
+    deleteASTNode(&ast);
+    deleteSymbolTable(&st);
+}
+
+static Frame* newZeroedFrame() {
+    Frame* f = newFrame(getMaxOffset(st) + 1);
+    for (unsigned int i = 0; i < f->size; i++) {
+        setFrameValue(f, i, 0);
+    }
+    return f;
+}
+
+static ASTNode* assign(Symbol* var, ASTNode* exp) {
+    return newASTAssignment(newASTID(var), exp).result_value;
+}
+
+// y = 1; while (x < ITERATION_COUNT) { x++; y = y * 3 }
+static void newLoopAST(ASTNode** inc, ASTNode** loop) {
+    *inc = newASTInc(newASTID(x), false).result_value;
+    ASTNode* body = newASTStatementList(*inc, assign(y, newASTMul(newASTID(y), newASTInt(3)).result_value));
+    *loop = newASTWhile(newASTCmpLT(newASTID(x), newASTInt(ITERATION_COUNT)).result_value, newASTScope(body)).result_value;
+    ast = newASTStatementList(assign(y, newASTInt(1)), *loop);
+}
+
+void profiledExecutionMatchesPlainExecution() {
+    ASTNode* inc = NULL;
+    ASTNode* loop = NULL;
+    newLoopAST(&inc, &loop);
+
+    Frame* reference = newZeroedFrame();
+    executeASTStatements(ast, st, reference);
+
+    Frame* frame = newZeroedFrame();
+    executeASTStatementsProfiled(ast, st, frame, profile);
+    TEST_ASSERT_EQUAL_INT_ARRAY(reference->values, frame->values, frame->size);
+
+    deleteFrame(&frame);
+    deleteFrame(&reference);
+}
+
+void countsExecutionsOfEachStatement() {
+    ASTNode* inc = NULL;
+    ASTNode* loop = NULL;
+    newLoopAST(&inc, &loop);
+
+    Frame* frame = newZeroedFrame();
+    executeASTStatementsProfiled(ast, st, frame, profile);
+    deleteFrame(&frame);
+
+    // The sequences are not statements of their own
+    TEST_ASSERT_NULL(getProfileEntry(profile, ast));
+
+    const ProfileEntry* loop_entry = getProfileEntry(profile, loop);
+    TEST_ASSERT_NOT_NULL(loop_entry);
+    TEST_ASSERT_EQUAL_UINT(1, loop_entry->count);
+    TEST_ASSERT_EQUAL_UINT(ITERATION_COUNT, getProfileEntry(profile, loop->right)->count);
+
+    const ProfileEntry* inc_entry = getProfileEntry(profile, inc);
+    TEST_ASSERT_NOT_NULL(inc_entry);
+    TEST_ASSERT_EQUAL_UINT(ITERATION_COUNT, inc_entry->count);
+    TEST_ASSERT_TRUE(inc_entry->total_ns == inc_entry->self_ns);
+
+    // The loop includes the time of its body
+    TEST_ASSERT_TRUE(loop_entry->total_ns >= inc_entry->total_ns);
+    TEST_ASSERT_TRUE(loop_entry->total_ns >= loop_entry->self_ns);
+
+    // y = 1, the loop, its body and the two statements of the body
+    TEST_ASSERT_EQUAL_UINT(5, getProfileSize(profile));
+}
+
+void stopsAtBreakAndKeepsCounting() {
+    // while (true) { x++; if (x == ITERATION_COUNT) break }
+    ASTNode* inc = newASTInc(newASTID(x), false).result_value;
+    ASTNode* stop = newASTIf(newASTCmpEQ(newASTID(x), newASTInt(ITERATION_COUNT)).result_value, newASTBreak()).result_value;
+    ASTNode* loop = newASTWhile(newASTBool(true), newASTScope(newASTStatementList(inc, stop))).result_value;
+    ast = loop;
+
+    Frame* frame = newZeroedFrame();
+    executeASTStatementsProfiled(ast, st, frame, profile);
+    TEST_ASSERT_EQUAL_INT(ITERATION_COUNT, getFrameValue(frame, getVarOffset(x)));
+    deleteFrame(&frame);
+
+    TEST_ASSERT_EQUAL_UINT(ITERATION_COUNT, getProfileEntry(profile, inc)->count);
+    TEST_ASSERT_EQUAL_UINT(ITERATION_COUNT, getProfileEntry(profile, stop)->count);
+    TEST_ASSERT_EQUAL_UINT(1, getProfileEntry(profile, loop)->count);
+}
+
+void reportIsAnnotatedWithTheSource() {
+    const char* src = "y = 1;\nwhile (x < 10) {\n    x++; y = y * 3;\n}\n";
+
+    ASTNode* inc = NULL;
+    ASTNode* loop = NULL;
+    newLoopAST(&inc, &loop);
+    setASTLocation((ASTNode*) ast->stmts[0], 1, 1);
+    setASTLocation(loop, 2, 1);
+    setASTLocation(inc, 3, 5);
+
+    Frame* frame = newZeroedFrame();
+    executeASTStatementsProfiled(ast, st, frame, profile);
+    deleteFrame(&frame);
+
+    char* report = NULL;
+    size_t size = 0;
+    IOStream* stream = openIOStreamFromMemmory(&report, &size);
+    printProfile(profile, src, DEFAULT_PROFILE_REPORT_SIZE, stream);
+    IOStreamClose(&stream);
+
+    TEST_ASSERT_NOT_NULL(report);
+    TEST_ASSERT_NOT_NULL(strstr(report, "2:1       while (x < 10) {"));
+    TEST_ASSERT_NOT_NULL(strstr(report, "3:5       x++; y = y * 3;"));
+    // The statements without location show their type
+    TEST_ASSERT_NOT_NULL(strstr(report, "?         AST_ID_ASSIGNMENT"));
+    free(report);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(profiledExecutionMatchesPlainExecution);
+    RUN_TEST(countsExecutionsOfEachStatement);
+    RUN_TEST(stopsAtBreakAndKeepsCounting);
+    RUN_TEST(reportIsAnnotatedWithTheSource);
+    return UNITY_END();
+}
@@ -0,0 +1,261 @@
+#include <unity.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "ast/ast.h"
+#include "out/out.h"
+
+static SymbolTable* st = NULL;
+static ASTNode* ast = NULL;
+static Frame* frame = NULL;
+static Symbol* x = NULL;
+static Symbol* y = NULL;
+static Symbol* z = NULL;
+
+#define ITERATION_COUNT 1000
+#define THRESHOLD 10
+#define READ_BUFFER_SIZE 256
+#define CACHE_DIR_TEMPLATE "/tmp/mylang-test-XXXXXX"
+#define MAX_PATH_SIZE 512
+#define THREAD_COUNT 4
+
+void setUp (void) {
+    st = newSymbolTableDefault();
+    x = defineVar(st, AST_TYPE_INT, "x", false).result_value;
+    y = defineVar(st, AST_TYPE_INT, "y", false).result_value;
+    z = defineVar(st, AST_TYPE_BOOL, "z", false).result_value;
+}
+
+void tearDown (void) {
+    if (frame != NULL) {
+        deleteFrame(&frame);
+    }
+    deleteASTNode(&ast);
+    deleteSymbolTable(&st);
+}
+
+static Frame* newZeroedFrame() {
+    Frame* f = newFrame(getMaxOffset(st) + 1);
+    for (unsigned int i = 0; i < f->size; i++) {
+        setFrameValue(f, i, 0);
+    }
+    return f;
+}
+
+// Executes the AST with the tree walker and as a tiered program, checks that the resulting frames match and
+// returns the number of loops that were compiled
+unsigned int execAST(unsigned int threshold) {
+    assert(ast != NULL);
+
+    Frame* reference = newZeroedFrame();
+    executeASTStatements(ast, st, reference);
+
+    Program* program = newTieredProgramFromAST(ast, st, threshold);
+    frame = newZeroedFrame();
+    executeProgram(program, frame);
+    TEST_ASSERT_EQUAL_INT_ARRAY(reference->values, frame->values, frame->size);
+
+    unsigned int count = getProgramNativeLoopCount(program);
+    deleteProgram(&program);
+    deleteFrame(&reference);
+    return count;
+}
+
+#define value(var) getFrameValue(frame, getVarOffset(var))
+
+static ASTNode* assign(Symbol* var, ASTNode* exp) {
+    return newASTAssignment(newASTID(var), exp).result_value;
+}
+
+void execHotWhileLoop() {
+    // while (x < ITERATION_COUNT) { x++; y = y * 31 + x; z = !z }
+    ASTNode* hash = newASTAdd(newASTMul(newASTID(y), newASTInt(31)).result_value, newASTID(x)).result_value;
+    ASTNode* body = newASTStatementList(assign(y, hash), assign(z, newASTLogicalNot(newASTID(z)).result_value));
+    body = newASTStatementList(newASTInc(newASTID(x), false).result_value, body);
+    ast = newASTWhile(newASTCmpLT(newASTID(x), newASTInt(ITERATION_COUNT)).result_value, newASTScope(body)).result_value;
+
+    unsigned int count = execAST(THRESHOLD);
+
+    TEST_ASSERT_EQUAL_INT(ITERATION_COUNT, value(x));
+    if (count == 0) {
+        TEST_IGNORE_MESSAGE("The loop was not compiled, there is no C compiler");
+    }
+    TEST_ASSERT_EQUAL_UINT(1, count);
+}
+
+void execHotForLoopWithBreak() {
+    // for (var i = 0; i < ITERATION_COUNT; i++) { x += i; if (x > ITERATION_COUNT * 100) break; }
+    ASTNode* init = newASTIDDeclaration(AST_TYPE_INT, "i", newASTInt(0), false, st).result_value;
+    Symbol* i = getVarReference(st, "i").result_value;
+    ASTNode* cond = newASTCmpLT(newASTID(i), newASTInt(ITERATION_COUNT)).result_value;
+    ASTNode* update = newASTInc(newASTID(i), false).result_value;
+    ASTNode* stop = newASTIf(newASTCmpGT(newASTID(x), newASTInt(ITERATION_COUNT * 100)).result_value, newASTBreak()).result_value;
+    ASTNode* body = newASTStatementList(newASTCompoundAssignment(AST_ADD, newASTID(x), newASTID(i)).result_value, stop);
+    ast = newASTFor(init, cond, update, newASTScope(body)).result_value;
+
+    unsigned int count = execAST(THRESHOLD);
+
+    TEST_ASSERT_TRUE(value(x) > ITERATION_COUNT * 100);
+    if (count == 0) {
+        TEST_IGNORE_MESSAGE("The loop was not compiled, there is no C compiler");
+    }
+}
+
+void execHotLoopWithLogicalCompoundAssignment() {
+    // while (x < ITERATION_COUNT) { x++; z ||= x % 7 == 0; z &&= x % 3 != 0 }
+    ASTNode* seven = newASTCmpEQ(newASTMod(newASTID(x), newASTInt(7)).result_value, newASTInt(0)).result_value;
+    ASTNode* three = newASTCmpNEQ(newASTMod(newASTID(x), newASTInt(3)).result_value, newASTInt(0)).result_value;
+    ASTNode* body = newASTStatementList(newASTCompoundAssignment(AST_LOGICAL_OR, newASTID(z), seven).result_value,
+                                        newASTCompoundAssignment(AST_LOGICAL_AND, newASTID(z), three).result_value);
+    body = newASTStatementList(newASTInc(newASTID(x), false).result_value, body);
+    ast = newASTWhile(newASTCmpLT(newASTID(x), newASTInt(ITERATION_COUNT)).result_value, newASTScope(body)).result_value;
+
+    unsigned int count = execAST(THRESHOLD);
+
+    TEST_ASSERT_EQUAL_INT(ITERATION_COUNT, value(x));
+    if (count == 0) {
+        TEST_IGNORE_MESSAGE("The loop was not compiled, there is no C compiler");
+    }
+    TEST_ASSERT_EQUAL_UINT(1, count);
+}
+
+void execColdLoopStaysInterpreted() {
+    // while (x < THRESHOLD / 2) x++
+    ast = newASTWhile(newASTCmpLT(newASTID(x), newASTInt(THRESHOLD / 2)).result_value, newASTScope(newASTInc(newASTID(x), false).result_value)).result_value;
+
+    TEST_ASSERT_EQUAL_UINT(0, execAST(THRESHOLD));
+    TEST_ASSERT_EQUAL_INT(THRESHOLD / 2, value(x));
+}
+
+void execLoopWithDeclarationStaysInterpreted() {
+    // while (x < ITERATION_COUNT) { var t = x * 2; x++ }
+    ASTNode* decl = newASTIDDeclaration(AST_TYPE_INT, "t", newASTMul(newASTID(x), newASTInt(2)).result_value, false, st).result_value;
+    ASTNode* body = newASTStatementList(decl, newASTInc(newASTID(x), false).result_value);
+    ast = newASTWhile(newASTCmpLT(newASTID(x), newASTInt(ITERATION_COUNT)).result_value, newASTScope(body)).result_value;
+
+    // The frame keeps the last value of t, which the native loop would not write back
+    TEST_ASSERT_EQUAL_UINT(0, execAST(THRESHOLD));
+    TEST_ASSERT_EQUAL_INT(ITERATION_COUNT, value(x));
+}
+
+void execPrintsInHotLoopToCurrentSink() {
+    FILE* file = tmpfile();
+    TEST_ASSERT_NOT_NULL(file);
+    OutputSink* sink = newOutputSinkDefault(file, FLUSH_FULL);
+    OutputSink* previous = setOutputSink(sink);
+
+    // while (x < 2 * THRESHOLD) { x++; if (x % THRESHOLD == 0) printvar(x) }; print(true)
+    ASTNode* every = newASTCmpEQ(newASTMod(newASTID(x), newASTInt(THRESHOLD)).result_value, newASTInt(0)).result_value;
+    ASTNode* body = newASTStatementList(newASTInc(newASTID(x), false).result_value, newASTIf(every, newASTPrintVar(newASTID(x))).result_value);
+    ASTNode* loop = newASTWhile(newASTCmpLT(newASTID(x), newASTInt(2 * THRESHOLD)).result_value, newASTScope(body)).result_value;
+    ast = newASTStatementList(loop, newASTPrint(newASTBool(true)));
+
+    Program* program = newTieredProgramFromAST(ast, st, THRESHOLD / 2);
+    frame = newZeroedFrame();
+    executeProgram(program, frame);
+    unsigned int count = getProgramNativeLoopCount(program);
+    deleteProgram(&program);
+
+    setOutputSink(previous);
+    deleteOutputSink(&sink);
+
+    char buffer[READ_BUFFER_SIZE];
+    rewind(file);
+    size_t n = fread(buffer, 1, READ_BUFFER_SIZE - 1, file);
+    buffer[n] = '\0';
+    fclose(file);
+
+    TEST_ASSERT_EQUAL_STRING("int x = 10\nint x = 20\ntrue\n", buffer);
+    if (count == 0) {
+        TEST_IGNORE_MESSAGE("The loop was not compiled, there is no C compiler");
+    }
+}
+
+typedef struct ThreadRun {
+    const Program* program;
+    Frame* frame;
+} ThreadRun;
+
+static void* execProgramInThread(void* arg) {
+    ThreadRun* run = arg;
+    executeProgram(run->program, run->frame);
+    return NULL;
+}
+
+void execHotLoopInSeveralThreads() {
+    // while (x < ITERATION_COUNT) { x++; y = y * 31 + x }
+    ASTNode* hash = newASTAdd(newASTMul(newASTID(y), newASTInt(31)).result_value, newASTID(x)).result_value;
+    ASTNode* body = newASTStatementList(newASTInc(newASTID(x), false).result_value, assign(y, hash));
+    ast = newASTWhile(newASTCmpLT(newASTID(x), newASTInt(ITERATION_COUNT)).result_value, newASTScope(body)).result_value;
+
+    Frame* reference = newZeroedFrame();
+    executeASTStatements(ast, st, reference);
+
+    // Every thread gets hot at the same time, and runs the loop natively once one of them compiled it
+    Program* program = newTieredProgramFromAST(ast, st, THRESHOLD);
+    pthread_t threads[THREAD_COUNT];
+    ThreadRun runs[THREAD_COUNT];
+    for (unsigned int i = 0; i < THREAD_COUNT; i++) {
+        runs[i] = (ThreadRun) { .program = program, .frame = newZeroedFrame() };
+        TEST_ASSERT_EQUAL_INT(0, pthread_create(&threads[i], NULL, &execProgramInThread, &runs[i]));
+    }
+    for (unsigned int i = 0; i < THREAD_COUNT; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    for (unsigned int i = 0; i < THREAD_COUNT; i++) {
+        TEST_ASSERT_EQUAL_INT_ARRAY(reference->values, runs[i].frame->values, reference->size);
+        deleteFrame(&runs[i].frame);
+    }
+    unsigned int count = getProgramNativeLoopCount(program);
+    deleteProgram(&program);
+    deleteFrame(&reference);
+
+    if (count == 0) {
+        TEST_IGNORE_MESSAGE("The loop was not compiled, there is no C compiler");
+    }
+    TEST_ASSERT_EQUAL_UINT(1, count);
+}
+
+static void removeCacheDir(const char* path) {
+    DIR* dir = opendir(path);
+    if (dir == NULL) {
+        return;
+    }
+    struct dirent* entry;
+    char file[MAX_PATH_SIZE];
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] != '.') {
+            snprintf(file, MAX_PATH_SIZE, "%s/%s", path, entry->d_name);
+            remove(file);
+        }
+    }
+    closedir(dir);
+    rmdir(path);
+}
+
+int main() {
+    // Keep the compiled loops of the tests out of the shared cache
+    char cache_dir[] = CACHE_DIR_TEMPLATE;
+    if (mkdtemp(cache_dir) != NULL) {
+        setenv("MYLANG_CACHE_DIR", cache_dir, 1);
+    }
+
+    UNITY_BEGIN();
+    RUN_TEST(execHotWhileLoop);
+    RUN_TEST(execHotForLoopWithBreak);
+    RUN_TEST(execHotLoopWithLogicalCompoundAssignment);
+    RUN_TEST(execColdLoopStaysInterpreted);
+    RUN_TEST(execLoopWithDeclarationStaysInterpreted);
+    RUN_TEST(execPrintsInHotLoopToCurrentSink);
+    RUN_TEST(execHotLoopInSeveralThreads);
+    int status = UNITY_END();
+
+    removeCacheDir(cache_dir);
+    return status;
+}
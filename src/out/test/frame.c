@@ -0,0 +1,124 @@
+#include <unity.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ast/ast.h"
+#include "out/out.h"
+
+static SymbolTable* st = NULL;
+static Frame* frame = NULL;
+
+#define LARGE_VAR_COUNT 100000
+
+void setUp (void) {
+    st = newSymbolTableDefault();
+}
+
+void tearDown (void) {
+    if (frame != NULL) {
+        deleteFrame(&frame);
+    }
+    deleteSymbolTable(&st);
+}
+
+static char* printState() {
+    char* ptr = NULL;
+    size_t size = 0;
+    IOStream* stream = openIOStreamFromMemmory(&ptr, &size);
+    printSymbolTable(st, frame, stream);
+    IOStreamClose(&stream);
+    return ptr;
+}
+
+void printEmptyState() {
+    frame = newFrame(1);
+
+    char* txt = printState();
+    TEST_ASSERT_EQUAL_STRING(" (0 vars) []\n", txt);
+    free(txt);
+}
+
+void printStateShowsLastDefinedVars() {
+    // { int n; } int m; bool z;
+    enterScopeDefault(st);
+    defineVar(st, AST_TYPE_INT, "n", false);
+    leaveScope(st);
+    defineVar(st, AST_TYPE_INT, "m", false);
+    defineVar(st, AST_TYPE_BOOL, "z", false);
+
+    frame = newFrame(getMaxOffset(st) + 1);
+    setFrameValue(frame, 0, -3);
+    setFrameValue(frame, 1, 1);
+
+    char* txt = printState();
+    TEST_ASSERT_EQUAL_STRING(" (2 vars) [int m = -3, bool z = true]\n", txt);
+    free(txt);
+}
+
+void printLargeState() {
+    char id[MAX_ID_SIZE];
+    for (int i = 0; i < LARGE_VAR_COUNT; i++) {
+        sprintf(id, "v%d", i);
+        defineVar(st, AST_TYPE_INT, id, false);
+    }
+
+    frame = newFrame(getMaxOffset(st) + 1);
+    for (int i = 0; i < LARGE_VAR_COUNT; i++) {
+        setFrameValue(frame, i, i);
+    }
+
+    char* txt = printState();
+    const char* start = " (100000 vars) [int v0 = 0, int v1 = 1, ";
+    TEST_ASSERT_EQUAL_INT(0, strncmp(start, txt, strlen(start)));
+    const char* end = "int v99998 = 99998, int v99999 = 99999]\n";
+    TEST_ASSERT_EQUAL_STRING(end, txt + strlen(txt) - strlen(end));
+    free(txt);
+}
+
+void resizeFrameKeepsTheValues() {
+    frame = newFrame(2);
+    setFrameValue(frame, 0, 7);
+    setFrameValue(frame, 1, -1);
+
+    frame = resizeFrame(frame, LARGE_VAR_COUNT);
+    TEST_ASSERT_EQUAL_UINT(LARGE_VAR_COUNT, frame->size);
+    TEST_ASSERT_EQUAL_INT(7, getFrameValue(frame, 0));
+    TEST_ASSERT_EQUAL_INT(-1, getFrameValue(frame, 1));
+    for (unsigned int i = 2; i < LARGE_VAR_COUNT; i++) {
+        TEST_ASSERT_EQUAL_INT(0, getFrameValue(frame, i));
+    }
+
+    // Never shrinks
+    frame = resizeFrame(frame, 1);
+    TEST_ASSERT_EQUAL_UINT(LARGE_VAR_COUNT, frame->size);
+}
+
+void printStateSlots() {
+    defineVar(st, AST_TYPE_INT, "a", false);
+    defineVar(st, AST_TYPE_INT, "b", false);
+    defineVar(st, AST_TYPE_BOOL, "c", false);
+
+    frame = resizeFrame(newFrame(0), getMaxOffset(st) + 1);
+    setFrameValue(frame, 1, 5);
+
+    char* ptr = NULL;
+    size_t size = 0;
+    IOStream* stream = openIOStreamFromMemmory(&ptr, &size);
+    printSymbolTableSlots(st, frame, 1, 3, stream);
+    printSymbolTableSlots(st, frame, 3, 3, stream);
+    IOStreamClose(&stream);
+    TEST_ASSERT_EQUAL_STRING(" (2 vars) [int b = 5, bool c = false]\n (0 vars) []\n", ptr);
+    free(ptr);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(printEmptyState);
+    RUN_TEST(printStateShowsLastDefinedVars);
+    RUN_TEST(printLargeState);
+    RUN_TEST(resizeFrameKeepsTheValues);
+    RUN_TEST(printStateSlots);
+    return UNITY_END();
+}
@@ -0,0 +1,159 @@
+#include <unity.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <pthread.h>
+
+#include "ast/ast.h"
+#include "out/out.h"
+
+static FILE* file = NULL;
+static OutputSink* sink = NULL;
+
+#define READ_BUFFER_SIZE 256
+#define THREAD_COUNT 8
+
+void setUp (void) {
+    file = tmpfile();
+    TEST_ASSERT_NOT_NULL(file);
+}
+
+void tearDown (void) {
+    setOutputSink(NULL);
+    if (sink != NULL) {
+        deleteOutputSink(&sink);
+    }
+    fclose(file);
+}
+
+// Returns what reached the file so far
+static const char* written() {
+    static char buffer[READ_BUFFER_SIZE];
+    long size = ftell(file);
+    rewind(file);
+    size_t n = fread(buffer, 1, size, file);
+    buffer[n] = '\0';
+    fseek(file, 0, SEEK_END);
+    return buffer;
+}
+
+void writeValues() {
+    sink = newOutputSinkDefault(file, FLUSH_EXPLICIT);
+
+    sinkWriteInt(sink, 0);
+    sinkWriteStr(sink, " ");
+    sinkWriteInt(sink, -42);
+    sinkWriteStr(sink, " ");
+    sinkWriteInt(sink, INT_MAX);
+    sinkWriteStr(sink, " ");
+    sinkWriteInt(sink, INT_MIN);
+    sinkWriteStr(sink, " ");
+    sinkWriteValue(sink, AST_TYPE_BOOL, 1);
+    sinkWriteStr(sink, " ");
+    sinkWriteValue(sink, AST_TYPE_BOOL, 0);
+    sinkWriteStr(sink, " ");
+    sinkWriteValue(sink, AST_TYPE_TYPE, AST_TYPE_INT);
+    flushOutputSink(sink);
+
+    TEST_ASSERT_EQUAL_STRING("0 -42 2147483647 -2147483648 true false int", written());
+}
+
+void lineFlushPolicyFlushesEveryLine() {
+    sink = newOutputSinkDefault(file, FLUSH_LINE);
+
+    sinkWriteInt(sink, 1);
+    TEST_ASSERT_EQUAL_STRING("", written());
+    sinkEndLine(sink);
+    TEST_ASSERT_EQUAL_STRING("1\n", written());
+}
+
+void fullFlushPolicyFlushesAtTheEnd() {
+    sink = newOutputSinkDefault(file, FLUSH_FULL);
+
+    sinkWriteInt(sink, 1);
+    sinkEndLine(sink);
+    TEST_ASSERT_EQUAL_STRING("", written());
+    endOutputSink(sink);
+    TEST_ASSERT_EQUAL_STRING("1\n", written());
+}
+
+void explicitFlushPolicyOnlyFlushesWhenAsked() {
+    sink = newOutputSinkDefault(file, FLUSH_EXPLICIT);
+
+    sinkWriteInt(sink, 1);
+    sinkEndLine(sink);
+    endOutputSink(sink);
+    TEST_ASSERT_EQUAL_STRING("", written());
+    flushOutputSink(sink);
+    TEST_ASSERT_EQUAL_STRING("1\n", written());
+}
+
+void fullBufferIsFlushed() {
+    sink = newOutputSink(file, 4, FLUSH_EXPLICIT);
+
+    sinkWriteStr(sink, "abc");
+    TEST_ASSERT_EQUAL_STRING("", written());
+    sinkWriteStr(sink, "de");
+    TEST_ASSERT_EQUAL_STRING("abc", written());
+
+    // Longer than the buffer
+    sinkWriteStr(sink, "fghijk");
+    TEST_ASSERT_EQUAL_STRING("abcdefghijk", written());
+}
+
+void executionPrintsToCurrentSink() {
+    sink = newOutputSinkDefault(file, FLUSH_FULL);
+    TEST_ASSERT_NULL(setOutputSink(sink));
+    TEST_ASSERT_EQUAL_PTR(sink, getOutputSink());
+
+    SymbolTable* st = newSymbolTableDefault();
+    ASTNode* decl = newASTIDDeclaration(AST_TYPE_INT, "n", newASTInt(-7), false, st).result_value;
+    ASTNode* print_var = newASTPrintVar(newASTID(lookupVar(st, "n")));
+    ASTNode* ast = newASTStatementList(decl, newASTStatementList(newASTPrint(newASTBool(true)), print_var));
+
+    char expected[READ_BUFFER_SIZE] = "";
+    for (ExecMode mode = 0; mode < EXEC_MODE_COUNT; mode++) {
+        Frame* frame = executeASTWithMode(ast, st, mode);
+        deleteFrame(&frame);
+        strcat(expected, "true\nint n = -7\n");
+    }
+    TEST_ASSERT_EQUAL_STRING(expected, written());
+
+    deleteASTNode(&ast);
+    deleteSymbolTable(&st);
+}
+
+static void* getSink(void* arg) {
+    *(OutputSink**) arg = getOutputSink();
+    return NULL;
+}
+
+void threadsWithoutSinkShareTheDefaultOne() {
+    OutputSink* sinks[THREAD_COUNT];
+    pthread_t threads[THREAD_COUNT];
+    for (int i = 0; i < THREAD_COUNT; i++) {
+        TEST_ASSERT_EQUAL_INT(0, pthread_create(&threads[i], NULL, &getSink, &sinks[i]));
+    }
+    for (int i = 0; i < THREAD_COUNT; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    TEST_ASSERT_NOT_NULL(sinks[0]);
+    for (int i = 1; i < THREAD_COUNT; i++) {
+        TEST_ASSERT_EQUAL_PTR(sinks[0], sinks[i]);
+    }
+    TEST_ASSERT_EQUAL_PTR(sinks[0], getOutputSink());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(writeValues);
+    RUN_TEST(lineFlushPolicyFlushesEveryLine);
+    RUN_TEST(fullFlushPolicyFlushesAtTheEnd);
+    RUN_TEST(explicitFlushPolicyOnlyFlushesWhenAsked);
+    RUN_TEST(fullBufferIsFlushed);
+    RUN_TEST(executionPrintsToCurrentSink);
+    RUN_TEST(threadsWithoutSinkShareTheDefaultOne);
+    return UNITY_END();
+}
@@ -7,6 +7,7 @@
 
 extern const OutSerializer cSerializer;
 extern const OutSerializer javaSerializer;
+extern const OutSerializer cLibrarySerializer;
 
 const char* compileStmt(const ASTNode* ast, const OutSerializer* os, const SymbolTable* st) {
     char* ptr = NULL;
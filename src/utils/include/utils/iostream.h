@@ -14,8 +14,21 @@ IOStream* openIOStreamFromFile(const FILE* fp);
 
 IOStream* openIOStreamFromStdout();
 
+IOStream* openIOStreamFromStderr();
+
 int IOStreamWritef(const IOStream* s, const char* format, ...);
 
+// Writes len raw bytes, without parsing a format
+int IOStreamWrite(const IOStream* s, const char* str, size_t len);
+
+#define IOStreamWriteLiteral(s, literal) IOStreamWrite(s, literal, sizeof(literal) - 1)
+
+int IOStreamWriteStr(const IOStream* s, const char* str);
+
+int IOStreamWriteChar(const IOStream* s, char c);
+
+int IOStreamWriteInt(const IOStream* s, int value);
+
 int indent(const IOStream* stream, unsigned int indentation_level);
 
 int IOStreamClose(IOStream** s);
@@ -1,14 +1,19 @@
 #include <stdio.h>
 #include <stdarg.h>
+#include <string.h>
 #include <assert.h>
 
 #include "iostream.h"
 
+#define MEM_BUFFER_MIN_CAPACITY 256
+#define INT_DIGITS_BUFFER_SIZE 12 // Sign and 10 digits of a 32 bit int
+
 struct MemBuffer {
     char** ptr;
     size_t* buffer_size;
     char* buffer;
-    size_t available_size;
+    size_t used;     // Without the \0
+    size_t capacity;
 };
 
 void initMemBuffer(struct MemBuffer* mb, char** ptr, size_t* size) {
@@ -18,7 +23,8 @@ void initMemBuffer(struct MemBuffer* mb, char** ptr, size_t* size) {
     mb->buffer_size = size;
     *size = 0;
     mb->buffer = NULL;
-    mb->available_size = 0;
+    mb->used = 0;
+    mb->capacity = 0;
 }
 
 struct MemBuffer* newMemBuffer(char** ptr, size_t* size) {
@@ -27,74 +33,105 @@ struct MemBuffer* newMemBuffer(char** ptr, size_t* size) {
     return mb;
 }
 
-int MemBufferWritef(struct MemBuffer* mb, const char* format, va_list args) {
-    if(mb == NULL || format == NULL) {
+// Makes room for len more chars and the \0. The capacity is doubled so that appends are amortized O(1).
+static inline void reserveMemBuffer(struct MemBuffer* mb, size_t len) {
+    size_t required = mb->used + len + 1;
+    if (required <= mb->capacity) {
+        return;
+    }
+
+    size_t capacity = mb->capacity == 0 ? MEM_BUFFER_MIN_CAPACITY : mb->capacity;
+    while (capacity < required) {
+        capacity *= 2;
+    }
+
+    mb->buffer = realloc(mb->buffer, capacity);
+    assert(mb->buffer != NULL);
+    mb->capacity = capacity;
+}
+
+int MemBufferWrite(struct MemBuffer* mb, const char* str, size_t len) {
+    if(mb == NULL || str == NULL) {
         return -1;
     }
 
-    va_list args_1, args_2;
-    va_copy(args_1, args);
-    va_copy(args_2, args);
-
-    size_t required_chars = vsnprintf(NULL, 0, format, args_1);
-    if(mb->buffer == NULL) {
-        mb->buffer = malloc(required_chars + 1);
-        *(mb->ptr) = mb->buffer;
-        *(mb->buffer_size) = required_chars + 1;
-        mb->available_size = required_chars;  // Do not count the \0
-    } else if(mb->available_size < required_chars) {
-        size_t extra = (required_chars - mb->available_size);
-        size_t new_size = *(mb->buffer_size) + extra;
-        size_t offset = *(mb->ptr) - mb->buffer;
-        mb->buffer = realloc(mb->buffer, new_size); // may merge with the if
-        *(mb->buffer_size) = new_size;
-        mb->available_size += extra;
-        assert(mb->available_size == required_chars);
-        *(mb->ptr) = mb->buffer + offset;
+    reserveMemBuffer(mb, len);
+    memcpy(mb->buffer + mb->used, str, len);
+    mb->used += len;
+    mb->buffer[mb->used] = '\0';
+
+    return len;
+}
+
+int MemBufferWritef(struct MemBuffer* mb, const char* format, va_list args) {
+    if(mb == NULL || format == NULL) {
+        return -1;
     }
 
-    size_t written_chars = vsnprintf(*(mb->ptr), mb->available_size + 1, format, args_2);
-    *(mb->ptr) += written_chars;
-    mb->available_size -= written_chars;
+    // Most writes fit in the free space, so the format is only parsed again when the buffer has to grow
+    va_list args_copy;
+    va_copy(args_copy, args);
 
-    va_end(args_1);
-    va_end(args_2);
+    size_t available = mb->capacity - mb->used;
+    char* dst = mb->buffer == NULL ? NULL : mb->buffer + mb->used;
+    int written_chars = vsnprintf(dst, available, format, args);
+    if (written_chars >= 0 && (size_t) written_chars >= available) {
+        reserveMemBuffer(mb, written_chars);
+        vsnprintf(mb->buffer + mb->used, mb->capacity - mb->used, format, args_copy);
+    }
+    va_end(args_copy);
 
+    if (written_chars > 0) {
+        mb->used += written_chars;
+    }
     return written_chars;
 }
 
 int MemBufferClose(struct MemBuffer* mb) {
-    *(mb->ptr) = mb->buffer;
+    if (mb->buffer != NULL) {
+        // Release the spare capacity
+        char* buffer = realloc(mb->buffer, mb->used + 1);
+        *(mb->ptr) = buffer != NULL ? buffer : mb->buffer;
+        *(mb->buffer_size) = mb->used + 1;
+    }
     free(mb);
     return 0;
 }
 
+static int fileWrite(FILE* fp, const char* str, size_t len) {
+    return fwrite(str, 1, len, fp);
+}
+
 typedef int (*IOStreamWritter)(const void* handler, const char* format, va_list args);
 
+typedef int (*IOStreamRawWritter)(const void* handler, const char* str, size_t len);
+
 typedef int (*IOStreamCloser)(const void* handler);
 
 struct IOStream {
     const void* state;
     IOStreamWritter write;
+    IOStreamRawWritter write_raw;
     IOStreamCloser close;
 };
 
 
-IOStream* newIOStream(const void* state, const IOStreamWritter write, const IOStreamCloser close) {
+IOStream* newIOStream(const void* state, const IOStreamWritter write, const IOStreamRawWritter write_raw, const IOStreamCloser close) {
     struct IOStream* s = malloc(sizeof(struct IOStream));
     s->state = state;
     s->write = write;
+    s->write_raw = write_raw;
     s->close = close;
     return s;
 }
 
 IOStream* openIOStreamFromMemmory(char** ptr, size_t* size) {
     struct MemBuffer* mb = newMemBuffer(ptr, size);
-    return newIOStream(mb, (IOStreamWritter)&MemBufferWritef, (IOStreamCloser)&MemBufferClose);
+    return newIOStream(mb, (IOStreamWritter)&MemBufferWritef, (IOStreamRawWritter)&MemBufferWrite, (IOStreamCloser)&MemBufferClose);
 }
 
 IOStream* openIOStreamFromFile(const FILE* fp) {
-    return newIOStream(fp, (IOStreamWritter)&vfprintf, (IOStreamCloser)&fclose);
+    return newIOStream(fp, (IOStreamWritter)&vfprintf, (IOStreamRawWritter)&fileWrite, (IOStreamCloser)&fclose);
 }
 
 int IOStreamWritef(const IOStream* stream, const char* format, ...) {
@@ -108,6 +145,37 @@ int IOStreamWritef(const IOStream* stream, const char* format, ...) {
     return written;
 }
 
+int IOStreamWrite(const IOStream* stream, const char* str, size_t len) {
+    struct IOStream* s = (struct IOStream*) stream;
+    return s->write_raw(s->state, str, len);
+}
+
+int IOStreamWriteStr(const IOStream* stream, const char* str) {
+    return IOStreamWrite(stream, str, strlen(str));
+}
+
+int IOStreamWriteChar(const IOStream* stream, char c) {
+    return IOStreamWrite(stream, &c, 1);
+}
+
+int IOStreamWriteInt(const IOStream* stream, int value) {
+    char digits[INT_DIGITS_BUFFER_SIZE];
+    char* end = digits + INT_DIGITS_BUFFER_SIZE;
+    char* p = end;
+
+    // Negated as unsigned so that INT_MIN does not overflow
+    unsigned int n = value < 0 ? 0u - (unsigned int) value : (unsigned int) value;
+    do {
+        *--p = '0' + n % 10;
+        n /= 10;
+    } while (n > 0);
+    if (value < 0) {
+        *--p = '-';
+    }
+
+    return IOStreamWrite(stream, p, end - p);
+}
+
 int IOStreamClose(IOStream** stream) {
     struct IOStream* s = (struct IOStream*) *stream;
     int status = 0;
@@ -123,13 +191,17 @@ int IOStreamClose(IOStream** stream) {
 }
 
 IOStream* openIOStreamFromStdout() {
-    return newIOStream(stdout, (IOStreamWritter)&vfprintf, NULL);
+    return newIOStream(stdout, (IOStreamWritter)&vfprintf, (IOStreamRawWritter)&fileWrite, NULL);
+}
+
+IOStream* openIOStreamFromStderr() {
+    return newIOStream(stderr, (IOStreamWritter)&vfprintf, (IOStreamRawWritter)&fileWrite, NULL);
 }
 
 int indent(const IOStream* stream, unsigned int indentation_level) {
     int n = 0;
     for(unsigned int i = 0; i < indentation_level; i++) {
-        n += IOStreamWritef(stream, DEFAULT_IDENTATION);
+        n += IOStreamWriteLiteral(stream, DEFAULT_IDENTATION);
     }
     return n;
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include <string.h>
+#include <limits.h>
 
 #include <unity.h>
 
@@ -43,9 +44,75 @@ void testIOStreamFromMemoryMultipleLines() {
     free(ptr);
 }
 
+void testIOStreamFromMemoryManyWrites() {
+    char* ptr;
+    size_t size;
+    IOStream* s = openIOStreamFromMemmory(&ptr, &size);
+
+    const int count = 100000;
+    int n = 0;
+    for (int i = 0; i < count; i++) {
+        n += IOStreamWritef(s, "%d,", i % 10);
+    }
+
+    IOStreamClose(&s);
+
+    TEST_ASSERT_EQUAL_INT(2 * count, n);
+    TEST_ASSERT_EQUAL_INT(n + 1, size);
+    TEST_ASSERT_EQUAL_INT(n, strlen(ptr));
+    TEST_ASSERT_EQUAL_INT(0, strncmp("0,1,2,3,4,5,6,7,8,9,0,", ptr, 22));
+    TEST_ASSERT_EQUAL_STRING("8,9,", ptr + n - 4);
+
+    free(ptr);
+}
+
+void testIOStreamFromMemoryRawWrites() {
+    char* ptr;
+    size_t size;
+    IOStream* s = openIOStreamFromMemmory(&ptr, &size);
+
+    int n = IOStreamWrite(s, "abcdef", 3);
+    n += IOStreamWriteLiteral(s, " = ");
+    n += IOStreamWriteInt(s, 0);
+    n += IOStreamWriteChar(s, ' ');
+    n += IOStreamWriteInt(s, INT_MIN);
+    n += IOStreamWriteChar(s, ' ');
+    n += IOStreamWriteInt(s, INT_MAX);
+    n += IOStreamWritef(s, " %s", "end");
+    n += IOStreamWriteStr(s, "!");
+
+    IOStreamClose(&s);
+
+    const char* expected_str = "abc = 0 -2147483648 2147483647 end!";
+    TEST_ASSERT_EQUAL_INT(strlen(expected_str), n);
+    TEST_ASSERT_EQUAL_INT(n + 1, size);
+    TEST_ASSERT_EQUAL_STRING(expected_str, ptr);
+
+    free(ptr);
+}
+
+void testIOStreamFromMemoryEmptyWrite() {
+    char* ptr;
+    size_t size;
+    IOStream* s = openIOStreamFromMemmory(&ptr, &size);
+
+    int n = IOStreamWritef(s, "%s", "");
+
+    IOStreamClose(&s);
+
+    TEST_ASSERT_EQUAL_INT(0, n);
+    TEST_ASSERT_EQUAL_INT(1, size);
+    TEST_ASSERT_EQUAL_STRING("", ptr);
+
+    free(ptr);
+}
+
 int main() {
     UNITY_BEGIN();
     RUN_TEST(testIOStreamFromMemorySingleLine);
     RUN_TEST(testIOStreamFromMemoryMultipleLines);
+    RUN_TEST(testIOStreamFromMemoryManyWrites);
+    RUN_TEST(testIOStreamFromMemoryRawWrites);
+    RUN_TEST(testIOStreamFromMemoryEmptyWrite);
     return UNITY_END();
 }